@@ -38,6 +38,8 @@
 
 #cmakedefine HAVE_SYS_UIO_H       1
 
+#cmakedefine HAVE_SYS_MMAN_H      1
+
 #cmakedefine HAVE_FCNTL_H         1
 
 #cmakedefine HAVE_MATH_H          1
@@ -84,5 +86,9 @@
 
 #cmakedefine THROW_EXCEPTION_IN_COMPARATORS 1
 
+#cmakedefine CDT_FLAT_HASH        1
+
+#cmakedefine SIMD_ESCAPE_SUPPORT  1
+
 #endif /* _CTPP2_SYS_HEADERS_H__ */
 /* End. */
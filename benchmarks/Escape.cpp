@@ -0,0 +1,350 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      Escape.cpp
+ *
+ * $CTPP$
+ */
+#include <CDT.hpp>
+#include <CTPP2Escape.hpp>
+#include <CTPP2JSONParser.hpp>
+#include <CTPP2Util.hpp>
+#include <STLVector.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#ifdef HAVE_SYSEXITS_H
+#include <sysexits.h>
+#endif
+
+using namespace CTPP;
+
+//
+// Get current time, microseconds
+//
+static UINT_64 GetUSTime()
+{
+	struct timeval oTV;
+	gettimeofday(&oTV, NULL);
+
+return UINT_64(oTV.tv_sec) * 1000000 + oTV.tv_usec;
+}
+
+//
+// Reference implementation: byte by byte, fixed buffer flushed into string, as CTPP 2.8 does
+//
+static STLW::string ReferenceEscape(const eEscapeType     eType,
+                                    const STLW::string  & sData)
+{
+	static const CHAR_8 * szEscape = "0123456789ABCDEF";
+	static const CHAR_8 * szJSONHex = "0123456789abcdef";
+
+	const bool bECMAConventions = (eType == ESCAPE_JSON_ECMA || eType == ESCAPE_JSON_ECMA_HTML);
+	const bool bHTMLSafe        = (eType == ESCAPE_JSON_HTML || eType == ESCAPE_JSON_ECMA_HTML);
+
+	CHAR_8 sBuffer[CTPP_ESCAPE_BUFFER_LEN + 1];
+	STLW::string sRetVal = "";
+	UINT_32 iBufferPointer = 0;
+
+	STLW::string::const_iterator itsData = sData.begin();
+	while (itsData != sData.end())
+	{
+		const UCHAR_8 chTMP = (UCHAR_8)(*itsData);
+
+		if (iBufferPointer >= CTPP_ESCAPE_BUFFER_LEN - 6)
+		{
+			sRetVal.append(sBuffer, iBufferPointer);
+			iBufferPointer = 0;
+		}
+
+		CCHAR_P szEscaped = NULL;
+		if (eType == ESCAPE_URL || eType == ESCAPE_URI)
+		{
+			if ((chTMP >= 'a' && chTMP <= 'z') ||
+			    (chTMP >= 'A' && chTMP <= 'Z') ||
+			    (chTMP >= '0' && chTMP <= '9') ||
+			     chTMP == '/' || chTMP == '.' || chTMP == '-' || chTMP == '_') { sBuffer[iBufferPointer++] = chTMP; }
+			else if (chTMP == ' ' && eType == ESCAPE_URL)                     { sBuffer[iBufferPointer++] = '+';   }
+			else
+			{
+				sBuffer[iBufferPointer++] = '%';
+				sBuffer[iBufferPointer++] = szEscape[((chTMP >> 4) & 0x0F)];
+				sBuffer[iBufferPointer++] = szEscape[(chTMP & 0x0F)];
+			}
+		}
+		else if (eType == ESCAPE_HTML || eType == ESCAPE_XML || eType == ESCAPE_WML)
+		{
+			if      (chTMP < ' ' && eType == ESCAPE_WML)  { ;; }
+			else if (chTMP == '"')                        { szEscaped = "&quot;"; }
+			else if (chTMP == '\'')                       { szEscaped = (eType == ESCAPE_HTML) ? "&#39;" : "&apos;"; }
+			else if (chTMP == '<')                        { szEscaped = "&lt;";   }
+			else if (chTMP == '>')                        { szEscaped = "&gt;";   }
+			else if (chTMP == '&')                        { szEscaped = "&amp;";  }
+			else if (chTMP == '$' && eType == ESCAPE_WML) { szEscaped = "$$";     }
+			else                                          { sBuffer[iBufferPointer++] = chTMP; }
+		}
+		else
+		{
+			if      (chTMP == '"')                          { szEscaped = "\\\""; }
+			else if (chTMP == '\\')                         { szEscaped = "\\\\"; }
+			else if (chTMP == '/')                          { szEscaped = "\\/";  }
+			else if (chTMP == '\b')                         { szEscaped = "\\b";  }
+			else if (chTMP == '\f')                         { szEscaped = "\\f";  }
+			else if (chTMP == '\n')                         { szEscaped = "\\n";  }
+			else if (chTMP == '\r')                         { szEscaped = "\\r";  }
+			else if (chTMP == '\t')                         { szEscaped = "\\t";  }
+			else if (chTMP == '\'' && bECMAConventions)     { szEscaped = "\\'";  }
+			else if (chTMP == '\v' && bECMAConventions)     { szEscaped = "\\v";  }
+			else if (chTMP == '\0' && bECMAConventions)     { szEscaped = "\\0";  }
+			else if (chTMP < ' ' || (bHTMLSafe && (chTMP == '<' || chTMP == '>')))
+			{
+				sBuffer[iBufferPointer++] = '\\';
+				sBuffer[iBufferPointer++] = 'u';
+				sBuffer[iBufferPointer++] = '0';
+				sBuffer[iBufferPointer++] = '0';
+				sBuffer[iBufferPointer++] = szJSONHex[chTMP >> 4];
+				sBuffer[iBufferPointer++] = szJSONHex[chTMP & 0x0F];
+			}
+			else { sBuffer[iBufferPointer++] = chTMP; }
+		}
+
+		if (szEscaped != NULL)
+		{
+			while (*szEscaped != '\0') { sBuffer[iBufferPointer++] = *szEscaped++; }
+		}
+		++itsData;
+	}
+
+	if (iBufferPointer != 0) { sRetVal.append(sBuffer, iBufferPointer); }
+
+return sRetVal;
+}
+
+//
+// Collect all strings and keys of document
+//
+static void CollectStrings(const CDT                   & oData,
+                           STLW::vector<STLW::string>  & vStrings)
+{
+	if (oData.GetType() == CDT::STRING_VAL) { vStrings.push_back(oData.GetString()); return; }
+
+	if (oData.GetType() == CDT::ARRAY_VAL)
+	{
+		for (UINT_32 iPos = 0; iPos < oData.Size(); ++iPos) { CollectStrings(oData.GetCDT(iPos), vStrings); }
+	}
+	else if (oData.GetType() == CDT::HASH_VAL)
+	{
+		CDT::ConstIterator itData = oData.Begin();
+		for (; itData != oData.End(); ++itData)
+		{
+			vStrings.push_back(itData -> first);
+			CollectStrings(itData -> second, vStrings);
+		}
+	}
+}
+
+//
+// Strings with every character at every position of short and long runs
+//
+static void SyntheticStrings(STLW::vector<STLW::string>  & vStrings)
+{
+	for (UINT_32 iLength = 1; iLength <= 80; iLength += 13)
+	{
+		for (UINT_32 iChar = 0; iChar < 256; ++iChar)
+		{
+			for (UINT_32 iPos = 0; iPos < iLength; ++iPos)
+			{
+				STLW::string sData(iLength, 'x');
+				sData[iPos] = CHAR_8(iChar);
+				vStrings.push_back(sData);
+			}
+		}
+	}
+
+	STLW::string sAll;
+	for (UINT_32 iChar = 0; iChar < 256; ++iChar) { sAll += CHAR_8(iChar); sAll += "Lorem ipsum"; }
+	vStrings.push_back(sAll);
+}
+
+static const eEscapeType aTypes[] = { ESCAPE_HTML, ESCAPE_XML, ESCAPE_WML, ESCAPE_URL, ESCAPE_URI,
+                                      ESCAPE_JSON, ESCAPE_JSON_ECMA, ESCAPE_JSON_HTML, ESCAPE_JSON_ECMA_HTML };
+
+static CCHAR_P aTypeNames[] = { "HTML", "XML", "WML", "URL", "URI", "JSON", "JSON_ECMA", "JSON_HTML", "JSON_ECMA_HTML" };
+
+static const eEscapeKernel aKernels[] = { ESCAPE_KERNEL_SCALAR, ESCAPE_KERNEL_SSE2, ESCAPE_KERNEL_AVX2 };
+
+static CCHAR_P aKernelNames[] = { "auto", "scalar", "sse2", "avx2" };
+
+//
+// Check that every kernel gives same result as reference implementation
+//
+static INT_32 CheckKernels(const STLW::vector<STLW::string>  & vStrings)
+{
+	INT_32 iRC = EX_OK;
+	for (UINT_32 iKernel = 0; iKernel < sizeof(aKernels) / sizeof(aKernels[0]); ++iKernel)
+	{
+		if (SetEscapeKernel(aKernels[iKernel]) != aKernels[iKernel]) { continue; }
+
+		for (UINT_32 iType = 0; iType < sizeof(aTypes) / sizeof(aTypes[0]); ++iType)
+		{
+			UINT_32 iErrors = 0;
+			STLW::vector<CHAR_8> vBuffer;
+			for (UINT_32 iPos = 0; iPos < vStrings.size(); ++iPos)
+			{
+				const STLW::string & sData = vStrings[iPos];
+				const STLW::string sReference = ReferenceEscape(aTypes[iType], sData);
+
+				STLW::string sResult;
+				Escape(aTypes[iType], sData.data(), sData.size(), sResult);
+
+				vBuffer.resize(sData.size() * C_ESCAPE_MAX_EXPANSION + 1);
+				const UINT_32 iLength = Escape(aTypes[iType], sData.data(), sData.size(), &vBuffer[0]);
+
+				if (sResult != sReference || sReference.compare(0, STLW::string::npos, &vBuffer[0], iLength) != 0) { ++iErrors; }
+			}
+
+			if (iErrors != 0)
+			{
+				fprintf(stderr, "ERROR: %s/%s: %u of %u strings mismatch\n", aKernelNames[aKernels[iKernel]], aTypeNames[iType], iErrors, UINT_32(vStrings.size()));
+				iRC = EX_SOFTWARE;
+			}
+		}
+		fprintf(stdout, "%s: OK\n", aKernelNames[aKernels[iKernel]]);
+	}
+
+return iRC;
+}
+
+//
+// Escape all strings iRuns times, return time in microseconds
+//
+static UINT_64 EscapeStrings(const eEscapeType                   eType,
+                             const STLW::vector<STLW::string>  & vStrings,
+                             const bool                          bReference,
+                             const UINT_32                       iRuns)
+{
+	UINT_64 iTotal = 0;
+	const UINT_64 iStart = GetUSTime();
+	for (UINT_32 iRun = 0; iRun < iRuns; ++iRun)
+	{
+		for (UINT_32 iPos = 0; iPos < vStrings.size(); ++iPos)
+		{
+			if (bReference) { iTotal += ReferenceEscape(eType, vStrings[iPos]).size(); continue; }
+
+			STLW::string sResult;
+			Escape(eType, vStrings[iPos].data(), vStrings[iPos].size(), sResult);
+			iTotal += sResult.size();
+		}
+	}
+	const UINT_64 iTime = GetUSTime() - iStart;
+
+	// Do not let compiler to throw result away
+	if (iTotal == 0) { fprintf(stderr, "Empty corpus\n"); }
+
+return iTime;
+}
+
+//
+// Usage
+//
+static void Usage(CCHAR_P szName)
+{
+	fprintf(stderr, "usage: %s -[t|b] data.json [data2.json ...]\n"
+	                "\t -t - check that all escape kernels give same result as reference implementation\n"
+	                "\t -b - compare speed of reference implementation and escape kernels on strings of documents\n", szName);
+}
+
+// Escape kernels benchmark
+int main(int argc, char ** argv)
+{
+	if (argc < 3 || argv[1][0] != '-' || (argv[1][1] != 't' && argv[1][1] != 'b'))
+	{
+		Usage(argv[0]);
+		return EX_USAGE;
+	}
+
+	const bool bBenchmark = (argv[1][1] == 'b');
+
+	// Realistic corpus: strings and keys of documents, and documents as a whole
+	STLW::vector<STLW::string> vStrings;
+	UINT_64 iCorpusSize = 0;
+	for (INT_32 iPos = 2; iPos < argc; ++iPos)
+	{
+		FILE * F = fopen(argv[iPos], "r");
+		if (F == NULL)
+		{
+			fprintf(stderr, "ERROR: Cannot open file `%s` for reading\n", argv[iPos]);
+			return EX_NOINPUT;
+		}
+
+		STLW::string sJSON;
+		CHAR_8 szBuffer[8192];
+		for (;;)
+		{
+			const size_t iRead = fread(szBuffer, 1, sizeof(szBuffer), F);
+			if (iRead == 0) { break; }
+			sJSON.append(szBuffer, iRead);
+		}
+		fclose(F);
+
+		CDT oData;
+		CTPP2JSONParser oJSONParser(oData);
+		oJSONParser.Parse(sJSON.data(), sJSON.data() + sJSON.size());
+
+		CollectStrings(oData, vStrings);
+		vStrings.push_back(sJSON);
+	}
+	for (UINT_32 iPos = 0; iPos < vStrings.size(); ++iPos) { iCorpusSize += vStrings[iPos].size(); }
+
+	if (!bBenchmark)
+	{
+		SyntheticStrings(vStrings);
+		return CheckKernels(vStrings);
+	}
+
+	const UINT_32 iRuns = 200;
+	for (UINT_32 iType = 0; iType < sizeof(aTypes) / sizeof(aTypes[0]); ++iType)
+	{
+		const UINT_64 iReferenceTime = EscapeStrings(aTypes[iType], vStrings, true, iRuns);
+		fprintf(stdout, "%-16s reference: %8.2f MB/s", aTypeNames[iType], 1.0 * iCorpusSize * iRuns / (iReferenceTime + 1));
+
+		for (UINT_32 iKernel = 0; iKernel < sizeof(aKernels) / sizeof(aKernels[0]); ++iKernel)
+		{
+			if (SetEscapeKernel(aKernels[iKernel]) != aKernels[iKernel]) { continue; }
+
+			const UINT_64 iTime = EscapeStrings(aTypes[iType], vStrings, false, iRuns);
+			fprintf(stdout, ", %s: %8.2f MB/s", aKernelNames[aKernels[iKernel]], 1.0 * iCorpusSize * iRuns / (iTime + 1));
+		}
+		fprintf(stdout, "\n");
+	}
+
+return EX_OK;
+}
+// End.
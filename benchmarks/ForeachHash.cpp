@@ -0,0 +1,146 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      ForeachHash.cpp
+ *
+ * $CTPP$
+ */
+#include <CDT.hpp>
+#include <CTPP2FileLogger.hpp>
+#include <CTPP2SimpleCompiler.hpp>
+#include <CTPP2SimpleVM.hpp>
+
+#include <stdio.h>
+#include <sys/time.h>
+
+#ifdef HAVE_SYSEXITS_H
+#include <sysexits.h>
+#endif
+
+using namespace CTPP;
+
+//
+// Get current time, microseconds
+//
+static UINT_64 GetUSTime()
+{
+	struct timeval oTV;
+	gettimeofday(&oTV, NULL);
+
+return UINT_64(oTV.tv_sec) * 1000000 + oTV.tv_usec;
+}
+
+//
+// Create hash with iKeys elements and expected output of template
+//
+static void CreateData(const UINT_32 iKeys, CDT & oData, std::string & sExpected)
+{
+	CDT oHash(CDT::HASH_VAL);
+	for (UINT_32 iI = 0; iI < iKeys; ++iI)
+	{
+		CHAR_8 szKey[32];
+		snprintf(szKey, 32, "key%08u", iI);
+		oHash[szKey] = iI;
+	}
+
+	CDT::ConstIterator itHash = static_cast<const CDT &>(oHash).Begin();
+	while (itHash != static_cast<const CDT &>(oHash).End())
+	{
+		sExpected.append(itHash -> first);
+		sExpected.append("=");
+		sExpected.append(itHash -> second.GetString());
+		sExpected.append("\n");
+		++itHash;
+	}
+
+	oData["hash"] = oHash;
+}
+
+//
+// Usage
+//
+static void Usage(CCHAR_P szName)
+{
+	fprintf(stderr, "usage: %s -[t|b] foreach-hash.tmpl\n"
+	                "\t -t - check output of foreach over HASH\n"
+	                "\t -b - render 10, 1000 and 100000-key hashes\n", szName);
+}
+
+// foreach over HASH benchmark
+int main(int argc, char ** argv)
+{
+	if (argc != 3 || argv[1][0] != '-' || (argv[1][1] != 't' && argv[1][1] != 'b'))
+	{
+		Usage(argv[0]);
+		return EX_USAGE;
+	}
+
+	const bool bBenchmark = (argv[1][1] == 'b');
+
+	SimpleCompiler oCompiler(argv[2]);
+	SimpleVM       oSimpleVM(1024, 4096, 4096, 0xFFFFFFFF);
+	FileLogger     oLogger(stderr);
+
+	// Number of keys and number of runs
+	static const UINT_32 aKeys[] = { 10, 1000, 100000 };
+	static const UINT_32 aRuns[] = { 100000, 1000, 10 };
+
+	for (UINT_32 iTest = 0; iTest < sizeof(aKeys) / sizeof(aKeys[0]); ++iTest)
+	{
+		CDT         oData;
+		std::string sExpected;
+		CreateData(aKeys[iTest], oData, sExpected);
+
+		std::string sResult;
+		oSimpleVM.Run(oData, oCompiler.GetCore(), sResult, oLogger);
+		if (sResult != sExpected)
+		{
+			fprintf(stderr, "ERROR: output mismatch for %u-key hash\n", aKeys[iTest]);
+			return EX_SOFTWARE;
+		}
+
+		if (!bBenchmark) { continue; }
+
+		const UINT_64 iStart = GetUSTime();
+		for (UINT_32 iRun = 0; iRun < aRuns[iTest]; ++iRun)
+		{
+			sResult.erase();
+			oSimpleVM.Run(oData, oCompiler.GetCore(), sResult, oLogger);
+		}
+		const UINT_64 iTime = GetUSTime() - iStart;
+
+		fprintf(stdout, "%6u keys: %6u runs in %10llu microsecs, %12.3f microsecs/run, %10.3f nanosecs/key\n",
+		                aKeys[iTest],
+		                aRuns[iTest],
+		                (unsigned long long)iTime,
+		                1.0 * iTime / aRuns[iTest],
+		                1000.0 * iTime / aRuns[iTest] / aKeys[iTest]);
+	}
+
+return EX_OK;
+}
+// End.
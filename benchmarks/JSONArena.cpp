@@ -0,0 +1,188 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *
+ *      JSONArena.cpp
+ *
+ * $CTPP$
+ */
+#include <CDT.hpp>
+#include <CDTArena.hpp>
+#include <CTPP2JSONParser.hpp>
+#include <CTPP2Util.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#ifdef HAVE_SYSEXITS_H
+#include <sysexits.h>
+#endif
+
+using namespace CTPP;
+
+//
+// Get current time, microseconds
+//
+static UINT_64 GetUSTime()
+{
+	struct timeval oTV;
+	gettimeofday(&oTV, NULL);
+
+return UINT_64(oTV.tv_sec) * 1000000 + oTV.tv_usec;
+}
+
+//
+// Parse and destroy document iRuns times, return time in microseconds
+//
+static UINT_64 ParseDocument(const STLW::string  & sJSON,
+                             CDTArena            * pArena,
+                             const UINT_32         iRuns,
+                             STLW::string        & sResult,
+                             CDT                 & oCopy,
+                             bool                & bForeign)
+{
+	const UINT_64 iStart = GetUSTime();
+	for (UINT_32 iRun = 0; iRun < iRuns; ++iRun)
+	{
+		{
+			CDT oData;
+			CTPP2JSONParser oJSONParser(oData, pArena);
+			oJSONParser.Parse(sJSON.data(), sJSON.data() + sJSON.size());
+
+			if (iRun == 0)
+			{
+				CDT2JSON(oData, sResult);
+
+				// Modified copy is moved out of arena
+				oCopy = oData;
+				oCopy.MergeCDT(CDT());
+			}
+		}
+
+		// Document in arena should be released without walk
+		if (pArena != NULL && pArena -> IsForeign()) { bForeign = true; }
+
+		// Whole document is released at once
+		if (pArena != NULL) { pArena -> Release(); }
+	}
+
+return GetUSTime() - iStart;
+}
+
+//
+// Usage
+//
+static void Usage(CCHAR_P szName)
+{
+	fprintf(stderr, "usage: %s -[t|b] data.json [data2.json ...]\n"
+	                "\t -t - check that documents parsed into heap and into arena are equal\n"
+	                "\t -b - compare parse+destroy time of heap and arena\n", szName);
+}
+
+// Arena allocation benchmark
+int main(int argc, char ** argv)
+{
+	if (argc < 3 || argv[1][0] != '-' || (argv[1][1] != 't' && argv[1][1] != 'b'))
+	{
+		Usage(argv[0]);
+		return EX_USAGE;
+	}
+
+	const bool    bBenchmark = (argv[1][1] == 'b');
+	const UINT_32 iRuns      = bBenchmark ? 2000 : 1;
+
+	INT_32 iRC = EX_OK;
+	CDTArena oArena;
+	for (INT_32 iPos = 2; iPos < argc; ++iPos)
+	{
+		FILE * F = fopen(argv[iPos], "r");
+		if (F == NULL)
+		{
+			fprintf(stderr, "ERROR: Cannot open file `%s` for reading\n", argv[iPos]);
+			return EX_NOINPUT;
+		}
+
+		STLW::string sJSON;
+		CHAR_8 szBuffer[8192];
+		for (;;)
+		{
+			const size_t iRead = fread(szBuffer, 1, sizeof(szBuffer), F);
+			if (iRead == 0) { break; }
+			sJSON.append(szBuffer, iRead);
+		}
+		fclose(F);
+
+		STLW::string sHeapResult;
+		STLW::string sArenaResult;
+		CDT          oHeapCopy;
+		CDT          oArenaCopy;
+		bool         bForeign = false;
+		const UINT_64 iHeapTime  = ParseDocument(sJSON, NULL,    iRuns, sHeapResult,  oHeapCopy,  bForeign);
+		const UINT_64 iArenaTime = ParseDocument(sJSON, &oArena, iRuns, sArenaResult, oArenaCopy, bForeign);
+
+		if (sHeapResult != sArenaResult)
+		{
+			fprintf(stderr, "ERROR: %s: heap and arena documents mismatch\n", argv[iPos]);
+			iRC = EX_SOFTWARE;
+			continue;
+		}
+
+		if (bForeign)
+		{
+			fprintf(stderr, "ERROR: %s: document in arena is destroyed by walk\n", argv[iPos]);
+			iRC = EX_SOFTWARE;
+			continue;
+		}
+
+		// Arena is released already
+		STLW::string sCopyResult;
+		CDT2JSON(oArenaCopy, sCopyResult);
+		if (sHeapResult != sCopyResult)
+		{
+			fprintf(stderr, "ERROR: %s: copy of document does not outlive arena\n", argv[iPos]);
+			iRC = EX_SOFTWARE;
+			continue;
+		}
+
+		if (!bBenchmark) { continue; }
+
+		CCHAR_P szName = strrchr(argv[iPos], '/');
+		szName = (szName == NULL) ? argv[iPos] : szName + 1;
+
+		fprintf(stdout, "%-32s heap: %8.2f us/doc, arena: %8.2f us/doc, speedup %6.2f%%\n",
+		                szName,
+		                1.0 * iHeapTime / iRuns,
+		                1.0 * iArenaTime / iRuns,
+		                100.0 * iHeapTime / (iArenaTime + 1) - 100.0);
+	}
+
+return iRC;
+}
+// End.
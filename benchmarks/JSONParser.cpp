@@ -0,0 +1,502 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      JSONParser.cpp
+ *
+ * $CTPP$
+ */
+#include <CDT.hpp>
+#include <CTPP2Escape.hpp>
+#include <CTPP2JSONFastParser.hpp>
+#include <CTPP2JSONFileParser.hpp>
+#include <CTPP2JSONMappedFile.hpp>
+#include <CTPP2JSONParser.hpp>
+#include <CTPP2JSONStreamParser.hpp>
+#include <CTPP2ParserException.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#ifdef HAVE_SYSEXITS_H
+#include <sysexits.h>
+#endif
+
+using namespace CTPP;
+
+//
+// Get current time, microseconds
+//
+static UINT_64 GetUSTime()
+{
+	struct timeval oTV;
+	gettimeofday(&oTV, NULL);
+
+return UINT_64(oTV.tv_sec) * 1000000 + oTV.tv_usec;
+}
+
+//
+// Compare documents, types of values included
+//
+static bool Equal(const CDT  & oLeft,
+                  const CDT  & oRight)
+{
+	if (oLeft.GetType() != oRight.GetType()) { return false; }
+
+	switch (oLeft.GetType())
+	{
+		case CDT::UNDEF:
+			return true;
+
+		case CDT::INT_VAL:
+			return oLeft.GetInt() == oRight.GetInt();
+
+		case CDT::REAL_VAL:
+			return oLeft.GetFloat() == oRight.GetFloat();
+
+		case CDT::ARRAY_VAL:
+			if (oLeft.Size() != oRight.Size()) { return false; }
+			for (UINT_32 iPos = 0; iPos < oLeft.Size(); ++iPos)
+			{
+				if (!Equal(oLeft.GetCDT(iPos), oRight.GetCDT(iPos))) { return false; }
+			}
+			return true;
+
+		case CDT::HASH_VAL:
+			{
+				if (oLeft.Size() != oRight.Size()) { return false; }
+				CDT::ConstIterator itLeft = oLeft.Begin();
+				for (; itLeft != oLeft.End(); ++itLeft)
+				{
+					bool bExists = false;
+					const CDT & oValue = oRight.GetExistedCDT(itLeft -> first, bExists);
+					if (!bExists || !Equal(itLeft -> second, oValue)) { return false; }
+				}
+			}
+			return true;
+
+		default:
+			;;
+	}
+
+return oLeft.GetString() == oRight.GetString();
+}
+
+//
+// Parse document, result is printable
+//
+static STLW::string ParseDocument(const STLW::string                  & sJSON,
+                                  const CTPP2JSONParser::eParserMode    eMode,
+                                  CDT                                 & oData)
+{
+	CTPP2JSONParser oJSONParser(oData, NULL, eMode);
+	try
+	{
+		oJSONParser.Parse(sJSON.data(), sJSON.data() + sJSON.size());
+	}
+	catch(CTPPParserSyntaxError & e)
+	{
+		CHAR_8 szError[1024];
+		snprintf(szError, sizeof(szError), "error at line %u, pos. %u: %s", e.GetLine(), e.GetLinePos(), e.what());
+		return szError;
+	}
+
+return "ok";
+}
+
+//
+// Parse document in chunks of iChunkSize bytes, result is printable
+//
+static STLW::string StreamDocument(const STLW::string  & sJSON,
+                                   const UINT_32         iChunkSize,
+                                   CDT                 & oData)
+{
+	CTPP2JSONStreamParser oStreamParser(oData);
+	try
+	{
+		for (UINT_32 iPos = 0; iPos < sJSON.size(); iPos += iChunkSize)
+		{
+			const UINT_32 iLength = (sJSON.size() - iPos < iChunkSize) ? sJSON.size() - iPos : iChunkSize;
+			// Chunk is copied to make sure that parser does not use data after return
+			const STLW::string sChunk(sJSON, iPos, iLength);
+			oStreamParser.Feed(sChunk.data(), iLength);
+		}
+		oStreamParser.Finish();
+	}
+	catch(CTPPParserSyntaxError & e)
+	{
+		CHAR_8 szError[1024];
+		snprintf(szError, sizeof(szError), "error at line %u, pos. %u: %s", e.GetLine(), e.GetLinePos(), e.what());
+		return szError;
+	}
+
+return "ok";
+}
+
+/** Edge cases of syntax accepted by character parser */
+static CCHAR_P aSnippets[] = { "{\"a\":1,\"b\":[1,2,3],\"c\":{\"d\":\"e\"}}",
+                               " [1, -2, +3, 010, 09, 0, -0, 1.5, -0.5e3, 1.e5, 2.5E-3, -., -, 123456789012345678, 12345678901234567890] ",
+                               "[1e5]", "[1.5e]", "[1.5e+]", "[1-2]", "[1 2]", "[1,\f2]",
+                               "{\"a\":\"x\\u0041\\u00e9\\u20ac\\n\\t\\/\\q\\a\\b\\f\\v\\r\\\\\\\"\"}",
+                               "{\"a\":\"\\u00E9\"}", "{\"a\":\"\\u00\"}", "[\"a\\\"b\"]", "[\"unterminated]", "[\"a\\",
+                               "[null, NULL, True, false, FALSE]", "[nul]", "[nullx]", "[null1]", "true", "true\n", "null ",
+                               "123", "\"string\"", "-", "",  "   ", "\t\r\n",
+                               "{'a': 'b'}", "[\"it's\"]", "// comment\n{\"a\":1}", "{\"a\":1} /* comment */", "[\"http://x/y\"]",
+                               "{\"a\":1,}", "[1,]", "[,]", "[]", "{}", "[[],{},[[]],{\"a\":{}}]", "{\"a\":[1,2}", "[1,2}", "]", "{",
+                               "{1:2, 1.5:\"x\", -3:4, +1e:5}", "{1:2, 1.5:\"x\", -3:4}", "{a:1}", "{\"a\" 1}", "{\"a\":}", "{\"a\":1 \"b\":2}",
+                               "{\"a\":1,\"a\":[2],\"b\":{},\"b\":\"c\"}", "{\"a\":1}garbage", "{\"a\":1}   ", "[\"\xD0\xB0\xD0\xB1\"]", "[\xD0\xB0]",
+                               "[\"a\"1]", "[\"a\"\"b\"]", "[1\"a\"]", "[true\"a\"]", "[\\\"a\"]", "\\", "\"\\u0000\"",
+                               NULL };
+
+//
+// Long documents: escape sequences at every position of block
+//
+static void SyntheticDocuments(STLW::vector<STLW::string>  & vDocuments)
+{
+	for (UINT_32 iSnippet = 0; aSnippets[iSnippet] != NULL; ++iSnippet) { vDocuments.push_back(aSnippets[iSnippet]); }
+
+	for (UINT_32 iLength = 0; iLength < 140; ++iLength)
+	{
+		const STLW::string sPadding(iLength, 'x');
+		vDocuments.push_back("[\"" + sPadding + "\\\"\", \"\\\\\", \"" + sPadding + "\\\\\\\\\\\"\"]");
+		vDocuments.push_back("{\"" + sPadding + "\":\"\\\\\", \"k\":[" + sPadding.substr(0, iLength % 3) + "1, true, null]}");
+		vDocuments.push_back("[\"" + sPadding + "\\\\\"]");
+		vDocuments.push_back("[\"" + sPadding + "\"]");
+		vDocuments.push_back("[\"" + sPadding + "\\\"]");
+		vDocuments.push_back("[\"" + sPadding + "\", 12" + sPadding.substr(0, iLength % 7) + "]");
+		vDocuments.push_back(STLW::string(iLength, ' ') + "[1,2,3.5]" + STLW::string(iLength % 5, '\n'));
+	}
+}
+
+static const eEscapeKernel aKernels[] = { ESCAPE_KERNEL_SCALAR, ESCAPE_KERNEL_SSE2, ESCAPE_KERNEL_AVX2 };
+
+static CCHAR_P aKernelNames[] = { "auto", "scalar", "sse2", "avx2" };
+
+//
+// Check that fast mode gives same result as character parser
+//
+static INT_32 CheckDocuments(const STLW::vector<STLW::string>  & vDocuments,
+                             const UINT_32                       iFiles)
+{
+	INT_32 iRC = EX_OK;
+	for (UINT_32 iKernel = 0; iKernel < sizeof(aKernels) / sizeof(aKernels[0]); ++iKernel)
+	{
+		if (SetEscapeKernel(aKernels[iKernel]) != aKernels[iKernel]) { continue; }
+
+		UINT_32 iErrors = 0;
+		for (UINT_32 iPos = 0; iPos < vDocuments.size(); ++iPos)
+		{
+			const STLW::string & sJSON = vDocuments[iPos];
+
+			CDT oCompat;
+			CDT oFast;
+			const STLW::string sCompat = ParseDocument(sJSON, CTPP2JSONParser::COMPAT_MODE, oCompat);
+			const STLW::string sFast   = ParseDocument(sJSON, CTPP2JSONParser::FAST_MODE,   oFast);
+
+			bool bEqual = (sCompat == sFast) && (sCompat != "ok" || Equal(oCompat, oFast));
+
+			// Data files must not need fallback to character parser
+			if (iPos < iFiles)
+			{
+				CDT oData;
+				CTPP2JSONFastParser oFastParser(oData);
+				bEqual = bEqual && oFastParser.Parse(sJSON.data(), sJSON.data() + sJSON.size()) == 0 && Equal(oCompat, oData);
+			}
+
+			if (!bEqual)
+			{
+				fprintf(stderr, "ERROR: %s: document #%u `%.64s`: `%s` != `%s`\n", aKernelNames[aKernels[iKernel]], iPos, sJSON.c_str(), sCompat.c_str(), sFast.c_str());
+				++iErrors;
+			}
+		}
+
+		if (iErrors != 0) { iRC = EX_SOFTWARE; }
+		fprintf(stdout, "%s: %u of %u documents mismatch\n", aKernelNames[aKernels[iKernel]], iErrors, UINT_32(vDocuments.size()));
+	}
+
+return iRC;
+}
+
+/** Chunk sizes for stream parser, 0 - whole document */
+static const UINT_32 aChunkSizes[] = { 0, 1, 2, 3, 7, 64, 4096 };
+
+//
+// Check that stream parser gives same result as character parser for any chunk size
+//
+static INT_32 CheckStream(const STLW::vector<STLW::string>  & vDocuments)
+{
+	UINT_32 iErrors = 0;
+	for (UINT_32 iPos = 0; iPos < vDocuments.size(); ++iPos)
+	{
+		const STLW::string & sJSON = vDocuments[iPos];
+
+		CDT oCompat;
+		const STLW::string sCompat = ParseDocument(sJSON, CTPP2JSONParser::COMPAT_MODE, oCompat);
+
+		STLW::string sWhole;
+		for (UINT_32 iChunk = 0; iChunk < sizeof(aChunkSizes) / sizeof(aChunkSizes[0]); ++iChunk)
+		{
+			const UINT_32 iChunkSize = aChunkSizes[iChunk] == 0 ? sJSON.size() + 1 : aChunkSizes[iChunk];
+
+			CDT oStream;
+			const STLW::string sStream = StreamDocument(sJSON, iChunkSize, oStream);
+			if (iChunk == 0) { sWhole = sStream; }
+
+			// Position of error may differ from character parser, but not between chunk sizes
+			const bool bEqual = (sCompat == "ok") == (sStream == "ok") &&
+			                    (sCompat != "ok" || Equal(oCompat, oStream)) &&
+			                    sStream == sWhole;
+			if (!bEqual)
+			{
+				fprintf(stderr, "ERROR: stream, chunk %u: document #%u `%.64s`: `%s` != `%s`\n", aChunkSizes[iChunk], iPos, sJSON.c_str(), sCompat.c_str(), sStream.c_str());
+				++iErrors;
+			}
+		}
+	}
+	fprintf(stdout, "stream: %u of %u documents mismatch\n", iErrors, UINT_32(vDocuments.size()));
+
+return iErrors == 0 ? EX_OK : EX_SOFTWARE;
+}
+
+//
+// Count strings referring to mapped file
+//
+static UINT_32 CountViews(const CDT                  & oData,
+                          const CTPP2JSONMappedFile  & oMappedFile)
+{
+	UINT_32 iViews = 0;
+	switch (oData.GetType())
+	{
+		case CDT::STRING_VAL:
+			{
+				UINT_32 iLength = 0;
+				CCHAR_P szString = oData.GetStringData(iLength);
+				if (szString >= oMappedFile.GetData() && szString < oMappedFile.GetData() + oMappedFile.GetSize()) { ++iViews; }
+			}
+			break;
+
+		case CDT::ARRAY_VAL:
+			for (UINT_32 iPos = 0; iPos < oData.Size(); ++iPos) { iViews += CountViews(oData.GetCDT(iPos), oMappedFile); }
+			break;
+
+		case CDT::HASH_VAL:
+			{
+				CDT::ConstIterator itData = oData.Begin();
+				for (; itData != oData.End(); ++itData) { iViews += CountViews(itData -> second, oMappedFile); }
+			}
+			break;
+
+		default:
+			;;
+	}
+
+return iViews;
+}
+
+//
+// Check that mapped file gives same result as character parser
+//
+static INT_32 CheckMapped(const STLW::vector<STLW::string>  & vDocuments,
+                          char                             ** aFiles)
+{
+	static const CTPP2JSONParser::eParserMode aModes[] = { CTPP2JSONParser::COMPAT_MODE, CTPP2JSONParser::FAST_MODE };
+	static CCHAR_P aModeNames[] = { "compat", "fast" };
+
+	INT_32 iRC = EX_OK;
+	for (UINT_32 iPos = 0; iPos < vDocuments.size(); ++iPos)
+	{
+		CDT oCompat;
+		const STLW::string sCompat = ParseDocument(vDocuments[iPos], CTPP2JSONParser::COMPAT_MODE, oCompat);
+
+		for (UINT_32 iMode = 0; iMode < sizeof(aModes) / sizeof(aModes[0]); ++iMode)
+		{
+			CTPP2JSONMappedFile oMappedFile;
+			CDT oMapped;
+			CTPP2JSONFileParser oFileParser(oMapped, NULL, aModes[iMode], &oMappedFile);
+			oFileParser.Parse(aFiles[iPos]);
+
+			bool bEqual = sCompat == "ok" && Equal(oCompat, oMapped);
+			fprintf(stdout, "%s, %s: %s, %u strings refer to file\n", aFiles[iPos], aModeNames[iMode], bEqual ? "ok" : "mismatch", CountViews(oMapped, oMappedFile));
+
+			// Strings keep file mapped after it is released
+			CDT oCopy = oMapped;
+			oMappedFile.Release();
+			oMapped = CDT();
+			bEqual = bEqual && Equal(oCompat, oCopy);
+			fprintf(stdout, "%s, %s: %s after file is released\n", aFiles[iPos], aModeNames[iMode], bEqual ? "ok" : "mismatch");
+			if (!bEqual) { iRC = EX_SOFTWARE; }
+		}
+	}
+
+return iRC;
+}
+
+//
+// Parse document iRuns times, return time in microseconds
+//
+static UINT_64 ParseDocument(const STLW::string                  & sJSON,
+                             const CTPP2JSONParser::eParserMode    eMode,
+                             const UINT_32                         iRuns)
+{
+	const UINT_64 iStart = GetUSTime();
+	for (UINT_32 iRun = 0; iRun < iRuns; ++iRun)
+	{
+		CDT oData;
+		CTPP2JSONParser oJSONParser(oData, NULL, eMode);
+		oJSONParser.Parse(sJSON.data(), sJSON.data() + sJSON.size());
+	}
+
+return GetUSTime() - iStart;
+}
+
+//
+// Parse document iRuns times in chunks of iChunkSize bytes, return time in microseconds
+//
+static UINT_64 StreamDocument(const STLW::string  & sJSON,
+                              const UINT_32         iChunkSize,
+                              const UINT_32         iRuns)
+{
+	const UINT_64 iStart = GetUSTime();
+	for (UINT_32 iRun = 0; iRun < iRuns; ++iRun)
+	{
+		CDT oData;
+		CTPP2JSONStreamParser oStreamParser(oData);
+		for (UINT_32 iPos = 0; iPos < sJSON.size(); iPos += iChunkSize)
+		{
+			oStreamParser.Feed(sJSON.data() + iPos, (sJSON.size() - iPos < iChunkSize) ? sJSON.size() - iPos : iChunkSize);
+		}
+		oStreamParser.Finish();
+	}
+
+return GetUSTime() - iStart;
+}
+
+//
+// Map and parse file iRuns times, return time in microseconds
+//
+static UINT_64 ParseMapped(CCHAR_P        szFileName,
+                           const UINT_32  iRuns)
+{
+	const UINT_64 iStart = GetUSTime();
+	for (UINT_32 iRun = 0; iRun < iRuns; ++iRun)
+	{
+		CTPP2JSONMappedFile oMappedFile;
+		CDT oData;
+		CTPP2JSONFileParser oFileParser(oData, NULL, CTPP2JSONParser::FAST_MODE, &oMappedFile);
+		oFileParser.Parse(szFileName);
+	}
+
+return GetUSTime() - iStart;
+}
+
+//
+// Usage
+//
+static void Usage(CCHAR_P szName)
+{
+	fprintf(stderr, "usage: %s -[t|m|b] data.json [data2.json ...]\n"
+	                "\t -t - check that fast mode and stream parser give same result as character parser\n"
+	                "\t -m - check that memory-mapped file gives same result as character parser\n"
+	                "\t -b - compare speed of character parser, fast mode, stream parser and mapped file\n", szName);
+}
+
+// JSON parser benchmark
+int main(int argc, char ** argv)
+{
+	if (argc < 3 || argv[1][0] != '-' || (argv[1][1] != 't' && argv[1][1] != 'm' && argv[1][1] != 'b'))
+	{
+		Usage(argv[0]);
+		return EX_USAGE;
+	}
+
+	const bool bBenchmark = (argv[1][1] == 'b');
+
+	STLW::vector<STLW::string> vDocuments;
+	for (INT_32 iPos = 2; iPos < argc; ++iPos)
+	{
+		FILE * F = fopen(argv[iPos], "r");
+		if (F == NULL)
+		{
+			fprintf(stderr, "ERROR: Cannot open file `%s` for reading\n", argv[iPos]);
+			return EX_NOINPUT;
+		}
+
+		STLW::string sJSON;
+		CHAR_8 szBuffer[8192];
+		for (;;)
+		{
+			const size_t iRead = fread(szBuffer, 1, sizeof(szBuffer), F);
+			if (iRead == 0) { break; }
+			sJSON.append(szBuffer, iRead);
+		}
+		fclose(F);
+
+		vDocuments.push_back(sJSON);
+	}
+
+	if (argv[1][1] == 'm') { return CheckMapped(vDocuments, argv + 2); }
+
+	if (!bBenchmark)
+	{
+		const UINT_32 iFiles = UINT_32(vDocuments.size());
+		SyntheticDocuments(vDocuments);
+		const INT_32 iRC = CheckDocuments(vDocuments, iFiles);
+		return CheckStream(vDocuments) == EX_OK ? iRC : EX_SOFTWARE;
+	}
+
+	for (INT_32 iPos = 2; iPos < argc; ++iPos)
+	{
+		const STLW::string & sJSON = vDocuments[iPos - 2];
+		// About 100 MB of data per measurement
+		const UINT_32 iRuns = 1 + 100000000 / (sJSON.size() + 1);
+
+		CCHAR_P szName = strrchr(argv[iPos], '/');
+		szName = (szName == NULL) ? argv[iPos] : szName + 1;
+
+		const UINT_64 iCompatTime = ParseDocument(sJSON, CTPP2JSONParser::COMPAT_MODE, iRuns);
+		fprintf(stdout, "%-24s compat: %8.2f MB/s", szName, 1.0 * sJSON.size() * iRuns / (iCompatTime + 1));
+
+		for (UINT_32 iKernel = 0; iKernel < sizeof(aKernels) / sizeof(aKernels[0]); ++iKernel)
+		{
+			if (SetEscapeKernel(aKernels[iKernel]) != aKernels[iKernel]) { continue; }
+
+			const UINT_64 iFastTime = ParseDocument(sJSON, CTPP2JSONParser::FAST_MODE, iRuns);
+			fprintf(stdout, ", %s: %8.2f MB/s", aKernelNames[aKernels[iKernel]], 1.0 * sJSON.size() * iRuns / (iFastTime + 1));
+		}
+		SetEscapeKernel(ESCAPE_KERNEL_AUTO);
+
+		const UINT_64 iStreamTime = StreamDocument(sJSON, 65536, iRuns);
+		fprintf(stdout, ", stream: %8.2f MB/s", 1.0 * sJSON.size() * iRuns / (iStreamTime + 1));
+
+		const UINT_64 iMappedTime = ParseMapped(argv[iPos], iRuns);
+		fprintf(stdout, ", mapped: %8.2f MB/s\n", 1.0 * sJSON.size() * iRuns / (iMappedTime + 1));
+	}
+
+return EX_OK;
+}
+// End.
@@ -0,0 +1,362 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      TemplateCache.cpp
+ *
+ * $CTPP$
+ */
+#include <CDT.hpp>
+#include <CTPP2FileLogger.hpp>
+#include <CTPP2StringOutputCollector.hpp>
+#include <CTPP2SyscallFactory.hpp>
+#include <CTPP2TemplateCache.hpp>
+#include <CTPP2VM.hpp>
+#include <CTPP2VMSTDLib.hpp>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifdef HAVE_SYSEXITS_H
+#include <sysexits.h>
+#endif
+
+using namespace CTPP;
+
+/** Template of reload test         */
+#define C_TEST_TEMPLATE    "TemplateCacheTest.tmpl"
+
+/** Number of versions of template  */
+#define C_TEST_VERSIONS    20
+
+/** Number of threads in test       */
+#define C_TEST_THREADS     4
+
+/** Maximal number of threads       */
+#define C_MAX_THREADS      64
+
+/** Number of lookups per benchmark */
+#define C_BENCH_LOOKUPS    4000000
+
+//
+// Get current time, microseconds
+//
+static UINT_64 GetUSTime()
+{
+	struct timeval oTV;
+	gettimeofday(&oTV, NULL);
+
+return UINT_64(oTV.tv_sec) * 1000000 + oTV.tv_usec;
+}
+
+//
+// Write template source; rename() replaces file atomically
+//
+static void WriteSource(CCHAR_P szSource)
+{
+	FILE * F = fopen(C_TEST_TEMPLATE ".new", "w");
+	if (F == NULL) { perror("fopen"); exit(EX_CANTCREAT); }
+
+	fputs(szSource, F);
+	fclose(F);
+
+	if (rename(C_TEST_TEMPLATE ".new", C_TEST_TEMPLATE) == -1) { perror("rename"); exit(EX_CANTCREAT); }
+}
+
+//
+// Write new version of template
+//
+static void WriteTemplate(const INT_32 iVersion)
+{
+	CHAR_8 szSource[64];
+	snprintf(szSource, sizeof(szSource), "version %d", iVersion);
+	WriteSource(szSource);
+}
+
+// Context of test thread
+struct TestContext
+{
+	// Template cache
+	TemplateCache    * cache;
+	// Stop flag
+	bool               stop;
+	// Number of errors
+	INT_32             errors;
+	// Number of renders
+	INT_32             renders;
+};
+
+//
+// Render template until stop, check that versions never go back
+//
+static void * TestThread(void * vContext)
+{
+	TestContext * pContext = static_cast<TestContext *>(vContext);
+
+	SyscallFactory oSyscalls(1024);
+	STDLibInitializer::InitLibrary(oSyscalls);
+	{
+		VM         oVM(&oSyscalls);
+		FileLogger oLogger(stderr);
+		CDT        oData;
+
+		INT_32 iLastVersion = 0;
+		while (!__atomic_load_n(&(pContext -> stop), __ATOMIC_ACQUIRE))
+		{
+			STLW::string sResult;
+			StringOutputCollector oOutputCollector(sResult);
+
+			TemplateCache::Handle oHandle = pContext -> cache -> Get(C_TEST_TEMPLATE);
+
+			UINT_32 iIP = 0;
+			oVM.Init(oHandle.GetCore(), &oOutputCollector, &oLogger);
+			oVM.Run(oHandle.GetCore(), &oOutputCollector, iIP, oData, &oLogger);
+
+			INT_32 iVersion = -1;
+			if (sscanf(sResult.c_str(), "version %d", &iVersion) != 1 || iVersion < iLastVersion)
+			{
+				fprintf(stderr, "ERROR: unexpected output `%s` after version %d\n", sResult.c_str(), iLastVersion);
+				__atomic_fetch_add(&(pContext -> errors), 1, __ATOMIC_RELAXED);
+			}
+			iLastVersion = iVersion;
+			__atomic_fetch_add(&(pContext -> renders), 1, __ATOMIC_RELAXED);
+		}
+	}
+	STDLibInitializer::DestroyLibrary(oSyscalls);
+
+return NULL;
+}
+
+//
+// Reload templates while threads render them
+//
+static INT_32 ReloadTest()
+{
+	WriteTemplate(0);
+
+	TestContext oContext;
+	TemplateCache oCache;
+	oContext.cache   = &oCache;
+	oContext.stop    = false;
+	oContext.errors  = 0;
+	oContext.renders = 0;
+
+	pthread_t aThreads[C_TEST_THREADS];
+	for (INT_32 iPos = 0; iPos < C_TEST_THREADS; ++iPos) { pthread_create(&aThreads[iPos], NULL, TestThread, &oContext); }
+
+	// Explicit checks
+	for (INT_32 iVersion = 1; iVersion < C_TEST_VERSIONS; ++iVersion)
+	{
+		usleep(5000);
+		WriteTemplate(iVersion);
+		if (oCache.CheckUpdates() != 1)
+		{
+			fprintf(stderr, "ERROR: version %d is not reloaded\n", iVersion);
+			__atomic_fetch_add(&(oContext.errors), 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	// Template that cannot be compiled keeps old version
+	usleep(5000);
+	WriteSource("<TMPL_if>");
+	try
+	{
+		if (oCache.CheckUpdates() != 0)
+		{
+			fprintf(stderr, "ERROR: broken template is reloaded\n");
+			__atomic_fetch_add(&(oContext.errors), 1, __ATOMIC_RELAXED);
+		}
+	}
+	catch(...)
+	{
+		fprintf(stderr, "ERROR: error of broken template is not handled\n");
+		__atomic_fetch_add(&(oContext.errors), 1, __ATOMIC_RELAXED);
+	}
+
+	// Background checks
+	oCache.StartChecker(10);
+	WriteTemplate(C_TEST_VERSIONS);
+
+	bool bReloaded = false;
+	for (INT_32 iTry = 0; iTry < 500 && !bReloaded; ++iTry)
+	{
+		usleep(10000);
+
+		TemplateCache::Handle oHandle = oCache.Get(C_TEST_TEMPLATE);
+				STLW::string sResult;
+		StringOutputCollector oOutputCollector(sResult);
+		SyscallFactory oSyscalls(1024);
+		STDLibInitializer::InitLibrary(oSyscalls);
+		{
+			VM         oVM(&oSyscalls);
+			FileLogger oLogger(stderr);
+			CDT        oData;
+			UINT_32    iIP = 0;
+			oVM.Init(oHandle.GetCore(), &oOutputCollector, &oLogger);
+			oVM.Run(oHandle.GetCore(), &oOutputCollector, iIP, oData, &oLogger);
+		}
+		STDLibInitializer::DestroyLibrary(oSyscalls);
+
+		INT_32 iVersion = -1;
+		bReloaded = (sscanf(sResult.c_str(), "version %d", &iVersion) == 1 && iVersion == C_TEST_VERSIONS);
+	}
+	oCache.StopChecker();
+
+	if (!bReloaded)
+	{
+		fprintf(stderr, "ERROR: background checker did not reload template\n");
+		__atomic_fetch_add(&(oContext.errors), 1, __ATOMIC_RELAXED);
+	}
+
+	__atomic_store_n(&(oContext.stop), true, __ATOMIC_RELEASE);
+	for (INT_32 iPos = 0; iPos < C_TEST_THREADS; ++iPos) { pthread_join(aThreads[iPos], NULL); }
+
+	unlink(C_TEST_TEMPLATE);
+	fprintf(stdout, "%d renders, %d errors\n", oContext.renders, oContext.errors);
+
+return oContext.errors == 0 ? EX_OK : EX_SOFTWARE;
+}
+
+// Context of benchmark thread
+struct BenchContext
+{
+	// Template cache
+	TemplateCache                               * cache;
+	// Templates, guarded by mutex
+	STLW::map<STLW::string, const VMMemoryCore *> * templates;
+	// Templates lock
+	pthread_mutex_t                             * mutex;
+	// Template name
+	STLW::string                                  name;
+	// Number of lookups
+	UINT_32                                       lookups;
+};
+
+//
+// Lookup in template cache
+//
+static void * CacheThread(void * vContext)
+{
+	BenchContext * pContext = static_cast<BenchContext *>(vContext);
+	for (UINT_32 iPos = 0; iPos < pContext -> lookups; ++iPos)
+	{
+		TemplateCache::Handle oHandle = pContext -> cache -> Get(pContext -> name);
+		if (oHandle.GetCore() == NULL) { abort(); }
+	}
+
+return NULL;
+}
+
+//
+// Lookup in map guarded by mutex
+//
+static void * MutexThread(void * vContext)
+{
+	BenchContext * pContext = static_cast<BenchContext *>(vContext);
+	for (UINT_32 iPos = 0; iPos < pContext -> lookups; ++iPos)
+	{
+		pthread_mutex_lock(pContext -> mutex);
+		const VMMemoryCore * pCore = (*(pContext -> templates))[pContext -> name];
+		pthread_mutex_unlock(pContext -> mutex);
+		if (pCore == NULL) { abort(); }
+	}
+
+return NULL;
+}
+
+//
+// Run lookups in iThreads threads, return lookups per second
+//
+static W_FLOAT RunThreads(void * (*fnThread)(void *), BenchContext & oContext, const INT_32 iThreads)
+{
+	pthread_t aThreads[C_MAX_THREADS];
+	oContext.lookups = C_BENCH_LOOKUPS / iThreads;
+
+	const UINT_64 iStart = GetUSTime();
+	for (INT_32 iPos = 0; iPos < iThreads; ++iPos) { pthread_create(&aThreads[iPos], NULL, fnThread, &oContext); }
+	for (INT_32 iPos = 0; iPos < iThreads; ++iPos) { pthread_join(aThreads[iPos], NULL); }
+
+return 1.0 * oContext.lookups * iThreads / (GetUSTime() - iStart + 1);
+}
+
+//
+// Usage
+//
+static void Usage(CCHAR_P szName)
+{
+	fprintf(stderr, "usage: %s -t | -b template.tmpl\n"
+	                "\t -t - render templates in threads while they are reloaded\n"
+	                "\t -b - compare lookups/second of template cache and of map guarded by mutex\n", szName);
+}
+
+// Template cache benchmark
+int main(int argc, char ** argv)
+{
+	if (argc < 2 || argv[1][0] != '-' || (argv[1][1] != 't' && argv[1][1] != 'b') || (argv[1][1] == 'b' && argc < 3))
+	{
+		Usage(argv[0]);
+		return EX_USAGE;
+	}
+
+	if (argv[1][1] == 't') { return ReloadTest(); }
+
+	TemplateCache oCache;
+	pthread_mutex_t oMutex;
+	pthread_mutex_init(&oMutex, NULL);
+	STLW::map<STLW::string, const VMMemoryCore *> mTemplates;
+
+	BenchContext oContext;
+	oContext.cache     = &oCache;
+	oContext.templates = &mTemplates;
+	oContext.mutex     = &oMutex;
+	oContext.name      = argv[2];
+
+	mTemplates[oContext.name] = oCache.Get(oContext.name).GetCore();
+
+	// Linear scaling is speedup equal to number of threads, up to number of CPUs
+	const INT_32 iCPUs = INT_32(sysconf(_SC_NPROCESSORS_ONLN));
+	fprintf(stdout, "%d CPUs online\n", iCPUs);
+
+	W_FLOAT dCacheSingle = 0;
+	for (INT_32 iThreads = 1; iThreads <= C_MAX_THREADS; iThreads *= 2)
+	{
+		const W_FLOAT dCache = RunThreads(CacheThread, oContext, iThreads);
+		const W_FLOAT dMutex = RunThreads(MutexThread, oContext, iThreads);
+		if (iThreads == 1) { dCacheSingle = dCache; }
+
+		const INT_32 iIdeal = (iThreads < iCPUs) ? iThreads : iCPUs;
+		fprintf(stdout, "%2d threads, cache: %8.2f Mlookups/s, speedup %5.2f of %2d, mutex: %8.2f Mlookups/s\n", iThreads, dCache, dCache / dCacheSingle, iIdeal, dMutex);
+	}
+
+	pthread_mutex_destroy(&oMutex);
+
+return EX_OK;
+}
+// End.
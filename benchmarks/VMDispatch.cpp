@@ -0,0 +1,162 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      VMDispatch.cpp
+ *
+ * $CTPP$
+ */
+#include <CDT.hpp>
+#include <CTPP2FileLogger.hpp>
+#include <CTPP2JSONFileParser.hpp>
+#include <CTPP2SimpleCompiler.hpp>
+#include <CTPP2StringOutputCollector.hpp>
+#include <CTPP2SyscallFactory.hpp>
+#include <CTPP2VM.hpp>
+#include <CTPP2VMSTDLib.hpp>
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#ifdef HAVE_SYSEXITS_H
+#include <sysexits.h>
+#endif
+
+using namespace CTPP;
+
+//
+// Get current time, microseconds
+//
+static UINT_64 GetUSTime()
+{
+	struct timeval oTV;
+	gettimeofday(&oTV, NULL);
+
+return UINT_64(oTV.tv_sec) * 1000000 + oTV.tv_usec;
+}
+
+//
+// Run program iRuns times, return time in microseconds and number of executed instructions
+//
+static UINT_64 RunProgram(VM                  & oVM,
+                          const VMMemoryCore  * pCore,
+                          CDT                 & oData,
+                          Logger              & oLogger,
+                          const UINT_32         iRuns,
+                          UINT_64             & iSteps,
+                          std::string         & sResult)
+{
+	iSteps = 0;
+	const UINT_64 iStart = GetUSTime();
+	for (UINT_32 iRun = 0; iRun < iRuns; ++iRun)
+	{
+		sResult.erase();
+		StringOutputCollector oOutputCollector(sResult);
+
+		UINT_32 iIP = 0;
+		oVM.Init(pCore, &oOutputCollector, &oLogger);
+		oVM.Run(pCore, &oOutputCollector, iIP, oData, &oLogger);
+		iSteps += oVM.GetExecutedSteps();
+	}
+
+return GetUSTime() - iStart;
+}
+
+//
+// Usage
+//
+static void Usage(CCHAR_P szName)
+{
+	fprintf(stderr, "usage: %s -[t|b] data.json template.tmpl [template2.tmpl ...]\n"
+	                "\t -t - check that switch and threaded dispatch produce equal output\n"
+	                "\t -b - compare instructions/second of switch and threaded dispatch\n", szName);
+}
+
+// Instruction dispatch benchmark
+int main(int argc, char ** argv)
+{
+	if (argc < 4 || argv[1][0] != '-' || (argv[1][1] != 't' && argv[1][1] != 'b'))
+	{
+		Usage(argv[0]);
+		return EX_USAGE;
+	}
+
+	const bool    bBenchmark = (argv[1][1] == 'b');
+	const UINT_32 iRuns      = bBenchmark ? 20000 : 1;
+
+	CDT oData;
+	CTPP2JSONFileParser oJSONParser(oData);
+	oJSONParser.Parse(argv[2]);
+
+	SyscallFactory oSyscalls(1024);
+	STDLibInitializer::InitLibrary(oSyscalls);
+
+	INT_32 iRC = EX_OK;
+	{
+		VM         oSwitchVM(&oSyscalls, 4096, 4096, 0xFFFFFFFF, 0, VM::SWITCH_DISPATCH);
+		VM         oThreadedVM(&oSyscalls, 4096, 4096, 0xFFFFFFFF, 0, VM::THREADED_DISPATCH);
+		FileLogger oLogger(stderr);
+
+		for (INT_32 iPos = 3; iPos < argc; ++iPos)
+		{
+			SimpleCompiler oCompiler(argv[iPos]);
+			const VMMemoryCore * pCore = oCompiler.GetCore();
+
+			UINT_64 iSwitchSteps   = 0;
+			UINT_64 iThreadedSteps = 0;
+			std::string sSwitchResult;
+			std::string sThreadedResult;
+
+			const UINT_64 iSwitchTime   = RunProgram(oSwitchVM,   pCore, oData, oLogger, iRuns, iSwitchSteps,   sSwitchResult);
+			const UINT_64 iThreadedTime = RunProgram(oThreadedVM, pCore, oData, oLogger, iRuns, iThreadedSteps, sThreadedResult);
+
+			if (iSwitchSteps != iThreadedSteps || sSwitchResult != sThreadedResult)
+			{
+				fprintf(stderr, "ERROR: %s: dispatch engines mismatch\n", argv[iPos]);
+				iRC = EX_SOFTWARE;
+				continue;
+			}
+
+			if (!bBenchmark) { continue; }
+
+			CCHAR_P szName = strrchr(argv[iPos], '/');
+			szName = (szName == NULL) ? argv[iPos] : szName + 1;
+
+			fprintf(stdout, "%-32s %8llu instr/run, switch: %8.2f Minstr/s, threaded: %8.2f Minstr/s, speedup %6.2f%%\n",
+			                szName,
+			                (unsigned long long)(iSwitchSteps / iRuns),
+			                1.0 * iSwitchSteps / (iSwitchTime + 1),
+			                1.0 * iThreadedSteps / (iThreadedTime + 1),
+			                100.0 * iSwitchTime / (iThreadedTime + 1) - 100.0);
+		}
+	}
+
+	STDLibInitializer::DestroyLibrary(oSyscalls);
+
+return iRC;
+}
+// End.
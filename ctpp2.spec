@@ -1,6 +1,6 @@
 Summary: 	CTPP2 template engine.
 Name: 		ctpp2
-Version: 	2.8.2
+Version: 	2.9.0
 Release: 	0%{?dist}
 License: 	BSD
 Source: 	ctpp2-%{version}.tar.gz
@@ -67,6 +67,12 @@ rm -rf %{buildroot}
 %{_libdir}/libctpp2-st.a
 
 %changelog
+* Sun Oct 18 2026 agent <agent@local> - 2.9.0-0
+- Binary interface is changed, soname is libctpp2.so.3.
+- Bytecode version is 5, templates must be recompiled.
+- Performance improvements of VM, CDT, compiler and JSON parser.
+- Added TemplateCache, CDTArena, IOVecOutputCollector, incremental JSON parser, parallel batch compiler.
+
 * Fri Jul 13 2012 Andrei V. Shetuhin <reki@reki.ru> - 2.8.2-0
 - Removed TMPL_loop. Added TMPL_foreach's attributes for iterator.
 - TMPL_foreach works with HASH.
@@ -41,6 +41,8 @@
 #include "STLString.hpp"
 #include "STLVector.hpp"
 
+#include "CDTArena.hpp"
+#include "CDTHashMap.hpp"
 #include "CTPP2Exception.hpp"
 
 namespace CTPP // C++ Template Engine
@@ -48,6 +50,97 @@ namespace CTPP // C++ Template Engine
 
 #define C_MAX_SPRINTF_LENGTH 128
 
+/** Maximal length of string stored inline in CDT */
+#define C_CDT_INLINE_LENGTH  8
+
+/** Marker of string stored in shareable container */
+#define C_CDT_SHARED_STRING  0xFF
+
+/** Marker of string referring to immutable data not owned by CDT */
+#define C_CDT_STATIC_STRING  0xFE
+
+/** Marker of string referring to immutable data kept alive by refcounted owner */
+#define C_CDT_OWNED_STRING   0xFD
+
+// FWD
+class OutputCollector;
+
+/**
+  @struct CDTStringView CDT.hpp <CDT.hpp>
+  @brief Immutable string not owned by CDT, e.g. record of static text segment;
+         it must outlive all CDT objects referring to it
+*/
+struct CTPP2DECL CDTStringView
+{
+	/** String data, followed by zero or other character that cannot continue a number, e.g. quote */
+	CCHAR_P        data;
+	/** String length                */
+	UINT_32        length;
+};
+
+/**
+  @struct CDTStringOwner CDT.hpp <CDT.hpp>
+  @brief Refcounted owner of immutable strings, e.g. mapped JSON file; every CDT object
+         referring to one of its strings holds a reference, owner is deleted with last reference
+*/
+struct CTPP2DECL CDTStringOwner
+{
+	/** Number of references */
+	UINT_32        refcount;
+
+	/**
+	  @brief Constructor; creator holds first reference
+	*/
+	CDTStringOwner();
+
+	/**
+	  @brief Release reference, delete owner if it was last one
+	*/
+	void Release() throw();
+
+	/**
+	  @brief A destructor
+	*/
+	virtual ~CDTStringOwner() throw();
+};
+
+/**
+  @struct CDTOwnedStringView CDT.hpp <CDT.hpp>
+  @brief View of immutable string kept alive by its owner; view record itself belongs to owner
+*/
+struct CTPP2DECL CDTOwnedStringView
+{
+	/** View of string, must be first member */
+	CDTStringView     view;
+	/** Owner of string                      */
+	CDTStringOwner  * owner;
+};
+
+/**
+  @struct CDTKey CDT.hpp <CDT.hpp>
+  @brief Interned key of HASH with precomputed hash value
+*/
+struct CTPP2DECL CDTKey
+{
+	/** Key                */
+	STLW::string   key;
+	/** Hash value of key  */
+	UINT_64        hash;
+
+	/**
+	  @brief Constructor, empty key
+	*/
+	CDTKey();
+
+	/**
+	  @brief Constructor
+	  @param szKey - key
+	  @param iKeyLength - key length
+	*/
+	CDTKey(CCHAR_P        szKey,
+	       const UINT_32  iKeyLength);
+};
+
 /**
   @class CDT CDT.hpp <CDT.hpp>
   @brief Common Data Type
@@ -56,22 +149,30 @@ class CTPP2DECL CDT
 {
 private:
 	/**
-	  @var typedef STLW::string<CDT> String
+	  @var typedef STLW::basic_string<CHAR_8, STLW::char_traits<CHAR_8>, CDTArenaAllocator<CHAR_8> > String
 	  @brief internal string definition
 	*/
-	typedef STLW::string            String;
+	typedef STLW::basic_string<CHAR_8, STLW::char_traits<CHAR_8>, CDTArenaAllocator<CHAR_8> >  String;
 
 	/**
-	  @var typedef STLW::vector<CDT> Vector
+	  @var typedef STLW::vector<CDT, CDTArenaAllocator<CDT> > Vector
 	  @brief internal array definition
 	*/
-	typedef STLW::vector<CDT>       Vector;
+	typedef STLW::vector<CDT, CDTArenaAllocator<CDT> >                                         Vector;
 
+#ifdef CDT_FLAT_HASH
 	/**
-	  @var typedef STLW::map<String, CDT> Map
+	  @var typedef CDTHashMap<CDT> Map
 	  @brief internal hash definition
 	*/
-	typedef STLW::map<String, CDT>  Map;
+	typedef CDTHashMap<CDT>                                                                     Map;
+#else
+	/**
+	  @var typedef STLW::map<STLW::string, CDT, STLW::less<STLW::string>, CDTArenaAllocator<STLW::pair<const STLW::string, CDT> > > Map
+	  @brief internal hash definition
+	*/
+	typedef STLW::map<STLW::string, CDT, STLW::less<STLW::string>, CDTArenaAllocator<STLW::pair<const STLW::string, CDT> > >  Map;
+#endif
 public:
 	/**
 	  @enum eValType CDT.hpp <CDT.hpp>
@@ -106,6 +207,14 @@ public:
 	*/
 	CDT(const CDT::eValType & oValue = UNDEF);
 
+	/**
+	  @brief Constructor; container of ARRAY, HASH or STRING is allocated in arena
+	  @param oValue - type of value
+	  @param pArena - arena, NULL for heap
+	*/
+	CDT(const CDT::eValType  & oValue,
+	    CDTArena             * pArena);
+
 	/**
 	  @brief Copy constructor
 	  @param oCDT - Object to copy
@@ -155,6 +264,14 @@ public:
 	*/
 	CDT(const STLW::string & oValue);
 
+	/**
+	  @brief Type cast constructor; long string is allocated in arena
+	  @param oValue - string value
+	  @param pArena - arena, NULL for heap
+	*/
+	CDT(const STLW::string  & oValue,
+	    CDTArena            * pArena);
+
 	/**
 	  @brief Type cast constructor
 	  @param oValue - asciz string to copy
@@ -162,6 +279,19 @@ public:
 	*/
 	CDT(CCHAR_P oValue);
 
+	/**
+	  @brief Type cast constructor; string is not copied, copy is made only on modification
+	  @param oValue - view of immutable string, must outlive created object and all copies of it
+	*/
+	CDT(const CDTStringView & oValue);
+
+	/**
+	  @brief Type cast constructor; string is not copied, created object and all copies of it
+	         hold reference to owner of string
+	  @param oValue - view of string kept alive by its owner
+	*/
+	CDT(const CDTOwnedStringView & oValue);
+
 	/**
 	  @brief Type cast constructor
 	  @param oValue - generic pointer value
@@ -274,6 +404,21 @@ public:
 	*/
 	const CDT & GetExistedCDT(const STLW::string & sKey, bool & bCDTExist) const;
 
+	/**
+	  @brief Provides constant access to the data contained in CDT
+	  @param oKey - Interned key of the hash
+	  @return Object with data
+	*/
+	const CDT & GetCDT(const CDTKey & oKey) const;
+
+	/**
+	  @brief Provides constant access to the data contained in CDT
+	  @param oKey - Interned key of the hash [in]
+	  @param bCDTExist - Existence flag [out], is set to true if object exist or false otherwise
+	  @return Object with data
+	*/
+	const CDT & GetExistedCDT(const CDTKey & oKey, bool & bCDTExist) const;
+
 	/**
 	  @brief Erase element from HASH
 	  @param sKey - The key of the hash [in]
@@ -1610,6 +1755,22 @@ public:
 	*/
 	STLW::string GetString(CCHAR_P szFormat = "") const;
 
+	/**
+	  @brief Get string value without copying
+	  @param iLength - string length
+	  @return pointer to string data, not zero-terminated and valid while CDT is unchanged,
+	          or NULL if value is not a string
+	*/
+	CCHAR_P GetStringData(UINT_32 & iLength) const;
+
+	/**
+	  @brief Write value to output collector; string is written without copying,
+	         numbers are formatted on stack exactly as GetString() does
+	  @param oCollector - output collector
+	  @return 0 - if success, -1 - if any error occured
+	*/
+	INT_32 WriteTo(OutputCollector  & oCollector) const;
+
 	/**
 	  @brief Cast value to W_FLOAT
         */
@@ -1689,6 +1850,19 @@ public:
 	*/
 	UINT_32 Size() const;
 
+	/**
+	  @brief Reserve space for elements of ARRAY or HASH, does nothing for other types
+	  @param iElements - expected number of elements
+	*/
+	void Reserve(const UINT_32 iElements);
+
+	/**
+	  @brief Check whether both objects refer to the same shareable container
+	  @param oCDT - object to compare
+	  @return true if objects share one STRING, ARRAY or HASH container
+	*/
+	bool SharesData(const CDT & oCDT) const;
+
 	/**
 	  @brief Swap values
 	  @param oCDT - value to swap
@@ -1971,10 +2145,16 @@ private:
 		_CDT                 * p_data;
 		/** Generic pointer                */
 		void                 * pp_data;
+		/** Short string, stored inline    */
+		CHAR_8                 s_inline[C_CDT_INLINE_LENGTH];
 	} u;
 
 	/** Value type */
 	mutable eValType               eValueType;
+	/** Length of inline string, C_CDT_SHARED_STRING if string is stored in shareable container,
+	    C_CDT_STATIC_STRING if string is a view of immutable data or C_CDT_OWNED_STRING if
+	    string is a view of data kept alive by refcounted owner */
+	UCHAR_8                        iInlineLength;
 
 	/**
 	  @brief Destroy object if need
@@ -1982,10 +2162,93 @@ private:
 	void Destroy() throw();
 
 	/**
-	  @brief Unshare shareable container
+	  @brief Initialize empty value of type eValueType
+	  @param pArena - arena for containers, NULL for heap
+	*/
+	void InitValue(CDTArena  * pArena);
+
+	/**
+	  @brief Unshare shareable container; inline string is moved to shareable container
 	*/
 	void Unshare();
 
+	/**
+	  @brief Copy shareable container into heap; values of container in arena are moved to heap too
+	  @return copy with reference counter equal to 1
+	*/
+	_CDT * CopyToHeap() const;
+
+	/**
+	  @brief Move shareable container in arena to heap
+	*/
+	void LeaveArena();
+
+	/**
+	  @brief Mark arena of container as foreign before mutable access to elements of container
+	*/
+	void TouchArena() const;
+
+	/**
+	  @brief Check whether value is a string stored inline or a view of immutable string, i.e. not stored in shareable container
+	*/
+	bool IsInlineString() const;
+
+	/**
+	  @brief Set string value, short strings are stored inline
+	  @param szData - string data
+	  @param iLength - string length
+	  @param pArena - arena for long string, NULL for heap
+	*/
+	void InitString(CCHAR_P        szData,
+	                const UINT_32  iLength,
+	                CDTArena     * pArena = NULL);
+
+	/**
+	  @brief Get pointer to string data, not zero-terminated for inline string
+	*/
+	CCHAR_P StringData() const;
+
+	/**
+	  @brief Get string length
+	*/
+	UINT_32 StringLength() const;
+
+	/**
+	  @brief Compare string values
+	  @param oCDT - string to compare with
+	  @return <0, 0 or >0 like STLW::string::compare
+	*/
+	INT_32 StringCompare(const CDT & oCDT) const;
+
+	/**
+	  @brief Parse string value as number
+	  @param iData - integer value [out]
+	  @param dData - floating point value [out]
+	  @return INT_VAL, REAL_VAL or UNDEF if string is not a number
+	*/
+	eValType ParseString(INT_64   & iData,
+	                     W_FLOAT  & dData) const;
+
+	/**
+	  @brief Store numeric value of string
+	  @param eType - INT_VAL or REAL_VAL
+	  @param iData - integer value
+	  @param dData - floating point value
+	*/
+	void CacheNumber(const eValType  eType,
+	                 const INT_64    iData,
+	                 const W_FLOAT   dData) const;
+
+	/**
+	  @brief Get cached integer value of STRING_INT_VAL
+	*/
+	INT_64 CachedInt() const;
+
+	/**
+	  @brief Get cached floating point value of STRING_REAL_VAL
+	*/
+	W_FLOAT CachedFloat() const;
+
 	/**
 	  @brief Dump CDT into string
 	  @param iLevel  - level of recursion
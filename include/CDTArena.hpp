@@ -0,0 +1,386 @@
+/*-
+ * Copyright (c) 2004 - 2011 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CDTArena.hpp
+ *
+ * $CTPP$
+ */
+#ifndef _CDT_ARENA_HPP__
+#define _CDT_ARENA_HPP__ 1
+
+/**
+  @file CDTArena.hpp
+  @brief Monotonic memory arena for CDT trees
+*/
+
+#include "CTPP2Types.h"
+
+#include <new>
+#include <stddef.h>
+
+#if __cplusplus >= 201103L
+    #include <type_traits>
+#endif
+
+/** Default size of first arena chunk      */
+#define C_CDT_ARENA_CHUNK_SIZE      8192
+
+/** Maximal size of arena chunk            */
+#define C_CDT_ARENA_MAX_CHUNK_SIZE  1048576
+
+/** Alignment of memory blocks             */
+#define C_CDT_ARENA_ALIGN           16
+
+namespace CTPP // C++ Template Engine
+{
+
+/**
+  @class CDTArena CDTArena.hpp <CDTArena.hpp>
+  @brief Monotonic memory arena
+
+  Memory is taken from chunks by moving a pointer and is never released
+  block by block; all chunks are released at once by Release() or by
+  destructor.
+
+  CDT tree in arena is not walked on destruction: when last reference to
+  container in arena is dropped, container is left as is and its memory is
+  reclaimed by Release(). Keys of HASH that do not fit into small-string
+  buffer are destroyed by Release() too. This is safe while trees of arena
+  contain values of this arena only; CDT marks arena as foreign when it
+  gives out mutable access to container in arena (operator[], At, Iterator,
+  PushBack, etc.), since values of heap or of other arena can be stored
+  this way. Trees of foreign arena are destroyed by walk as trees in heap.
+  Code that fills trees with values of the same arena only (e.g. JSON
+  parser) declares it with CDTArena::Builder.
+
+  CDT objects outside arena may share values of tree; such copies should be
+  destroyed before Release(). Modified copy of value in arena is moved to
+  heap together with all its values in arena, so it can outlive arena.
+*/
+class CTPP2DECL CDTArena
+{
+public:
+	/**
+	  @brief Constructor
+	  @param iIChunkSize - size of first chunk
+	*/
+	CDTArena(const UINT_32  iIChunkSize = C_CDT_ARENA_CHUNK_SIZE);
+
+	/**
+	  @brief Allocate memory block
+	  @param iSize - block size
+	  @return pointer to block aligned to C_CDT_ARENA_ALIGN bytes
+	*/
+	void * Allocate(size_t  iSize)
+	{
+		iSize = (iSize + C_CDT_ARENA_ALIGN - 1) & ~size_t(C_CDT_ARENA_ALIGN - 1);
+		if (iSize > iFree) { return AllocateChunk(iSize); }
+
+		void * vBlock = pPos;
+		pPos  += iSize;
+		iFree -= iSize;
+		iUsed += iSize;
+
+	return vBlock;
+	}
+
+	/**
+	  @class Builder CDTArena.hpp <CDTArena.hpp>
+	  @brief Scope in which trees of arena are filled with values of this arena only,
+	         mutable access to them does not mark arena as foreign
+	*/
+	class CTPP2DECL Builder
+	{
+	public:
+		/**
+		  @brief Constructor
+		  @param pIArena - arena, NULL for heap
+		*/
+		Builder(CDTArena  * pIArena);
+
+		/**
+		  @brief A destructor
+		*/
+		~Builder() throw();
+	private:
+		/** Arena, NULL for heap */
+		CDTArena  * pArena;
+
+		// Does not exist
+		Builder(const Builder & oRhs);
+		Builder & operator=(const Builder & oRhs);
+	};
+
+	/**
+	  @brief Mark that trees of arena can refer to memory outside it;
+	         such trees are destroyed by walk until Release()
+	*/
+	void MarkForeign() throw() { bForeign = true; }
+
+	/**
+	  @brief Check whether trees of arena can refer to memory outside it
+	*/
+	bool IsForeign() const throw() { return bForeign; }
+
+	/**
+	  @brief Check whether trees of arena are filled by CDTArena::Builder
+	*/
+	bool IsBuilding() const throw() { return iBuilders != 0; }
+
+	/**
+	  @brief Register function called by Release() before memory is released
+	  @param fnCallback - function
+	  @param vObject - argument of function
+	*/
+	void AtRelease(void  (* fnCallback)(void *),
+	               void   * vObject);
+
+	/**
+	  @brief Release all memory
+	*/
+	void Release() throw();
+
+	/**
+	  @brief Get number of allocated bytes
+	*/
+	UINT_64 GetUsed() const;
+
+	/**
+	  @brief Get number of bytes taken from system
+	*/
+	UINT_64 GetReserved() const;
+
+	/**
+	  @brief A destructor
+	*/
+	~CDTArena() throw();
+
+private:
+	/**
+	  @struct Chunk CDTArena.hpp <CDTArena.hpp>
+	  @brief Header of memory chunk
+	*/
+	struct Chunk
+	{
+		/** Previous chunk      */
+		Chunk    * prev;
+		/** Padding for alignment of data */
+		CHAR_8     padding[C_CDT_ARENA_ALIGN - sizeof(Chunk *)];
+	};
+
+	/**
+	  @struct Finalizer CDTArena.hpp <CDTArena.hpp>
+	  @brief Function called by Release(), allocated in arena
+	*/
+	struct Finalizer
+	{
+		/** Previous finalizer  */
+		Finalizer  * prev;
+		/** Function            */
+		void      (* callback)(void *);
+		/** Argument            */
+		void       * object;
+	};
+
+	/** Last allocated chunk           */
+	Chunk       * pChunks;
+	/** First free byte in last chunk  */
+	CHAR_8      * pPos;
+	/** Number of free bytes in last chunk */
+	size_t        iFree;
+	/** Size of next chunk             */
+	size_t        iChunkSize;
+	/** Number of allocated bytes      */
+	UINT_64       iUsed;
+	/** Number of bytes taken from system */
+	UINT_64       iReserved;
+	/** Last registered finalizer      */
+	Finalizer   * pFinalizers;
+	/** Number of active builders      */
+	UINT_32       iBuilders;
+	/** Trees of arena can refer to memory outside it */
+	bool          bForeign;
+
+	/**
+	  @brief Allocate new chunk and memory block in it
+	  @param iSize - aligned block size
+	*/
+	void * AllocateChunk(const size_t  iSize);
+
+	// Does not exist
+	CDTArena(const CDTArena & oRhs);
+	CDTArena & operator=(const CDTArena & oRhs);
+};
+
+/**
+  @class CDTArenaAllocator CDTArena.hpp <CDTArena.hpp>
+  @brief STL allocator; takes memory from arena or from heap if arena is NULL
+*/
+template<typename T>class CDTArenaAllocator
+{
+public:
+	typedef T                value_type;
+	typedef T              * pointer;
+	typedef const T        * const_pointer;
+	typedef T              & reference;
+	typedef const T        & const_reference;
+	typedef size_t           size_type;
+	typedef ptrdiff_t        difference_type;
+
+#if __cplusplus >= 201103L
+	typedef std::true_type   propagate_on_container_copy_assignment;
+	typedef std::true_type   propagate_on_container_move_assignment;
+	typedef std::true_type   propagate_on_container_swap;
+#endif
+
+	/**
+	  @struct rebind CDTArena.hpp <CDTArena.hpp>
+	  @brief Allocator for other type
+	*/
+	template<typename U>struct rebind
+	{
+		typedef CDTArenaAllocator<U> other;
+	};
+
+	/**
+	  @brief Constructor
+	  @param pIArena - arena, NULL for heap
+	*/
+	CDTArenaAllocator(CDTArena  * pIArena = NULL) throw(): pArena(pIArena) { ;; }
+
+	/**
+	  @brief Type cast constructor
+	*/
+	template<typename U>CDTArenaAllocator(const CDTArenaAllocator<U> & oRhs) throw(): pArena(oRhs.GetArena()) { ;; }
+
+	/**
+	  @brief Get arena
+	*/
+	CDTArena * GetArena() const throw() { return pArena; }
+
+	/**
+	  @brief Get address of object
+	*/
+	pointer address(reference oValue) const { return &oValue; }
+
+	/**
+	  @brief Get address of object
+	*/
+	const_pointer address(const_reference oValue) const { return &oValue; }
+
+	/**
+	  @brief Allocate memory for iCount objects
+	*/
+	pointer allocate(const size_type iCount, const void * = NULL)
+	{
+		if (pArena == NULL) { return static_cast<pointer>(::operator new(iCount * sizeof(T))); }
+
+	return static_cast<pointer>(pArena -> Allocate(iCount * sizeof(T)));
+	}
+
+	/**
+	  @brief Release memory; memory of arena is released only with arena
+	*/
+	void deallocate(pointer pObject, const size_type)
+	{
+		if (pArena == NULL) { ::operator delete(pObject); }
+	}
+
+	/**
+	  @brief Maximal number of objects
+	*/
+	size_type max_size() const throw() { return size_type(-1) / sizeof(T); }
+
+	/**
+	  @brief Construct object
+	*/
+	void construct(pointer pObject, const T & oValue) { new (static_cast<void *>(pObject)) T(oValue); }
+
+	/**
+	  @brief Destroy object
+	*/
+	void destroy(pointer pObject) { pObject -> ~T(); }
+
+	/**
+	  @brief Comparison operator
+	*/
+	template<typename U>bool operator==(const CDTArenaAllocator<U> & oRhs) const throw() { return pArena == oRhs.GetArena(); }
+
+	/**
+	  @brief Comparison operator
+	*/
+	template<typename U>bool operator!=(const CDTArenaAllocator<U> & oRhs) const throw() { return pArena != oRhs.GetArena(); }
+
+private:
+	/** Arena, NULL for heap */
+	CDTArena  * pArena;
+};
+
+/**
+  @brief Destroy object; finalizer for CDTArena::AtRelease
+  @param vObject - object to destroy
+*/
+template<typename T>void DestroyObject(void * vObject) { static_cast<T *>(vObject) -> ~T(); }
+
+/**
+  @brief Destroy object created with operator new(size_t, CDTArena *)
+  @param pObject - object to destroy
+  @param pArena - arena, NULL for heap
+*/
+template<typename T>void DestroyInArena(T         * pObject,
+                                        CDTArena  * pArena)
+{
+	if (pArena == NULL) { delete pObject; }
+	else                { pObject -> ~T(); }
+}
+
+} // namespace CTPP
+
+/**
+  @brief Allocate object in arena or in heap if arena is NULL
+  @param iSize - object size
+  @param pArena - arena
+*/
+inline void * operator new(size_t iSize, CTPP::CDTArena * pArena)
+{
+	if (pArena == NULL) { return ::operator new(iSize); }
+
+return pArena -> Allocate(iSize);
+}
+
+/**
+  @brief Release memory if constructor of object throws exception
+  @param vObject - memory block
+  @param pArena - arena
+*/
+inline void operator delete(void * vObject, CTPP::CDTArena * pArena)
+{
+	if (pArena == NULL) { ::operator delete(vObject); }
+}
+
+#endif // _CDT_ARENA_HPP__
+// End.
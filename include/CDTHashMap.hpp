@@ -0,0 +1,1151 @@
+/*-
+ * Copyright (c) 2004 - 2011 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CDTHashMap.hpp
+ *
+ * $CTPP$
+ */
+#ifndef _CDT_HASH_MAP_HPP__
+#define _CDT_HASH_MAP_HPP__ 1
+
+#include "CDTArena.hpp"
+#include "CTPP2HashTable.hpp"
+#include "CTPP2Types.h"
+
+#include "STLFunctional.hpp"
+#include "STLPair.hpp"
+#include "STLString.hpp"
+#include "STLVector.hpp"
+
+#include <algorithm>
+#include <new>
+
+/**
+  @file CDTHashMap.hpp
+  @brief Open-addressing hash map for CDT[HASH]
+*/
+
+namespace CTPP // C++ Template Engine
+{
+
+/** Maximal size of map without index  */
+#define C_HASH_MAP_LINEAR_SIZE  8
+
+/** Minimal size of index              */
+#define C_HASH_MAP_MIN_INDEX    16
+
+/** Minimal number of nodes in chunk   */
+#define C_HASH_MAP_MIN_CHUNK    4
+
+/** Maximal number of elements in block */
+#define C_HASH_MAP_BLOCK_SIZE   512
+
+/**
+  @class CDTHashMap CDTHashMap.hpp <CDTHashMap.hpp>
+  @brief Hash map with open-addressing index and std::map-compatible interface
+
+  Elements live in chunks owned by the map, so references to elements
+  stay valid until element is erased. Elements are iterated in
+  ascending order of keys, exactly as STLW::map<STLW::string, T> does;
+  order is kept by list of sorted blocks of pointers to elements.
+  Any insertion or erasing invalidates iterators.
+
+  Map in arena does not destroy keys: key that allocated memory is
+  destroyed by CDTArena::Release(), so map may be left without destruction.
+*/
+template<typename T>class CDTHashMap
+{
+private:
+	/**
+	  @struct Node CDTHashMap.hpp <CDTHashMap.hpp>
+	  @brief Map element with hash value of key
+	*/
+	struct Node
+	{
+		/** Key => value pair  */
+		STLW::pair<const STLW::string, T>   value;
+		/** Hash value of key  */
+		UINT_64                             hash;
+
+		/**
+		  @brief Constructor
+		  @param sKey - key
+		  @param oValue - value
+		  @param iHash - hash value of key
+		*/
+		Node(const STLW::string  & sKey,
+		     const T             & oValue,
+		     const UINT_64         iHash): value(sKey, oValue), hash(iHash) { ;; }
+	};
+
+	/** Block of elements, sorted by key */
+	typedef STLW::vector<Node *, CDTArenaAllocator<Node *> >  Block;
+	/** List of blocks                   */
+	typedef STLW::vector<Block, CDTArenaAllocator<Block> >    BlockList;
+	/** Open-addressing index            */
+	typedef STLW::vector<Node *, CDTArenaAllocator<Node *> >  Index;
+
+public:
+	/** Key => value pair         */
+	typedef STLW::pair<const STLW::string, T>  value_type;
+	/** Type of value             */
+	typedef T                                  mapped_type;
+	/** Size type                 */
+	typedef UINT_32                            size_type;
+	/** Allocator type            */
+	typedef CDTArenaAllocator<value_type>      allocator_type;
+
+	// FWD
+	class const_iterator;
+
+	/**
+	  @class iterator CDTHashMap.hpp <CDTHashMap.hpp>
+	  @brief Forward iterator
+	*/
+	class iterator
+	{
+	public:
+		/**
+		  @brief Constructor
+		*/
+		iterator(): pMap(NULL), iBlock(0), iPos(0) { ;; }
+
+		/**
+		  @brief Pre-increment operator ++
+		*/
+		iterator & operator++() { pMap -> Advance(iBlock, iPos); return *this; }
+
+		/**
+		  @brief Post-increment operator ++
+		*/
+		iterator operator++(int) { iterator oTMP(*this); pMap -> Advance(iBlock, iPos); return oTMP; }
+
+		/**
+		  @brief Access operator
+		*/
+		value_type & operator*() const { return pMap -> vBlocks[iBlock][iPos] -> value; }
+
+		/**
+		  @brief Access operator
+		*/
+		value_type * operator->() const { return &(pMap -> vBlocks[iBlock][iPos] -> value); }
+
+		/**
+		  @brief Comparison operator
+		*/
+		bool operator==(const iterator & oRhs) const { return iBlock == oRhs.iBlock && iPos == oRhs.iPos && pMap == oRhs.pMap; }
+
+		/**
+		  @brief Comparison operator
+		*/
+		bool operator!=(const iterator & oRhs) const { return !(*this == oRhs); }
+
+	private:
+		friend class CDTHashMap;
+		friend class const_iterator;
+
+		/** Iterated map                  */
+		CDTHashMap  * pMap;
+		/** Block of elements             */
+		size_type     iBlock;
+		/** Position in block             */
+		size_type     iPos;
+
+		/**
+		  @brief Constructor
+		*/
+		iterator(CDTHashMap       * pIMap,
+		         const size_type    iIBlock,
+		         const size_type    iIPos): pMap(pIMap), iBlock(iIBlock), iPos(iIPos) { ;; }
+	};
+
+	/**
+	  @class const_iterator CDTHashMap.hpp <CDTHashMap.hpp>
+	  @brief Forward constant iterator
+	*/
+	class const_iterator
+	{
+	public:
+		/**
+		  @brief Constructor
+		*/
+		const_iterator(): pMap(NULL), iBlock(0), iPos(0) { ;; }
+
+		/**
+		  @brief Type cast constructor
+		*/
+		const_iterator(const iterator & oRhs): pMap(oRhs.pMap), iBlock(oRhs.iBlock), iPos(oRhs.iPos) { ;; }
+
+		/**
+		  @brief Pre-increment operator ++
+		*/
+		const_iterator & operator++() { pMap -> Advance(iBlock, iPos); return *this; }
+
+		/**
+		  @brief Post-increment operator ++
+		*/
+		const_iterator operator++(int) { const_iterator oTMP(*this); pMap -> Advance(iBlock, iPos); return oTMP; }
+
+		/**
+		  @brief Access operator
+		*/
+		const value_type & operator*() const { return pMap -> vBlocks[iBlock][iPos] -> value; }
+
+		/**
+		  @brief Access operator
+		*/
+		const value_type * operator->() const { return &(pMap -> vBlocks[iBlock][iPos] -> value); }
+
+		/**
+		  @brief Comparison operator
+		*/
+		bool operator==(const const_iterator & oRhs) const { return iBlock == oRhs.iBlock && iPos == oRhs.iPos && pMap == oRhs.pMap; }
+
+		/**
+		  @brief Comparison operator
+		*/
+		bool operator!=(const const_iterator & oRhs) const { return !(*this == oRhs); }
+
+	private:
+		friend class CDTHashMap;
+
+		/** Iterated map                  */
+		const CDTHashMap  * pMap;
+		/** Block of elements             */
+		size_type           iBlock;
+		/** Position in block             */
+		size_type           iPos;
+
+		/**
+		  @brief Constructor
+		*/
+		const_iterator(const CDTHashMap  * pIMap,
+		               const size_type     iIBlock,
+		               const size_type     iIPos): pMap(pIMap), iBlock(iIBlock), iPos(iIPos) { ;; }
+	};
+
+	/**
+	  @brief Constructor
+	*/
+	CDTHashMap();
+
+	/**
+	  @brief Constructor, same as for STLW::map
+	  @param oLess - comparator, keys are always compared by STLW::string::operator<
+	  @param oAllocator - allocator; memory of elements is taken from its arena
+	*/
+	CDTHashMap(const STLW::less<STLW::string>  & oLess,
+	           const allocator_type            & oAllocator);
+
+	/**
+	  @brief Constructor, same as for STLW::map
+	  @param itFirst - first element to copy
+	  @param itLast - element after last one to copy
+	  @param oLess - comparator, keys are always compared by STLW::string::operator<
+	  @param oAllocator - allocator; memory of elements is taken from its arena
+	*/
+	template<typename InputIterator>CDTHashMap(InputIterator                     itFirst,
+	                                           InputIterator                     itLast,
+	                                           const STLW::less<STLW::string>  & oLess,
+	                                           const allocator_type            & oAllocator);
+
+	/**
+	  @brief Copy constructor
+	  @param oRhs - object to copy
+	*/
+	CDTHashMap(const CDTHashMap & oRhs);
+
+	/**
+	  @brief Copy operator
+	  @param oRhs - object to copy
+	*/
+	CDTHashMap & operator=(const CDTHashMap & oRhs);
+
+	/**
+	  @brief Calculate hash value of key
+	  @param sKey - key
+	  @return hash value
+	*/
+	static UINT_64 Hash(const STLW::string & sKey) { return HashFunc(sKey.data(), UINT_32(sKey.size())); }
+
+	/**
+	  @brief Get value by key
+	  @param sKey - key
+	  @param iHash - hash value of key
+	  @return pointer to value or NULL if nothing found
+	*/
+	T * Get(const STLW::string & sKey, const UINT_64 iHash);
+
+	/**
+	  @brief Get value by key
+	  @param sKey - key
+	  @param iHash - hash value of key
+	  @return pointer to value or NULL if nothing found
+	*/
+	const T * Get(const STLW::string & sKey, const UINT_64 iHash) const;
+
+	/**
+	  @brief Get value by key, value is created if not exist
+	  @param sKey - key
+	  @return reference to value
+	*/
+	T & operator[](const STLW::string & sKey);
+
+	/**
+	  @brief Insert pair of key => value, if key does not exist
+	  @param oValue - pair to insert
+	  @return true, if element inserted, false - if key already exist
+	*/
+	bool insert(const value_type & oValue);
+
+	/**
+	  @brief Find element
+	  @param sKey - key
+	  @return iterator pointed to element or end() if nothing found
+	*/
+	iterator find(const STLW::string & sKey);
+
+	/**
+	  @brief Find element
+	  @param sKey - key
+	  @return iterator pointed to element or end() if nothing found
+	*/
+	const_iterator find(const STLW::string & sKey) const;
+
+	/**
+	  @brief Erase element
+	  @param itElement - element to erase
+	*/
+	void erase(iterator itElement);
+
+	/**
+	  @brief Erase element
+	  @param sKey - key
+	  @return number of erased elements
+	*/
+	size_type erase(const STLW::string & sKey);
+
+	/**
+	  @brief Get iterator pointed to first element
+	*/
+	iterator begin() { return iterator(this, 0, 0); }
+
+	/**
+	  @brief Get iterator pointed to end of map
+	*/
+	iterator end() { return iterator(this, size_type(vBlocks.size()), 0); }
+
+	/**
+	  @brief Get iterator pointed to first element
+	*/
+	const_iterator begin() const { return const_iterator(this, 0, 0); }
+
+	/**
+	  @brief Get iterator pointed to end of map
+	*/
+	const_iterator end() const { return const_iterator(this, size_type(vBlocks.size()), 0); }
+
+	/**
+	  @brief Get number of elements
+	*/
+	size_type size() const { return iSize; }
+
+	/**
+	  @brief Check map emptiness
+	*/
+	bool empty() const { return iSize == 0; }
+
+	/**
+	  @brief Reserve space for elements, index and nodes are allocated at once
+	  @param iElements - expected number of elements
+	*/
+	void reserve(const size_type iElements);
+
+	/**
+	  @brief Get allocator
+	*/
+	allocator_type get_allocator() const { return allocator_type(pArena); }
+
+	/**
+	  @brief Swap content of maps
+	  @param oRhs - map to swap with
+	*/
+	void swap(CDTHashMap & oRhs);
+
+	/**
+	  @brief A destructor
+	*/
+	~CDTHashMap() throw();
+
+private:
+	/** Arena, NULL for heap                               */
+	CDTArena               * pArena;
+	/** Blocks of elements, sorted by key; no empty blocks */
+	BlockList                vBlocks;
+	/** Number of elements                                 */
+	size_type                iSize;
+	/** Open-addressing index, empty for small map         */
+	Index                    vIndex;
+	/** Number of non-empty cells in index                 */
+	size_type                iIndexUsed;
+	/** Allocated chunks of nodes, empty for arena         */
+	STLW::vector<void *>     vChunks;
+	/** First unused node in last chunk                    */
+	Node                   * pChunkPos;
+	/** Number of unused nodes in last chunk               */
+	size_type                iChunkFree;
+	/** Number of allocated nodes                          */
+	size_type                iAllocated;
+	/** List of released nodes                             */
+	void                   * pFreeList;
+
+	/** Marker of erased cell of index                     */
+	static char              cDeleted;
+
+	/**
+	  @brief Erased cell of index
+	*/
+	static Node * Deleted() { return reinterpret_cast<Node *>(&cDeleted); }
+
+	/**
+	  @brief Get start position in index; low bits of HashFunc are poorly mixed
+	*/
+	static size_type Slot(UINT_64 iHash, const size_type iMask)
+	{
+		iHash ^= iHash >> 33;
+		iHash *= 0xFF51AFD7ED558CCDULL;
+		iHash ^= iHash >> 33;
+return size_type(iHash) & iMask;
+	}
+
+	/**
+	  @brief Compare key of element with key
+	*/
+	static bool KeyLess(const Node * pNode, const STLW::string & sKey) { return pNode -> value.first < sKey; }
+
+	/**
+	  @brief Compare last key of block with key
+	*/
+	static bool BlockLess(const Block & vBlock, const STLW::string & sKey) { return vBlock.back() -> value.first < sKey; }
+
+	/**
+	  @brief Move iterator position to next element
+	  @param iBlock - block of elements
+	  @param iPos - position in block
+	*/
+	void Advance(size_type  & iBlock,
+	             size_type  & iPos) const;
+
+	/**
+	  @brief Find position of key in blocks
+	  @param sKey - key
+	  @param iBlock - block of elements [out]
+	  @param iPos - position in block [out]
+	*/
+	void Locate(const STLW::string  & sKey,
+	            size_type           & iBlock,
+	            size_type           & iPos) const;
+
+	/**
+	  @brief Find node by key
+	  @param sKey - key
+	  @param iHash - hash value of key
+	  @return pointer to node or NULL if nothing found
+	*/
+	Node * FindNode(const STLW::string & sKey, const UINT_64 iHash) const;
+
+	/**
+	  @brief Insert new node
+	  @param sKey - key
+	  @param oValue - value
+	  @param iHash - hash value of key
+	  @return pointer to inserted node
+	*/
+	Node * InsertNode(const STLW::string  & sKey,
+	                  const T             & oValue,
+	                  const UINT_64         iHash);
+
+	/**
+	  @brief Put node into blocks
+	  @param pNode - node
+	*/
+	void PlaceNode(Node * pNode);
+
+	/**
+	  @brief Erase node
+	  @param iBlock - block of elements
+	  @param iPos - position in block
+	*/
+	void EraseNode(const size_type  iBlock,
+	               const size_type  iPos);
+
+	/**
+	  @brief Allocate and construct node
+	*/
+	Node * AllocNode(const STLW::string  & sKey,
+	                 const T             & oValue,
+	                 const UINT_64         iHash);
+
+	/**
+	  @brief Allocate chunk of nodes
+	  @param iChunkSize - number of nodes in chunk
+	*/
+	void AllocChunk(const size_type iChunkSize);
+
+	/**
+	  @brief Destroy node; key of node in arena is destroyed by arena
+	*/
+	void DestroyNode(Node * pNode);
+
+	/**
+	  @brief Destroy and release node
+	*/
+	void FreeNode(Node * pNode);
+
+	/**
+	  @brief Put node into index
+	  @return number of newly used cells
+	*/
+	static size_type IndexNode(Index & vTargetIndex, Node * pNode);
+
+	/**
+	  @brief Remove node from index
+	*/
+	void UnindexNode(const Node * pNode);
+
+	/**
+	  @brief Rebuild index
+	  @param iElements - expected number of elements
+	*/
+	void Rehash(const size_type iElements);
+
+	/**
+	  @brief Destroy all elements and release memory
+	*/
+	void Clear() throw();
+};
+
+//
+// Marker of erased cell of index
+//
+template<typename T> char CDTHashMap<T>::cDeleted = 0;
+
+//
+// Constructor
+//
+template<typename T> CDTHashMap<T>::CDTHashMap(): pArena(NULL),
+                                                  iSize(0),
+                                                  iIndexUsed(0),
+                                                  pChunkPos(NULL),
+                                                  iChunkFree(0),
+                                                  iAllocated(0),
+                                                  pFreeList(NULL)
+{
+	;;
+}
+
+//
+// Constructor, same as for STLW::map
+//
+template<typename T> CDTHashMap<T>::CDTHashMap(const STLW::less<STLW::string>  & ,
+                                               const allocator_type            & oAllocator): pArena(oAllocator.GetArena()),
+                                                                                              vBlocks(pArena),
+                                                                                              iSize(0),
+                                                                                              vIndex(pArena),
+                                                                                              iIndexUsed(0),
+                                                                                              pChunkPos(NULL),
+                                                                                              iChunkFree(0),
+                                                                                              iAllocated(0),
+                                                                                              pFreeList(NULL)
+{
+	;;
+}
+
+//
+// Constructor, same as for STLW::map
+//
+template<typename T> template<typename InputIterator> CDTHashMap<T>::CDTHashMap(InputIterator                     itFirst,
+                                                                                InputIterator                     itLast,
+                                                                                const STLW::less<STLW::string>  & ,
+                                                                                const allocator_type            & oAllocator): pArena(oAllocator.GetArena()),
+                                                                                                                               vBlocks(pArena),
+                                                                                                                               iSize(0),
+                                                                                                                               vIndex(pArena),
+                                                                                                                               iIndexUsed(0),
+                                                                                                                               pChunkPos(NULL),
+                                                                                                                               iChunkFree(0),
+                                                                                                                               iAllocated(0),
+                                                                                                                               pFreeList(NULL)
+{
+	try
+	{
+		for (; itFirst != itLast; ++itFirst) { insert(*itFirst); }
+	}
+	catch(...)
+	{
+		Clear();
+		throw;
+	}
+}
+
+//
+// Copy constructor
+//
+template<typename T> CDTHashMap<T>::CDTHashMap(const CDTHashMap & oRhs): pArena(oRhs.pArena),
+                                                                         vBlocks(pArena),
+                                                                         iSize(0),
+                                                                         vIndex(pArena),
+                                                                         iIndexUsed(0),
+                                                                         pChunkPos(NULL),
+                                                                         iChunkFree(0),
+                                                                         iAllocated(0),
+                                                                         pFreeList(NULL)
+{
+	try
+	{
+		vBlocks.reserve(oRhs.vBlocks.size());
+
+		typename BlockList::const_iterator itvBlock = oRhs.vBlocks.begin();
+		while (itvBlock != oRhs.vBlocks.end())
+		{
+			vBlocks.push_back(Block(pArena));
+			vBlocks.back().reserve(itvBlock -> size());
+
+			typename Block::const_iterator itvElement = itvBlock -> begin();
+			while (itvElement != itvBlock -> end())
+			{
+				vBlocks.back().push_back(AllocNode((*itvElement) -> value.first, (*itvElement) -> value.second, (*itvElement) -> hash));
+				++iSize;
+				++itvElement;
+			}
+			++itvBlock;
+		}
+
+		if (iSize > C_HASH_MAP_LINEAR_SIZE) { Rehash(iSize); }
+	}
+	catch(...)
+	{
+		Clear();
+		throw;
+	}
+}
+
+//
+// Copy operator
+//
+template<typename T> CDTHashMap<T> & CDTHashMap<T>::operator=(const CDTHashMap & oRhs)
+{
+	if (this != &oRhs)
+	{
+		CDTHashMap oTMP(oRhs);
+		swap(oTMP);
+	}
+
+return *this;
+}
+
+//
+// Get value by key
+//
+template<typename T> T * CDTHashMap<T>::Get(const STLW::string & sKey, const UINT_64 iHash)
+{
+	Node * pNode = FindNode(sKey, iHash);
+	if (pNode == NULL) { return NULL; }
+
+return &(pNode -> value.second);
+}
+
+//
+// Get value by key
+//
+template<typename T> const T * CDTHashMap<T>::Get(const STLW::string & sKey, const UINT_64 iHash) const
+{
+	const Node * pNode = FindNode(sKey, iHash);
+	if (pNode == NULL) { return NULL; }
+
+return &(pNode -> value.second);
+}
+
+//
+// Get value by key, value is created if not exist
+//
+template<typename T> T & CDTHashMap<T>::operator[](const STLW::string & sKey)
+{
+	const UINT_64 iHash = Hash(sKey);
+
+	Node * pNode = FindNode(sKey, iHash);
+	if (pNode == NULL) { pNode = InsertNode(sKey, T(), iHash); }
+
+return pNode -> value.second;
+}
+
+//
+// Insert pair of key => value, if key does not exist
+//
+template<typename T> bool CDTHashMap<T>::insert(const value_type & oValue)
+{
+	const UINT_64 iHash = Hash(oValue.first);
+
+	if (FindNode(oValue.first, iHash) != NULL) { return false; }
+
+	InsertNode(oValue.first, oValue.second, iHash);
+
+return true;
+}
+
+//
+// Find element
+//
+template<typename T> typename CDTHashMap<T>::iterator CDTHashMap<T>::find(const STLW::string & sKey)
+{
+	if (FindNode(sKey, Hash(sKey)) == NULL) { return end(); }
+
+	size_type iBlock = 0;
+	size_type iPos   = 0;
+	Locate(sKey, iBlock, iPos);
+
+return iterator(this, iBlock, iPos);
+}
+
+//
+// Find element
+//
+template<typename T> typename CDTHashMap<T>::const_iterator CDTHashMap<T>::find(const STLW::string & sKey) const
+{
+	if (FindNode(sKey, Hash(sKey)) == NULL) { return end(); }
+
+	size_type iBlock = 0;
+	size_type iPos   = 0;
+	Locate(sKey, iBlock, iPos);
+
+return const_iterator(this, iBlock, iPos);
+}
+
+//
+// Erase element
+//
+template<typename T> void CDTHashMap<T>::erase(iterator itElement) { EraseNode(itElement.iBlock, itElement.iPos); }
+
+//
+// Erase element
+//
+template<typename T> typename CDTHashMap<T>::size_type CDTHashMap<T>::erase(const STLW::string & sKey)
+{
+	if (FindNode(sKey, Hash(sKey)) == NULL) { return 0; }
+
+	size_type iBlock = 0;
+	size_type iPos   = 0;
+	Locate(sKey, iBlock, iPos);
+	EraseNode(iBlock, iPos);
+
+return 1;
+}
+
+//
+// Swap content of maps
+//
+template<typename T> void CDTHashMap<T>::swap(CDTHashMap & oRhs)
+{
+	STLW::swap(pArena, oRhs.pArena);
+	vBlocks.swap(oRhs.vBlocks);
+	vIndex.swap(oRhs.vIndex);
+	vChunks.swap(oRhs.vChunks);
+
+	STLW::swap(iSize,      oRhs.iSize);
+	STLW::swap(iIndexUsed, oRhs.iIndexUsed);
+	STLW::swap(pChunkPos,  oRhs.pChunkPos);
+	STLW::swap(iChunkFree, oRhs.iChunkFree);
+	STLW::swap(iAllocated, oRhs.iAllocated);
+	STLW::swap(pFreeList,  oRhs.pFreeList);
+}
+
+//
+// A destructor
+//
+template<typename T> CDTHashMap<T>::~CDTHashMap() throw() { Clear(); }
+
+//
+// Move iterator position to next element
+//
+template<typename T> void CDTHashMap<T>::Advance(size_type  & iBlock,
+                                                 size_type  & iPos) const
+{
+	++iPos;
+	if (iPos == vBlocks[iBlock].size())
+	{
+		++iBlock;
+		iPos = 0;
+	}
+}
+
+//
+// Find position of key in blocks
+//
+template<typename T> void CDTHashMap<T>::Locate(const STLW::string  & sKey,
+                                                size_type           & iBlock,
+                                                size_type           & iPos) const
+{
+	// First block with last key not less than sKey
+	iBlock = size_type(STLW::lower_bound(vBlocks.begin(), vBlocks.end(), sKey, BlockLess) - vBlocks.begin());
+	if (iBlock == vBlocks.size())
+	{
+		// Key is greater than all keys, position after last element
+		if (iBlock == 0) { iPos = 0; return; }
+
+		--iBlock;
+		iPos = size_type(vBlocks[iBlock].size());
+		return;
+	}
+
+	const Block & vBlock = vBlocks[iBlock];
+	iPos = size_type(STLW::lower_bound(vBlock.begin(), vBlock.end(), sKey, KeyLess) - vBlock.begin());
+}
+
+//
+// Find node by key
+//
+template<typename T> typename CDTHashMap<T>::Node * CDTHashMap<T>::FindNode(const STLW::string & sKey, const UINT_64 iHash) const
+{
+	// Small map, linear search
+	if (vIndex.empty())
+	{
+		if (vBlocks.empty()) { return NULL; }
+
+		typename Block::const_iterator itvElement = vBlocks[0].begin();
+		while (itvElement != vBlocks[0].end())
+		{
+			if ((*itvElement) -> hash == iHash && (*itvElement) -> value.first == sKey) { return *itvElement; }
+			++itvElement;
+		}
+		return NULL;
+	}
+
+	const size_type iMask = size_type(vIndex.size()) - 1;
+	size_type iPos = Slot(iHash, iMask);
+	for (;;)
+	{
+		Node * pNode = vIndex[iPos];
+		if (pNode == NULL) { break; }
+
+		if (pNode != Deleted() && pNode -> hash == iHash && pNode -> value.first == sKey) { return pNode; }
+
+		iPos = (iPos + 1) & iMask;
+	}
+
+return NULL;
+}
+
+//
+// Reserve space for elements
+//
+template<typename T> void CDTHashMap<T>::reserve(const size_type iElements)
+{
+	if (iElements <= iSize) { return; }
+
+	// Index is built once instead of being doubled on insertions
+	if (iElements > C_HASH_MAP_LINEAR_SIZE && (iElements + 1) * 2 > vIndex.size()) { Rehash(iElements); }
+
+	// Nodes of new elements are taken from one chunk
+	if (pFreeList == NULL && iChunkFree == 0)
+	{
+		const size_type iNodes = iElements - iSize;
+		AllocChunk(iNodes < C_HASH_MAP_MIN_CHUNK ? C_HASH_MAP_MIN_CHUNK : iNodes);
+	}
+}
+
+//
+// Insert new node
+//
+template<typename T> typename CDTHashMap<T>::Node * CDTHashMap<T>::InsertNode(const STLW::string  & sKey,
+                                                                              const T             & oValue,
+                                                                              const UINT_64         iHash)
+{
+	Node * pNode = AllocNode(sKey, oValue, iHash);
+
+	// Load factor of index should not exceed 1/2
+	try
+	{
+		if (!vIndex.empty() && (iIndexUsed + 1) * 2 <= vIndex.size()) { iIndexUsed += IndexNode(vIndex, pNode); }
+		else if (iSize + 1 > C_HASH_MAP_LINEAR_SIZE)
+		{
+			Rehash(iSize + 1);
+			iIndexUsed += IndexNode(vIndex, pNode);
+		}
+	}
+	catch(...)
+	{
+		FreeNode(pNode);
+		throw;
+	}
+
+	try
+	{
+		PlaceNode(pNode);
+	}
+	catch(...)
+	{
+		if (!vIndex.empty()) { UnindexNode(pNode); }
+		FreeNode(pNode);
+		throw;
+	}
+	++iSize;
+
+return pNode;
+}
+
+//
+// Put node into blocks
+//
+template<typename T> void CDTHashMap<T>::PlaceNode(Node * pNode)
+{
+	const STLW::string & sKey = pNode -> value.first;
+
+	// Keys are often inserted in ascending order
+	if (vBlocks.empty() || vBlocks.back().back() -> value.first < sKey)
+	{
+		if (vBlocks.empty() || vBlocks.back().size() == C_HASH_MAP_BLOCK_SIZE) { vBlocks.push_back(Block(pArena)); }
+
+		vBlocks.back().push_back(pNode);
+		return;
+	}
+
+	size_type iBlock = 0;
+	size_type iPos   = 0;
+	Locate(sKey, iBlock, iPos);
+
+	Block & vBlock = vBlocks[iBlock];
+	vBlock.insert(vBlock.begin() + iPos, pNode);
+
+	// Split full block into halves
+	if (vBlock.size() > C_HASH_MAP_BLOCK_SIZE)
+	{
+		Block vTail(vBlock.begin() + vBlock.size() / 2, vBlock.end(), pArena);
+		vBlocks.insert(vBlocks.begin() + iBlock + 1, Block(pArena));
+
+		Block & vHead = vBlocks[iBlock];
+		vHead.resize(vHead.size() - vTail.size());
+		vBlocks[iBlock + 1].swap(vTail);
+	}
+}
+
+//
+// Erase node
+//
+template<typename T> void CDTHashMap<T>::EraseNode(const size_type  iBlock,
+                                                   const size_type  iPos)
+{
+	Block & vBlock = vBlocks[iBlock];
+	Node  * pNode  = vBlock[iPos];
+
+	if (!vIndex.empty()) { UnindexNode(pNode); }
+
+	vBlock.erase(vBlock.begin() + iPos);
+	if (vBlock.empty()) { vBlocks.erase(vBlocks.begin() + iBlock); }
+	--iSize;
+
+	FreeNode(pNode);
+}
+
+//
+// Allocate and construct node
+//
+template<typename T> typename CDTHashMap<T>::Node * CDTHashMap<T>::AllocNode(const STLW::string  & sKey,
+                                                                             const T             & oValue,
+                                                                             const UINT_64         iHash)
+{
+	// Reuse released node
+	if (pFreeList != NULL)
+	{
+		void * vPlace = pFreeList;
+		pFreeList = *reinterpret_cast<void **>(vPlace);
+		try
+		{
+			return new (vPlace) Node(sKey, oValue, iHash);
+		}
+		catch(...)
+		{
+			*reinterpret_cast<void **>(vPlace) = pFreeList;
+			pFreeList = vPlace;
+			throw;
+		}
+	}
+
+	// Allocate new chunk, size of chunk is doubled each time
+	if (iChunkFree == 0) { AllocChunk(iAllocated < C_HASH_MAP_MIN_CHUNK ? C_HASH_MAP_MIN_CHUNK : iAllocated); }
+
+	Node * pNode = new (pChunkPos) Node(sKey, oValue, iHash);
+	++pChunkPos;
+	--iChunkFree;
+
+	// Key that allocated memory is destroyed with arena
+	if (pArena != NULL && pNode -> value.first.capacity() > STLW::string().capacity())
+	{
+		try
+		{
+			pArena -> AtRelease(DestroyObject<STLW::string>, const_cast<STLW::string *>(&(pNode -> value.first)));
+		}
+		catch(...)
+		{
+			pNode -> ~Node();
+			throw;
+		}
+	}
+
+return pNode;
+}
+
+//
+// Allocate chunk of nodes
+//
+template<typename T> void CDTHashMap<T>::AllocChunk(const size_type iChunkSize)
+{
+	if (pArena != NULL) { pChunkPos = static_cast<Node *>(pArena -> Allocate(sizeof(Node) * iChunkSize)); }
+	else
+	{
+		vChunks.reserve(vChunks.size() + 1);
+		pChunkPos  = static_cast<Node *>(::operator new(sizeof(Node) * iChunkSize));
+		vChunks.push_back(pChunkPos);
+	}
+	iChunkFree = iChunkSize;
+	iAllocated += iChunkSize;
+}
+
+//
+// Destroy node
+//
+template<typename T> void CDTHashMap<T>::DestroyNode(Node * pNode)
+{
+	if (pArena == NULL) { pNode -> ~Node(); }
+	else                { pNode -> value.second.~T(); }
+}
+
+//
+// Destroy and release node
+//
+template<typename T> void CDTHashMap<T>::FreeNode(Node * pNode)
+{
+	DestroyNode(pNode);
+
+	// Key of node in arena lives until arena is released, so node is not reused
+	if (pArena != NULL) { return; }
+
+	*reinterpret_cast<void **>(pNode) = pFreeList;
+	pFreeList = pNode;
+}
+
+//
+// Put node into index
+//
+template<typename T> typename CDTHashMap<T>::size_type CDTHashMap<T>::IndexNode(Index & vTargetIndex, Node * pNode)
+{
+	const size_type iMask = size_type(vTargetIndex.size()) - 1;
+	size_type iPos = Slot(pNode -> hash, iMask);
+	while (vTargetIndex[iPos] != NULL && vTargetIndex[iPos] != Deleted()) { iPos = (iPos + 1) & iMask; }
+
+	const size_type iUsed = (vTargetIndex[iPos] == NULL) ? 1 : 0;
+	vTargetIndex[iPos] = pNode;
+
+return iUsed;
+}
+
+//
+// Remove node from index
+//
+template<typename T> void CDTHashMap<T>::UnindexNode(const Node * pNode)
+{
+	const size_type iMask = size_type(vIndex.size()) - 1;
+	size_type iPos = Slot(pNode -> hash, iMask);
+	while (vIndex[iPos] != pNode) { iPos = (iPos + 1) & iMask; }
+
+	vIndex[iPos] = Deleted();
+}
+
+//
+// Rebuild index
+//
+template<typename T> void CDTHashMap<T>::Rehash(const size_type iElements)
+{
+	size_type iIndexSize = C_HASH_MAP_MIN_INDEX;
+	while (iIndexSize < (iElements + 1) * 2) { iIndexSize <<= 1; }
+
+	Index vNewIndex(iIndexSize, NULL, pArena);
+	size_type iNewIndexUsed = 0;
+
+	typename BlockList::const_iterator itvBlock = vBlocks.begin();
+	while (itvBlock != vBlocks.end())
+	{
+		typename Block::const_iterator itvElement = itvBlock -> begin();
+		while (itvElement != itvBlock -> end())
+		{
+			iNewIndexUsed += IndexNode(vNewIndex, *itvElement);
+			++itvElement;
+		}
+		++itvBlock;
+	}
+
+	vIndex.swap(vNewIndex);
+	iIndexUsed = iNewIndexUsed;
+}
+
+//
+// Destroy all elements and release memory
+//
+template<typename T> void CDTHashMap<T>::Clear() throw()
+{
+	typename BlockList::const_iterator itvBlock = vBlocks.begin();
+	while (itvBlock != vBlocks.end())
+	{
+		typename Block::const_iterator itvElement = itvBlock -> begin();
+		while (itvElement != itvBlock -> end())
+		{
+			DestroyNode(*itvElement);
+			++itvElement;
+		}
+		++itvBlock;
+	}
+	vBlocks.clear();
+	vIndex.clear();
+
+	STLW::vector<void *>::const_iterator itvChunk = vChunks.begin();
+	while (itvChunk != vChunks.end())
+	{
+		::operator delete(*itvChunk);
+		++itvChunk;
+	}
+	vChunks.clear();
+
+	iSize      = 0;
+	iIndexUsed = 0;
+	pChunkPos  = NULL;
+	iChunkFree = 0;
+	iAllocated = 0;
+	pFreeList  = NULL;
+}
+
+} // namespace CTPP
+#endif // _CDT_HASH_MAP_HPP__
+// End.
@@ -0,0 +1,204 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2BatchCompiler.hpp
+ *
+ * $CTPP$
+ */
+#ifndef _CTPP2_BATCH_COMPILER_HPP__
+#define _CTPP2_BATCH_COMPILER_HPP__ 1
+
+#include "CTPP2Types.h"
+
+#include "STLString.hpp"
+#include "STLVector.hpp"
+
+/**
+  @file CTPP2BatchCompiler.hpp
+  @brief Parallel compiler of template trees
+*/
+
+/** Extension of dependency manifest, added to name of compiled template */
+#define C_BATCH_DEPENDENCY_EXTENSION ".dep"
+
+namespace CTPP // C++ Template Engine
+{
+
+/**
+  @class BatchCompiler CTPP2BatchCompiler.hpp <CTPP2BatchCompiler.hpp>
+  @brief Parallel compiler of template trees
+
+  Templates are compiled by pool of threads; every thread takes templates
+  from own queue and steals from queues of other threads when own queue is
+  empty. Sources of templates and include files are read once and shared
+  between threads.
+
+  Dependency manifest is written next to every compiled template; it lists
+  size, modification time, hash and time of loading of source and of all
+  included files. Template is not compiled again while none of them is
+  changed; content of file modified in the same second it was loaded is
+  always compared by hash.
+*/
+class CTPP2DECL BatchCompiler
+{
+private:
+	// FWD
+	struct SourceCache;
+	struct WorkQueue;
+	struct WorkerContext;
+	class  BatchSourceLoader;
+public:
+	/**
+	  @enum eJobStatus CTPP2BatchCompiler.hpp <CTPP2BatchCompiler.hpp>
+	  @brief Result of compilation
+	*/
+	enum eJobStatus { PENDING    = 0,
+	                  COMPILED   = 1,
+	                  UP_TO_DATE = 2,
+	                  FAILED     = 3 };
+
+	/**
+	  @struct Job CTPP2BatchCompiler.hpp <CTPP2BatchCompiler.hpp>
+	  @brief Template to compile
+	*/
+	struct Job
+	{
+		/** Source file of template     */
+		STLW::string   source;
+		/** Compiled template file      */
+		STLW::string   destination;
+		/** Result of compilation       */
+		eJobStatus     status;
+		/** Error message, if failed    */
+		STLW::string   error;
+	};
+
+	/**
+	  @brief Constructor
+	  @param bIOptimize - apply all optimizations to compiled code
+	  @param bIIncludeUnits - compile every distinct include file once per template
+	*/
+	BatchCompiler(const bool  bIOptimize     = false,
+	              const bool  bIIncludeUnits = false);
+
+	/**
+	  @brief Add template
+	  @param sSource - source file of template
+	  @param sDestination - compiled template file
+	*/
+	void AddTemplate(const STLW::string  & sSource,
+	                 const STLW::string  & sDestination);
+
+	/**
+	  @brief Add all templates from directory tree; tree is mirrored into destination directory
+	  @param sSourceDir - source directory
+	  @param sDestinationDir - destination directory
+	  @param sExtension - extension of template files
+	  @return number of added templates
+	*/
+	UINT_32 AddDirectory(const STLW::string  & sSourceDir,
+	                     const STLW::string  & sDestinationDir,
+	                     const STLW::string  & sExtension = ".tmpl");
+
+	/**
+	  @brief Add templates listed in manifest; every line contains source file and, optionally, compiled file name
+	  @param sManifest - manifest file; relative names are resolved from directory of manifest
+	  @param sDestinationDir - directory for compiled templates with relative or omitted names
+	  @return number of added templates
+	*/
+	UINT_32 AddManifest(const STLW::string  & sManifest,
+	                    const STLW::string  & sDestinationDir);
+
+	/**
+	  @brief Compile templates
+	  @param iThreads - number of threads
+	  @param bForce - compile templates even if they are not changed
+	  @return number of failed templates
+	*/
+	UINT_32 Compile(const UINT_32  iThreads,
+	                const bool     bForce = false);
+
+	/**
+	  @brief Get templates and results of compilation
+	  @return list of templates in order of addition
+	*/
+	const STLW::vector<Job> & GetJobs() const;
+
+	/**
+	  @brief A destructor
+	*/
+	~BatchCompiler() throw();
+private:
+	/** Optimize code               */
+	const bool           bOptimize;
+	/** Use include units           */
+	const bool           bIncludeUnits;
+	/** Templates                   */
+	STLW::vector<Job>    vJobs;
+	/** Shared sources of templates */
+	SourceCache        * pSourceCache;
+	/** Work queues, one per thread */
+	WorkQueue          * aQueues;
+	/** Number of work queues       */
+	UINT_32              iQueues;
+	/** Skip unchanged templates    */
+	bool                 bSkipUnchanged;
+
+	/**
+	  @brief Compile template
+	  @param oJob - template to compile
+	*/
+	void CompileJob(Job & oJob);
+
+	/**
+	  @brief Check dependency manifest of compiled template
+	  @param oJob - template
+	  @return true if template and all included files are not changed
+	*/
+	bool IsUpToDate(const Job & oJob);
+
+	/**
+	  @brief Get next template to compile, own queue first
+	  @param iQueue - queue of thread
+	  @return index of template or -1 if all templates are taken
+	*/
+	INT_32 NextJob(const UINT_32  iQueue);
+
+	/**
+	  @brief Worker thread function
+	  @param pContext - worker context
+	*/
+	static void * WorkerThread(void * pContext);
+
+	// Does not exist
+	BatchCompiler(const BatchCompiler & oRhs);
+	BatchCompiler & operator=(const BatchCompiler & oRhs);
+};
+
+} // namespace CTPP
+#endif // _CTPP2_BATCH_COMPILER_HPP__
+// End.
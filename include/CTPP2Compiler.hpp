@@ -52,6 +52,7 @@ class HashTable;
 class StaticText;
 class StaticData;
 class CTPP2Parser;
+class CTPP2GetText;
 
 /**
   @class CTPP2Compiler CTPP2Parser.hpp <CTPP2Parser.hpp>
@@ -74,6 +75,14 @@ public:
 	              StaticText         & oIStaticText,
 	              HashTable          & oIHashTable);
 
+	/**
+	  @brief Translate calls of gettext with static arguments at compile time
+	  @param pIGetText - translations, NULL to leave all calls to run time
+	  @param sILanguage - language of translation
+	*/
+	void SetTranslation(const CTPP2GetText   * pIGetText,
+	                    const STLW::string   & sILanguage);
+
 	/**
 	  @brief Store template source name
 	  @param szName -  name
@@ -89,6 +98,17 @@ public:
 	*/
 	INT_32 OutputVariable(const VMDebugInfo & oDebugInfo = VMDebugInfo());
 
+	/**
+	  @brief  Send result of expression to standard output collector; if expression is
+	          a single variable, optionally passed through escape function, whole sequence
+	          is replaced with OUTVAR/OUTVAR_ESC superinstruction; if expression ends with
+	          system call, call is replaced with OUTSYS
+	  @param iExprIP - instruction pointer of first instruction of expression
+	  @param oDebugInfo - debug information object
+	*/
+	INT_32 OutputVariable(const UINT_32        iExprIP,
+	                      const VMDebugInfo  & oDebugInfo);
+
 	/**
 	  @brief Send text data to standard output collector
 	  @param vBuffer - data
@@ -279,6 +299,40 @@ public:
 	*/
 	void PrepareCallBlock(const VMDebugInfo & oDebugInfo = VMDebugInfo());
 
+	/**
+	  @brief Start of include unit; unit body is skipped by jump and executed by CALL only
+	  @param oDebugInfo - debug information object
+	  @return instruction pointer of jump over unit body if success, -1 if any error occured
+	*/
+	INT_32 StartIncludeUnit(const VMDebugInfo & oDebugInfo = VMDebugInfo());
+
+	/**
+	  @brief End of include unit; registers unit and calls it
+	  @param sUnitName - unit name (normalized name of include file)
+	  @param iJumpIP - instruction pointer returned by StartIncludeUnit
+	  @param oDebugInfo - debug information object
+	  @return instruction pointer if success, -1 if any error occured
+	*/
+	INT_32 EndIncludeUnit(const STLW::string  & sUnitName,
+	                      const UINT_32         iJumpIP,
+	                      const VMDebugInfo   & oDebugInfo = VMDebugInfo());
+
+	/**
+	  @brief Get entry point of compiled include unit
+	  @param sUnitName - unit name
+	  @return entry point of unit or -1 if unit is not compiled yet
+	*/
+	INT_32 GetIncludeUnit(const STLW::string & sUnitName) const;
+
+	/**
+	  @brief Call include unit
+	  @param iEntryIP - entry point of unit
+	  @param oDebugInfo - debug information object
+	  @return instruction pointer if success, -1 if any error occured
+	*/
+	INT_32 CallIncludeUnit(const UINT_32        iEntryIP,
+	                       const VMDebugInfo  & oDebugInfo = VMDebugInfo());
+
 	// ////////////////////////////////////////////////////////////////////////////////
 
 	/**
@@ -617,6 +671,35 @@ private:
 	UINT_32                            iCurrBlockStackDepth;
 	/** Saved stack depths for blocks */
 	STLW::vector<UINT_32>              vSavedStackDepths;
+	/** Entry points of include units */
+	STLW::map<STLW::string,  UINT_32>  mIncludeUnits;
+	/** Translations for static gettext calls */
+	const CTPP2GetText               * pGetText;
+	/** Language of translation    */
+	STLW::string                       sLanguage;
+
+	/**
+	  @brief Replace call of gettext with static arguments by its translation
+	  @param szSyscallName - system call name
+	  @param iSyscallNameLength - system call name length
+	  @param iArgNum - number of arguments
+	  @param oDebugInfo - debug information
+	  @return instruction pointer if call is translated, -1 otherwise
+	*/
+	INT_32 TranslateSyscall(CCHAR_P              szSyscallName,
+	                        const UINT_32        iSyscallNameLength,
+	                        const UINT_32        iArgNum,
+	                        const VMDebugInfo  & oDebugInfo);
+
+	/**
+	  @brief Send result of expression ending with system call to standard output collector,
+	         system call writes result directly to collector
+	  @param iExprIP - instruction pointer of first instruction of expression
+	  @param oDebugInfo - debug information object
+	  @return instruction pointer
+	*/
+	INT_32 OutputSyscall(const UINT_32        iExprIP,
+	                     const VMDebugInfo  & oDebugInfo);
 };
 
 } // namespace CTPP
@@ -0,0 +1,184 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2Escape.hpp
+ *
+ * $CTPP$
+ */
+#ifndef _CTPP2_ESCAPE_HPP__
+#define _CTPP2_ESCAPE_HPP__ 1
+
+#include "CTPP2Types.h"
+
+#include "STLString.hpp"
+
+/**
+  @file CTPP2Escape.hpp
+  @brief Escaping of HTML, XML, WML, URL, URI and JSON strings
+*/
+
+/** Max. length of escape sequence for one character, "&quot;" or "\u001F" */
+#define C_ESCAPE_MAX_EXPANSION      6
+
+namespace CTPP // C++ Template Engine
+{
+// FWD
+class CDT;
+class DumpBuffer;
+class OutputCollector;
+
+/**
+  @enum eEscapeType CTPP2Escape.hpp <CTPP2Escape.hpp>
+  @brief Escaping rules
+*/
+enum eEscapeType { ESCAPE_HTML,             /**< " ' < > &                                        */
+                   ESCAPE_XML,              /**< " ' < > &, apostrophe is &apos;                  */
+                   ESCAPE_WML,              /**< as XML, $ is doubled, control characters removed */
+                   ESCAPE_URL,              /**< all except [A-Za-z0-9/._-], space is '+'         */
+                   ESCAPE_URI,              /**< all except [A-Za-z0-9/._-]                       */
+                   ESCAPE_JSON,             /**< JSON string                                      */
+                   ESCAPE_JSON_ECMA,        /**< JSON string, ECMA-262 conventions for ' \v \0    */
+                   ESCAPE_JSON_HTML,        /**< JSON string, < and > escaped                     */
+                   ESCAPE_JSON_ECMA_HTML    /**< JSON string, ECMA-262 conventions, < and >       */
+                 };
+
+/**
+  @enum eEscapeKernel CTPP2Escape.hpp <CTPP2Escape.hpp>
+  @brief Implementation of search of characters to escape
+*/
+enum eEscapeKernel { ESCAPE_KERNEL_AUTO,    /**< Fastest one supported by CPU */
+                     ESCAPE_KERNEL_SCALAR,  /**< Byte by byte, lookup table   */
+                     ESCAPE_KERNEL_SSE2,    /**< 16 bytes per step            */
+                     ESCAPE_KERNEL_AVX2     /**< 32 bytes per step            */
+                   };
+
+/**
+  @fn eEscapeKernel SetEscapeKernel(const eEscapeKernel eKernel)
+  @brief Select search kernel; not thread-safe, call it before any escaping is done
+  @param eKernel - kernel to use
+  @return Kernel actually used; kernel not supported by CPU or compiler is replaced with the fastest supported
+*/
+eEscapeKernel SetEscapeKernel(const eEscapeKernel eKernel);
+
+/**
+  @fn eEscapeKernel GetEscapeKernel()
+  @brief Get used search kernel
+  @return Search kernel
+*/
+eEscapeKernel GetEscapeKernel();
+
+/**
+  @fn UINT_32 EscapeScan(const eEscapeType eType, CCHAR_P szData, const UINT_32 iDataLength)
+  @brief Find first character to escape
+  @param eType - escaping rules
+  @param szData - data to check
+  @param iDataLength - data length
+  @return Position of first character to escape, or iDataLength if data can be written as is
+*/
+UINT_32 EscapeScan(const eEscapeType  eType,
+                   CCHAR_P            szData,
+                   const UINT_32      iDataLength);
+
+/**
+  @fn UINT_32 Escape(const eEscapeType eType, CCHAR_P szData, const UINT_32 iDataLength, CHAR_P szBuffer)
+  @brief Escape data to buffer
+  @param eType - escaping rules
+  @param szData - data to escape
+  @param iDataLength - data length
+  @param szBuffer - destination buffer, at least iDataLength * C_ESCAPE_MAX_EXPANSION bytes
+  @return Length of escaped data
+*/
+UINT_32 Escape(const eEscapeType  eType,
+               CCHAR_P            szData,
+               const UINT_32      iDataLength,
+               CHAR_P             szBuffer);
+
+/**
+  @fn void Escape(const eEscapeType eType, CCHAR_P szData, const UINT_32 iDataLength, STLW::string & sResult)
+  @brief Escape data and append it to string
+  @param eType - escaping rules
+  @param szData - data to escape
+  @param iDataLength - data length
+  @param sResult - string to append escaped data to
+*/
+void Escape(const eEscapeType  eType,
+            CCHAR_P            szData,
+            const UINT_32      iDataLength,
+            STLW::string     & sResult);
+
+/**
+  @fn void Escape(const eEscapeType eType, CCHAR_P szData, const UINT_32 iDataLength, DumpBuffer & oBuffer)
+  @brief Escape data and append it to dump buffer
+  @param eType - escaping rules
+  @param szData - data to escape
+  @param iDataLength - data length
+  @param oBuffer - buffer to append escaped data to
+*/
+void Escape(const eEscapeType  eType,
+            CCHAR_P            szData,
+            const UINT_32      iDataLength,
+            DumpBuffer       & oBuffer);
+
+/**
+  @fn void Escape(const eEscapeType eType, CCHAR_P szData, const UINT_32 iDataLength, OutputCollector & oCollector)
+  @brief Escape data and write it to output collector; runs of characters
+         that need no escaping are passed to collector as is, without copying
+  @param eType - escaping rules
+  @param szData - data to escape
+  @param iDataLength - data length
+  @param oCollector - output collector
+*/
+void Escape(const eEscapeType  eType,
+            CCHAR_P            szData,
+            const UINT_32      iDataLength,
+            OutputCollector  & oCollector);
+
+/**
+  @fn void Escape(const eEscapeType eType, const CDT & oData, STLW::string & sResult)
+  @brief Escape string representation of CDT value and append it to string
+  @param eType - escaping rules
+  @param oData - value to escape
+  @param sResult - destination string
+*/
+void Escape(const eEscapeType  eType,
+            const CDT        & oData,
+            STLW::string     & sResult);
+
+/**
+  @fn void Escape(const eEscapeType eType, const CDT & oData, OutputCollector & oCollector)
+  @brief Escape string representation of CDT value and write it to output collector
+  @param eType - escaping rules
+  @param oData - value to escape
+  @param oCollector - output collector
+*/
+void Escape(const eEscapeType  eType,
+            const CDT        & oData,
+            OutputCollector  & oCollector);
+
+} // namespace CTPP
+#endif // _CTPP2_ESCAPE_HPP__
+// End.
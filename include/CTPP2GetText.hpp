@@ -32,11 +32,18 @@
 #ifndef _CTPP2_GETTEXT_HPP__
 #define _CTPP2_GETTEXT_HPP__ 1
 
-#include "CTPP2Types.h"
+#include "CDT.hpp"
+#include "CTPP2MappedFile.hpp"
 #include "STLString.hpp"
 #include "STLVector.hpp"
 #include "STLMap.hpp"
 
+/**
+  @def C_GETTEXT_MAX_PLURAL_RULE
+  @brief Max. number of data items and instructions of compiled plural form rule
+*/
+#define C_GETTEXT_MAX_PLURAL_RULE 128
+
 namespace CTPP // C++ Template Engine
 {
 
@@ -44,71 +51,67 @@ namespace CTPP // C++ Template Engine
 class SyscallFactory;
 
 /**
-  @class CTPP2GetText CTPP2GetText.hpp <CTPP2GetText.hpp>
-  @brief CTPP2 gettext support
+  @class CTPP2GetTextCatalog CTPP2GetText.hpp <CTPP2GetText.hpp>
+  @brief Compiled i18n catalog of one .mo file. Messages are looked up through .mo hash table
+         (or own index with the same hash function if file has none) directly in memory-mapped data,
+         plural form rule is compiled into fixed-size instruction arrays; lookup allocates no memory
 */
-class CTPP2DECL CTPP2GetText
+class CTPP2DECL CTPP2GetTextCatalog
 {
 public:
 	/**
 	  @brief A constructor
+	  @param sFileName - .mo filename
+	  @param sDomain - i18n domain, used in error messages
 	*/
-	CTPP2GetText();
-
-	/**
-	  @brief A destructor
-	*/
-	~CTPP2GetText() throw();
+	CTPP2GetTextCatalog(const STLW::string & sFileName, const STLW::string & sDomain);
 
 	/**
-	  @brief Add translation
-	  @param sFileName - .mo filename
-	  @param sDomain - i18n domain
-	  @param sLang - language of translation
+	  @brief Find message
+	  @param szMessage - message, not necessarily zero-terminated
+	  @param iMessageLength - message length
+	  @return message index or -1 if message not found
 	*/
-	void AddTranslation(const STLW::string & sFileName, const STLW::string & sDomain, const STLW::string & sLang);
+	INT_32 FindMessage(CCHAR_P szMessage, const UINT_32 iMessageLength) const;
 
 	/**
-	  @brief Find translated message
-	  @param sLang - language of translation
-	  @param sMessage - message
-	  @param sDomain - i18n domain (if none, default domain used)
-	  @return translated message
+	  @brief Get translation of message
+	  @param iMessage - message index
+	  @param iForm - number of plural form, 0 for singular
+	  @return view of translation in .mo data or NULL if there is no such plural form;
+	          view is valid while catalog exists
 	*/
-	STLW::string FindMessage(const STLW::string & sLang, const STLW::string & sMessage, const STLW::string & sDomain = "");
+	const CDTStringView * GetTranslation(const INT_32 iMessage, const UINT_32 iForm) const;
 
 	/**
-	  @brief Find translated message with correct plural form
-	  @param sLang - language of translation
-	  @param sMessage - message in singular
-	  @param sPlMessage - message in plural
+	  @brief Calculate plural form of message
 	  @param iCount - determine plural form
-	  @param sDomain - i18n domain (if none, default domain used)
-	  @return translated message
+	  @return Number of plural form
 	*/
-	STLW::string FindPluralMessage(const STLW::string & sLang, const STLW::string & sMessage, const STLW::string & sPlMessage,
-	                               UINT_32 iCount, const STLW::string & ssDomain = "");
+	UINT_32 GetPluralForm(const UINT_32 iCount) const;
 
 	/**
-	  @brief Set default i18n domain
-	  @param sDomain - i18n domain
+	  @brief Get translation of message with correct plural form
+	  @param iMessage - message index
+	  @param iCount - determine plural form
+	  @return view of translation in .mo data, valid while catalog exists
 	*/
-	void SetDefaultDomain(const STLW::string & sDomain);
+	const CDTStringView & GetPluralTranslation(const INT_32 iMessage, const UINT_32 iCount) const;
 
 	/**
-	  @brief Initialize system calls FnGetText/FnGetText_
-	  @param oSyscallFactory - factory with system calls
+	  @brief Get charset of messages
 	*/
-	void InitSTDLibFunction(SyscallFactory & oSyscallFactory);
+	const STLW::string & GetCharset() const;
 
 	/**
-	  @brief Set language for system calls FnGetText/FnGetText_
-	  @param oSyscallFactory - factory with system calls
-	  @param sLang - language of translation
+	  @brief A destructor
 	*/
-	void SetLanguage(SyscallFactory & oSyscallFactory, const STLW::string & sLang);
-
+	~CTPP2GetTextCatalog() throw();
 private:
+	// Does not exist
+	CTPP2GetTextCatalog(const CTPP2GetTextCatalog & oRhs);
+	CTPP2GetTextCatalog & operator=(const CTPP2GetTextCatalog & oRhs);
+
 	enum eCTPP2Instruction { INS_NONE  = 0,
 	                         INS_EQ    = 1,
 	                         INS_NE    = 2,
@@ -122,101 +125,94 @@ private:
 	                         INS_JLAND = 10,
 	                         INS_JLOR  = 11 };
 
-	/**
-	  @struct CTPP2Data CTPP2GetText.hpp <CTPP2GetText.hpp>
-	  @brief Representation of number/placeholder in plural form rule
-	*/
-	struct CTPP2Data
-	{
-		/**
-		  @brief A constructor for number data
-		  @param iValue - number
-		*/
-		CTPP2Data(UINT_32 iValue) : i_value(iValue), b_variable(false) { ;; }
-
-		/**
-		  @brief A constructor for placeholder data
-		*/
-		CTPP2Data() : i_value(0), b_variable(true) { ;; }
-
-		/** value of number  */
-		UINT_32 i_value;
-		/** placeholder flag */
-		bool b_variable;
-	};
-
-	/**
-	  @struct CTPP2Data CTPP2GetText.hpp <CTPP2GetText.hpp>
-	  @brief i18n catalog
-	*/
-	struct CTPP2Catalog
-	{
-		/** stack of data for determining of plural form */
-		STLW::vector<CTPP2Data> v_pl_stack;
-		/** list of instructions for determining of plural form */
-		STLW::vector<eCTPP2Instruction> v_pl_instructions;
-		/** charset of messages from .mo file */
-		STLW::string s_charset;
-		/** messages with translations */
-		STLW::map<STLW::string, STLW::vector<STLW::string> > m_messages;
-		/** generic information from .mo file */
-		STLW::map<STLW::string, STLW::string> m_info;
-		/** flag of endiannes of .mo file */
-		bool b_reversed;
-	};
-
-	/** Type of catalog map */
-	typedef STLW::map<STLW::string, STLW::map<STLW::string, CTPP2Catalog> > CatalogMap;
-
-	/** CTPP2Catalog map                                 */
-	CatalogMap mCatalog;
-	/** Default i18n domain                         */
-	STLW::string sDefaultDomain;
-
-	/** i18n domain for generating plural form rule */
-	STLW::string sWorkableDomain;
-	/** Language for generating plural form rule    */
-	STLW::string sWorkableLang;
+	/** i18n domain                                    */
+	STLW::string                          sDomain;
+	/** .mo file                                       */
+	MappedFile                            oFile;
+	/** .mo data                                       */
+	UCCHAR_P                              pData;
+	/** Length of .mo data                             */
+	UINT_32                               iDataLength;
+	/** flag of endiannes of .mo file                  */
+	bool                                  bReversed;
+
+	/** Original messages                              */
+	STLW::vector<CDTStringView>           vOriginals;
+	/** Translations, all plural forms of all messages */
+	STLW::vector<CDTStringView>           vTranslations;
+	/** Index of first translation of each message     */
+	STLW::vector<UINT_32>                 vFirstTranslation;
+
+	/** Hash table, .mo or own one                     */
+	const UINT_32                       * pHashTable;
+	/** Hash table size                                */
+	UINT_32                               iHashSize;
+	/** Hash table has byte order of .mo file          */
+	bool                                  bHashReversed;
+	/** Own hash table, if .mo file has none           */
+	STLW::vector<UINT_32>                 vHashTable;
+
+	/** charset of messages from .mo file              */
+	STLW::string                          sCharset;
+	/** generic information from .mo file              */
+	STLW::map<STLW::string, STLW::string> mInfo;
+
+	/** Data for determining of plural form, in order of evaluation  */
+	UINT_32                               aPluralStack[C_GETTEXT_MAX_PLURAL_RULE];
+	/** Placeholder flags of data                                    */
+	UCHAR_8                               aPluralVariable[C_GETTEXT_MAX_PLURAL_RULE];
+	/** Number of data items                                         */
+	UINT_32                               iPluralStackSize;
+	/** Instructions for determining of plural form                  */
+	UCHAR_8                               aPluralInstructions[C_GETTEXT_MAX_PLURAL_RULE];
+	/** Number of instructions                                       */
+	UINT_32                               iPluralInstructionsSize;
 
 	// Parsing of .mo file ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 	/**
-	  @brief Parse line of metadata from .mo file
-	  @param sLine - line of metadata
-	  @param sLastKey - key for multiline value
+	  @brief Map or read .mo file
+	  @param sFileName - .mo filename
 	*/
-	void ParseMetadataLine(const STLW::string & sLine, STLW::string & sLastKey);
+	void ReadFile(const STLW::string & sFileName);
 
 	/**
-	  @brief Parse metadata from .mo file
-	  @param sMeta - metadata
+	  @brief Parse .mo data, build index
+	  @param sFileName - .mo filename
 	*/
-	void ParseMetadata(const STLW::string & sMeta);
+	void ParseData(const STLW::string & sFileName);
 
 	/**
 	  @brief Read .mo data by 4 bytes
-	  @param pData - .mo data
 	  @param iOffset - offset of reading
 	  @return integer value
 	*/
-	UINT_32 ReadMOData(UCCHAR_P pData, INT_32 iOffset);
-
-	/**
-	  @brief Read .mo file
-	  @param szFileName - .mo filename
-	  @param iLength - length of read file
-	  @return data
-	*/
-	UCHAR_P ReadFile(CCHAR_P szFileName, UINT_32 & iLength);
+	UINT_32 ReadMOData(const UINT_32 iOffset) const;
 
 	/**
 	  @brief Extract message from .mo data
-	  @param pData - .mo data
-	  @param iLength - length of .mo data
 	  @param iMasteridx - message index
 	  @param iTransidx - translated message index
 	*/
-	void ExtractMessage(UCCHAR_P pData, UINT_32 iLength, INT_32 iMasteridx, INT_32 iTransidx);
+	void ExtractMessage(const UINT_32 iMasteridx, const UINT_32 iTransidx);
+
+	/**
+	  @brief Build own hash table for .mo file without it
+	*/
+	void BuildHashTable();
+
+	/**
+	  @brief Parse line of metadata from .mo file
+	  @param sLine - line of metadata
+	  @param sLastKey - key for multiline value
+	*/
+	void ParseMetadataLine(const STLW::string & sLine, STLW::string & sLastKey);
+
+	/**
+	  @brief Parse metadata from .mo file
+	  @param sMeta - metadata
+	*/
+	void ParseMetadata(const STLW::string & sMeta);
 
 	// Expressions for generating plural form rule ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -279,13 +275,18 @@ private:
 	// Other stuff ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 	/**
-	  @brief Calculate plural form of message
-	  @param iCount - determine plural form
-	  @param sLang - language of translation
-	  @param sDomain - i18n domain
-	  @return Number of plural form
+	  @brief Add data item to plural form rule
+	  @param iValue - number
+	  @param bVariable - placeholder flag
+	  @return index of data item
 	*/
-	UINT_32 CalculatePluralForm(UINT_32 iCount, const STLW::string & sLang, const STLW::string & sDomain);
+	UINT_32 PushPluralData(const UINT_32 iValue, const bool bVariable = false);
+
+	/**
+	  @brief Add instruction to plural form rule
+	  @param eType - instruction for determining plural form
+	*/
+	void PushPluralInstruction(const eCTPP2Instruction eType);
 
 	/**
 	  @brief Generate plural form rule
@@ -298,8 +299,128 @@ private:
 	  @param eType - instruction for determining plural form
 	  @return string representation of instruction
 	*/
-	CCHAR_P StringifyInstruction(eCTPP2Instruction eType);
+	static CCHAR_P StringifyInstruction(const UINT_32 eType);
+};
+
+/**
+  @class CTPP2GetText CTPP2GetText.hpp <CTPP2GetText.hpp>
+  @brief CTPP2 gettext support
+*/
+class CTPP2DECL CTPP2GetText
+{
+public:
+	/** List of catalogs of i18n domain, most recently added first */
+	typedef STLW::vector<CTPP2GetTextCatalog *>                  CatalogList;
+	/** Catalogs of language, by i18n domain                       */
+	typedef STLW::map<STLW::string, CatalogList>                 DomainMap;
+
+	/**
+	  @brief A constructor
+	*/
+	CTPP2GetText();
+
+	/**
+	  @brief A destructor
+	*/
+	~CTPP2GetText() throw();
+
+	/**
+	  @brief Add translation
+	  @param sFileName - .mo filename
+	  @param sDomain - i18n domain
+	  @param sLang - language of translation
+	*/
+	void AddTranslation(const STLW::string & sFileName, const STLW::string & sDomain, const STLW::string & sLang);
+
+	/**
+	  @brief Find translated message
+	  @param sLang - language of translation
+	  @param sMessage - message
+	  @param sDomain - i18n domain (if none, default domain used)
+	  @return translated message
+	*/
+	STLW::string FindMessage(const STLW::string & sLang, const STLW::string & sMessage, const STLW::string & sDomain = "") const;
 
+	/**
+	  @brief Find translated message with correct plural form
+	  @param sLang - language of translation
+	  @param sMessage - message in singular
+	  @param sPlMessage - message in plural
+	  @param iCount - determine plural form
+	  @param sDomain - i18n domain (if none, default domain used)
+	  @return translated message
+	*/
+	STLW::string FindPluralMessage(const STLW::string & sLang, const STLW::string & sMessage, const STLW::string & sPlMessage,
+	                               UINT_32 iCount, const STLW::string & ssDomain = "") const;
+
+	/**
+	  @brief Get catalogs of language
+	  @param sLang - language of translation
+	  @return catalogs by i18n domain or NULL if language has no translations
+	*/
+	const DomainMap * GetDomains(const STLW::string & sLang) const;
+
+	/**
+	  @brief Get catalogs of i18n domain
+	  @param pDomains - catalogs of language, may be NULL
+	  @param sDomain - i18n domain (if none, default domain used)
+	  @return list of catalogs or NULL if domain has no translations
+	*/
+	const CatalogList * GetCatalogs(const DomainMap * pDomains, const STLW::string & sDomain = "") const;
+
+	/**
+	  @brief Find message in list of catalogs
+	  @param pCatalogs - list of catalogs, may be NULL
+	  @param szMessage - message, not necessarily zero-terminated
+	  @param iMessageLength - message length
+	  @param iMessage - message index in catalog, if found
+	  @return catalog with message or NULL if message not found
+	*/
+	static const CTPP2GetTextCatalog * FindCatalog(const CatalogList  * pCatalogs,
+	                                               CCHAR_P              szMessage,
+	                                               const UINT_32        iMessageLength,
+	                                               INT_32             & iMessage);
+
+	/**
+	  @brief Set default i18n domain
+	  @param sDomain - i18n domain
+	*/
+	void SetDefaultDomain(const STLW::string & sDomain);
+
+	/**
+	  @brief Get revision of catalogs, it is changed by AddTranslation and SetDefaultDomain
+	  @return revision number
+	*/
+	UINT_32 GetRevision() const;
+
+	/**
+	  @brief Initialize system calls FnGetText/FnGetText_
+	  @param oSyscallFactory - factory with system calls
+	*/
+	void InitSTDLibFunction(SyscallFactory & oSyscallFactory);
+
+	/**
+	  @brief Set language for system calls FnGetText/FnGetText_; binds catalogs of language and default
+	         domain to system calls once instead of every call
+	  @param oSyscallFactory - factory with system calls
+	  @param sLang - language of translation
+	*/
+	void SetLanguage(SyscallFactory & oSyscallFactory, const STLW::string & sLang);
+
+private:
+	// Does not exist
+	CTPP2GetText(const CTPP2GetText & oRhs);
+	CTPP2GetText & operator=(const CTPP2GetText & oRhs);
+
+	/** Type of catalog map */
+	typedef STLW::map<STLW::string, DomainMap> CatalogMap;
+
+	/** Catalogs by language and i18n domain        */
+	CatalogMap mCatalog;
+	/** Default i18n domain                         */
+	STLW::string sDefaultDomain;
+	/** Revision of catalogs                        */
+	UINT_32      iRevision;
 };
 
 } // namespace CTPP
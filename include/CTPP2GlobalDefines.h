@@ -57,6 +57,11 @@
     #define _DEBUG 1
 #endif // DEBUG_MODE
 
+/*
+ * Define this if you want to build virtual machine without computed goto instruction dispatch
+ */
+/* #define _NO_COMPUTED_GOTO 1 */
+
 /*
  * Define this if your compiler does not support namesapce std for STL
  */
@@ -42,6 +42,16 @@
 namespace CTPP // C++ Template Engine
 {
 
+/**
+  @fn UINT_64 HashFunc(CCHAR_P sKey, const UINT_32 iLength)
+  @brief Hash function
+  @param sKey - key
+  @param iLength - key length
+  @return hash value
+*/
+UINT_64 HashFunc(CCHAR_P        sKey,
+                 const UINT_32  iLength);
+
 /**
   @struct HashElement CTPP2HashTable.hpp <CTPP2HashTable.hpp>
   @brief Static data variable
@@ -148,6 +158,7 @@ public:
 	~HashTable() throw();
 private:
 	friend class VMDumper;
+	friend class VMOptimizer;
 
 	// Does not exist
 	HashTable(const HashTable & oRhs);
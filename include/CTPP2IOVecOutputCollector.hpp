@@ -0,0 +1,152 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2IOVecOutputCollector.hpp
+ *
+ * $CTPP$
+ */
+#ifndef _CTPP2_IOVEC_OUTPUT_COLLECTOR_HPP__
+#define _CTPP2_IOVEC_OUTPUT_COLLECTOR_HPP__ 1
+
+#include "CTPP2OutputCollector.hpp"
+#include "STLVector.hpp"
+
+#ifdef HAVE_SYS_UIO_H
+
+#include <sys/uio.h>
+
+/**
+  @file CTPP2IOVecOutputCollector.hpp
+  @brief Virtual machine output data collector, scatter/gather list of fragments
+*/
+
+/** Size of buffer chunk for dynamic data                    */
+#define C_IOVEC_CHUNK_SIZE          16384
+
+/** Static text shorter than this is copied, not referenced  */
+#define C_IOVEC_MIN_STATIC_LENGTH   64
+
+namespace CTPP // C++ Template Engine
+{
+
+/**
+  @class IOVecOutputCollector CTPP2IOVecOutputCollector.hpp <CTPP2IOVecOutputCollector.hpp>
+  @brief Output data collector; static text is stored as reference, dynamic data
+         is copied into chunked buffer, result is a list of iovec fragments.
+
+  References to static text are valid while program core exists, so result
+  must be sent before program core is released.
+*/
+class CTPP2DECL IOVecOutputCollector:
+  public OutputCollector
+{
+public:
+	/**
+	  @brief Constructor
+	  @param iIChunkSize - size of buffer chunk
+	*/
+	IOVecOutputCollector(const UINT_32  iIChunkSize = C_IOVEC_CHUNK_SIZE);
+
+	/**
+	  @brief Collect data, data is copied
+	  @param vData - data to store
+	  @param iDataLength - data length
+	  @return 0 - if success, -1 - if any error occured
+	*/
+	INT_32 Collect(const void     * vData,
+	               const UINT_32    iDataLength);
+
+	/**
+	  @brief Collect static text, long text is stored as reference
+	  @param vData - data to store
+	  @param iDataLength - data length
+	  @return 0 - if success, -1 - if any error occured
+	*/
+	INT_32 CollectStatic(const void     * vData,
+	                     const UINT_32    iDataLength);
+
+	/**
+	  @brief Get list of collected fragments
+	  @param iIOVecCount - number of fragments [out]
+	  @return pointer to first fragment
+	*/
+	const struct iovec * GetIOVec(UINT_32 & iIOVecCount) const;
+
+	/**
+	  @brief Get total size of collected data
+	*/
+	UINT_64 GetSize() const;
+
+	/**
+	  @brief Write collected data to file descriptor with writev(2) and clear collector
+	  @param iFD - file or socket descriptor
+	  @return 0 - if success, -1 - if any error occured, errno is set
+	*/
+	INT_32 Flush(const INT_32  iFD);
+
+	/**
+	  @brief Clear collected data; first chunk of buffer is kept for reuse
+	*/
+	void Clear();
+
+	/**
+	  @brief A destructor
+	*/
+	~IOVecOutputCollector() throw();
+private:
+	/** List of fragments                 */
+	STLW::vector<struct iovec>  vIOVec;
+	/** Chunks of buffer                  */
+	STLW::vector<CHAR_P>        vChunks;
+	/** Separate blocks for large data    */
+	STLW::vector<CHAR_P>        vLargeBlocks;
+	/** Free space of last chunk          */
+	CHAR_P                      pPos;
+	/** Size of free space in last chunk  */
+	UINT_32                     iFree;
+	/** Size of chunk                     */
+	UINT_32                     iChunkSize;
+	/** Total size of collected data      */
+	UINT_64                     iSize;
+
+	/**
+	  @brief Add fragment, adjacent fragments are merged
+	  @param vData - fragment data
+	  @param iDataLength - fragment length
+	*/
+	void AddFragment(const void     * vData,
+	                 const UINT_32    iDataLength);
+
+	// Does not exist
+	IOVecOutputCollector(const IOVecOutputCollector & oRhs);
+	IOVecOutputCollector & operator=(const IOVecOutputCollector & oRhs);
+};
+
+} // namespace CTPP
+#endif // HAVE_SYS_UIO_H
+#endif // _CTPP2_IOVEC_OUTPUT_COLLECTOR_HPP__
+// End.
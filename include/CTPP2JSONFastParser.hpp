@@ -0,0 +1,168 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2JSONFastParser.hpp
+ *
+ * $CTPP$
+ */
+#ifndef _CTPP2_JSON_FAST_PARSER_H__
+#define _CTPP2_JSON_FAST_PARSER_H__ 1
+
+#include "CDT.hpp"
+
+#include "STLString.hpp"
+#include "STLVector.hpp"
+
+/**
+  @file CTPP2JSONFastParser.hpp
+  @brief JSON parser with structural index
+*/
+
+namespace CTPP // C++ Template Engine
+{
+// FWD
+class CTPP2JSONMappedFile;
+
+/**
+  @class CTPP2JSONFastParser CTPP2JSONFastParser.hpp <CTPP2JSONFastParser.hpp>
+  @brief JSON parser in two stages: positions of structural characters, strings and scalar
+         values are found with SSE2/AVX2 kernels, then CDT is built by walking these positions.
+         Parser does not track line and position and does not support comments and
+         single-quoted strings; use CTPP2JSONParser::FAST_MODE to get diagnostics
+         and full syntax with fallback to character parser.
+*/
+class CTPP2DECL CTPP2JSONFastParser
+{
+public:
+	/**
+	  @brief Constructor
+	  @param oICDT - data collector
+	  @param pIArena - arena for containers of parsed document, NULL for heap;
+	                   document must be destroyed before arena is released
+	  @param pIMappedFile - mapped file with parsed data, NULL if data are not mapped;
+	                        strings without escape sequences refer to file data
+	*/
+	CTPP2JSONFastParser(CDT                  & oICDT,
+	                    CDTArena             * pIArena     = NULL,
+	                    CTPP2JSONMappedFile  * pIMappedFile = NULL);
+
+	/**
+	  @brief Parse JSON data
+	  @param szIData - start of data
+	  @param szIEnd - end of data
+	  @return 0 if success, -1 if syntax error or comment or single-quoted string found
+	*/
+	INT_32 Parse(CCHAR_P  szIData,
+	             CCHAR_P  szIEnd);
+
+	/**
+	  @brief A destructor
+	*/
+	~CTPP2JSONFastParser() throw();
+private:
+	/** Data collector                                               */
+	CDT                    & oCDT;
+	/** Arena, NULL for heap                                         */
+	CDTArena               * pArena;
+	/** Mapped file, NULL if data are not mapped                     */
+	CTPP2JSONMappedFile    * pMappedFile;
+	/** Data                                                         */
+	CCHAR_P                  szData;
+	/** Data length                                                  */
+	UINT_32                  iDataLength;
+	/** Structural index: positions of structural characters,
+	    quotes and first characters of scalar values, data length at end */
+	STLW::vector<UINT_32>    vIndex;
+	/** Number of positions in structural index                      */
+	UINT_32                  iSlots;
+	/** Current position in structural index                        */
+	UINT_32                  iSlot;
+	/** Number of elements of ARRAY-s and HASH-es, in order of opening brackets */
+	STLW::vector<UINT_32>    vElements;
+	/** Current ARRAY or HASH                                        */
+	UINT_32                  iContainer;
+	/** Temp. buffer for string values                               */
+	STLW::string             sTMPBuf;
+
+	/**
+	  @brief Build structural index, stage 1
+	  @return 0 if success, -1 if unsupported syntax or unterminated string found
+	*/
+	INT_32 BuildIndex();
+
+	/**
+	  @brief Count elements of ARRAY-s and HASH-es
+	  @return 0 if success, -1 if brackets are unbalanced
+	*/
+	INT_32 CountElements();
+
+	/**
+	  @brief JSON Value
+	  @param oValue - CDT object
+	  @return 0 if success, -1 if syntax error found
+	*/
+	INT_32 ParseValue(CDT & oValue);
+
+	/**
+	  @brief JSON Object
+	  @param oValue - CDT object
+	  @return 0 if success, -1 if syntax error found
+	*/
+	INT_32 ParseObject(CDT & oValue);
+
+	/**
+	  @brief JSON Array
+	  @param oValue - CDT object
+	  @return 0 if success, -1 if syntax error found
+	*/
+	INT_32 ParseArray(CDT & oValue);
+
+	/**
+	  @brief JSON string, spans between escape sequences are copied at once
+	  @param sValue - unescaped string
+	  @return 0 if success, -1 if syntax error found
+	*/
+	INT_32 ParseString(STLW::string & sValue);
+
+	/**
+	  @brief JSON number [-]0-9[. [0-9] ] [E][+- 0-9] or null, true, false
+	  @param oValue - CDT object
+	  @return 0 if success, -1 if syntax error found
+	*/
+	INT_32 ParseScalar(CDT & oValue);
+
+	/**
+	  @brief JSON Key, string or raw text of number
+	  @param sKey - JSON hash key
+	  @return 0 if success, -1 if syntax error found
+	*/
+	INT_32 ParseKey(STLW::string & sKey);
+};
+
+} // namespace CTPP
+#endif // _CTPP2_JSON_FAST_PARSER_H__
+// End.
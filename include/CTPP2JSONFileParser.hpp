@@ -32,6 +32,7 @@
 #ifndef _CTPP2_JSON_FILE_PARSER_H__
 #define _CTPP2_JSON_FILE_PARSER_H__ 1
 
+#include "CTPP2JSONMappedFile.hpp"
 #include "CTPP2JSONParser.hpp"
 
 #include <stdio.h>
@@ -54,8 +55,17 @@ class CTPP2DECL CTPP2JSONFileParser:
 public:
 	/**
 	  @brief Constructor
+	  @param oICDT - data collector
+	  @param pIArena - arena for containers of parsed document, NULL for heap
+	  @param eIMode - parsing algorithm
+	  @param pIMappedFile - if not NULL, Parse(CCHAR_P) maps file to memory instead of reading it,
+	                        strings without escape sequences refer to file data and keep it
+	                        mapped while they exist
 	*/
-	CTPP2JSONFileParser(CDT & oICDT);
+	CTPP2JSONFileParser(CDT                                 & oICDT,
+	                    CDTArena                            * pIArena      = NULL,
+	                    const CTPP2JSONParser::eParserMode    eIMode       = CTPP2JSONParser::COMPAT_MODE,
+	                    CTPP2JSONMappedFile                 * pIMappedFile = NULL);
 
 	/**
 	  @brief Parse JSON data from file
@@ -77,7 +87,8 @@ public:
 	*/
 	~CTPP2JSONFileParser() throw();
 private:
-
+	/** Mapped file, NULL if file is read */
+	CTPP2JSONMappedFile  * pMappedFile;
 };
 
 } // namespace CTPP
@@ -0,0 +1,115 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2JSONMappedFile.hpp
+ *
+ * $CTPP$
+ */
+#ifndef _CTPP2_JSON_MAPPED_FILE_H__
+#define _CTPP2_JSON_MAPPED_FILE_H__ 1
+
+#include "CDT.hpp"
+
+/**
+  @file CTPP2JSONMappedFile.hpp
+  @brief Memory-mapped JSON file
+*/
+
+/** Number of string views in one block */
+#define C_JSON_VIEWS_BLOCK_SIZE  1024
+
+namespace CTPP // C++ Template Engine
+{
+
+/**
+  @class CTPP2JSONMappedFile CTPP2JSONMappedFile.hpp <CTPP2JSONMappedFile.hpp>
+  @brief JSON file mapped to memory read-only; string values without escape sequences
+         refer to file data instead of being copied. File data are refcounted: every CDT
+         object referring to them holds a reference, so file is unmapped when both this
+         object and last such CDT object are destroyed.
+*/
+class CTPP2DECL CTPP2JSONMappedFile
+{
+public:
+	/**
+	  @brief Constructor
+	*/
+	CTPP2JSONMappedFile();
+
+	/**
+	  @brief Map file to memory; file is read into memory if it cannot be mapped
+	  @param szFileName - file name
+	*/
+	void Open(CCHAR_P szFileName);
+
+	/**
+	  @brief Get file data
+	*/
+	CCHAR_P GetData() const;
+
+	/**
+	  @brief Get file size
+	*/
+	UINT_32 GetSize() const;
+
+	/**
+	  @brief Create string value; string inside file data is not copied
+	  @param szString - string data
+	  @param iLength - string length
+	  @param pArena - arena for copy of string outside file data, NULL for heap; view of file marks arena as foreign
+	  @return string value
+	*/
+	CDT MakeString(CCHAR_P          szString,
+	               const UINT_32    iLength,
+	               CDTArena       * pArena = NULL);
+
+	/**
+	  @brief Release file; file data are unmapped when last CDT object referring to them is destroyed
+	*/
+	void Release() throw();
+
+	/**
+	  @brief A destructor
+	*/
+	~CTPP2JSONMappedFile() throw();
+private:
+	// FWD
+	struct Storage;
+
+	/** File data and string views, NULL if file is not mapped */
+	Storage                       * pStorage;
+	/** Number of used views in last block                     */
+	UINT_32                         iUsedViews;
+
+	// Does not exist
+	CTPP2JSONMappedFile(const CTPP2JSONMappedFile & oRhs);
+	CTPP2JSONMappedFile & operator=(const CTPP2JSONMappedFile & oRhs);
+};
+
+} // namespace CTPP
+#endif // _CTPP2_JSON_MAPPED_FILE_H__
+// End.
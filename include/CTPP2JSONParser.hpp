@@ -44,6 +44,8 @@
 
 namespace CTPP // C++ Template Engine
 {
+// FWD
+class CTPP2JSONMappedFile;
 
 /**
   @class CTPP2JSONParser CTPP2JSONParser.hpp <CTPP2JSONParser.hpp>
@@ -52,10 +54,29 @@ namespace CTPP // C++ Template Engine
 class CTPP2DECL CTPP2JSONParser
 {
 public:
+	/**
+	  @enum eParserMode CTPP2JSONParser.hpp <CTPP2JSONParser.hpp>
+	  @brief Parsing algorithm
+	*/
+	enum eParserMode { COMPAT_MODE, /**< Character by character                                             */
+	                   FAST_MODE    /**< CTPP2JSONFastParser; if it fails, document is parsed again in
+	                                     COMPAT_MODE to report line and position of error, or to accept
+	                                     comments and single-quoted strings                                */
+	                 };
+
 	/**
 	  @brief Constructor
+	  @param oICDT - data collector
+	  @param pIArena - arena for containers of parsed document, NULL for heap;
+	                   document must be destroyed before arena is released
+	  @param eIMode - parsing algorithm
+	  @param pIMappedFile - mapped file with parsed data, NULL if data are not mapped;
+	                        strings without escape sequences refer to file data
 	*/
-	CTPP2JSONParser(CDT & oICDT);
+	CTPP2JSONParser(CDT                   & oICDT,
+	                CDTArena              * pIArena      = NULL,
+	                const eParserMode       eIMode       = COMPAT_MODE,
+	                CTPP2JSONMappedFile   * pIMappedFile = NULL);
 
 	/**
 	  @brief Parse JSON data
@@ -71,15 +92,21 @@ public:
 	~CTPP2JSONParser() throw();
 private:
 	/** Data collector        */
-	CDT           & oCDT;
+	CDT                   & oCDT;
+	/** Arena, NULL for heap  */
+	CDTArena              * pArena;
+	/** Parsing algorithm     */
+	eParserMode             eMode;
+	/** Mapped file, NULL if data are not mapped */
+	CTPP2JSONMappedFile   * pMappedFile;
 	/** Temp. buffer          */
-	STLW::string    sTMPBuf;
+	STLW::string            sTMPBuf;
 	/** Parsed integer value  */
-	INT_64         iIntData;
+	INT_64                  iIntData;
 	/** Parsed floating value */
-	W_FLOAT        dFloatData;
+	W_FLOAT                 dFloatData;
 	/** Type of parsed value  */
-	INT_32         iParsedNumberType;
+	INT_32                  iParsedNumberType;
 
 	/**
 	  @brief JSON string "blah-blah \" clah-clah " | 'blah-blah \' clah-clah '
@@ -0,0 +1,238 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2JSONStreamParser.hpp
+ *
+ * $CTPP$
+ */
+#ifndef _CTPP2_JSON_STREAM_PARSER_H__
+#define _CTPP2_JSON_STREAM_PARSER_H__ 1
+
+#include "CDT.hpp"
+
+#include "STLString.hpp"
+#include "STLVector.hpp"
+
+/**
+  @file CTPP2JSONStreamParser.hpp
+  @brief JSON parser, incremental interface
+*/
+
+namespace CTPP // C++ Template Engine
+{
+
+/**
+  @class CTPP2JSONStreamParser CTPP2JSONStreamParser.hpp <CTPP2JSONStreamParser.hpp>
+  @brief JSON parser that accepts data in chunks of any size and builds CDT while data arrives;
+         tokens may span over chunk boundaries. Syntax, result and error messages are
+         the same as of CTPP2JSONParser, syntax errors are reported as CTPPParserSyntaxError.
+*/
+class CTPP2DECL CTPP2JSONStreamParser
+{
+public:
+	/**
+	  @brief Constructor
+	  @param oICDT - data collector
+	  @param pIArena - arena for containers of parsed document, NULL for heap;
+	                   document must be destroyed before arena is released
+	*/
+	CTPP2JSONStreamParser(CDT       & oICDT,
+	                      CDTArena  * pIArena = NULL);
+
+	/**
+	  @brief Parse next chunk of JSON data; chunk is not used after return
+	  @param szData - chunk of data
+	  @param iDataLength - chunk length
+	  @return 0 if success, throws CTPPParserSyntaxError if syntax error found
+	*/
+	INT_32 Feed(CCHAR_P        szData,
+	            const UINT_32  iDataLength);
+
+	/**
+	  @brief Finish parsing, end of data
+	  @return 0 if success, throws CTPPParserSyntaxError if document is incomplete
+	*/
+	INT_32 Finish();
+
+	/**
+	  @brief A destructor
+	*/
+	~CTPP2JSONStreamParser() throw();
+private:
+	/**
+	  @enum eParserState CTPP2JSONStreamParser.hpp <CTPP2JSONStreamParser.hpp>
+	  @brief What is expected between tokens
+	*/
+	enum eParserState { VALUE,              // Value; top level, after ':' or after ',' in ARRAY
+	                     VALUE_OR_END_ARRAY, // Value or ']' after '['
+	                     KEY_OR_END_HASH,    // Key or '}' after '{'
+	                     KEY,                // Key after ',' in HASH
+	                     COLON,              // ':' after key
+	                     NEXT,               // ',' or end of ARRAY or HASH after value
+	                     DONE                // White space after top level value
+	                   };
+
+	/**
+	  @enum eTokenState CTPP2JSONStreamParser.hpp <CTPP2JSONStreamParser.hpp>
+	  @brief Token that may continue in next chunk
+	*/
+	enum eTokenState { NO_TOKEN,
+	                   COMMENT_START,       // '/'
+	                   LINE_COMMENT,        // "// ..."
+	                   BLOCK_COMMENT,       // "/* ..."
+	                   BLOCK_COMMENT_STAR,  // "/* ... *"
+	                   STRING,
+	                   STRING_ESCAPE,       // '\'
+	                   STRING_UNICODE,      // "\u" and less than 4 digits
+	                   NUMBER,
+	                   WORD                 // null, true, false
+	                 };
+
+	/**
+	  @enum eNumberState CTPP2JSONStreamParser.hpp <CTPP2JSONStreamParser.hpp>
+	  @brief Part of number [-]0-9[. [0-9] ] [E][+- 0-9]
+	*/
+	enum eNumberState { INTEGER,
+	                    FRACTION,
+	                    EXPONENT_START,     // 'E'
+	                    EXPONENT_SIGN,      // 'E' and sign
+	                    EXPONENT
+	                  };
+
+	/** Data collector                                               */
+	CDT                    & oCDT;
+	/** Arena, NULL for heap                                         */
+	CDTArena               * pArena;
+	/** Opened ARRAY-s and HASH-es                                   */
+	STLW::vector<CDT *>      vContainers;
+	/** Value being parsed                                           */
+	CDT                    * pValue;
+	/** Parser state                                                 */
+	eParserState             eState;
+	/** Token state                                                  */
+	eTokenState              eToken;
+	/** Number state                                                 */
+	eNumberState             eNumber;
+	/** Number has decimal point                                     */
+	bool                     bFloat;
+	/** Terminating character of string                              */
+	CHAR_8                   chEOS;
+	/** Digits of unicode escape sequence                            */
+	UINT_32                  iUnicodeDigits;
+	/** Unicode character                                            */
+	UINT_32                  iUnicode;
+	/** Text of string, number or word                               */
+	STLW::string             sToken;
+	/** Key of HASH element                                          */
+	STLW::string             sKey;
+	/** Current chunk, NULL after end of data                        */
+	CCHAR_P                  szChunk;
+	/** Line at start of current chunk                               */
+	UINT_32                  iLine;
+	/** Position in line at start of current chunk                   */
+	UINT_32                  iLinePos;
+
+	/**
+	  @brief White space and structural characters
+	  @param szData - start of data
+	  @param szEnd - end of chunk
+	  @return end of parsed data
+	*/
+	CCHAR_P ParseStructure(CCHAR_P  szData,
+	                       CCHAR_P  szEnd);
+
+	/**
+	  @brief Comment "// ..." or "/ * ... * /"
+	  @param szData - start of data
+	  @param szEnd - end of chunk
+	  @return end of parsed data
+	*/
+	CCHAR_P ParseComment(CCHAR_P  szData,
+	                     CCHAR_P  szEnd);
+
+	/**
+	  @brief String, spans between escape sequences are copied at once
+	  @param szData - start of data
+	  @param szEnd - end of chunk
+	  @return end of parsed data
+	*/
+	CCHAR_P ParseString(CCHAR_P  szData,
+	                    CCHAR_P  szEnd);
+
+	/**
+	  @brief Number [-]0-9[. [0-9] ] [E][+- 0-9]
+	  @param szData - start of data
+	  @param szEnd - end of chunk
+	  @return end of parsed data
+	*/
+	CCHAR_P ParseNumber(CCHAR_P  szData,
+	                    CCHAR_P  szEnd);
+
+	/**
+	  @brief Word: null, true, false
+	  @param szData - start of data
+	  @param szEnd - end of chunk
+	  @return end of parsed data
+	*/
+	CCHAR_P ParseWord(CCHAR_P  szData,
+	                  CCHAR_P  szEnd);
+
+	/**
+	  @brief Start of value, throws CTPPParserSyntaxError if value is not expected
+	  @param szData - first character of value
+	*/
+	void BeginValue(CCHAR_P  szData);
+
+	/**
+	  @brief End of value
+	*/
+	void EndValue();
+
+	/**
+	  @brief End of string, number or word
+	  @param szData - character after token, NULL at end of data
+	*/
+	void EndToken(CCHAR_P  szData);
+
+	/**
+	  @brief Throw error "what is expected" for current parser state
+	  @param szData - unexpected character, NULL at end of data
+	*/
+	void SyntaxError(CCHAR_P  szData);
+
+	/**
+	  @brief Throw CTPPParserSyntaxError with line and position of character
+	  @param szReason - error description
+	  @param szData - character in current chunk, NULL at end of data
+	*/
+	void ThrowError(CCHAR_P  szReason,
+	                CCHAR_P  szData);
+};
+
+} // namespace CTPP
+#endif // _CTPP2_JSON_STREAM_PARSER_H__
+// End.
@@ -0,0 +1,100 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2MappedFile.hpp
+ *
+ * $CTPP$
+ */
+#ifndef _CTPP2_MAPPED_FILE_HPP__
+#define _CTPP2_MAPPED_FILE_HPP__ 1
+
+#include "CTPP2Types.h"
+
+/**
+  @file CTPP2MappedFile.hpp
+  @brief File mapped to memory read-only
+*/
+
+namespace CTPP // C++ Template Engine
+{
+
+/**
+  @class MappedFile CTPP2MappedFile.hpp <CTPP2MappedFile.hpp>
+  @brief File mapped to memory read-only and shared with page cache; file is read
+         into private memory if it cannot be mapped. Mapped file must be replaced
+         with rename(2), never rewritten in place: truncation of file kills process
+         with SIGBUS or SIGSEGV on access to mapped data.
+*/
+class CTPP2DECL MappedFile
+{
+public:
+	/**
+	  @brief Constructor
+	*/
+	MappedFile();
+
+	/**
+	  @brief Map file to memory; throws CTPPUnixException on I/O error
+	  @param szFileName - file name
+	*/
+	void Open(CCHAR_P szFileName);
+
+	/**
+	  @brief Get file data, NULL for empty file
+	*/
+	CCHAR_P GetData() const;
+
+	/**
+	  @brief Get file size
+	*/
+	UINT_32 GetSize() const;
+
+	/**
+	  @brief Unmap or free file data
+	*/
+	void Close() throw();
+
+	/**
+	  @brief A destructor
+	*/
+	~MappedFile() throw();
+private:
+	/** File data                */
+	CHAR_P     szData;
+	/** File size                */
+	UINT_32    iSize;
+	/** File is mapped, not read */
+	bool       bMapped;
+
+	// Does not exist
+	MappedFile(const MappedFile & oRhs);
+	MappedFile & operator=(const MappedFile & oRhs);
+};
+
+} // namespace CTPP
+#endif // _CTPP2_MAPPED_FILE_HPP__
+// End.
@@ -57,6 +57,15 @@ public:
 	*/
 	virtual INT_32 Collect(const void * vData, const UINT_32 iDataLength) = 0;
 
+	/**
+	  @brief Collect static text; data is not changed while program core exists,
+	         so collector may store reference to it instead of copy
+	  @param vData - data to store
+	  @param iDataLength - data length
+	  @return 0 - if success, -1 - if any error occured
+	*/
+	virtual INT_32 CollectStatic(const void * vData, const UINT_32 iDataLength) { return Collect(vData, iDataLength); }
+
 	/**
 	  @brief A destructor
 	*/
@@ -80,6 +80,12 @@ public:
 	*/
 	INT_32 Compile(const UINT_32 & iHalt = 1);
 
+	/**
+	  @brief Compile every distinct include file once into callable unit instead of inlining it into every call point
+	  @param bIIncludeUnits - if set to true, use include units
+	*/
+	void SetIncludeUnits(const bool bIIncludeUnits);
+
 	/**
 	  @brief A destructor
 	*/
@@ -210,6 +216,8 @@ private:
 	bool                bVerboseMode;
 	/** Block flag                  */
 	bool                bInBlock;
+	/** Include units flag           */
+	bool                bIncludeUnits;
 	/** Current block arguments     */
 	BlockArgMapType     mCurrentBlock;
 	/** Map of number of arguments of blocks */
@@ -64,7 +64,7 @@ public:
 	SimpleCompiler(const std::string & sSourceFile);
 
 	/**
-	  @brief Save compiled data to file
+	  @brief Save compiled data to file; file is replaced atomically, programs which mapped old file keep using it
 	  @param sCompiledFile - compiled file
 	  @return 0 - if success, -1 - if any error occured
 	*/
@@ -69,6 +69,12 @@ public:
 	*/
 	virtual CTPP2SourceLoader * Clone() = 0;
 
+	/**
+	  @brief Get unique name of loaded template
+	  @return asciz template name or NULL if loader does not provide it
+	*/
+	virtual CCHAR_P GetTemplateName() const { return NULL; }
+
 	/**
 	  @brief A destructor
 	*/
@@ -33,6 +33,9 @@
 #define _CTPP2_STATIC_TEXT_HPP__ 1
 
 #include "CTPP2Types.h"
+#include "STLMap.hpp"
+#include "STLString.hpp"
+#include "STLVector.hpp"
 
 /**
   @file CTPP2StaticText.hpp
@@ -129,7 +132,7 @@ public:
 	           const UINT_32          iMaxDataOffsetsSize);
 
 	/**
-	  @brief Store data
+	  @brief Store data; identical strings are stored only once and share the same ID
 	  @param sStoreData - text data
 	  @param iDataLength - data length
 	  @return data ID
@@ -137,6 +140,18 @@ public:
 	UINT_32 StoreData(CCHAR_P          sStoreData,
 	                  const UINT_32    iDataLength);
 
+	/**
+	  @brief Release data stored by StoreData; text is removed by Compact() when no references left
+	  @param iDataId - data ID
+	*/
+	void ReleaseData(const UINT_32  iDataId);
+
+	/**
+	  @brief Remove unreferenced text from segment; data IDs are not changed
+	  @return number of freed bytes
+	*/
+	UINT_32 Compact();
+
 	/**
 	  @brief GetData by ID
 	  @param iDataId - data ID
@@ -152,6 +167,12 @@ public:
 	*/
 	UINT_32 GetRecordsNum() const;
 
+	/**
+	  @brief Get size of text segment
+	  @return size of text segment, bytes
+	*/
+	UINT_32 GetDataSize() const;
+
 	/**
 	  @brief A destructor
 	*/
@@ -159,6 +180,11 @@ public:
 private:
 	friend class VMDumper;
 
+	// Does not exist
+	StaticText(const StaticText & oRhs);
+	// Does not exist
+	StaticText & operator=(const StaticText & oRhs);
+
 	/** Max. data buffer size      */
 	UINT_32          iMaxDataSize;
 	/** Max. offsets array length  */
@@ -172,6 +198,10 @@ private:
 	CHAR_P           sData;
 	/** Stored data offsets        */
 	TextDataIndex  * aDataOffsets;
+	/** Text-to-ID index           */
+	STLW::map<STLW::string, UINT_32>  mDataIndex;
+	/** Number of references to every record */
+	STLW::vector<UINT_32>             vReferences;
 };
 
 } // namespace CTPP
@@ -0,0 +1,263 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2TemplateCache.hpp
+ *
+ * $CTPP$
+ */
+#ifndef _CTPP2_TEMPLATE_CACHE_HPP__
+#define _CTPP2_TEMPLATE_CACHE_HPP__ 1
+
+#include "CTPP2Types.h"
+
+#include "STLMap.hpp"
+#include "STLString.hpp"
+#include "STLVector.hpp"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <pthread.h>
+
+/**
+  @file CTPP2TemplateCache.hpp
+  @brief Thread-safe shared cache of compiled templates
+*/
+
+/** Number of reader slots; threads are spread over slots  */
+#define C_TEMPLATE_CACHE_READER_SLOTS   128
+
+/** Size of CPU cache line                                 */
+#define C_TEMPLATE_CACHE_LINE_SIZE      64
+
+namespace CTPP // C++ Template Engine
+{
+// FWD
+class Logger;
+struct VMMemoryCore;
+
+/**
+  @class TemplateCache CTPP2TemplateCache.hpp <CTPP2TemplateCache.hpp>
+  @brief Thread-safe shared cache of compiled templates
+
+  Lookup does not take locks: readers register in per-thread slot of
+  epoch counters and read immutable table of templates. Loading of new
+  templates and reloading of changed ones is serialized by mutex; old
+  table and replaced templates are released when no handle taken before
+  the replacement is alive (epoch-based reclamation).
+
+  Files with extension ".ct2" are loaded as compiled programs, other
+  files are compiled from source. Change of file is detected by
+  modification time, size and inode; deploy new versions by rename().
+*/
+class CTPP2DECL TemplateCache
+{
+private:
+	// FWD
+	struct Template;
+	struct Table;
+	struct ReaderSlot;
+public:
+	/**
+	  @class Handle CTPP2TemplateCache.hpp <CTPP2TemplateCache.hpp>
+	  @brief Reference to template; template is not released while handle is alive
+
+	  Handle should live no longer than one render, otherwise release
+	  of reloaded templates is delayed.
+	*/
+	class CTPP2DECL Handle
+	{
+	public:
+		/**
+		  @brief Constructor, empty handle
+		*/
+		Handle();
+
+		/**
+		  @brief Copy constructor
+		  @param oRhs - handle to copy
+		*/
+		Handle(const Handle & oRhs);
+
+		/**
+		  @brief Copy operator
+		  @param oRhs - handle to copy
+		*/
+		Handle & operator=(const Handle & oRhs);
+
+		/**
+		  @brief Get ready-to-run program
+		  @return program or NULL for empty handle
+		*/
+		const VMMemoryCore * GetCore() const;
+
+		/**
+		  @brief A destructor
+		*/
+		~Handle() throw();
+	private:
+		friend class TemplateCache;
+
+		/** Reader slot        */
+		ReaderSlot      * pSlot;
+		/** Epoch parity       */
+		UINT_32           iParity;
+		/** Template           */
+		const Template  * pTemplate;
+
+		/**
+		  @brief Release reference
+		*/
+		void Release() throw();
+	};
+
+	/**
+	  @brief Constructor
+	*/
+	TemplateCache();
+
+	/**
+	  @brief Get template, load it if need
+	  @param sName - template file name
+	  @return handle of template
+	*/
+	Handle Get(const STLW::string & sName);
+
+	/**
+	  @brief Reload changed templates; template that failed to load is kept in old version
+	  @param pLogger - logger for errors, may be NULL
+	  @return number of reloaded templates
+	*/
+	UINT_32 CheckUpdates(Logger * pLogger = NULL);
+
+	/**
+	  @brief Start background thread, which checks templates for changes
+	  @param iInterval - check interval, milliseconds
+	  @param pLogger - logger for errors, may be NULL; must be thread-safe
+	*/
+	void StartChecker(const UINT_32    iInterval,
+	                  Logger         * pLogger = NULL);
+
+	/**
+	  @brief Stop background thread
+	*/
+	void StopChecker();
+
+	/**
+	  @brief A destructor; all handles must be released before
+	*/
+	~TemplateCache() throw();
+
+private:
+	/** Current table of templates       */
+	Table                   * pTable;
+	/** Current epoch                    */
+	UINT_32                   iEpoch;
+	/** Reader slots                     */
+	ReaderSlot              * aSlots;
+	/** Next slot to give to thread      */
+	UINT_32                   iNextSlot;
+	/** Thread-specific slot number      */
+	pthread_key_t             oSlotKey;
+
+	/** Writers lock                     */
+	pthread_mutex_t           oWriteMutex;
+	/** Tables retired in current epoch                 */
+	STLW::vector<Table *>     vPendingTables;
+	/** Templates retired in current epoch              */
+	STLW::vector<Template *>  vPendingTemplates;
+	/** Tables waiting for readers of previous epoch    */
+	STLW::vector<Table *>     vWaitingTables;
+	/** Templates waiting for readers of previous epoch */
+	STLW::vector<Template *>  vWaitingTemplates;
+
+	/** Checker thread                   */
+	pthread_t                 oChecker;
+	/** Checker thread is running        */
+	bool                      bCheckerRunning;
+	/** Stop flag for checker thread     */
+	bool                      bStopChecker;
+	/** Check interval, milliseconds     */
+	UINT_32                   iCheckInterval;
+	/** Logger of checker thread         */
+	Logger                  * pCheckerLogger;
+	/** Checker thread lock              */
+	pthread_mutex_t           oCheckerMutex;
+	/** Wakeup of checker thread         */
+	pthread_cond_t            oCheckerCond;
+
+	/**
+	  @brief Get reader slot of current thread
+	*/
+	ReaderSlot * GetSlot();
+
+	/**
+	  @brief Find template, lock-free
+	  @param sName - template file name
+	  @param oHandle - handle to fill
+	  @return true if template found
+	*/
+	bool Find(const STLW::string  & sName,
+	          Handle              & oHandle);
+
+	/**
+	  @brief Load new version of changed template, error is logged. Writers lock must be held
+	  @param pTemplate - current version of template
+	  @param oStat - state of file before loading
+	  @param pLogger - logger for errors, may be NULL
+	  @return new version of template or NULL if it cannot be loaded
+	*/
+	Template * LoadTemplate(Template           * pTemplate,
+	                        const struct stat  & oStat,
+	                        Logger             * pLogger);
+
+	/**
+	  @brief Publish new table; old table and replaced templates are retired. Writers lock must be held
+	  @param pNewTable - new table
+	  @param vReplaced - replaced templates
+	*/
+	void Publish(Table                           * pNewTable,
+	             const STLW::vector<Template *>  & vReplaced);
+
+	/**
+	  @brief Release retired objects if readers of old epoch are gone, advance epoch. Writers lock must be held
+	*/
+	void Reclaim();
+
+	/**
+	  @brief Checker thread function
+	*/
+	static void * CheckerThread(void * pContext);
+
+	// Does not exist
+	TemplateCache(const TemplateCache & oRhs);
+	TemplateCache & operator=(const TemplateCache & oRhs);
+};
+
+} // namespace CTPP
+#endif // _CTPP2_TEMPLATE_CACHE_HPP__
+// End.
@@ -106,6 +106,16 @@ private:
 */
 UINT_32 crc32(UCCHAR_P sBuffer, const UINT_32 & iSize);
 
+/**
+  @fn UINT_32 crc32(UCCHAR_P sBuffer, const UINT_32 & iSize, const UINT_32 & iCRC)
+  @brief Continue calculation of crc32 checksum
+  @param sBuffer - buffer with source data to calculate CRC
+  @param iSize - buffer size
+  @param iCRC - checksum of previous data
+  @return CRC32 checksum
+*/
+UINT_32 crc32(UCCHAR_P sBuffer, const UINT_32 & iSize, const UINT_32 & iCRC);
+
 /**
   @fn UINT_32 Swap32(const UINT_32 & iValue)
   @brief Swap bytes for UINT_32 value
@@ -238,5 +248,29 @@ INT_32 utf_charlen(CCHAR_P szString, CCHAR_P szStringEnd);
 */
 INT_32 UnicodeToUTF8(UINT_32 iUCS, UCHAR_P sUTF8);
 
+/**
+  @brief Convert JSON number [-]0-9[. [0-9] ] [E][+- 0-9], result is the same as of JSON parsers
+  @param szData - start of number
+  @param szEnd - end of number
+  @param bFloat - number has decimal point
+  @param oValue - converted value [out]
+*/
+void ConvertJSONNumber(CCHAR_P       szData,
+                       CCHAR_P       szEnd,
+                       const bool    bFloat,
+                       CDT         & oValue);
+
+/**
+  @brief Replace file atomically: data are written to unique temporary file in the same directory,
+         then it is renamed to file name, so processes which mapped old file keep using old data.
+         New file gets permissions of replaced one, 0644 if there was no file
+  @param sFileName - file name
+  @param vData - data to write
+  @param iDataSize - data size
+*/
+void ReplaceFile(const STLW::string  & sFileName,
+                 const void          * vData,
+                 const UINT_32         iDataSize);
+
 } // namespace CTPP
 // End.
@@ -40,9 +40,14 @@
 #include "CTPP2VMArgStack.hpp"
 #include "CTPP2VMCodeStack.hpp"
 
+#include "STLVector.hpp"
+
 namespace CTPP // C++ Template Engine
 {
 
+/** Max. number of simultaneously tracked HASH foreach loops */
+#define C_MAX_LOOP_CURSORS 32
+
 // FWD
 class OutputCollector;
 class SyscallFactory;
@@ -57,6 +62,14 @@ class Logger;
 class CTPP2DECL VM
 {
 public:
+	/**
+	  @enum eDispatchType CTPP2VM.hpp <CTPP2VM.hpp>
+	  @brief Instruction dispatch engine
+	*/
+	enum eDispatchType { SWITCH_DISPATCH,   // Decode every instruction with switch
+	                     THREADED_DISPATCH  // Jump to pre-decoded handler (computed goto, if supported by compiler)
+	                   };
+
 	/**
 	  @brief Constructor
 	  @param oISyscallFactory - factory with system calls
@@ -64,12 +77,14 @@ public:
 	  @param iIMaxCodeStackSize - max. size of code stack
 	  @param iIMaxSteps - max. number of executed steps
 	  @param iIDebugLevel - debugging level
+	  @param eIDispatchType - instruction dispatch engine
 	*/
-	VM(SyscallFactory  * pSyscallFactory,
-	   const UINT_32     iIMaxArgStackSize  = 4096,
-	   const UINT_32     iIMaxCodeStackSize = 4096,
-	   const UINT_32     iIMaxSteps         = 10240,
-	   const UINT_32     iIDebugLevel       = 0);
+	VM(SyscallFactory       * pSyscallFactory,
+	   const UINT_32          iIMaxArgStackSize  = 4096,
+	   const UINT_32          iIMaxCodeStackSize = 4096,
+	   const UINT_32          iIMaxSteps         = 10240,
+	   const UINT_32          iIDebugLevel       = 0,
+	   const eDispatchType    eIDispatchType     = THREADED_DISPATCH);
 
 	/**
 	  @brief Initialize virtual machine
@@ -92,10 +107,24 @@ public:
 	           Logger              * pLogger);
 
 	/**
-	  @brief Reset virtual machine state
+	  @brief Reset virtual machine state; all data referenced by registers, stack and active loops
+	         is released, so VM kept in pool does not retain data of previous run
 	*/
 	INT_32 Reset();
 
+	/**
+	  @brief Get handler of pre-decoded instruction, used by threaded dispatch
+	  @param iOpCode - instruction opcode
+	  @return number of handler
+	*/
+	static UCHAR_8 DecodeInstruction(const UINT_32  iOpCode);
+
+	/**
+	  @brief Get number of instructions executed by last run of program
+	  @return number of executed instructions
+	*/
+	UINT_32 GetExecutedSteps() const;
+
 	/**
 	  @brief A destructor
 	*/
@@ -113,6 +142,8 @@ private:
 	const UINT_32      iMaxSteps;
 	/** Debug level                  */
 	const UINT_32      iDebugLevel;
+	/** Instruction dispatch engine  */
+	const eDispatchType  eDispatch;
 
 	/** Number of system calls       */
 	UINT_32            iMaxCalls;
@@ -130,6 +161,48 @@ private:
 	CDT                oRegs[8];
 	/** Virtual flags                */
 	UINT_32            iFlags;
+	/** Number of executed steps     */
+	UINT_32            iExecutedSteps;
+
+	/**
+	  @struct LoopCursor CTPP2VM.hpp <CTPP2VM.hpp>
+	  @brief Position of foreach loop over HASH
+	*/
+	struct LoopCursor
+	{
+		/** Address of MOVIREGI instruction */
+		UINT_32              ip;
+		/** Index of current element        */
+		INT_32               index;
+		/** Iterated hash; keeps container
+		    unchanged while loop is active  */
+		CDT                  container;
+		/** Current element                 */
+		CDT::ConstIterator   cursor;
+
+		/**
+		  @brief Constructor
+		  @param iIIP - address of MOVIREGI instruction
+		  @param oIContainer - iterated hash
+		*/
+		LoopCursor(const UINT_32  iIIP,
+		           const CDT    & oIContainer);
+	};
+
+	/** Cursors of active foreach
+	                 loops over HASH */
+	STLW::vector<LoopCursor> vLoopCursors;
+
+	/**
+	  @brief Get iterator pointed to element of HASH in foreach loop
+	  @param iIP - address of MOVIREGI instruction
+	  @param oHash - iterated hash
+	  @param iIdx - index of element
+	  @return Iterator pointed to iIdx-th element of hash
+	*/
+	CDT::ConstIterator GetLoopCursor(const UINT_32  iIP,
+	                                 const CDT    & oHash,
+	                                 const INT_32   iIdx);
 
 	void CheckStackOnlyRegs(const UINT_32 iSrcReg, const UINT_32 iDstReg, const VMMemoryCore  * pMemoryCore, const UINT_32 iIP);
 };
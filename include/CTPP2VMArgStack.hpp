@@ -99,7 +99,7 @@ public:
 	INT_32 PushElement(const CDT & oCDT);
 
 	/**
-	  @brief Remove top stack element
+	  @brief Remove top stack element; value of element is released
 	  @return stack depth
 	*/
 	INT_32 PopElement();
@@ -118,14 +118,14 @@ public:
 	inline CDT & GetTopElement(const INT_32  iPos = 0) { return GetElement(iStackPointer + iPos); }
 
 	/**
-	  @brief Clear stack on specified depth
+	  @brief Clear stack on specified depth; values of removed elements are released
 	  @param iDepth - number of elements to clear
 	  @return stack depth
 	*/
 	INT_32 ClearStack(const INT_32  iDepth);
 
 	/**
-	  @brief Reset stack of arguments to default state
+	  @brief Reset stack of arguments to default state and release all values
 	*/
 	void Reset();
 
@@ -164,6 +164,14 @@ private:
 	*/
 	inline CDT * GetStackFrame(const INT_32  iTopOffset = 0) { return &aStack[iStackPointer + iTopOffset]; }
 
+	/**
+	  @brief Release values of elements, so stack does not retain data after they are removed
+	  @param iBegin - first element
+	  @param iEnd - element after last one
+	*/
+	void ReleaseElements(const INT_32  iBegin,
+	                     const INT_32  iEnd);
+
 };
 
 } // namespace CTPP
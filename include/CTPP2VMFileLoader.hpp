@@ -32,6 +32,7 @@
 #ifndef _CTPP2_VM_FILE_LOADER_HPP__
 #define _CTPP2_VM_FILE_LOADER_HPP__ 1
 
+#include "CTPP2MappedFile.hpp"
 #include "CTPP2VMLoader.hpp"
 
 /**
@@ -53,6 +54,11 @@ class CTPP2DECL VMFileLoader:
 {
 public:
 	/**
+	  @brief Constructor; file is mapped into memory read-only and shared
+	         between processes, image with foreign byte order is copied and converted.
+	         Mapped file must be replaced (new file is written and renamed, as ctpp2c
+	         does), never rewritten in place: truncated mapping crashes the process
+	  @param szFile - file name
 	*/
 	VMFileLoader(CCHAR_P szFile);
 	/**
@@ -65,10 +71,31 @@ public:
 	*/
 	~VMFileLoader() throw();
 private:
+	/** Program file             */
+	MappedFile      oFile;
 	/** Program core             */
 	VMExecutable  * oCore;
+	/** Size of program core     */
+	UINT_32         iCoreSize;
+	/** Core is private copy     */
+	bool            bCopied;
 	/** Ready-to-run program     */
 	VMMemoryCore  * pVMMemoryCore;
+
+	/**
+	  @brief Check program core, convert byte order if need
+	*/
+	void CheckCore();
+
+	/**
+	  @brief Copy program core into private memory
+	*/
+	void CopyCore();
+
+	/**
+	  @brief Release program core
+	*/
+	void ReleaseCore() throw();
 };
 
 } // namespace CTPP
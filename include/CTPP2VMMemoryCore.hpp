@@ -32,11 +32,14 @@
 #ifndef _CTPP2_VM_MEMORY_CORE_HPP__
 #define _CTPP2_VM_MEMORY_CORE_HPP__ 1
 
+#include "CDT.hpp"
 #include "CTPP2HashTable.hpp"
 #include "CTPP2StaticData.hpp"
 #include "CTPP2StaticText.hpp"
 #include "CTPP2BitIndex.hpp"
 
+#include "STLVector.hpp"
+
 /**
   @file CTPP2VMMemoryCore.hpp
   @brief Virtual machine ready-to-run memory core of executable file
@@ -75,6 +78,15 @@ struct CTPP2DECL VMMemoryCore
 	const ReducedHashTable       calls_table;
 	/** System calls translation map         */
 	INT_32                     * syscall_map;
+	/** Interned HASH keys, indexed by
+	    ID of static text record             */
+	STLW::vector<CDTKey>         keys;
+	/** Views of string literals, indexed by
+	    ID of static text record             */
+	STLW::vector<CDTStringView>  strings;
+	/** Pre-decoded instructions, indexed
+	    by instruction address               */
+	STLW::vector<UCHAR_8>        handlers;
 };
 
 } // namespace CTPP
@@ -88,6 +88,8 @@ public:
 	*/
 	~VMOpcodeCollector() throw();
 private:
+	friend class VMOptimizer;
+
 	/** Code segment */
 	STLW::vector<VMInstruction>  oCodeSeg;
 };
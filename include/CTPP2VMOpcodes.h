@@ -34,8 +34,9 @@
 
 #include "CTPP2Types.h"
 
-// Version 3
-#define VM_OPCODE_VERSION  0x00000003
+// Version 4: OUTVAR, OUTVAR_ESC
+// Version 5: OUTSYS
+#define VM_OPCODE_VERSION  0x00000005
 
 /**
   @file CTPP2VMOpcodes.h
@@ -148,6 +149,9 @@
 #define SAVEBP           0x08090000 // Save base pointer
 #define RESTBP           0x080A0000 // Restore base pointer
 #define REPLIND          0x080B0000 // Replace ARRAY/HASH variable in stack with it's element
+#define OUTVAR           0x080C0000 // Output variable from local scope register or, if it is undefined, from global scope register
+#define OUTVAR_ESC       0x080D0000 // Output result of single-argument system call (escape function) applied to variable, as OUTVAR
+#define OUTSYS           0x080E0000 // System call with result written directly to output collector
 
 // Sources ///////////// 0x-------X //////////////////////////////////////////////////////////////////
 #define ARG_SRC_AR       0x00000000 // AR is source register
@@ -0,0 +1,152 @@
+/*-
+ * Copyright (c) 2004 - 2011 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2VMOptimizer.hpp
+ *
+ * $CTPP$
+ */
+#ifndef _CTPP2_VM_OPTIMIZER_HPP__
+#define _CTPP2_VM_OPTIMIZER_HPP__ 1
+
+#include "CTPP2Types.h"
+#include "STLVector.hpp"
+
+/**
+  @file CTPP2VMOptimizer.hpp
+  @brief Optimizer of generated operation codes
+*/
+
+namespace CTPP // C++ Template Engine
+{
+// FWD
+class CDT;
+class HashTable;
+class StaticData;
+class StaticText;
+class VMOpcodeCollector;
+struct VMInstruction;
+
+/**
+  @class VMOptimizer CTPP2VMOptimizer.hpp <CTPP2VMOptimizer.hpp>
+  @brief Optimizer of generated operation codes; should be applied to compiled program before it is dumped by VMDumper
+*/
+class CTPP2DECL VMOptimizer
+{
+public:
+	/**
+	  @brief Constructor
+	  @param oIVMOpcodeCollector - compiled code
+	  @param oIStaticData - static data segment
+	  @param oIStaticText - static text segment
+	  @param oICallsTable - table of block entry points
+	*/
+	VMOptimizer(VMOpcodeCollector  & oIVMOpcodeCollector,
+	            StaticData         & oIStaticData,
+	            StaticText         & oIStaticText,
+	            HashTable          & oICallsTable);
+
+	/**
+	  @brief Apply all optimizations until code does not change
+	  @return number of removed instructions
+	*/
+	UINT_32 Optimize();
+
+	/**
+	  @brief Merge consecutive outputs of static text into one instruction
+	  @return number of removed instructions
+	*/
+	UINT_32 MergeStaticOutput();
+
+	/**
+	  @brief Calculate ADD, SUB, MUL and comparisons of static operands at compile time
+	  @return number of removed instructions
+	*/
+	UINT_32 FoldConstants();
+
+	/**
+	  @brief Replace PUSH followed by POP with MOV
+	  @return number of removed instructions
+	*/
+	UINT_32 RemovePushPop();
+
+	/**
+	  @brief Shorten chains of jumps, remove jumps to next instruction and unreachable code
+	  @return number of removed instructions
+	*/
+	UINT_32 OptimizeJumps();
+
+	/**
+	  @brief A destructor
+	*/
+	~VMOptimizer() throw();
+private:
+	// Does not exist
+	VMOptimizer(const VMOptimizer & oRhs);
+	// Does not exist
+	VMOptimizer & operator=(const VMOptimizer & oRhs);
+
+	/** Compiled code            */
+	VMOpcodeCollector  & oVMOpcodeCollector;
+	/** Static data segment      */
+	StaticData         & oStaticData;
+	/** Static text segment      */
+	StaticText         & oStaticText;
+	/** Block entry points       */
+	HashTable          & oCallsTable;
+
+	/**
+	  @brief Count jumps and calls to every instruction
+	  @param vTargets - number of jumps to instruction, one per instruction [out]
+	*/
+	void MarkJumpTargets(STLW::vector<UINT_32> & vTargets) const;
+
+	/**
+	  @brief Get value pushed by instruction if it is static
+	  @param oInstruction - instruction
+	  @param oValue - pushed value [out]
+	  @return true if instruction pushes static integer, float or string
+	*/
+	bool GetStaticOperand(const VMInstruction  & oInstruction,
+	                      CDT                  & oValue) const;
+
+	/**
+	  @brief Release static text used by instruction
+	  @param oInstruction - instruction
+	*/
+	void ReleaseStaticText(const VMInstruction & oInstruction);
+
+	/**
+	  @brief Remove instructions from code segment and correct jump targets
+	  @param vRemoved - flags of instructions to remove
+	  @return number of removed instructions
+	*/
+	UINT_32 RemoveInstructions(const STLW::vector<bool> & vRemoved);
+};
+
+} // namespace CTPP
+#endif // _CTPP2_VM_OPTIMIZER_HPP__
+// End.
@@ -92,6 +92,21 @@ public:
 	                       CDT            & oCDTRetVal,
 	                       Logger         & oLogger) = 0;
 
+	/**
+	  @brief Handler for call which result is sent to output immediately, e.g. <TMPL_var HTMLESCAPE(x)>;
+	         default implementation calls Handler() and writes result to collector, functions
+	         which produce long strings may override it to write result without temporary copies
+	  @param aArguments - list of arguments
+	  @param iArgNum - number of arguments
+	  @param oCollector - output data collector
+	  @param oLogger - logger
+	  @return 0 - if success, -1 - if any error occured
+	*/
+	virtual INT_32 HandlerToOutput(CDT              * aArguments,
+	                               const UINT_32      iArgNum,
+	                               OutputCollector  & oCollector,
+	                               Logger           & oLogger);
+
 	/**
 	  @brief Get function name
 	*/
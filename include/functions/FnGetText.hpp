@@ -32,6 +32,7 @@
 #ifndef _FN_GET_TEXT_HPP__
 #define _FN_GET_TEXT_HPP__ 1
 
+#include "CTPP2GetText.hpp"
 #include "CTPP2VMSyscall.hpp"
 
 /**
@@ -44,7 +45,6 @@ namespace CTPP // C++ Template Engine
 
 class CDT;
 class Logger;
-class CTPP2GetText;
 
 /**
   @class FnGetText FnGetText.hpp <FnGetText.hpp>
@@ -92,16 +92,30 @@ private:
 	void SetGetText(CTPP2GetText * pGetText);
 
 	/**
-	  @brief Set language of translation
+	  @brief Set language of translation, bind its catalogs
 	  @param sLang - language
 	*/
 	void SetLanguage(const STLW::string & sLang);
 
-	/** GetText pointer         */
-	CTPP2GetText * pGetText;
+	/**
+	  @brief Bind catalogs of language and default i18n domain
+	*/
+	void BindCatalogs();
+
+	/** GetText pointer                              */
+	CTPP2GetText                      * pGetText;
+
+	/** Language of translation                      */
+	STLW::string                        sLanguage;
+
+	/** Revision of bound catalogs                   */
+	UINT_32                             iRevision;
+
+	/** Catalogs of language of translation          */
+	const CTPP2GetText::DomainMap     * pDomains;
 
-	/** Language of translation */
-	STLW::string sLanguage;
+	/** Catalogs of language and default i18n domain */
+	const CTPP2GetText::CatalogList   * pCatalogs;
 
 	/** Name of function */
 	CHAR_P szFuncName;
@@ -44,6 +44,7 @@ namespace CTPP // C++ Template Engine
 
 class CDT;
 class Logger;
+class OutputCollector;
 
 /**
   @class FnURLEscape FnURLEscape.hpp <FnURLEscape.hpp>
@@ -78,6 +79,19 @@ private:
 	               CDT            & oCDTRetVal,
 	               Logger         & oLogger);
 
+	/**
+	  @brief Handler, result is written to output collector
+	  @param aArguments - list of arguments
+	  @param iArgNum - number of arguments
+	  @param oCollector - output data collector
+	  @param oLogger - logger
+	  @return 0 - if success, -1 - otherwise
+	*/
+	INT_32 HandlerToOutput(CDT              * aArguments,
+	                       const UINT_32      iArgNum,
+	                       OutputCollector  & oCollector,
+	                       Logger           & oLogger);
+
 	/**
 	  @brief Get function name
 	*/
@@ -40,7 +40,7 @@
 #include "CTPP2StringOutputCollector.hpp"
 #include "CTPP2SyscallFactory.hpp"
 
-#include "CTPP2VMFileLoader.hpp"
+#include "CTPP2TemplateCache.hpp"
 #include "CTPP2VM.hpp"
 #include "CTPP2VMSTDLib.hpp"
 
@@ -55,12 +55,10 @@ struct ThreadContext
 {
 	// Output mutex
 	pthread_mutex_t     output_mutex;
-	// Template access mutex
-	pthread_mutex_t     template_mutex;
 	// Max handlers
 	INT_32              max_handlers;
-	// Set of templates
-	STLW::map<STLW::string, VMFileLoader *>    templates;
+	// Set of templates, lock-free lookup
+	TemplateCache       templates;
 };
 
 // Thread function
@@ -93,22 +91,14 @@ static void * ThreadFunction(void * pContext)
 	FileLogger oLogger(stderr);
 
 	// Perform some work
-	const VMMemoryCore * pVMMemoryCore = NULL;
 	for (UINT_32 iCount = 0; iCount < MAX_ITERATIONS; ++iCount)
 	{
 		STLW::string sResult;
 		StringOutputCollector  oDataCollector(sResult);
 
-		// Get template, thread-safe
-		pthread_mutex_lock(&(pThreadContext -> template_mutex));
-		STLW::map<STLW::string, VMFileLoader *>::iterator itLoader = pThreadContext -> templates.find("hello.ct2");
-		if (itLoader == pThreadContext -> templates.end())
-		{
-			continue;
-		}
-
-		pVMMemoryCore = itLoader -> second -> GetCore();
-		pthread_mutex_unlock(&(pThreadContext -> template_mutex));
+		// Get template, thread-safe; template is not released until end of render
+		TemplateCache::Handle oTemplate = pThreadContext -> templates.Get("hello.ct2");
+		const VMMemoryCore * pVMMemoryCore = oTemplate.GetCore();
 
 		// Run VM
 		pVM -> Init(pVMMemoryCore, &oDataCollector, &oLogger);
@@ -132,11 +122,13 @@ int main(int argc, char ** argv)
 	ThreadContext oContext;
 
 	// Load file
-	oContext.templates["hello.ct2"] = new VMFileLoader("hello.ct2");
+	oContext.templates.Get("hello.ct2");
 	oContext.max_handlers = 1024;
 
+	// Reload changed templates every second
+	oContext.templates.StartChecker(1000);
+
 	// Init mutexes
-	pthread_mutex_init(&oContext.template_mutex, NULL);
 	pthread_mutex_init(&oContext.output_mutex, NULL);
 
 	pthread_attr_t        oAttrs;
@@ -178,7 +170,7 @@ int main(int argc, char ** argv)
 
 	fprintf(stderr, "Cleanup and exit\n");
 	pthread_attr_destroy(&oAttrs);
-	pthread_mutex_destroy(&oContext.template_mutex);
+	oContext.templates.StopChecker();
 	pthread_mutex_destroy(&oContext.output_mutex);
 }
 // End.
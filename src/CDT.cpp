@@ -30,9 +30,16 @@
  * $CTPP$
  */
 #include "CDT.hpp"
+#include "CTPP2DTOA.hpp"
+#include "CTPP2HashTable.hpp"
+#include "CTPP2OutputCollector.hpp"
 #include "STLFunctional.hpp"
 
 #include <stdio.h>
+#include <string.h>
+
+/** Size of buffer for zero-terminated copy of numeric string view */
+#define C_CDT_NUMBER_BUFFER_LENGTH  64
 
 namespace CTPP
 {
@@ -56,6 +63,8 @@ struct CDT::_CDT
 	UINT_32           refcount;
 	/** Value type fpr complex datatypes */
 	mutable eValType  value_type;
+	/** Arena of container, NULL for heap */
+	CDTArena        * arena;
 
 	/** Union */
 	union
@@ -78,24 +87,91 @@ struct CDT::_CDT
 	} uc;
 
 	/** Constructor */
-	_CDT();
+	_CDT(CDTArena  * pIArena = NULL);
 };
 
 //
 // Constructor
 //
-CDT::_CDT::_CDT(): refcount(1), value_type(UNDEF)
+CDT::_CDT::_CDT(CDTArena  * pIArena): refcount(1), value_type(UNDEF), arena(pIArena)
 {
 	u.s_data  = NULL;
 	uc.i_data = 0;
 }
 
+// ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Struct CDTStringOwner
+//
+
+//
+// Constructor
+//
+CDTStringOwner::CDTStringOwner(): refcount(1) { ;; }
+
+//
+// Release reference
+//
+void CDTStringOwner::Release() throw()
+{
+	--refcount;
+	if (refcount == 0) { delete this; }
+}
+
+//
+// A destructor
+//
+CDTStringOwner::~CDTStringOwner() throw() { ;; }
+
 // ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // Static vars
 //
 static const CDT oNonExistentCDT;
 
+#ifdef CDT_FLAT_HASH
+//
+// Find element in HASH
+//
+static const CDT * FindElement(const CDTHashMap<CDT>  & mHash,
+                               const STLW::string     & sKey,
+                               const UINT_64            iHash)
+{
+return mHash.Get(sKey, iHash);
+}
+
+//
+// Find element in HASH
+//
+static const CDT * FindElement(const CDTHashMap<CDT>  & mHash,
+                               const STLW::string     & sKey)
+{
+return mHash.Get(sKey, CDTHashMap<CDT>::Hash(sKey));
+}
+#else
+//
+// Find element in HASH
+//
+template<typename M>static const CDT * FindElement(const M             & mHash,
+                                                  const STLW::string  & sKey)
+{
+	typename M::const_iterator itmHash = mHash.find(sKey);
+	if (itmHash == mHash.end()) { return NULL; }
+
+return &(itmHash -> second);
+}
+
+//
+// Find element in HASH, precomputed hash value is not used by tree
+//
+template<typename M>static const CDT * FindElement(const M             & mHash,
+                                                  const STLW::string  & sKey,
+                                                  const UINT_64         iHash)
+{
+return FindElement(mHash, sKey);
+}
+#endif
+
 // ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // Class Iterator
@@ -165,6 +241,8 @@ CDT::Iterator CDT::Begin()
 {
 	if (eValueType != HASH_VAL) { throw CDTAccessException(); }
 
+	TouchArena();
+
 return Iterator(u.p_data -> u.m_data -> begin());
 }
 
@@ -185,6 +263,8 @@ CDT::Iterator CDT::Find(const STLW::string & sKey)
 {
 	if (eValueType != HASH_VAL) { throw CDTAccessException(); }
 
+	TouchArena();
+
 return Iterator(u.p_data -> u.m_data -> find(sKey));
 }
 
@@ -330,6 +410,26 @@ SortHelper::SortHelper(const CDT::SortingComparator  & oISortingComparator): oSo
 //
 bool SortHelper::operator()(const CDT & oX, const CDT & oY) const { return oSortingComparator.operator()(oX, oY); }
 
+// ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Struct CDTKey
+//
+
+//
+// Constructor, empty key
+//
+CDTKey::CDTKey(): hash(HashFunc("", 0)) { ;; }
+
+//
+// Constructor
+//
+CDTKey::CDTKey(CCHAR_P        szKey,
+               const UINT_32  iKeyLength): key(szKey, iKeyLength),
+                                           hash(HashFunc(szKey, iKeyLength))
+{
+	;;
+}
+
 // ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // Class CDT
@@ -338,11 +438,24 @@ bool SortHelper::operator()(const CDT & oX, const CDT & oY) const { return oSort
 //
 // Default constructor
 //
-CDT::CDT(const eValType & oValue): eValueType(oValue)
+CDT::CDT(const eValType & oValue): eValueType(oValue) { InitValue(NULL); }
+
+//
+// Constructor
+//
+CDT::CDT(const eValType  & oValue,
+         CDTArena        * pArena): eValueType(oValue) { InitValue(pArena); }
+
+//
+// Initialize empty value of given type
+//
+void CDT::InitValue(CDTArena  * pArena)
 {
 	switch (eValueType)
 	{
 		case UNDEF:
+			// Value is copied as a whole by operator=
+			u.i_data = 0;
 			break;
 
 		case INT_VAL:
@@ -354,30 +467,24 @@ CDT::CDT(const eValType & oValue): eValueType(oValue)
 			break;
 
 		case STRING_VAL:
-			u.p_data = new _CDT();
-			u.p_data -> u.s_data = new String;
-			break;
-
 		case STRING_INT_VAL:
-			u.p_data = new _CDT();
-			u.p_data -> value_type = INT_VAL;
-			u.p_data -> u.s_data = new String;
-			break;
-
 		case STRING_REAL_VAL:
-			u.p_data = new _CDT();
-			u.p_data -> value_type = REAL_VAL;
-			u.p_data -> u.s_data = new String;
+			// Empty string is stored inline, numeric value of it is zero
+			iInlineLength = 0;
 			break;
 
 		case ARRAY_VAL:
-			u.p_data = new _CDT();
-			u.p_data -> u.v_data = new Vector;
+			u.p_data = new (pArena) _CDT(pArena);
+			u.p_data -> u.v_data = new (pArena) Vector(Vector::allocator_type(pArena));
 			break;
 
 		case HASH_VAL:
-			u.p_data = new _CDT();
-			u.p_data -> u.m_data = new Map;
+			u.p_data = new (pArena) _CDT(pArena);
+			u.p_data -> u.m_data = new (pArena) Map(STLW::less<STLW::string>(), Map::allocator_type(pArena));
+#ifndef CDT_FLAT_HASH
+			// Keys of STLW::map are destroyed by walk only
+			if (pArena != NULL) { pArena -> MarkForeign(); }
+#endif
 			break;
 
 		case POINTER_VAL:
@@ -404,6 +511,7 @@ CDT::CDT(const CDT & oCDT)
 	switch (eValueType)
 	{
 		case UNDEF:
+			u.i_data = 0;
 			break;
 
 		case INT_VAL:
@@ -421,6 +529,17 @@ CDT::CDT(const CDT & oCDT)
 		case STRING_VAL:
 		case STRING_REAL_VAL:
 		case STRING_INT_VAL:
+			iInlineLength = oCDT.iInlineLength;
+			if (iInlineLength != C_CDT_SHARED_STRING)
+			{
+				u.i_data = oCDT.u.i_data;
+				if (iInlineLength == C_CDT_OWNED_STRING) { ++(static_cast<CDTOwnedStringView *>(u.pp_data) -> owner -> refcount); }
+				break;
+			}
+			u.p_data = oCDT.u.p_data;
+			++(u.p_data -> refcount);
+			break;
+
 		case ARRAY_VAL:
 		case HASH_VAL:
 			u.p_data = oCDT.u.p_data;
@@ -447,11 +566,16 @@ CDT & CDT::operator=(const CDT & oCDT)
 	W_FLOAT   dFloatVal    = oCDT.u.d_data;
 	void    * vPointerVal  = oCDT.u.pp_data;
 	eValType  eOrigValType = oCDT.eValueType;
+	// Length marker is set for strings only
+	UCHAR_8   iOrigLength  = ((eOrigValType & STRING_VAL) != 0) ? oCDT.iInlineLength : 0;
+
+	// Owner of string view is retained before destruction of this, oCDT can be nested in this
+	if (iOrigLength == C_CDT_OWNED_STRING) { ++(static_cast<CDTOwnedStringView *>(vPointerVal) -> owner -> refcount); }
 
 	// Destroy object if need
 	if (eValueType >= STRING_VAL)
 	{
-		if (oCDT.eValueType >= STRING_VAL && oCDT.u.p_data -> refcount == 1)
+		if (oCDT.eValueType >= STRING_VAL && !oCDT.IsInlineString() && oCDT.u.p_data -> refcount == 1)
 		{
 			// oCDT can be a child of this with u.refcount = 1;
 			// so we increase it's refcount
@@ -490,6 +614,16 @@ CDT & CDT::operator=(const CDT & oCDT)
 		case STRING_VAL:
 		case STRING_REAL_VAL:
 		case STRING_INT_VAL:
+			iInlineLength = iOrigLength;
+			if (iInlineLength != C_CDT_SHARED_STRING)
+			{
+				u.i_data = iIntVal;
+				break;
+			}
+			u.p_data = pTMP;
+			++u.p_data -> refcount;
+			break;
+
 		case ARRAY_VAL:
 		case HASH_VAL:
 			u.p_data = pTMP;
@@ -533,19 +667,52 @@ CDT::CDT(const W_FLOAT  oValue): eValueType(REAL_VAL)      { u.d_data = oValue;
 //
 // Type cast constructor from STLW::string type
 //
-CDT::CDT(const STLW::string & oValue): eValueType(STRING_VAL)
+CDT::CDT(const STLW::string & oValue): eValueType(UNDEF) { InitString(oValue.data(), UINT_32(oValue.size())); }
+
+//
+// Type cast constructor from STLW::string type, long string is allocated in arena
+//
+CDT::CDT(const STLW::string  & oValue,
+         CDTArena            * pArena): eValueType(UNDEF) { InitString(oValue.data(), UINT_32(oValue.size()), pArena); }
+
+//
+// Type cast constructor from CCHAR_P type
+//
+CDT::CDT(CCHAR_P oValue): eValueType(UNDEF) { InitString(oValue, UINT_32(strlen(oValue))); }
+
+//
+// Type cast constructor from view of immutable string
+//
+CDT::CDT(const CDTStringView & oValue): eValueType(STRING_VAL)
 {
-	u.p_data = new _CDT();
-	u.p_data -> u.s_data = new String(oValue);
+	// Short string is cheaper to copy than to refer to
+	if (oValue.length <= C_CDT_INLINE_LENGTH)
+	{
+		memcpy(u.s_inline, oValue.data, oValue.length);
+		iInlineLength = UCHAR_8(oValue.length);
+		return;
+	}
+
+	u.pp_data     = const_cast<CDTStringView *>(&oValue);
+	iInlineLength = C_CDT_STATIC_STRING;
 }
 
 //
-// Type cast constructor from CCHAR_P type
+// Type cast constructor from view of string kept alive by its owner
 //
-CDT::CDT(CCHAR_P oValue): eValueType(STRING_VAL)
+CDT::CDT(const CDTOwnedStringView & oValue): eValueType(STRING_VAL)
 {
-	u.p_data = new _CDT();
-	u.p_data -> u.s_data = new STLW::string(oValue);
+	// Short string is cheaper to copy than to refer to
+	if (oValue.view.length <= C_CDT_INLINE_LENGTH)
+	{
+		memcpy(u.s_inline, oValue.view.data, oValue.view.length);
+		iInlineLength = UCHAR_8(oValue.view.length);
+		return;
+	}
+
+	u.pp_data     = const_cast<CDTOwnedStringView *>(&oValue);
+	iInlineLength = C_CDT_OWNED_STRING;
+	++(oValue.owner -> refcount);
 }
 
 //
@@ -604,11 +771,13 @@ return *this;
 CDT & CDT::operator=(const STLW::string & oValue)
 {
 	// Destroy object if need
-	if (eValueType >= STRING_VAL) { Destroy(); }
+	if (eValueType >= STRING_VAL)
+	{
+		Destroy();
+		eValueType = UNDEF;
+	}
 
-	eValueType = STRING_VAL;
-	u.p_data = new _CDT();
-	u.p_data -> u.s_data = new String(oValue);
+	InitString(oValue.data(), UINT_32(oValue.size()));
 
 return *this;
 }
@@ -619,11 +788,13 @@ return *this;
 CDT & CDT::operator=(CCHAR_P oValue)
 {
 	// Destroy object if need
-	if (eValueType >= STRING_VAL) { Destroy(); }
+	if (eValueType >= STRING_VAL)
+	{
+		Destroy();
+		eValueType = UNDEF;
+	}
 
-	eValueType = STRING_VAL;
-	u.p_data = new _CDT();
-	u.p_data -> u.s_data = new String(oValue);
+	InitString(oValue, UINT_32(strlen(oValue)));
 
 return *this;
 }
@@ -731,15 +902,48 @@ const CDT & CDT::GetExistedCDT(const STLW::string & sKey, bool & bCDTExist) cons
 		return oNonExistentCDT;
 	}
 
-	Map::const_iterator itmHash = u.p_data -> u.m_data -> find(sKey);
-	if (itmHash == u.p_data -> u.m_data -> end())
+	const CDT * pCDT = FindElement(*(u.p_data -> u.m_data), sKey);
+	if (pCDT == NULL)
 	{
 		bCDTExist = false;
 		return oNonExistentCDT;
 	}
 	bCDTExist = true;
 
-return itmHash -> second;
+return *pCDT;
+}
+
+//
+// Provides constant access to the data contained in CDT
+//
+const CDT & CDT::GetCDT(const CDTKey & oKey) const
+{
+	bool bFlag = 0;
+
+return GetExistedCDT(oKey, bFlag);
+}
+
+//
+// Provides constant access to the data contained in CDT
+//
+const CDT & CDT::GetExistedCDT(const CDTKey & oKey, bool & bCDTExist) const
+{
+	// CDT Does Not exist
+	if (eValueType != HASH_VAL)
+	{
+		bCDTExist = false;
+		return oNonExistentCDT;
+	}
+
+	const CDT * pCDT = FindElement(*(u.p_data -> u.m_data), oKey.key, oKey.hash);
+	if (pCDT == NULL)
+	{
+		bCDTExist = false;
+		return oNonExistentCDT;
+	}
+	bCDTExist = true;
+
+return *pCDT;
 }
 
 //
@@ -778,10 +982,7 @@ bool CDT::Exists(const STLW::string & sKey) const
 {
 	if (eValueType != HASH_VAL) { throw CDTAccessException(); }
 
-	Map::const_iterator itmHash = u.p_data -> u.m_data -> find(sKey);
-	if (itmHash == u.p_data -> u.m_data -> end()) { return false; }
-
-return true;
+return FindElement(*(u.p_data -> u.m_data), sKey) != NULL;
 }
 
 //
@@ -824,7 +1025,12 @@ void CDT::PushBack(CCHAR_P oValue)              { PushBack(CDT(oValue)); }
 //
 void CDT::PushBack(const CDT & oValue)
 {
-	if      (eValueType == ARRAY_VAL) { u.p_data -> u.v_data -> push_back(oValue); }
+	if (eValueType == ARRAY_VAL)
+	{
+		// Unshare complex type
+		Unshare();
+		u.p_data -> u.v_data -> push_back(oValue);
+	}
 	else if (eValueType == UNDEF)
 	{
 		(*this) = CDT(CDT::ARRAY_VAL);
@@ -857,7 +1063,7 @@ bool CDT::Nonzero() const
 		case STRING_VAL:
 		case STRING_REAL_VAL:
 		case STRING_INT_VAL:
-			if (u.p_data -> u.s_data -> size() != 0) { return true; }
+			if (StringLength() != 0)                 { return true; }
 			break;
 
 		case ARRAY_VAL:
@@ -885,6 +1091,8 @@ CDT & CDT::At(const UINT_32  iPos)
 
 	if (iPos >= u.p_data -> u.v_data -> size()) { throw CDTRangeException(); }
 
+	TouchArena();
+
 return u.p_data -> u.v_data -> operator[](iPos);
 }
 
@@ -895,10 +1103,12 @@ CDT & CDT::At(const STLW::string & sKey)
 {
 	if (eValueType != HASH_VAL) { throw CDTAccessException(); }
 
-	Map::iterator itmHash = u.p_data -> u.m_data -> find(sKey);
-	if (itmHash == u.p_data -> u.m_data -> end()) { throw CDTRangeException(); }
+	const CDT * pCDT = FindElement(*(u.p_data -> u.m_data), sKey);
+	if (pCDT == NULL) { throw CDTRangeException(); }
 
-return itmHash -> second;
+	TouchArena();
+
+return *const_cast<CDT *>(pCDT);
 }
 
 // ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -934,11 +1144,11 @@ CDT CDT::operator+(const INT_64  oValue) const
 			}
 
 		case STRING_INT_VAL:
-			return CDT(u.p_data -> uc.i_data + oValue);
+			return CDT(CachedInt() + oValue);
 
 
 		case STRING_REAL_VAL:
-			return CDT(u.p_data -> uc.d_data + oValue);
+			return CDT(CachedFloat() + oValue);
 
 		default:
 			throw CDTTypeCastException("operator+ (INT_64)");
@@ -994,10 +1204,10 @@ CDT CDT::operator+(const W_FLOAT  oValue) const
 			}
 
 		case STRING_INT_VAL:
-			return CDT(u.p_data -> uc.i_data + oValue);
+			return CDT(CachedInt() + oValue);
 
 		case STRING_REAL_VAL:
-			return CDT(u.p_data -> uc.d_data + oValue);
+			return CDT(CachedFloat() + oValue);
 
 		default:
 			throw CDTTypeCastException("operator+(INT_64)");
@@ -1127,10 +1337,10 @@ CDT CDT::operator*(const INT_64  oValue) const
 			}
 
 		case STRING_INT_VAL:
-			return CDT(u.p_data -> uc.i_data * oValue);
+			return CDT(CachedInt() * oValue);
 
 		case STRING_REAL_VAL:
-			return CDT(u.p_data -> uc.d_data * oValue);
+			return CDT(CachedFloat() * oValue);
 
 		default:
 			throw CDTTypeCastException("operator*(INT_64)");
@@ -1186,10 +1396,10 @@ CDT CDT::operator*(const W_FLOAT  oValue) const
 			}
 
 		case STRING_INT_VAL:
-			return CDT(u.p_data -> uc.i_data * oValue);
+			return CDT(CachedInt() * oValue);
 
 		case STRING_REAL_VAL:
-			return CDT(u.p_data -> uc.d_data * oValue);
+			return CDT(CachedFloat() * oValue);
 
 		default:
 			throw CDTTypeCastException("operator*(W_FLOAT)");
@@ -1262,11 +1472,11 @@ CDT CDT::operator/(const INT_64  oValue) const
 			}
 
 		case STRING_INT_VAL:
-			return CDT(u.p_data -> uc.i_data / oValue);
+			return CDT(CachedInt() / oValue);
 
 
 		case STRING_REAL_VAL:
-			return CDT(u.p_data -> uc.d_data / oValue);
+			return CDT(CachedFloat() / oValue);
 
 		default:
 			throw CDTTypeCastException("operator/(INT_64)");
@@ -1324,11 +1534,11 @@ CDT CDT::operator/(const W_FLOAT  oValue) const
 			}
 
 		case STRING_INT_VAL:
-			return CDT(u.p_data -> uc.i_data / oValue);
+			return CDT(CachedInt() / oValue);
 
 
 		case STRING_REAL_VAL:
-			return CDT(u.p_data -> uc.d_data / oValue);
+			return CDT(CachedFloat() / oValue);
 
 		default:
 			throw CDTTypeCastException("operator/(W_FLOAT)");
@@ -1404,11 +1614,11 @@ CDT & CDT::operator+=(const INT_64  oValue)
 			break;
 
 		case STRING_INT_VAL:
-			(*this) = CDT(u.p_data -> uc.i_data + oValue);
+			(*this) = CDT(CachedInt() + oValue);
 			break;
 
 		case STRING_REAL_VAL:
-			(*this) = CDT(u.p_data -> uc.d_data + oValue);
+			(*this) = CDT(CachedFloat() + oValue);
 			break;
 
 		default:
@@ -1467,11 +1677,11 @@ CDT & CDT::operator+=(const W_FLOAT  oValue)
 			break;
 
 		case STRING_INT_VAL:
-			(*this) = CDT(u.p_data -> uc.i_data + oValue);
+			(*this) = CDT(CachedInt() + oValue);
 			break;
 
 		case STRING_REAL_VAL:
-			(*this) = CDT(u.p_data -> uc.d_data + oValue);
+			(*this) = CDT(CachedFloat() + oValue);
 			break;
 
 		default:
@@ -1608,11 +1818,11 @@ CDT & CDT::operator*=(const INT_64  oValue)
 			break;
 
 		case STRING_INT_VAL:
-			(*this) = CDT(u.p_data -> uc.i_data * oValue);
+			(*this) = CDT(CachedInt() * oValue);
 			break;
 
 		case STRING_REAL_VAL:
-			(*this) = CDT(u.p_data -> uc.d_data * oValue);
+			(*this) = CDT(CachedFloat() * oValue);
 			break;
 
 		default:
@@ -1676,11 +1886,11 @@ CDT & CDT::operator*=(const W_FLOAT  oValue)
 			break;
 
 		case STRING_INT_VAL:
-			(*this) = CDT(u.p_data -> uc.i_data * oValue);
+			(*this) = CDT(CachedInt() * oValue);
 			break;
 
 		case STRING_REAL_VAL:
-			(*this) = CDT(u.p_data -> uc.d_data * oValue);
+			(*this) = CDT(CachedFloat() * oValue);
 			break;
 
 		default:
@@ -1758,11 +1968,11 @@ CDT & CDT::operator/=(const INT_64  oValue)
 			break;
 
 		case STRING_INT_VAL:
-			(*this) = CDT(u.p_data -> uc.i_data / oValue);
+			(*this) = CDT(CachedInt() / oValue);
 			break;
 
 		case STRING_REAL_VAL:
-			(*this) = CDT(u.p_data -> uc.d_data / oValue);
+			(*this) = CDT(CachedFloat() / oValue);
 			break;
 
 		default:
@@ -1826,11 +2036,11 @@ CDT & CDT::operator/=(const W_FLOAT  oValue)
 			break;
 
 		case STRING_INT_VAL:
-			(*this) = CDT(u.p_data -> uc.i_data / oValue);
+			(*this) = CDT(CachedInt() / oValue);
 			break;
 
 		case STRING_REAL_VAL:
-			(*this) = CDT(u.p_data -> uc.d_data / oValue);
+			(*this) = CDT(CachedFloat() / oValue);
 			break;
 
 		default:
@@ -1881,8 +2091,8 @@ bool CDT::operator==(const INT_64  oValue) const
 {
 	if      (eValueType == INT_VAL)         { return u.i_data == oValue;              }
 	else if (eValueType == REAL_VAL)        { return u.d_data == oValue;              }
-	else if (eValueType == STRING_INT_VAL)  { return u.p_data -> uc.i_data == oValue; }
-	else if (eValueType == STRING_REAL_VAL) { return u.p_data -> uc.d_data == oValue; }
+	else if (eValueType == STRING_INT_VAL)  { return CachedInt() == oValue; }
+	else if (eValueType == STRING_REAL_VAL) { return CachedFloat() == oValue; }
 
 #if THROW_EXCEPTION_IN_COMPARATORS
 	else
@@ -1919,8 +2129,8 @@ bool CDT::operator==(const W_FLOAT  oValue) const
 {
 	if      (eValueType == INT_VAL)         { return u.i_data == oValue;              }
 	else if (eValueType == REAL_VAL)        { return u.d_data == oValue;              }
-	else if (eValueType == STRING_INT_VAL)  { return u.p_data -> uc.i_data == oValue; }
-	else if (eValueType == STRING_REAL_VAL) { return u.p_data -> uc.d_data == oValue; }
+	else if (eValueType == STRING_INT_VAL)  { return CachedInt() == oValue; }
+	else if (eValueType == STRING_REAL_VAL) { return CachedFloat() == oValue; }
 #if THROW_EXCEPTION_IN_COMPARATORS
 	else
 	{
@@ -2006,7 +2216,7 @@ bool CDT::operator==(const CDT & oCDT) const
 	else if ((eValueType      == STRING_VAL || eValueType      == STRING_REAL_VAL || eValueType      == STRING_INT_VAL) &&
 		 (oCDT.eValueType == STRING_VAL || oCDT.eValueType == STRING_REAL_VAL || oCDT.eValueType == STRING_INT_VAL))
 	{
-		return *(u.p_data -> u.s_data) == *(oCDT.u.p_data -> u.s_data);
+		return StringCompare(oCDT) == 0;
 	}
 	else if (eValueType == POINTER_VAL && oCDT.eValueType == POINTER_VAL)
 	{
@@ -2233,8 +2443,8 @@ bool CDT::operator>(const INT_64  oValue)  const
 {
 	if      (eValueType == INT_VAL)         { return u.i_data > oValue;              }
 	else if (eValueType == REAL_VAL)        { return u.d_data > oValue;              }
-	else if (eValueType == STRING_INT_VAL)  { return u.p_data -> uc.i_data > oValue; }
-	else if (eValueType == STRING_REAL_VAL) { return u.p_data -> uc.d_data > oValue; }
+	else if (eValueType == STRING_INT_VAL)  { return CachedInt() > oValue; }
+	else if (eValueType == STRING_REAL_VAL) { return CachedFloat() > oValue; }
 #if THROW_EXCEPTION_IN_COMPARATORS
 	else
 	{
@@ -2270,8 +2480,8 @@ bool CDT::operator>(const W_FLOAT  oValue) const
 {
 	if      (eValueType == INT_VAL)         { return u.i_data > oValue;              }
 	else if (eValueType == REAL_VAL)        { return u.d_data > oValue;              }
-	else if (eValueType == STRING_INT_VAL)  { return u.p_data -> uc.i_data > oValue; }
-	else if (eValueType == STRING_REAL_VAL) { return u.p_data -> uc.d_data > oValue; }
+	else if (eValueType == STRING_INT_VAL)  { return CachedInt() > oValue; }
+	else if (eValueType == STRING_REAL_VAL) { return CachedFloat() > oValue; }
 #if THROW_EXCEPTION_IN_COMPARATORS
 	else
 	{
@@ -2356,7 +2566,7 @@ bool CDT::operator>(const CDT & oCDT) const
 	else if ((eValueType      == STRING_VAL || eValueType      == STRING_REAL_VAL || eValueType      == STRING_INT_VAL) &&
 		 (oCDT.eValueType == STRING_VAL || oCDT.eValueType == STRING_REAL_VAL || oCDT.eValueType == STRING_INT_VAL))
 	{
-		return *(u.p_data -> u.s_data) > *(oCDT.u.p_data -> u.s_data);
+		return StringCompare(oCDT) > 0;
 	}
 	else if (eValueType == POINTER_VAL && oCDT.eValueType == POINTER_VAL)
 	{
@@ -2386,8 +2596,8 @@ bool CDT::operator<(const INT_64  oValue) const
 {
 	if      (eValueType == INT_VAL)         { return u.i_data < oValue;              }
 	else if (eValueType == REAL_VAL)        { return u.d_data < oValue;              }
-	else if (eValueType == STRING_INT_VAL)  { return u.p_data -> uc.i_data < oValue; }
-	else if (eValueType == STRING_REAL_VAL) { return u.p_data -> uc.d_data < oValue; }
+	else if (eValueType == STRING_INT_VAL)  { return CachedInt() < oValue; }
+	else if (eValueType == STRING_REAL_VAL) { return CachedFloat() < oValue; }
 #if THROW_EXCEPTION_IN_COMPARATORS
 	else
 	{
@@ -2423,8 +2633,8 @@ bool CDT::operator<(const W_FLOAT  oValue) const
 {
 	if      (eValueType == INT_VAL)         { return u.i_data < oValue;              }
 	else if (eValueType == REAL_VAL)        { return u.d_data < oValue;              }
-	else if (eValueType == STRING_INT_VAL)  { return u.p_data -> uc.i_data < oValue; }
-	else if (eValueType == STRING_REAL_VAL) { return u.p_data -> uc.d_data < oValue; }
+	else if (eValueType == STRING_INT_VAL)  { return CachedInt() < oValue; }
+	else if (eValueType == STRING_REAL_VAL) { return CachedFloat() < oValue; }
 #if THROW_EXCEPTION_IN_COMPARATORS
 	else
 	{
@@ -2509,7 +2719,7 @@ bool CDT::operator<(const CDT & oCDT) const
 	else if ((eValueType      == STRING_VAL || eValueType      == STRING_REAL_VAL || eValueType      == STRING_INT_VAL) &&
 		 (oCDT.eValueType == STRING_VAL || oCDT.eValueType == STRING_REAL_VAL || oCDT.eValueType == STRING_INT_VAL))
 	{
-		return *(u.p_data -> u.s_data) < *(oCDT.u.p_data -> u.s_data);
+		return StringCompare(oCDT) < 0;
 	}
 	else if (eValueType == POINTER_VAL && oCDT.eValueType == POINTER_VAL)
 	{
@@ -2539,8 +2749,8 @@ bool CDT::operator<=(const INT_64  oValue)  const
 {
 	if      (eValueType == INT_VAL)         { return u.i_data <= oValue;              }
 	else if (eValueType == REAL_VAL)        { return u.d_data <= oValue;              }
-	else if (eValueType == STRING_INT_VAL)  { return u.p_data -> uc.i_data <= oValue; }
-	else if (eValueType == STRING_REAL_VAL) { return u.p_data -> uc.d_data <= oValue; }
+	else if (eValueType == STRING_INT_VAL)  { return CachedInt() <= oValue; }
+	else if (eValueType == STRING_REAL_VAL) { return CachedFloat() <= oValue; }
 #if THROW_EXCEPTION_IN_COMPARATORS
 	else
 	{
@@ -2576,8 +2786,8 @@ bool CDT::operator<=(const W_FLOAT  oValue) const
 {
 	if      (eValueType == INT_VAL)         { return u.i_data <= oValue;              }
 	else if (eValueType == REAL_VAL)        { return u.d_data <= oValue;              }
-	else if (eValueType == STRING_INT_VAL)  { return u.p_data -> uc.i_data <= oValue; }
-	else if (eValueType == STRING_REAL_VAL) { return u.p_data -> uc.d_data <= oValue; }
+	else if (eValueType == STRING_INT_VAL)  { return CachedInt() <= oValue; }
+	else if (eValueType == STRING_REAL_VAL) { return CachedFloat() <= oValue; }
 #if THROW_EXCEPTION_IN_COMPARATORS
 	else
 	{
@@ -2662,7 +2872,7 @@ bool CDT::operator<=(const CDT & oCDT) const
 	else if ((eValueType      == STRING_VAL || eValueType      == STRING_REAL_VAL || eValueType      == STRING_INT_VAL) &&
 		 (oCDT.eValueType == STRING_VAL || oCDT.eValueType == STRING_REAL_VAL || oCDT.eValueType == STRING_INT_VAL))
 	{
-		return *(u.p_data -> u.s_data) <= *(oCDT.u.p_data -> u.s_data);
+		return StringCompare(oCDT) <= 0;
 	}
 	else if (eValueType == POINTER_VAL && oCDT.eValueType == POINTER_VAL)
 	{
@@ -2692,8 +2902,8 @@ bool CDT::operator>=(const INT_64  oValue)  const
 {
 	if      (eValueType == INT_VAL)         { return u.i_data >= oValue;              }
 	else if (eValueType == REAL_VAL)        { return u.d_data >= oValue;              }
-	else if (eValueType == STRING_INT_VAL)  { return u.p_data -> uc.i_data >= oValue; }
-	else if (eValueType == STRING_REAL_VAL) { return u.p_data -> uc.d_data >= oValue; }
+	else if (eValueType == STRING_INT_VAL)  { return CachedInt() >= oValue; }
+	else if (eValueType == STRING_REAL_VAL) { return CachedFloat() >= oValue; }
 #if THROW_EXCEPTION_IN_COMPARATORS
 	else
 	{
@@ -2729,8 +2939,8 @@ bool CDT::operator>=(const W_FLOAT  oValue) const
 {
 	if      (eValueType == INT_VAL)         { return u.i_data >= oValue;              }
 	else if (eValueType == REAL_VAL)        { return u.d_data >= oValue;              }
-	else if (eValueType == STRING_INT_VAL)  { return u.p_data -> uc.i_data >= oValue; }
-	else if (eValueType == STRING_REAL_VAL) { return u.p_data -> uc.d_data >= oValue; }
+	else if (eValueType == STRING_INT_VAL)  { return CachedInt() >= oValue; }
+	else if (eValueType == STRING_REAL_VAL) { return CachedFloat() >= oValue; }
 #if THROW_EXCEPTION_IN_COMPARATORS
 	else
 	{
@@ -2815,7 +3025,7 @@ bool CDT::operator>=(const CDT & oCDT) const
 	else if ((eValueType      == STRING_VAL || eValueType      == STRING_REAL_VAL || eValueType      == STRING_INT_VAL) &&
 		 (oCDT.eValueType == STRING_VAL || oCDT.eValueType == STRING_REAL_VAL || oCDT.eValueType == STRING_INT_VAL))
 	{
-		return *(u.p_data -> u.s_data) >= *(oCDT.u.p_data -> u.s_data);
+		return StringCompare(oCDT) >= 0;
 	}
 	else if (eValueType == POINTER_VAL && oCDT.eValueType == POINTER_VAL)
 	{
@@ -3366,14 +3576,14 @@ CDT & CDT::operator++()
 
 		case STRING_INT_VAL:
 			{
-				INT_64   iData1 = u.p_data -> uc.i_data;
+				INT_64   iData1 = CachedInt();
 				(*this) = CDT(++iData1);
 			}
 			break;
 
 		case STRING_REAL_VAL:
 			{
-				W_FLOAT  dData1 = u.p_data -> uc.d_data;
+				W_FLOAT  dData1 = CachedFloat();
 				(*this) = CDT(++dData1);
 			}
 			break;
@@ -3416,14 +3626,14 @@ CDT CDT::operator++(int)
 
 		case STRING_INT_VAL:
 			{
-				INT_64   iData1 = u.p_data -> uc.i_data;
+				INT_64   iData1 = CachedInt();
 			 	(*this) = CDT(++iData1);
 			}
 			break;
 
 		case STRING_REAL_VAL:
 			{
-				W_FLOAT  dData1 = u.p_data -> uc.d_data;
+				W_FLOAT  dData1 = CachedFloat();
 				(*this) = CDT(++dData1);
 			}
 			break;
@@ -3465,14 +3675,14 @@ CDT & CDT::operator--()
 
 		case STRING_INT_VAL:
 			{
-				INT_64   iData1 = u.p_data -> uc.i_data;
+				INT_64   iData1 = CachedInt();
 			 	(*this) = CDT(--iData1);
 			}
 			break;
 
 		case STRING_REAL_VAL:
 			{
-				W_FLOAT  dData1 = u.p_data -> uc.d_data;
+				W_FLOAT  dData1 = CachedFloat();
 				(*this) = CDT(--dData1);
 			}
 			break;
@@ -3514,14 +3724,14 @@ CDT CDT::operator--(int)
 
 		case STRING_INT_VAL:
 			{
-				INT_64   iData1 = u.p_data -> uc.i_data;
+				INT_64   iData1 = CachedInt();
 			 	(*this) = CDT(--iData1);
 			}
 			break;
 
 		case STRING_REAL_VAL:
 			{
-				W_FLOAT  dData1 = u.p_data -> uc.d_data;
+				W_FLOAT  dData1 = CachedFloat();
 				(*this) = CDT(--dData1);
 			}
 			break;
@@ -3553,7 +3763,7 @@ CDT & CDT::Concat(const STLW::string & oValue)
 	         eValueType == STRING_REAL_VAL)
 	{
 		Unshare();
-		u.p_data -> u.s_data -> append(oValue);
+		u.p_data -> u.s_data -> append(oValue.data(), oValue.size());
 	}
 	else { throw CDTTypeCastException("Concat"); }
 
@@ -3679,7 +3889,8 @@ CDT & CDT::Append(const CDT & oCDT)
 	         eValueType == STRING_REAL_VAL)
 	{
 		Unshare();
-		u.p_data -> u.s_data -> append(oCDT.GetString());
+		const STLW::string sTMP = oCDT.GetString();
+		u.p_data -> u.s_data -> append(sTMP.data(), sTMP.size());
 	}
 	else { throw CDTTypeCastException("Append"); }
 
@@ -3717,8 +3928,8 @@ CDT & CDT::Prepend(const STLW::string & oValue)
 	{
 		Unshare();
 		STLW::string sTMP = oValue;
-		sTMP.append(*(u.p_data -> u.s_data));
-		u.p_data -> u.s_data -> assign(sTMP);
+		sTMP.append(u.p_data -> u.s_data -> data(), u.p_data -> u.s_data -> size());
+		u.p_data -> u.s_data -> assign(sTMP.data(), sTMP.size());
 	}
 	else { throw CDTTypeCastException("Prepend"); }
 
@@ -3749,8 +3960,8 @@ CDT & CDT::Prepend(const INT_64  oValue)
 	{
 		Unshare();
 		STLW::string sTMP(szBuf, iLen);
-		sTMP.append(*(u.p_data -> u.s_data));
-		u.p_data -> u.s_data -> assign(sTMP);
+		sTMP.append(u.p_data -> u.s_data -> data(), u.p_data -> u.s_data -> size());
+		u.p_data -> u.s_data -> assign(sTMP.data(), sTMP.size());
 	}
 	else { throw CDTTypeCastException("Prepend"); }
 
@@ -3795,8 +4006,8 @@ CDT & CDT::Prepend(const W_FLOAT  oValue)
 	{
 		Unshare();
 		STLW::string sTMP(szBuf, iLen);
-		sTMP.append(*(u.p_data -> u.s_data));
-		u.p_data -> u.s_data -> assign(sTMP);
+		sTMP.append(u.p_data -> u.s_data -> data(), u.p_data -> u.s_data -> size());
+		u.p_data -> u.s_data -> assign(sTMP.data(), sTMP.size());
 	}
 	else { throw CDTTypeCastException("Prepend"); }
 
@@ -3824,8 +4035,8 @@ CDT & CDT::Prepend(const CDT & oCDT)
 	{
 		Unshare();
 		STLW::string sTMP = oCDT.GetString();
-		sTMP.append(*(u.p_data -> u.s_data));
-		u.p_data -> u.s_data -> assign(sTMP);
+		sTMP.append(u.p_data -> u.s_data -> data(), u.p_data -> u.s_data -> size());
+		u.p_data -> u.s_data -> assign(sTMP.data(), sTMP.size());
 	}
 	else { throw CDTTypeCastException("Prepend"); }
 
@@ -3855,10 +4066,10 @@ W_FLOAT CDT::GetFloat() const
 			}
 
 		case STRING_INT_VAL:
-			return W_FLOAT(u.p_data -> uc.i_data);
+			return W_FLOAT(CachedInt());
 
 		case STRING_REAL_VAL:
-			return u.p_data -> uc.d_data;
+			return CachedFloat();
 
 		case POINTER_VAL:
 			return W_FLOAT((INT_64)(u.pp_data));
@@ -3891,10 +4102,10 @@ INT_64 CDT::GetInt() const
 			}
 
 		case STRING_INT_VAL:
-			return u.p_data -> uc.i_data;
+			return CachedInt();
 
 		case STRING_REAL_VAL:
-			return INT_64(u.p_data -> uc.d_data);
+			return INT_64(CachedFloat());
 
 		case POINTER_VAL:
 			return (INT_64)(u.pp_data);
@@ -3927,10 +4138,10 @@ UINT_64 CDT::GetUInt() const
 			}
 
 		case STRING_INT_VAL:
-			return u.p_data -> uc.i_data;
+			return CachedInt();
 
 		case STRING_REAL_VAL:
-			return UINT_64(u.p_data -> uc.d_data);
+			return UINT_64(CachedFloat());
 
 		default:
 			return 0;
@@ -4024,7 +4235,7 @@ STLW::string CDT::GetString(CCHAR_P szFormat) const
 		case STRING_VAL:
 		case STRING_INT_VAL:
 		case STRING_REAL_VAL:
-			return *(u.p_data -> u.s_data);
+			return STLW::string(StringData(), StringLength());
 
 		case ARRAY_VAL:
 			{
@@ -4045,6 +4256,17 @@ STLW::string CDT::GetString(CCHAR_P szFormat) const
 	}
 }
 
+//
+// Get string value without copying
+//
+CCHAR_P CDT::GetStringData(UINT_32 & iLength) const
+{
+	if (eValueType != STRING_VAL && eValueType != STRING_INT_VAL && eValueType != STRING_REAL_VAL) { return NULL; }
+
+	iLength = StringLength();
+return StringData();
+}
+
 //
 // Get generic pointer
 //
@@ -4224,7 +4446,7 @@ UINT_32 CDT::Size() const
 		case STRING_VAL:
 		case STRING_INT_VAL:
 		case STRING_REAL_VAL:
-			return u.p_data -> u.s_data -> size();
+			return StringLength();
 
 		case ARRAY_VAL:
 			return u.p_data -> u.v_data -> size();
@@ -4239,6 +4461,51 @@ UINT_32 CDT::Size() const
 return 0;
 }
 
+//
+// Reserve space for elements of ARRAY or HASH
+//
+void CDT::Reserve(const UINT_32 iElements)
+{
+	if (eValueType == ARRAY_VAL)
+	{
+		Unshare();
+		u.p_data -> u.v_data -> reserve(iElements);
+	}
+#ifdef CDT_FLAT_HASH
+	else if (eValueType == HASH_VAL)
+	{
+		Unshare();
+		u.p_data -> u.m_data -> reserve(iElements);
+	}
+#endif
+}
+
+//
+// Check whether both objects refer to the same shareable container
+//
+bool CDT::SharesData(const CDT & oCDT) const
+{
+	if (eValueType != oCDT.eValueType) { return false; }
+
+	switch (eValueType)
+	{
+		case STRING_VAL:
+		case STRING_INT_VAL:
+		case STRING_REAL_VAL:
+			if (IsInlineString() || oCDT.IsInlineString()) { return false; }
+			return u.p_data == oCDT.u.p_data;
+
+		case ARRAY_VAL:
+		case HASH_VAL:
+			return u.p_data == oCDT.u.p_data;
+
+		default:
+			;;
+	}
+
+return false;
+}
+
 //
 // Swap values
 //
@@ -4442,11 +4709,11 @@ void CDT::MergeCDT(CDT & oDestination, const CDT & oSource, const eMergeStrategy
 					++itvArray;
 					if (itvArray == itvEnd)
 					{
-						oDestination.u.p_data -> u.m_data -> insert(STLW::pair<String, CDT>(itvKey -> GetString(), CDT()));
+						oDestination.u.p_data -> u.m_data -> insert(Map::value_type(itvKey -> GetString(), CDT()));
 						break;
 					}
 
-					oDestination.u.p_data -> u.m_data -> insert(STLW::pair<String, CDT>(itvKey -> GetString(), *itvArray));
+					oDestination.u.p_data -> u.m_data -> insert(Map::value_type(itvKey -> GetString(), *itvArray));
 
 					++itvArray;
 					if (itvArray == itvEnd) { break; }
@@ -4460,7 +4727,7 @@ void CDT::MergeCDT(CDT & oDestination, const CDT & oSource, const eMergeStrategy
 
 				while(itmHash != itmEnd)
 				{
-					oDestination.u.p_data -> u.m_data -> insert(STLW::pair<String, CDT>(itmHash -> first, itmHash -> second));
+					oDestination.u.p_data -> u.m_data -> insert(Map::value_type(itmHash -> first, itmHash -> second));
 					++itmHash;
 				}
 			}
@@ -4484,11 +4751,11 @@ void CDT::MergeCDT(CDT & oDestination, const CDT & oSource, const eMergeStrategy
 				++itvArray;
 				if (itvArray == itvEnd)
 				{
-					oDestination.u.p_data -> u.m_data -> insert(STLW::pair<String, CDT>(itvKey -> GetString(), CDT()));
+					oDestination.u.p_data -> u.m_data -> insert(Map::value_type(itvKey -> GetString(), CDT()));
 					break;
 				}
 
-				oDestination.u.p_data -> u.m_data -> insert(STLW::pair<String, CDT>(itvKey -> GetString(), *itvArray));
+				oDestination.u.p_data -> u.m_data -> insert(Map::value_type(itvKey -> GetString(), *itvArray));
 
 				++itvArray;
 				if (itvArray == itvEnd) { break; }
@@ -4502,14 +4769,14 @@ void CDT::MergeCDT(CDT & oDestination, const CDT & oSource, const eMergeStrategy
 
 			while(itmHash != itmEnd)
 			{
-				Map::iterator itmElement = oDestination.u.p_data -> u.m_data -> find(itmHash -> first);
-				if (itmElement == oDestination.u.p_data -> u.m_data -> end())
+				const CDT * pElement = FindElement(*(oDestination.u.p_data -> u.m_data), itmHash -> first);
+				if (pElement == NULL)
 				{
-					oDestination.u.p_data -> u.m_data -> insert(STLW::pair<String, CDT>(itmHash -> first, itmHash -> second));
+					oDestination.u.p_data -> u.m_data -> insert(Map::value_type(itmHash -> first, itmHash -> second));
 				}
 				else
 				{
-					MergeCDT(itmElement -> second, itmHash -> second, eStrategy);
+					MergeCDT(*const_cast<CDT *>(pElement), itmHash -> second, eStrategy);
 				}
 				++itmHash;
 			}
@@ -4559,11 +4826,15 @@ void CDT::Destroy() throw()
 		case STRING_INT_VAL:
 		case STRING_REAL_VAL:
 		case STRING_VAL:
+			if (iInlineLength == C_CDT_OWNED_STRING) { static_cast<CDTOwnedStringView *>(u.pp_data) -> owner -> Release(); }
+			if (iInlineLength != C_CDT_SHARED_STRING) { break; }
+
 			-- (u.p_data -> refcount);
 			if (u.p_data -> refcount == 0)
 			{
-				delete u.p_data -> u.s_data;
-				delete u.p_data;
+				CDTArena * pArena = u.p_data -> arena;
+				DestroyInArena(u.p_data -> u.s_data, pArena);
+				DestroyInArena(u.p_data, pArena);
 			}
 			break;
 
@@ -4571,8 +4842,12 @@ void CDT::Destroy() throw()
 			-- (u.p_data -> refcount);
 			if (u.p_data -> refcount == 0)
 			{
-				delete u.p_data -> u.v_data;
-				delete u.p_data;
+				CDTArena * pArena = u.p_data -> arena;
+				// Tree of arena is released with arena
+				if (pArena != NULL && !pArena -> IsForeign()) { break; }
+
+				DestroyInArena(u.p_data -> u.v_data, pArena);
+				DestroyInArena(u.p_data, pArena);
 			}
 			break;
 
@@ -4580,8 +4855,12 @@ void CDT::Destroy() throw()
 			-- (u.p_data -> refcount);
 			if (u.p_data -> refcount == 0)
 			{
-				delete u.p_data -> u.m_data;
-				delete u.p_data;
+				CDTArena * pArena = u.p_data -> arena;
+				// Tree of arena is released with arena
+				if (pArena != NULL && !pArena -> IsForeign()) { break; }
+
+				DestroyInArena(u.p_data -> u.m_data, pArena);
+				DestroyInArena(u.p_data, pArena);
 			}
 			break;
 
@@ -4596,27 +4875,193 @@ void CDT::Destroy() throw()
 //
 void CDT::Unshare()
 {
-	if (u.p_data -> refcount != 1)
+	// Inline string or view of immutable string is moved to shareable container before modification
+	if (IsInlineString())
 	{
 		_CDT * pTMP = new _CDT();
+		pTMP -> u.s_data = new String(StringData(), StringLength());
 
-		if      (eValueType == STRING_VAL)     { pTMP -> u.s_data = new String(*(u.p_data -> u.s_data)); }
-		else if (eValueType == STRING_INT_VAL)
+		if (eValueType == STRING_INT_VAL)
 		{
-			pTMP -> u.s_data = new String(*(u.p_data -> u.s_data));
-			pTMP -> uc.i_data = u.p_data -> uc.i_data;
+			pTMP -> value_type = INT_VAL;
+			pTMP -> uc.i_data  = CachedInt();
 		}
 		else if (eValueType == STRING_REAL_VAL)
 		{
-			pTMP -> u.s_data = new String(*(u.p_data -> u.s_data));
-			pTMP -> uc.d_data = u.p_data -> uc.d_data;
+			pTMP -> value_type = REAL_VAL;
+			pTMP -> uc.d_data  = CachedFloat();
 		}
-		else if (eValueType == ARRAY_VAL)  { pTMP -> u.v_data = new Vector(*(u.p_data -> u.v_data)); }
-		else if (eValueType == HASH_VAL)   { pTMP -> u.m_data = new Map(*(u.p_data -> u.m_data));    }
+
+		// String is copied, owner of view is not needed anymore
+		if (iInlineLength == C_CDT_OWNED_STRING) { static_cast<CDTOwnedStringView *>(u.pp_data) -> owner -> Release(); }
+
+		u.p_data      = pTMP;
+		iInlineLength = C_CDT_SHARED_STRING;
+		return;
+	}
+
+	if (u.p_data -> refcount != 1)
+	{
+		// Copy is placed into heap, so it can outlive arena of original
+		_CDT * pTMP = CopyToHeap();
 
 		-- u.p_data -> refcount;
 		u.p_data = pTMP;
 	}
+
+	// Values of other memory can be stored into container
+	if (eValueType >= ARRAY_VAL) { TouchArena(); }
+}
+
+//
+// Copy shareable container into heap
+//
+CDT::_CDT * CDT::CopyToHeap() const
+{
+	const _CDT * pOrig = u.p_data;
+
+	// Copy is destroyed if moving of its values fails
+	CDT oCopy;
+	oCopy.u.p_data      = new _CDT();
+	oCopy.eValueType    = eValueType;
+	oCopy.iInlineLength = C_CDT_SHARED_STRING;
+
+	_CDT * pTMP = oCopy.u.p_data;
+	if (eValueType == ARRAY_VAL)
+	{
+		pTMP -> u.v_data = new Vector(pOrig -> u.v_data -> begin(), pOrig -> u.v_data -> end());
+		if (pOrig -> arena != NULL)
+		{
+			Vector::iterator itvElement = pTMP -> u.v_data -> begin();
+			for (; itvElement != pTMP -> u.v_data -> end(); ++itvElement) { itvElement -> LeaveArena(); }
+		}
+	}
+	else if (eValueType == HASH_VAL)
+	{
+		if (pOrig -> arena == NULL) { pTMP -> u.m_data = new Map(*(pOrig -> u.m_data)); }
+		else
+		{
+			pTMP -> u.m_data = new Map(pOrig -> u.m_data -> begin(), pOrig -> u.m_data -> end(), STLW::less<STLW::string>(), Map::allocator_type());
+
+			Map::iterator itmElement = pTMP -> u.m_data -> begin();
+			for (; itmElement != pTMP -> u.m_data -> end(); ++itmElement) { itmElement -> second.LeaveArena(); }
+		}
+	}
+	else
+	{
+		pTMP -> u.s_data = new String(pOrig -> u.s_data -> data(), pOrig -> u.s_data -> size());
+
+		if      (eValueType == STRING_INT_VAL)  { pTMP -> uc.i_data = pOrig -> uc.i_data; }
+		else if (eValueType == STRING_REAL_VAL) { pTMP -> uc.d_data = pOrig -> uc.d_data; }
+	}
+
+	// Copy is passed to caller
+	oCopy.eValueType = UNDEF;
+
+return pTMP;
+}
+
+//
+// Move shareable container in arena to heap
+//
+void CDT::LeaveArena()
+{
+	if (eValueType < STRING_VAL || IsInlineString() || u.p_data -> arena == NULL) { return; }
+
+	_CDT * pTMP = CopyToHeap();
+	Destroy();
+	u.p_data = pTMP;
+}
+
+//
+// Mark arena of container as foreign
+//
+void CDT::TouchArena() const
+{
+	CDTArena * pArena = u.p_data -> arena;
+	if (pArena != NULL && !pArena -> IsBuilding()) { pArena -> MarkForeign(); }
+}
+
+//
+// Parse string as number
+//
+static CDT::eValType ParseNumber(CCHAR_P        szData,
+                                 const UINT_32  iLength,
+                                 INT_64       & iData,
+                                 W_FLOAT      & dData)
+{
+	// Check integer only
+	CCHAR_P       itStart = szData;
+	const CCHAR_P itEnd   = szData + iLength;
+	if (itStart == itEnd) { return CDT::INT_VAL; }
+
+	// [-+]?[0-9]
+
+	// Check sign
+	if (*itStart == '-' || *itStart == '+') { ++itStart; }
+
+	// Check numbers
+	while (itStart != itEnd)
+	{
+		if (!(*itStart >= '0' && *itStart <= '9')) { break; }
+		++itStart;
+	}
+
+	// Okay, it's integer
+	if (itStart == itEnd)
+	{
+		iData = strtoll(szData, NULL, 10);
+		return CDT::INT_VAL;
+	}
+
+	// [-+]?[0-9]*\.?[0-9]+([eE][-+]?[0-9]+)?
+
+	// Check IEEE 754
+	if (*itStart == '.')
+	{
+		++itStart;
+		if (itStart == itEnd) { return CDT::REAL_VAL; }
+
+		while (itStart != itEnd)
+		{
+			if (!(*itStart >= '0' && *itStart <= '9')) { break; }
+			++itStart;
+		}
+	}
+	// Okay, it's real without exponent
+	if (itStart == itEnd)
+	{
+		dData = strtod(szData, NULL);
+		return CDT::REAL_VAL;
+	}
+
+	// Check exponent
+	if (*itStart != 'e' && *itStart != 'E') { return CDT::REAL_VAL; }
+	++itStart;
+
+	// Check exponent sign
+	if (itStart == itEnd) { return CDT::REAL_VAL; }
+
+	if (*itStart == '-' || *itStart == '+')
+	{
+		++itStart;
+		if (itStart == itEnd) { return CDT::REAL_VAL; }
+	}
+
+	while (itStart != itEnd)
+	{
+		if (!(*itStart >= '0' && *itStart <= '9')) { break; }
+		++itStart;
+	}
+
+	// Okay, it's real with exponent
+	if (itStart == itEnd)
+	{
+		dData = strtod(szData, NULL);
+		return CDT::REAL_VAL;
+	}
+
+return CDT::UNDEF;
 }
 
 //
@@ -4645,128 +5090,20 @@ CDT::eValType CDT::CastToNumber(INT_64 & iData, W_FLOAT & dData) const
 				CheckComplexDataType();
 				if (eValueType != STRING_VAL) { return CastToNumber(iData, dData); }
 
-				// Check integer only
-				String::const_iterator        itStart = u.p_data -> u.s_data -> begin();
-				const String::const_iterator  itEnd   = u.p_data -> u.s_data -> end();
-				if (itStart == itEnd)
-				{
-					u.p_data -> uc.i_data = iData;
-					eValueType = STRING_INT_VAL;
-					u.p_data -> value_type = INT_VAL;
-					return INT_VAL;
-				}
-
-				// [-+]?[0-9]
-
-				// Check sign
-				if (*itStart == '-' || *itStart == '+') { ++itStart; }
-
-				// Check numbers
-				while (itStart != itEnd)
-				{
-					if (!(*itStart >= '0' && *itStart <= '9')) { break; }
-					++itStart;
-				}
+				const eValType eType = ParseString(iData, dData);
+				// Not a number, do not cache it
+				if (eType == UNDEF) { return REAL_VAL; }
 
-				// Okay, it's integer
-				if (itStart == itEnd)
-				{
-					iData = strtoll(u.p_data -> u.s_data -> data(), NULL, 10);
-
-					u.p_data -> uc.i_data = iData;
-					eValueType = STRING_INT_VAL;
-					u.p_data -> value_type = INT_VAL;
-					return INT_VAL;
-				}
-
-				// [-+]?[0-9]*\.?[0-9]+([eE][-+]?[0-9]+)?
-
-				// Check IEEE 754
-				if (*itStart == '.')
-				{
-					++itStart;
-					if (itStart == itEnd)
-					{
-						u.p_data -> uc.d_data = dData;
-						eValueType = STRING_REAL_VAL;
-						u.p_data -> value_type = REAL_VAL;
-						return REAL_VAL;
-					}
-
-					while (itStart != itEnd)
-					{
-						if (!(*itStart >= '0' && *itStart <= '9')) { break; }
-						++itStart;
-					}
-				}
-				// Okay, it's real without exponent
-				if (itStart == itEnd)
-				{
-					dData = strtod(u.p_data -> u.s_data -> data(), NULL);
-
-					u.p_data -> uc.d_data = dData;
-					eValueType = STRING_REAL_VAL;
-					u.p_data -> value_type = REAL_VAL;
-					return REAL_VAL;
-				}
-
-				// Check exponent
-				if (*itStart != 'e' && *itStart != 'E')
-				{
-					u.p_data -> uc.d_data = dData;
-					eValueType = STRING_REAL_VAL;
-					u.p_data -> value_type = REAL_VAL;
-					return REAL_VAL;
-				}
-				++itStart;
-
-				// Check exponent sign
-				if (itStart == itEnd)
-				{
-					u.p_data -> uc.d_data = dData;
-					eValueType = STRING_REAL_VAL;
-					u.p_data -> value_type = REAL_VAL;
-					return REAL_VAL;
-				}
-
-				if (*itStart == '-' || *itStart == '+')
-				{
-					++itStart;
-					if (itStart == itEnd)
-					{
-						u.p_data -> uc.d_data = dData;
-						eValueType = STRING_REAL_VAL;
-						u.p_data -> value_type = REAL_VAL;
-						return REAL_VAL;
-					}
-				}
-
-				while (itStart != itEnd)
-				{
-					if (!(*itStart >= '0' && *itStart <= '9')) { break; }
-					++itStart;
-				}
-
-				// Okay, it's real with exponent
-				if (itStart == itEnd)
-				{
-					dData = strtod(u.p_data -> u.s_data -> data(), NULL);
-
-					u.p_data -> uc.d_data = dData;
-					eValueType = STRING_REAL_VAL;
-					u.p_data -> value_type = REAL_VAL;
-					return REAL_VAL;
-				}
-
-			return REAL_VAL;
+				CacheNumber(eType, iData, dData);
+			return eType;
 			}
 
 		case STRING_INT_VAL:
-			iData = u.p_data -> uc.i_data;
+			iData = CachedInt();
 			return INT_VAL;
 
 		case STRING_REAL_VAL:
-			dData = u.p_data -> uc.d_data;
+			dData = CachedFloat();
 			return REAL_VAL;
 
 		case ARRAY_VAL:
@@ -4788,15 +5125,337 @@ CDT::eValType CDT::CastToNumber(INT_64 & iData, W_FLOAT & dData) const
 return INT_VAL;
 }
 
+//
+// Format integer, digits are written backwards; returns pointer to first character
+//
+static CHAR_P FormatInt(const INT_64   iValue,
+                        CHAR_P         szEnd)
+{
+	static const CHAR_8 szDigitPairs[] = "00010203040506070809"
+	                                     "10111213141516171819"
+	                                     "20212223242526272829"
+	                                     "30313233343536373839"
+	                                     "40414243444546474849"
+	                                     "50515253545556575859"
+	                                     "60616263646566676869"
+	                                     "70717273747576777879"
+	                                     "80818283848586878889"
+	                                     "90919293949596979899";
+
+	UINT_64 iTMP = (iValue < 0) ? 0 - UINT_64(iValue) : UINT_64(iValue);
+	while (iTMP >= 100)
+	{
+		const UINT_32 iPos = UINT_32(iTMP % 100) * 2;
+		iTMP /= 100;
+		*--szEnd = szDigitPairs[iPos + 1];
+		*--szEnd = szDigitPairs[iPos];
+	}
+
+	if (iTMP >= 10)
+	{
+		const UINT_32 iPos = UINT_32(iTMP) * 2;
+		*--szEnd = szDigitPairs[iPos + 1];
+		*--szEnd = szDigitPairs[iPos];
+	}
+	else
+	{
+		*--szEnd = CHAR_8('0' + iTMP);
+	}
+
+	if (iValue < 0) { *--szEnd = '-'; }
+
+return szEnd;
+}
+
+//
+// Format floating point value as "%.*G" with CTPP_FLOAT_PRECISION digits; returns length of result
+//
+static UINT_32 FormatFloat(const W_FLOAT   dValue,
+                           CHAR_P          szBuffer)
+{
+	// NAN and INF are rare, leave them to printf
+	if (dValue != dValue || dValue - dValue != 0)
+	{
+		return UINT_32(snprintf(szBuffer, C_MAX_SPRINTF_LENGTH, "%.*G", CTPP_FLOAT_PRECISION, dValue));
+	}
+
+	Bigint * aFreeList[Kmax + 1];
+	for (UINT_32 iPos = 0; iPos <= Kmax; ++iPos) { aFreeList[iPos] = NULL; }
+
+	AllocatedBlock * aBlocks = NULL;
+	INT_32 iDecPoint = 0;
+	INT_32 iSign     = 0;
+	CHAR_P szEnd     = NULL;
+
+	// Shortest representation with at most CTPP_FLOAT_PRECISION significant digits
+	CCHAR_P szDigits = ctpp_dtoa(&aBlocks, aFreeList, dValue, 2, CTPP_FLOAT_PRECISION, &iDecPoint, &iSign, &szEnd);
+	INT_32 iDigits         = INT_32(szEnd - szDigits);
+	const INT_32 iExponent = iDecPoint - 1;
+
+	// Rounding to CTPP_FLOAT_PRECISION digits may leave trailing zeros, %G drops them
+	while (iDigits > 1 && szDigits[iDigits - 1] == '0') { --iDigits; }
+
+	CHAR_P szPos = szBuffer;
+	if (iSign != 0) { *szPos++ = '-'; }
+
+	// Scientific notation, d.dddE+dd
+	if (iExponent < -4 || iExponent >= CTPP_FLOAT_PRECISION)
+	{
+		*szPos++ = szDigits[0];
+		if (iDigits > 1)
+		{
+			*szPos++ = '.';
+			memcpy(szPos, szDigits + 1, iDigits - 1);
+			szPos += iDigits - 1;
+		}
+		*szPos++ = 'E';
+		*szPos++ = (iExponent < 0) ? '-' : '+';
+
+		// At least 2 digits in exponent
+		const INT_32 iAbsExponent = (iExponent < 0) ? -iExponent : iExponent;
+		if (iAbsExponent < 10) { *szPos++ = '0'; }
+
+		CHAR_8 szExponent[C_MAX_SPRINTF_LENGTH];
+		CHAR_P szExponentEnd   = szExponent + C_MAX_SPRINTF_LENGTH;
+		CHAR_P szExponentStart = FormatInt(iAbsExponent, szExponentEnd);
+		memcpy(szPos, szExponentStart, szExponentEnd - szExponentStart);
+		szPos += szExponentEnd - szExponentStart;
+	}
+	// 0.000ddd
+	else if (iDecPoint <= 0)
+	{
+		*szPos++ = '0';
+		*szPos++ = '.';
+		memset(szPos, '0', -iDecPoint);
+		szPos += -iDecPoint;
+		memcpy(szPos, szDigits, iDigits);
+		szPos += iDigits;
+	}
+	// ddd000
+	else if (iDecPoint >= iDigits)
+	{
+		memcpy(szPos, szDigits, iDigits);
+		szPos += iDigits;
+		memset(szPos, '0', iDecPoint - iDigits);
+		szPos += iDecPoint - iDigits;
+	}
+	// ddd.ddd
+	else
+	{
+		memcpy(szPos, szDigits, iDecPoint);
+		szPos += iDecPoint;
+		*szPos++ = '.';
+		memcpy(szPos, szDigits + iDecPoint, iDigits - iDecPoint);
+		szPos += iDigits - iDecPoint;
+	}
+
+	freedtoa(&aBlocks);
+
+return UINT_32(szPos - szBuffer);
+}
+
+//
+// Write value to output collector
+//
+INT_32 CDT::WriteTo(OutputCollector  & oCollector) const
+{
+	switch (eValueType)
+	{
+		case UNDEF:
+			return 0;
+
+		case INT_VAL:
+			{
+				CHAR_8 szBuf[C_MAX_SPRINTF_LENGTH];
+				CHAR_P szEnd   = szBuf + C_MAX_SPRINTF_LENGTH;
+				CHAR_P szStart = FormatInt(u.i_data, szEnd);
+				return oCollector.Collect(szStart, UINT_32(szEnd - szStart));
+			}
+
+		case REAL_VAL:
+			{
+				CHAR_8 szBuf[C_MAX_SPRINTF_LENGTH + 1];
+				return oCollector.Collect(szBuf, FormatFloat(u.d_data, szBuf));
+			}
+
+		case STRING_VAL:
+		case STRING_INT_VAL:
+		case STRING_REAL_VAL:
+			return oCollector.Collect(StringData(), StringLength());
+
+		default:
+			;;
+	}
+
+	// Pointers, arrays and hashes are printed rarely
+	const STLW::string sTMP = GetString();
+return oCollector.Collect(sTMP.data(), UINT_32(sTMP.size()));
+}
+
 //
 // Check complex data type and change value type, if need
 //
 void CDT::CheckComplexDataType() const
 {
+	// Inline string is not shared, value type is always actual
+	if (IsInlineString()) { return; }
+
 	if      (u.p_data -> value_type == INT_VAL)  { eValueType = STRING_INT_VAL;  }
 	else if (u.p_data -> value_type == REAL_VAL) { eValueType = STRING_REAL_VAL; }
 }
 
+//
+// Check whether value is a string stored inline
+//
+bool CDT::IsInlineString() const { return (eValueType & STRING_VAL) != 0 && iInlineLength != C_CDT_SHARED_STRING; }
+
+//
+// Set string value, short strings are stored inline
+//
+void CDT::InitString(CCHAR_P        szData,
+                     const UINT_32  iLength,
+                     CDTArena     * pArena)
+{
+	if (iLength <= C_CDT_INLINE_LENGTH)
+	{
+		memcpy(u.s_inline, szData, iLength);
+		iInlineLength = UCHAR_8(iLength);
+	}
+	else
+	{
+		_CDT * pTMP = new (pArena) _CDT(pArena);
+		pTMP -> u.s_data = new (pArena) String(szData, iLength, String::allocator_type(pArena));
+
+		u.p_data      = pTMP;
+		iInlineLength = C_CDT_SHARED_STRING;
+	}
+
+	eValueType = STRING_VAL;
+}
+
+//
+// Get pointer to string data
+//
+CCHAR_P CDT::StringData() const
+{
+	if (iInlineLength == C_CDT_STATIC_STRING || iInlineLength == C_CDT_OWNED_STRING) { return static_cast<const CDTStringView *>(u.pp_data) -> data; }
+	if (iInlineLength != C_CDT_SHARED_STRING) { return u.s_inline; }
+
+return u.p_data -> u.s_data -> data();
+}
+
+//
+// Get string length
+//
+UINT_32 CDT::StringLength() const
+{
+	if (iInlineLength == C_CDT_STATIC_STRING || iInlineLength == C_CDT_OWNED_STRING) { return static_cast<const CDTStringView *>(u.pp_data) -> length; }
+	if (iInlineLength != C_CDT_SHARED_STRING) { return iInlineLength; }
+
+return UINT_32(u.p_data -> u.s_data -> size());
+}
+
+//
+// Compare string values
+//
+INT_32 CDT::StringCompare(const CDT & oCDT) const
+{
+	const UINT_32 iLength    = StringLength();
+	const UINT_32 iRHSLength = oCDT.StringLength();
+
+	const INT_32 iResult = memcmp(StringData(), oCDT.StringData(), iLength < iRHSLength ? iLength : iRHSLength);
+	if (iResult != 0) { return iResult; }
+
+	if (iLength < iRHSLength) { return -1; }
+
+return iLength == iRHSLength ? 0 : 1;
+}
+
+//
+// Parse string value as number
+//
+CDT::eValType CDT::ParseString(INT_64   & iData,
+                               W_FLOAT  & dData) const
+{
+	iData = 0;
+	dData = 0.0;
+
+	if (iInlineLength == C_CDT_SHARED_STRING) { return ParseNumber(u.p_data -> u.s_data -> data(), UINT_32(u.p_data -> u.s_data -> size()), iData, dData); }
+
+	// Static string is zero-terminated
+	if (iInlineLength == C_CDT_STATIC_STRING) { return ParseNumber(StringData(), StringLength(), iData, dData); }
+
+	// Owned view refers to the middle of file data, so strtoll and strtod get a zero-terminated copy
+	if (iInlineLength == C_CDT_OWNED_STRING)
+	{
+		const UINT_32 iLength = StringLength();
+		if (iLength >= C_CDT_NUMBER_BUFFER_LENGTH)
+		{
+			const STLW::string sTMP(StringData(), iLength);
+			return ParseNumber(sTMP.c_str(), iLength, iData, dData);
+		}
+
+		CHAR_8 szNumber[C_CDT_NUMBER_BUFFER_LENGTH];
+		memcpy(szNumber, StringData(), iLength);
+		szNumber[iLength] = '\0';
+
+		return ParseNumber(szNumber, iLength, iData, dData);
+	}
+
+	// strtoll and strtod need zero-terminated string
+	CHAR_8 szBuffer[C_CDT_INLINE_LENGTH + 1];
+	memcpy(szBuffer, u.s_inline, iInlineLength);
+	szBuffer[iInlineLength] = '\0';
+
+return ParseNumber(szBuffer, iInlineLength, iData, dData);
+}
+
+//
+// Store numeric value of string
+//
+void CDT::CacheNumber(const eValType  eType,
+                      const INT_64    iData,
+                      const W_FLOAT   dData) const
+{
+	eValueType = (eType == INT_VAL) ? STRING_INT_VAL : STRING_REAL_VAL;
+
+	// Inline string has no room for number, it is parsed on access
+	if (iInlineLength != C_CDT_SHARED_STRING) { return; }
+
+	if (eType == INT_VAL) { u.p_data -> uc.i_data = iData; }
+	else                  { u.p_data -> uc.d_data = dData; }
+
+	u.p_data -> value_type = eType;
+}
+
+//
+// Get cached integer value of STRING_INT_VAL
+//
+INT_64 CDT::CachedInt() const
+{
+	if (iInlineLength == C_CDT_SHARED_STRING) { return u.p_data -> uc.i_data; }
+
+	INT_64  iData = 0;
+	W_FLOAT dData = 0.0;
+	ParseString(iData, dData);
+
+return iData;
+}
+
+//
+// Get cached floating point value of STRING_REAL_VAL
+//
+W_FLOAT CDT::CachedFloat() const
+{
+	if (iInlineLength == C_CDT_SHARED_STRING) { return u.p_data -> uc.d_data; }
+
+	INT_64  iData = 0;
+	W_FLOAT dData = 0.0;
+	ParseString(iData, dData);
+
+return dData;
+}
+
 // ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // Standalone operators
@@ -0,0 +1,165 @@
+/*-
+ * Copyright (c) 2004 - 2011 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CDTArena.cpp
+ *
+ * $CTPP$
+ */
+#include "CDTArena.hpp"
+
+namespace CTPP // C++ Template Engine
+{
+
+//
+// Constructor
+//
+CDTArena::CDTArena(const UINT_32  iIChunkSize): pChunks(NULL),
+                                                pPos(NULL),
+                                                iFree(0),
+                                                iChunkSize(iIChunkSize),
+                                                iUsed(0),
+                                                iReserved(0),
+                                                pFinalizers(NULL),
+                                                iBuilders(0),
+                                                bForeign(false)
+{
+	;;
+}
+
+//
+// Register function called by Release()
+//
+void CDTArena::AtRelease(void  (* fnCallback)(void *),
+                         void   * vObject)
+{
+	Finalizer * pFinalizer = static_cast<Finalizer *>(Allocate(sizeof(Finalizer)));
+
+	pFinalizer -> prev     = pFinalizers;
+	pFinalizer -> callback = fnCallback;
+	pFinalizer -> object   = vObject;
+	pFinalizers = pFinalizer;
+}
+
+//
+// Release all memory
+//
+void CDTArena::Release() throw()
+{
+	// Finalizers are stored in chunks, so they are called first
+	while (pFinalizers != NULL)
+	{
+		pFinalizers -> callback(pFinalizers -> object);
+		pFinalizers = pFinalizers -> prev;
+	}
+
+	while (pChunks != NULL)
+	{
+		Chunk * pPrev = pChunks -> prev;
+		::operator delete(pChunks);
+		pChunks = pPrev;
+	}
+
+	// Size of next chunk is kept, so arena reused for similar data needs less chunks
+	pPos      = NULL;
+	iFree     = 0;
+	iUsed     = 0;
+	iReserved = 0;
+	bForeign  = false;
+}
+
+//
+// Get number of allocated bytes
+//
+UINT_64 CDTArena::GetUsed() const { return iUsed; }
+
+//
+// Get number of bytes taken from system
+//
+UINT_64 CDTArena::GetReserved() const { return iReserved; }
+
+//
+// A destructor
+//
+CDTArena::~CDTArena() throw() { Release(); }
+
+//
+// Allocate new chunk and memory block in it
+//
+void * CDTArena::AllocateChunk(const size_t  iSize)
+{
+	// Large block is placed into separate chunk, free space of current chunk is still used
+	const bool   bSeparate = iSize > iChunkSize / 4;
+	const size_t iDataSize = bSeparate ? iSize : iChunkSize;
+
+	Chunk * pChunk = static_cast<Chunk *>(::operator new(sizeof(Chunk) + iDataSize));
+	CHAR_8 * pData = reinterpret_cast<CHAR_8 *>(pChunk + 1);
+
+	iReserved += sizeof(Chunk) + iDataSize;
+	iUsed     += iSize;
+
+	if (bSeparate && pChunks != NULL)
+	{
+		pChunk -> prev  = pChunks -> prev;
+		pChunks -> prev = pChunk;
+		return pData;
+	}
+
+	pChunk -> prev = pChunks;
+	pChunks = pChunk;
+	if (bSeparate) { return pData; }
+
+	pPos  = pData + iSize;
+	iFree = iDataSize - iSize;
+
+	if (iChunkSize < C_CDT_ARENA_MAX_CHUNK_SIZE) { iChunkSize <<= 1; }
+
+return pData;
+}
+
+// ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Class CDTArena::Builder
+//
+
+//
+// Constructor
+//
+CDTArena::Builder::Builder(CDTArena  * pIArena): pArena(pIArena)
+{
+	if (pArena != NULL) { ++(pArena -> iBuilders); }
+}
+
+//
+// A destructor
+//
+CDTArena::Builder::~Builder() throw()
+{
+	if (pArena != NULL) { --(pArena -> iBuilders); }
+}
+
+} // namespace CTPP
+// End.
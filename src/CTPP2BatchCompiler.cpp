@@ -0,0 +1,836 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2BatchCompiler.cpp
+ *
+ * $CTPP$
+ */
+#include "CTPP2BatchCompiler.hpp"
+
+#include "CTPP2Compiler.hpp"
+#include "CTPP2Exception.hpp"
+#include "CTPP2HashTable.hpp"
+#include "CTPP2Parser.hpp"
+#include "CTPP2ParserException.hpp"
+#include "CTPP2SourceLoader.hpp"
+#include "CTPP2StaticData.hpp"
+#include "CTPP2StaticText.hpp"
+#include "CTPP2Util.hpp"
+#include "CTPP2VMDumper.hpp"
+#include "CTPP2VMOpcodeCollector.hpp"
+#include "CTPP2VMOptimizer.hpp"
+
+#include "STLMap.hpp"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace CTPP // C++ Template Engine
+{
+
+//
+// Extension of compiled templates
+//
+static const STLW::string sCompiledExtension(".ct2");
+
+//
+// First line of dependency manifest
+//
+static const STLW::string sManifestHeader("# CTPP2 dependencies v2");
+
+//
+// Lock mutex until end of scope
+//
+class MutexLock
+{
+public:
+	/**
+	  @brief Constructor
+	  @param pIMutex - mutex to lock
+	*/
+	MutexLock(pthread_mutex_t * pIMutex): pMutex(pIMutex) { pthread_mutex_lock(pMutex); }
+
+	/**
+	  @brief A destructor
+	*/
+	~MutexLock() throw() { pthread_mutex_unlock(pMutex); }
+private:
+	/** Locked mutex */
+	pthread_mutex_t  * pMutex;
+};
+
+//
+// Read line without trailing newline
+//
+static bool ReadLine(FILE * F, STLW::string & sLine)
+{
+	sLine.erase();
+
+	CHAR_8 szBuffer[1024];
+	while (fgets(szBuffer, sizeof(szBuffer), F) != NULL)
+	{
+		sLine.append(szBuffer);
+		if (sLine[sLine.size() - 1] == '\n')
+		{
+			sLine.erase(sLine.size() - 1);
+			return true;
+		}
+	}
+
+return !sLine.empty();
+}
+
+//
+// Get directory part of file name, with trailing slash
+//
+static STLW::string GetDirName(const STLW::string & sFileName)
+{
+	const STLW::string::size_type iPos = sFileName.rfind('/');
+	if (iPos == STLW::string::npos) { return ""; }
+
+return sFileName.substr(0, iPos + 1);
+}
+
+//
+// Join directory and file name; absolute file names are not changed
+//
+static STLW::string JoinPath(const STLW::string  & sDir,
+                             const STLW::string  & sFileName)
+{
+	if (sDir.empty() || (!sFileName.empty() && sFileName[0] == '/')) { return sFileName; }
+
+	STLW::string sResult(sDir);
+	if (sResult[sResult.size() - 1] != '/') { sResult.append("/", 1); }
+	sResult.append(sFileName);
+
+return sResult;
+}
+
+//
+// Replace extension of file name with extension of compiled templates
+//
+static STLW::string GetCompiledName(const STLW::string & sFileName)
+{
+	const STLW::string::size_type iDot   = sFileName.rfind('.');
+	const STLW::string::size_type iSlash = sFileName.rfind('/');
+
+	if (iDot == STLW::string::npos || (iSlash != STLW::string::npos && iDot < iSlash)) { return sFileName + sCompiledExtension; }
+
+return sFileName.substr(0, iDot) + sCompiledExtension;
+}
+
+//
+// Create all directories of file name
+//
+static void MakeDirs(const STLW::string & sFileName)
+{
+	STLW::string::size_type iPos = 0;
+	while ((iPos = sFileName.find('/', iPos + 1)) != STLW::string::npos)
+	{
+		const STLW::string sDir(sFileName, 0, iPos);
+		if (mkdir(sDir.c_str(), 0755) == -1 && errno != EEXIST) { throw CTPPUnixException("mkdir", errno); }
+	}
+}
+
+
+/**
+  @struct BatchCompiler::SourceCache CTPP2BatchCompiler.cpp
+  @brief Sources of templates shared between threads; loaded sources are immutable
+*/
+struct BatchCompiler::SourceCache
+{
+	/**
+	  @struct Source CTPP2BatchCompiler.cpp
+	  @brief Loaded file
+	*/
+	struct Source
+	{
+		/** File name         */
+		STLW::string   name;
+		/** Content of file   */
+		STLW::string   data;
+		/** State of file     */
+		struct stat    file_stat;
+		/** Hash of content   */
+		UINT_64        hash;
+		/** Time of loading   */
+		time_t         load_time;
+	};
+
+	/** Lock of sources list */
+	pthread_mutex_t                      mutex;
+	/** Sources by file name */
+	STLW::map<STLW::string, Source *>    sources;
+
+	/**
+	  @brief Constructor
+	*/
+	SourceCache();
+
+	/**
+	  @brief Get source, load it if need
+	  @param sFileName - file name
+	  @return source or NULL if file does not exist
+	*/
+	const Source * Get(const STLW::string & sFileName);
+
+	/**
+	  @brief A destructor
+	*/
+	~SourceCache() throw();
+};
+
+//
+// Constructor
+//
+BatchCompiler::SourceCache::SourceCache() { pthread_mutex_init(&mutex, NULL); }
+
+//
+// Get source, load it if need
+//
+const BatchCompiler::SourceCache::Source * BatchCompiler::SourceCache::Get(const STLW::string & sFileName)
+{
+	{
+		MutexLock oLock(&mutex);
+		STLW::map<STLW::string, Source *>::const_iterator itmSources = sources.find(sFileName);
+		if (itmSources != sources.end()) { return itmSources -> second; }
+	}
+
+	// File may be changed later in the same second, see IsUpToDate
+	const time_t iLoadTime = time(NULL);
+
+	// File is loaded without lock; if other thread loaded it at the same time, its copy is used
+	FILE * F = fopen(sFileName.c_str(), "rb");
+	if (F == NULL)
+	{
+		if (errno == ENOENT) { return NULL; }
+		throw CTPPUnixException("fopen", errno);
+	}
+
+	Source * pSource = new Source;
+	pSource -> name.assign(sFileName);
+	pSource -> load_time = iLoadTime;
+	if (fstat(fileno(F), &(pSource -> file_stat)) == -1)
+	{
+		const INT_32 iErrNo = errno;
+		fclose(F);
+		delete pSource;
+		throw CTPPUnixException("fstat", iErrNo);
+	}
+
+	pSource -> data.resize(pSource -> file_stat.st_size);
+	if (!pSource -> data.empty() && fread(&(pSource -> data[0]), pSource -> data.size(), 1, F) != 1)
+	{
+		fclose(F);
+		delete pSource;
+		throw CTPPLogicError("Cannot read from file");
+	}
+	fclose(F);
+
+	pSource -> hash = HashFunc(pSource -> data.data(), pSource -> data.size());
+
+	MutexLock oLock(&mutex);
+	STLW::pair<STLW::map<STLW::string, Source *>::iterator, bool> oInserted = sources.insert(STLW::pair<const STLW::string, Source *>(sFileName, pSource));
+	if (!oInserted.second) { delete pSource; }
+
+return oInserted.first -> second;
+}
+
+//
+// A destructor
+//
+BatchCompiler::SourceCache::~SourceCache() throw()
+{
+	STLW::map<STLW::string, Source *>::iterator itmSources = sources.begin();
+	while (itmSources != sources.end())
+	{
+		delete itmSources -> second;
+		++itmSources;
+	}
+
+	pthread_mutex_destroy(&mutex);
+}
+
+/**
+  @class BatchCompiler::BatchSourceLoader CTPP2BatchCompiler.cpp
+  @brief Loader of templates from shared cache; records all loaded files
+*/
+class BatchCompiler::BatchSourceLoader:
+  public CTPP2SourceLoader
+{
+public:
+	/** List of loaded files */
+	typedef STLW::vector<const SourceCache::Source *> DependencyList;
+
+	/**
+	  @brief Constructor
+	  @param pISourceCache - shared sources
+	  @param pIDependencies - list of loaded files
+	*/
+	BatchSourceLoader(SourceCache     * pISourceCache,
+	                  DependencyList  * pIDependencies);
+
+	/**
+	  @brief Load template with specified name
+	  @param szTemplateName - template name
+	  @return 0 if success, -1 if any error occured
+	*/
+	INT_32 LoadTemplate(CCHAR_P szTemplateName);
+
+	/**
+	  @brief Get template
+	  @param iTemplateSize - template size [out]
+	  @return pointer to start of template buffer if success, NULL - if any error occured
+	*/
+	CCHAR_P GetTemplate(UINT_32 & iTemplateSize);
+
+	/**
+	  @brief Clone loader object
+	  @return clone to self
+	*/
+	CTPP2SourceLoader * Clone();
+
+	/**
+	  @brief Get unique name of loaded template
+	  @return asciz template name
+	*/
+	CCHAR_P GetTemplateName() const;
+
+	/**
+	  @brief A destructor
+	*/
+	~BatchSourceLoader() throw();
+private:
+	/** Shared sources                 */
+	SourceCache                   * pSourceCache;
+	/** List of loaded files           */
+	DependencyList                * pDependencies;
+	/** Include directories            */
+	STLW::vector<STLW::string>      vIncludeDirs;
+	/** Directory of loaded template   */
+	STLW::string                    sCurrentDir;
+	/** Loaded template                */
+	const SourceCache::Source     * pSource;
+};
+
+//
+// Constructor
+//
+BatchCompiler::BatchSourceLoader::BatchSourceLoader(SourceCache     * pISourceCache,
+                                                    DependencyList  * pIDependencies): pSourceCache(pISourceCache),
+                                                                                       pDependencies(pIDependencies),
+                                                                                       pSource(NULL)
+{
+	// Same search order as CTPP2FileSourceLoader
+	vIncludeDirs.push_back("");
+}
+
+//
+// Load template with specified name
+//
+INT_32 BatchCompiler::BatchSourceLoader::LoadTemplate(CCHAR_P szTemplateName)
+{
+	pSource = NULL;
+
+	STLW::vector<STLW::string>::const_iterator itvIncludeDirs = vIncludeDirs.begin();
+	while (pSource == NULL && itvIncludeDirs != vIncludeDirs.end())
+	{
+		pSource = pSourceCache -> Get(JoinPath(*itvIncludeDirs, szTemplateName));
+		++itvIncludeDirs;
+	}
+
+	if (pSource == NULL)
+	{
+		STLW::string sError("cannot find file `");
+		sError.append(szTemplateName);
+		sError.append("` in include directories");
+		throw CTPPLogicError(sError.c_str());
+	}
+
+	if (pSource -> data.empty())
+	{
+		STLW::string sError("empty file `");
+		sError.append(pSource -> name);
+		sError.append("` found");
+		throw CTPPLogicError(sError.c_str());
+	}
+
+	sCurrentDir = GetDirName(pSource -> name);
+	if (STLW::find(pDependencies -> begin(), pDependencies -> end(), pSource) == pDependencies -> end()) { pDependencies -> push_back(pSource); }
+
+return 0;
+}
+
+//
+// Get template
+//
+CCHAR_P BatchCompiler::BatchSourceLoader::GetTemplate(UINT_32 & iTemplateSize)
+{
+	if (pSource == NULL) { return NULL; }
+
+	iTemplateSize = pSource -> data.size();
+
+return pSource -> data.data();
+}
+
+//
+// Clone loader object
+//
+CTPP2SourceLoader * BatchCompiler::BatchSourceLoader::Clone()
+{
+	BatchSourceLoader * pLoader = new BatchSourceLoader(pSourceCache, pDependencies);
+
+	pLoader -> vIncludeDirs = vIncludeDirs;
+	pLoader -> vIncludeDirs.push_back(sCurrentDir);
+
+return pLoader;
+}
+
+//
+// Get unique name of loaded template
+//
+CCHAR_P BatchCompiler::BatchSourceLoader::GetTemplateName() const { return pSource == NULL ? NULL : pSource -> name.c_str(); }
+
+//
+// A destructor
+//
+BatchCompiler::BatchSourceLoader::~BatchSourceLoader() throw() { ;; }
+
+/**
+  @struct BatchCompiler::WorkQueue CTPP2BatchCompiler.cpp
+  @brief Range of templates; owner takes templates from begin, other threads steal from end
+*/
+struct BatchCompiler::WorkQueue
+{
+	/** Queue lock               */
+	pthread_mutex_t   mutex;
+	/** First template in queue  */
+	UINT_32           begin;
+	/** End of queue             */
+	UINT_32           end;
+};
+
+/**
+  @struct BatchCompiler::WorkerContext CTPP2BatchCompiler.cpp
+  @brief Context of worker thread
+*/
+struct BatchCompiler::WorkerContext
+{
+	/** Compiler         */
+	BatchCompiler   * compiler;
+	/** Queue of thread  */
+	UINT_32           queue;
+};
+
+// ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Class BatchCompiler
+//
+
+//
+// Constructor
+//
+BatchCompiler::BatchCompiler(const bool  bIOptimize,
+                             const bool  bIIncludeUnits): bOptimize(bIOptimize),
+                                                          bIncludeUnits(bIIncludeUnits),
+                                                          pSourceCache(NULL),
+                                                          aQueues(NULL),
+                                                          iQueues(0),
+                                                          bSkipUnchanged(true)
+{
+	;;
+}
+
+//
+// Add template
+//
+void BatchCompiler::AddTemplate(const STLW::string  & sSource,
+                                const STLW::string  & sDestination)
+{
+	Job oJob;
+	oJob.source      = sSource;
+	oJob.destination = sDestination;
+	oJob.status      = PENDING;
+
+	vJobs.push_back(oJob);
+}
+
+//
+// Add all templates from directory tree
+//
+UINT_32 BatchCompiler::AddDirectory(const STLW::string  & sSourceDir,
+                                    const STLW::string  & sDestinationDir,
+                                    const STLW::string  & sExtension)
+{
+	DIR * pDir = opendir(sSourceDir.c_str());
+	if (pDir == NULL) { throw CTPPUnixException("opendir", errno); }
+
+	// Sorted, so order of compilation does not depend on file system
+	STLW::vector<STLW::string> vNames;
+	struct dirent * pEntry = NULL;
+	while ((pEntry = readdir(pDir)) != NULL)
+	{
+		if (strcmp(pEntry -> d_name, ".") != 0 && strcmp(pEntry -> d_name, "..") != 0) { vNames.push_back(pEntry -> d_name); }
+	}
+	closedir(pDir);
+	STLW::sort(vNames.begin(), vNames.end());
+
+	UINT_32 iAdded = 0;
+	for (UINT_32 iPos = 0; iPos < vNames.size(); ++iPos)
+	{
+		const STLW::string sSource(JoinPath(sSourceDir, vNames[iPos]));
+
+		struct stat oStat;
+		if (stat(sSource.c_str(), &oStat) == -1) { continue; }
+
+		if (S_ISDIR(oStat.st_mode))
+		{
+			iAdded += AddDirectory(sSource, JoinPath(sDestinationDir, vNames[iPos]), sExtension);
+		}
+		else if (vNames[iPos].size() > sExtension.size() &&
+		         vNames[iPos].compare(vNames[iPos].size() - sExtension.size(), sExtension.size(), sExtension) == 0)
+		{
+			AddTemplate(sSource, GetCompiledName(JoinPath(sDestinationDir, vNames[iPos])));
+			++iAdded;
+		}
+	}
+
+return iAdded;
+}
+
+//
+// Add templates listed in manifest
+//
+UINT_32 BatchCompiler::AddManifest(const STLW::string  & sManifest,
+                                   const STLW::string  & sDestinationDir)
+{
+	FILE * F = fopen(sManifest.c_str(), "r");
+	if (F == NULL) { throw CTPPUnixException("fopen", errno); }
+
+	const STLW::string sManifestDir(GetDirName(sManifest));
+
+	UINT_32 iAdded = 0;
+	STLW::string sLine;
+	while (ReadLine(F, sLine))
+	{
+		// Skip empty lines and comments
+		const STLW::string::size_type iBegin = sLine.find_first_not_of(" \t\r");
+		if (iBegin == STLW::string::npos || sLine[iBegin] == '#') { continue; }
+
+		const STLW::string::size_type iSourceEnd = sLine.find_first_of(" \t\r", iBegin);
+		const STLW::string sSource(sLine, iBegin, iSourceEnd == STLW::string::npos ? STLW::string::npos : iSourceEnd - iBegin);
+
+		STLW::string sDestination;
+		if (iSourceEnd != STLW::string::npos)
+		{
+			const STLW::string::size_type iDestBegin = sLine.find_first_not_of(" \t\r", iSourceEnd);
+			if (iDestBegin != STLW::string::npos)
+			{
+				const STLW::string::size_type iDestEnd = sLine.find_first_of(" \t\r", iDestBegin);
+				sDestination.assign(sLine, iDestBegin, iDestEnd == STLW::string::npos ? STLW::string::npos : iDestEnd - iDestBegin);
+			}
+		}
+		if (sDestination.empty()) { sDestination = GetCompiledName(sSource); }
+
+		AddTemplate(JoinPath(sManifestDir, sSource), JoinPath(sDestinationDir, sDestination));
+		++iAdded;
+	}
+	fclose(F);
+
+return iAdded;
+}
+
+//
+// Compile templates
+//
+UINT_32 BatchCompiler::Compile(const UINT_32  iThreads,
+                               const bool     bForce)
+{
+	bSkipUnchanged = !bForce;
+	for (UINT_32 iPos = 0; iPos < vJobs.size(); ++iPos)
+	{
+		vJobs[iPos].status = PENDING;
+		vJobs[iPos].error.erase();
+	}
+
+	iQueues = iThreads;
+	if (iQueues > vJobs.size()) { iQueues = vJobs.size(); }
+	if (iQueues == 0)           { iQueues = 1;            }
+
+	// Contiguous ranges of templates; includes of neighbouring templates are often the same
+	aQueues = new WorkQueue[iQueues];
+	for (UINT_32 iPos = 0; iPos < iQueues; ++iPos)
+	{
+		pthread_mutex_init(&(aQueues[iPos].mutex), NULL);
+		aQueues[iPos].begin = UINT_64(vJobs.size()) * iPos       / iQueues;
+		aQueues[iPos].end   = UINT_64(vJobs.size()) * (iPos + 1) / iQueues;
+	}
+
+	pSourceCache = new SourceCache;
+
+	STLW::vector<WorkerContext> vContexts(iQueues);
+	STLW::vector<pthread_t>     vThreads;
+	for (UINT_32 iPos = 0; iPos < iQueues; ++iPos)
+	{
+		vContexts[iPos].compiler = this;
+		vContexts[iPos].queue    = iPos;
+	}
+
+	// Templates of thread that was not started are stolen by other threads
+	for (UINT_32 iPos = 1; iPos < iQueues; ++iPos)
+	{
+		pthread_t oThread;
+		if (pthread_create(&oThread, NULL, WorkerThread, &vContexts[iPos]) == 0) { vThreads.push_back(oThread); }
+	}
+
+	// Current thread is worker too
+	WorkerThread(&vContexts[0]);
+
+	for (UINT_32 iPos = 0; iPos < vThreads.size(); ++iPos) { pthread_join(vThreads[iPos], NULL); }
+
+	for (UINT_32 iPos = 0; iPos < iQueues; ++iPos) { pthread_mutex_destroy(&(aQueues[iPos].mutex)); }
+	delete [] aQueues;
+	aQueues = NULL;
+
+	delete pSourceCache;
+	pSourceCache = NULL;
+
+	UINT_32 iFailed = 0;
+	for (UINT_32 iPos = 0; iPos < vJobs.size(); ++iPos)
+	{
+		if (vJobs[iPos].status == FAILED) { ++iFailed; }
+	}
+
+return iFailed;
+}
+
+//
+// Get templates and results of compilation
+//
+const STLW::vector<BatchCompiler::Job> & BatchCompiler::GetJobs() const { return vJobs; }
+
+//
+// Get next template to compile
+//
+INT_32 BatchCompiler::NextJob(const UINT_32  iQueue)
+{
+	{
+		WorkQueue & oQueue = aQueues[iQueue];
+		MutexLock oLock(&(oQueue.mutex));
+		if (oQueue.begin < oQueue.end) { return oQueue.begin++; }
+	}
+
+	// Own queue is empty, steal from other threads
+	for (UINT_32 iPos = 1; iPos < iQueues; ++iPos)
+	{
+		WorkQueue & oQueue = aQueues[(iQueue + iPos) % iQueues];
+		MutexLock oLock(&(oQueue.mutex));
+		if (oQueue.begin < oQueue.end) { return --oQueue.end; }
+	}
+
+return -1;
+}
+
+//
+// Worker thread function
+//
+void * BatchCompiler::WorkerThread(void * pContext)
+{
+	WorkerContext * pWorker = static_cast<WorkerContext *>(pContext);
+	BatchCompiler * pCompiler = pWorker -> compiler;
+
+	// Templates are never added during compilation, so empty queues mean end of work
+	INT_32 iJob = -1;
+	while ((iJob = pCompiler -> NextJob(pWorker -> queue)) != -1)
+	{
+		pCompiler -> CompileJob(pCompiler -> vJobs[iJob]);
+	}
+
+return NULL;
+}
+
+//
+// Check dependency manifest of compiled template
+//
+bool BatchCompiler::IsUpToDate(const Job & oJob)
+{
+	struct stat oStat;
+	if (stat(oJob.destination.c_str(), &oStat) == -1) { return false; }
+
+	FILE * F = fopen((oJob.destination + C_BATCH_DEPENDENCY_EXTENSION).c_str(), "r");
+	if (F == NULL) { return false; }
+
+	STLW::string sLine;
+	bool bUpToDate = ReadLine(F, sLine) && sLine == sManifestHeader;
+
+	// Options of compiler
+	if (bUpToDate)
+	{
+		CHAR_8 szOptions[64];
+		snprintf(szOptions, sizeof(szOptions), "options %d %d", INT_32(bOptimize), INT_32(bIncludeUnits));
+		bUpToDate = ReadLine(F, sLine) && sLine == szOptions;
+	}
+
+	UINT_32 iFiles = 0;
+	while (bUpToDate && ReadLine(F, sLine))
+	{
+		unsigned long long iSize  = 0;
+		long long          iMTime = 0;
+		unsigned long long iHash  = 0;
+		long long          iLoadTime = 0;
+		INT_32             iNameOffset = 0;
+		if (sscanf(sLine.c_str(), "%llu %lld %llx %lld %n", &iSize, &iMTime, &iHash, &iLoadTime, &iNameOffset) != 4 || iNameOffset == 0)
+		{
+			bUpToDate = false;
+			break;
+		}
+
+		const STLW::string sFileName(sLine, iNameOffset);
+		if (stat(sFileName.c_str(), &oStat) == -1 || UINT_64(oStat.st_size) != iSize) { bUpToDate = false; }
+		// File was touched or modification time has one second resolution and file
+		// could be rewritten in the same second after loading; compare content
+		else if (INT_64(oStat.st_mtime) != iMTime || iMTime >= iLoadTime)
+		{
+			const SourceCache::Source * pSource = pSourceCache -> Get(sFileName);
+			bUpToDate = pSource != NULL && pSource -> hash == iHash;
+		}
+		++iFiles;
+	}
+	fclose(F);
+
+return bUpToDate && iFiles != 0;
+}
+
+//
+// Compile template
+//
+void BatchCompiler::CompileJob(Job & oJob)
+{
+	CHAR_8 szError[2048 + 1];
+	try
+	{
+		if (bSkipUnchanged && IsUpToDate(oJob))
+		{
+			oJob.status = UP_TO_DATE;
+			return;
+		}
+
+		VMOpcodeCollector  oVMOpcodeCollector;
+		StaticText         oSyscalls;
+		StaticData         oStaticData;
+		StaticText         oStaticText;
+		HashTable          oHashTable;
+		CTPP2Compiler oCompiler(oVMOpcodeCollector, oSyscalls, oStaticData, oStaticText, oHashTable);
+
+		// Source and all included files
+		BatchSourceLoader::DependencyList vDependencies;
+		{
+			BatchSourceLoader oSourceLoader(pSourceCache, &vDependencies);
+			oSourceLoader.LoadTemplate(oJob.source.c_str());
+
+			CTPP2Parser oCTPP2Parser(&oSourceLoader, &oCompiler, oJob.source);
+			oCTPP2Parser.SetIncludeUnits(bIncludeUnits);
+			oCTPP2Parser.Compile();
+		}
+
+		VMOptimizer oOptimizer(oVMOpcodeCollector, oStaticData, oStaticText, oHashTable);
+		if (bOptimize) { oOptimizer.Optimize();          }
+		else           { oOptimizer.MergeStaticOutput(); }
+
+		UINT_32 iCodeSize = 0;
+		const VMInstruction * oVMInstruction = oVMOpcodeCollector.GetCode(iCodeSize);
+		VMDumper oDumper(iCodeSize, oVMInstruction, oSyscalls, oStaticData, oStaticText, oHashTable);
+		UINT_32 iSize = 0;
+		const VMExecutable * aProgramCore = oDumper.GetExecutable(iSize);
+
+		// Old manifest is removed first, so interrupted build is not treated as complete
+		const STLW::string sManifest(oJob.destination + C_BATCH_DEPENDENCY_EXTENSION);
+		unlink(sManifest.c_str());
+
+		MakeDirs(oJob.destination);
+		ReplaceFile(oJob.destination, aProgramCore, iSize);
+
+		STLW::string sManifestData(sManifestHeader);
+		snprintf(szError, sizeof(szError), "\noptions %d %d\n", INT_32(bOptimize), INT_32(bIncludeUnits));
+		sManifestData.append(szError);
+		for (UINT_32 iPos = 0; iPos < vDependencies.size(); ++iPos)
+		{
+			const SourceCache::Source * pSource = vDependencies[iPos];
+			snprintf(szError, sizeof(szError), "%llu %lld %016llx %lld ", (unsigned long long)pSource -> file_stat.st_size,
+			                                                              (long long)pSource -> file_stat.st_mtime,
+			                                                              (unsigned long long)pSource -> hash,
+			                                                              (long long)pSource -> load_time);
+			sManifestData.append(szError);
+			sManifestData.append(pSource -> name);
+			sManifestData.append("\n", 1);
+		}
+		ReplaceFile(sManifest, sManifestData.data(), sManifestData.size());
+
+		oJob.status = COMPILED;
+		return;
+	}
+	catch(CTPPParserSyntaxError & e)
+	{
+		snprintf(szError, 2048, "At line %d, pos. %d: %s", e.GetLine(), e.GetLinePos(), e.what());
+	}
+	catch(CTPPParserOperatorsMismatch & e)
+	{
+		snprintf(szError, 2048, "At line %d, pos. %d: expected %s, but found </%s>", e.GetLine(), e.GetLinePos(), e.Expected(), e.Found());
+	}
+	catch(CTPPUnixException & e)
+	{
+		snprintf(szError, 2048, "I/O in %s: %s", e.what(), strerror(e.ErrNo()));
+	}
+	catch(CTPPException & e)
+	{
+		snprintf(szError, 2048, "%s", e.what());
+	}
+	catch(...)
+	{
+		snprintf(szError, 2048, "Bad thing happened.");
+	}
+
+	oJob.status = FAILED;
+	oJob.error.assign(szError);
+}
+
+//
+// A destructor
+//
+BatchCompiler::~BatchCompiler() throw() { ;; }
+
+} // namespace CTPP
+// End.
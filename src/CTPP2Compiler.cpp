@@ -32,11 +32,14 @@
 #include "CTPP2Compiler.hpp"
 
 #include "CTPP2Syntax.h"
+#include "CTPP2GetText.hpp"
 #include "CTPP2HashTable.hpp"
 #include "CTPP2StaticData.hpp"
 #include "CTPP2StaticText.hpp"
 #include "CTPP2VMOpcodes.h"
 
+#include <strings.h>
+
 // #define _USE_COMPILER_REPORTER 1 // Use it only for hard debugging
 #define CTPP2_FOREACH_ITER_PREFIX "__iter_"
 
@@ -168,7 +171,8 @@ CTPP2Compiler::CTPP2Compiler(VMOpcodeCollector  & oIVMOpcodeCollector,
                                                                 oSyscalls(oISyscalls),
                                                                 oStaticData(oIStaticData),
                                                                 oStaticText(oIStaticText),
-                                                                oHashTable(oIHashTable)
+                                                                oHashTable(oIHashTable),
+                                                                pGetText(NULL)
 {
 	mSyscalls["__ctpp2_emitter"]      = oSyscalls.StoreData("__ctpp2_emitter",      15);
 
@@ -180,6 +184,16 @@ CTPP2Compiler::CTPP2Compiler(VMOpcodeCollector  & oIVMOpcodeCollector,
 	oVMOpcodeCollector.Insert(CreateInstruction(POP, 1, 0));
 }
 
+//
+// Translate calls of gettext with static arguments at compile time
+//
+void CTPP2Compiler::SetTranslation(const CTPP2GetText   * pIGetText,
+                                   const STLW::string   & sILanguage)
+{
+	pGetText  = pIGetText;
+	sLanguage = sILanguage;
+}
+
 //
 // Store template source name
 //
@@ -200,6 +214,95 @@ INT_32 CTPP2Compiler::OutputVariable(const VMDebugInfo & oDebugInfo)
 return oVMOpcodeCollector.Insert(CreateInstruction(OUTPUT | ARG_SRC_STACK, 0, oDebugInfo.GetInfo()));
 }
 
+//
+// Send result of expression to standard output collector
+//
+INT_32 CTPP2Compiler::OutputVariable(const UINT_32        iExprIP,
+                                     const VMDebugInfo  & oDebugInfo)
+{
+	COMPILER_REPORTER("OutputVariable");
+
+	// Expression is PrepareLocalScope() + PushVariable() and, maybe, ExecuteSyscall() with one argument:
+	//  PUSH HR; REPLACE STACK, HR["var"]; DEFINED STACK; JE +2; REPLACE STACK, DR["var"] [; SYSCALL func, 1]
+	// Nothing outside of expression can jump into it, so it can be fused safely
+	const UINT_32 iExprSize = oVMOpcodeCollector.GetCodeSize() - iExprIP;
+
+	// String constant, e.g. translated message, is output as static text and may be merged with text around it
+	//  PUSH STR -> OUTPUT STR
+	if (iExprSize == 1 && oVMOpcodeCollector.GetInstruction(iExprIP) -> instruction == (PUSH | ARG_SRC_STR))
+	{
+		VMInstruction * pInstruction = oVMOpcodeCollector.GetInstruction(iExprIP);
+		pInstruction -> instruction = OUTPUT | ARG_SRC_STR;
+
+		--iStackDepth;
+		return iExprIP;
+	}
+
+	if (iExprSize != 5 && iExprSize != 6) { return OutputSyscall(iExprIP, oDebugInfo); }
+
+	const VMInstruction * aCode = oVMOpcodeCollector.GetInstruction(iExprIP);
+	const UINT_32 iTextId = aCode[1].argument;
+	if (aCode[0].instruction != (PUSH    | ARG_SRC_HR)                      ||
+	    aCode[1].instruction != (REPLACE | ARG_SRC_IND_STR | ARG_DST_STACK) ||
+	    aCode[2].instruction != (DEFINED | ARG_SRC_STACK)                   || aCode[2].argument != 0            ||
+	    aCode[3].instruction != JE                                          || aCode[3].argument != iExprIP + 5  ||
+	    aCode[4].instruction != (REPLACE | ARG_SRC_IND_STR | ARG_DST_DR)    || aCode[4].argument != iTextId)
+	{
+		return OutputSyscall(iExprIP, oDebugInfo);
+	}
+
+	VMInstruction oInstruction = CreateInstruction(OUTVAR | ARG_SRC_HR | ARG_DST_DR, iTextId, aCode[1].reserved);
+	if (iExprSize == 6)
+	{
+		// Syscall number and name of variable are packed into one argument
+		const UINT_32 iCallNum = aCode[5].argument >> 16;
+		if (aCode[5].instruction != SYSCALL || (aCode[5].argument & 0x0000FFFF) != 1 || iTextId > 0x0000FFFF)
+		{
+			return OutputSyscall(iExprIP, oDebugInfo);
+		}
+		oInstruction = CreateInstruction(OUTVAR_ESC | ARG_SRC_HR | ARG_DST_DR, SYSCALL_PARAMS(iCallNum, iTextId), aCode[5].reserved);
+	}
+
+	for (UINT_32 iI = 0; iI < iExprSize; ++iI) { oVMOpcodeCollector.Remove(); }
+
+	--iStackDepth;
+return oVMOpcodeCollector.Insert(oInstruction);
+}
+
+//
+// Send result of expression ending with system call to standard output collector
+//
+INT_32 CTPP2Compiler::OutputSyscall(const UINT_32        iExprIP,
+                                    const VMDebugInfo  & oDebugInfo)
+{
+	const UINT_32 iCodeSize = oVMOpcodeCollector.GetCodeSize();
+	if (iCodeSize == iExprIP) { return OutputVariable(oDebugInfo); }
+
+	const UINT_32 iCallIP = iCodeSize - 1;
+	VMInstruction * pCall = oVMOpcodeCollector.GetInstruction(iCallIP);
+	if (pCall -> instruction != SYSCALL) { return OutputVariable(oDebugInfo); }
+
+	// Jump over system call, e.g. in short-circuit evaluation, expects its result in stack
+	const VMInstruction * aCode = oVMOpcodeCollector.GetInstruction(iExprIP);
+	for (UINT_32 iIP = iExprIP; iIP < iCallIP; ++iIP)
+	{
+		const UINT_32 iInstruction = aCode[iIP - iExprIP].instruction;
+		const UINT_32 iArgument    = aCode[iIP - iExprIP].argument;
+
+		UINT_32 iTarget = iExprIP;
+		if      ((iInstruction & 0xFFFF0000) == JMP  || (iInstruction & 0xFF000000) == JXX)  { iTarget = iArgument;       }
+		else if ((iInstruction & 0xFFFF0000) == RJMP || (iInstruction & 0xFF000000) == RJXX) { iTarget = iIP + iArgument; }
+
+		if (iTarget < iExprIP || iTarget > iCallIP) { return OutputVariable(oDebugInfo); }
+	}
+
+	// SYSCALL func, N; OUTPUT STACK -> OUTSYS func, N
+	pCall -> instruction = OUTSYS;
+
+	--iStackDepth;
+return iCallIP;
+}
+
 //
 // Send text data to standard output collector
 //
@@ -463,6 +566,59 @@ void CTPP2Compiler::PrepareCallBlock(const VMDebugInfo & oDebugInfo)
 	vSavedStackDepths.push_back(iStackDepth);
 }
 
+//
+// Start of include unit
+//
+INT_32 CTPP2Compiler::StartIncludeUnit(const VMDebugInfo & oDebugInfo)
+{
+	COMPILER_REPORTER("StartIncludeUnit");
+
+return oVMOpcodeCollector.Insert(CreateInstruction(JMP, (UINT_32)-1, oDebugInfo.GetInfo()));
+}
+
+//
+// End of include unit
+//
+INT_32 CTPP2Compiler::EndIncludeUnit(const STLW::string  & sUnitName,
+                                     const UINT_32         iJumpIP,
+                                     const VMDebugInfo   & oDebugInfo)
+{
+	COMPILER_REPORTER("EndIncludeUnit");
+
+	oVMOpcodeCollector.Insert(CreateInstruction(RET, 0, oDebugInfo.GetInfo()));
+
+	// Skip unit body
+	oVMOpcodeCollector.GetInstruction(iJumpIP) -> argument = oVMOpcodeCollector.GetCodeSize();
+
+	// Unit is registered after compilation, so recursive include is inlined and stopped by recursion limit
+	const UINT_32 iEntryIP = iJumpIP + 1;
+	mIncludeUnits[sUnitName] = iEntryIP;
+
+return CallIncludeUnit(iEntryIP, oDebugInfo);
+}
+
+//
+// Get entry point of compiled include unit
+//
+INT_32 CTPP2Compiler::GetIncludeUnit(const STLW::string & sUnitName) const
+{
+	STLW::map<STLW::string, UINT_32>::const_iterator itmIncludeUnits = mIncludeUnits.find(sUnitName);
+	if (itmIncludeUnits == mIncludeUnits.end()) { return -1; }
+
+return itmIncludeUnits -> second;
+}
+
+//
+// Call include unit
+//
+INT_32 CTPP2Compiler::CallIncludeUnit(const UINT_32        iEntryIP,
+                                      const VMDebugInfo  & oDebugInfo)
+{
+	COMPILER_REPORTER("CallIncludeUnit");
+
+return oVMOpcodeCollector.Insert(CreateInstruction(CALL, iEntryIP, oDebugInfo.GetInfo()));
+}
+
 //
 // Get system call by id
 //
@@ -492,11 +648,107 @@ INT_32 CTPP2Compiler::ExecuteSyscall(CCHAR_P              szSyscallName,
 {
 	COMPILER_REPORTER("ExecuteSyscall");
 
+	const INT_32 iIP = TranslateSyscall(szSyscallName, iSyscallNameLength, iArgNum, oDebugInfo);
+	if (iIP != -1) { return iIP; }
+
 	iStackDepth -= iArgNum - 1;
 
 return oVMOpcodeCollector.Insert(CreateInstruction(SYSCALL, SYSCALL_PARAMS(GetSyscallId(szSyscallName, iSyscallNameLength), iArgNum), oDebugInfo.GetInfo()));
 }
 
+//
+// Replace call of gettext with static arguments by its translation
+//
+//   PUSH     "msgid"
+// [ PUSH     "msgid_plural" ]
+// [ PUSH     n ]                    ->    PUSH     "translation"
+// [ PUSH     "domain" ]
+//   SYSCALL  gettext, N
+//
+INT_32 CTPP2Compiler::TranslateSyscall(CCHAR_P              szSyscallName,
+                                       const UINT_32        iSyscallNameLength,
+                                       const UINT_32        iArgNum,
+                                       const VMDebugInfo  & oDebugInfo)
+{
+	if (pGetText == NULL || iArgNum == 0 || iArgNum > 4 || oVMOpcodeCollector.GetCodeSize() < iArgNum) { return -1; }
+
+	if (!(iSyscallNameLength == 1 && szSyscallName[0] == '_') &&
+	    !(iSyscallNameLength == 7 && strncasecmp(szSyscallName, "gettext", 7) == 0)) { return -1; }
+
+	// Arguments: msgid[, msgid_plural, n][, domain]; messages and domain are strings, n is integer
+	const UINT_32 iArgsIP = oVMOpcodeCollector.GetCodeSize() - iArgNum;
+	const VMInstruction * aArgs = oVMOpcodeCollector.GetInstruction(iArgsIP);
+	for (UINT_32 iI = 0; iI < iArgNum; ++iI)
+	{
+		const UINT_32 iExpected = (iI == 2) ? (PUSH | ARG_SRC_INT) : (PUSH | ARG_SRC_STR);
+		if (aArgs[iI].instruction != iExpected) { return -1; }
+	}
+
+	UINT_32 iMessageLength = 0;
+	CCHAR_P szMessage = oStaticText.GetData(aArgs[0].argument, iMessageLength);
+	if (szMessage == NULL) { return -1; }
+
+	STLW::string sDomain;
+	if (iArgNum % 2 == 0)
+	{
+		UINT_32 iDomainLength = 0;
+		CCHAR_P szDomain = oStaticText.GetData(aArgs[iArgNum - 1].argument, iDomainLength);
+		if (szDomain == NULL) { return -1; }
+
+		sDomain.assign(szDomain, iDomainLength);
+	}
+
+	// No translations of domain, call is left to run time
+	const CTPP2GetText::CatalogList * pCatalogs = pGetText -> GetCatalogs(pGetText -> GetDomains(sLanguage), sDomain);
+	if (pCatalogs == NULL) { return -1; }
+
+	INT_32 iMessage = -1;
+	const CTPP2GetTextCatalog * pCatalog = CTPP2GetText::FindCatalog(pCatalogs, szMessage, iMessageLength, iMessage);
+
+	// Same result as FnGetText returns
+	STLW::string sTranslation;
+	if (iArgNum <= 2)
+	{
+		if (pCatalog == NULL) { sTranslation.assign(szMessage, iMessageLength); }
+		else
+		{
+			const CDTStringView * pTranslation = pCatalog -> GetTranslation(iMessage, 0);
+			sTranslation.assign(pTranslation -> data, pTranslation -> length);
+		}
+	}
+	else
+	{
+		const INT_64 iCount = oStaticData.GetInt(aArgs[2].argument);
+		if (pCatalog == NULL)
+		{
+			if (UINT_32(iCount) > 1)
+			{
+				UINT_32 iPlMessageLength = 0;
+				CCHAR_P szPlMessage = oStaticText.GetData(aArgs[1].argument, iPlMessageLength);
+				sTranslation.assign(szPlMessage, iPlMessageLength);
+			}
+			else
+			{
+				sTranslation.assign(szMessage, iMessageLength);
+			}
+		}
+		else
+		{
+			const CDTStringView & oTranslation = pCatalog -> GetPluralTranslation(iMessage, UINT_32(iCount));
+			sTranslation.assign(oTranslation.data, oTranslation.length);
+		}
+	}
+
+	for (UINT_32 iI = 0; iI < iArgNum; ++iI)
+	{
+		if (aArgs[iI].instruction == (PUSH | ARG_SRC_STR)) { oStaticText.ReleaseData(aArgs[iI].argument); }
+	}
+	for (UINT_32 iI = 0; iI < iArgNum; ++iI) { oVMOpcodeCollector.Remove(); }
+	iStackDepth -= iArgNum;
+
+return PushString(sTranslation.data(), sTranslation.size(), oDebugInfo);
+}
+
 //
 // Prepare before push hash or array variable
 //
@@ -607,28 +859,20 @@ INT_32 CTPP2Compiler::PushScopedVariable(CCHAR_P              szName,
 	// Check current stack depth
 	INT_32 iDepth = iStackDepth - pRecord -> symbol_data.stack_depth;
 
-	INT_32 iNSId   = oStaticText.StoreData(sNamespace.data(), sNamespace.size());
+	// Iterator record is taken directly from HR or from stack; it is not stored in scratch registers,
+	//  so VM can reuse record of previous iteration without copying it
+	const UINT_32 iPushInstruction = (pRecord -> symbol_data.scope_number == iScopeNumber) ? UINT_32(PUSH | ARG_SRC_HR) : UINT_32(PUSH | ARG_SRC_STACK);
+	const UINT_32 iPushArgument    = (pRecord -> symbol_data.scope_number == iScopeNumber) ? 0 : iDepth - 8;
 
 	++iStackDepth;
-	if (pRecord -> symbol_data.scope_number == iScopeNumber)
-	{
-		oVMOpcodeCollector.Insert(CreateInstruction(IMOVSTR | ARG_SRC_HR | ARG_DST_BR, iNSId,   iDebugInfo));
-		oVMOpcodeCollector.Insert(CreateInstruction(PUSH    | ARG_SRC_HR,     0,          iDebugInfo));
-	}
-	else
-	{
-		oVMOpcodeCollector.Insert(CreateInstruction(MOV     | ARG_SRC_STACK | ARG_DST_CR, iDepth - 8,   iDebugInfo));
-		oVMOpcodeCollector.Insert(CreateInstruction(IMOVSTR | ARG_SRC_CR | ARG_DST_BR, iNSId,   iDebugInfo));
-		oVMOpcodeCollector.Insert(CreateInstruction(PUSH    | ARG_SRC_STACK,  iDepth - 8, iDebugInfo));
-	}
+	oVMOpcodeCollector.Insert(CreateInstruction(iPushInstruction, iPushArgument, iDebugInfo));
 
 	oVMOpcodeCollector.Insert(CreateInstruction(REPLACE | ARG_SRC_IND_STR | ARG_DST_STACK, iId,    iDebugInfo));
 	INT_32 iPos =
 	oVMOpcodeCollector.Insert(CreateInstruction(DEFINED | ARG_SRC_STACK, 0,    iDebugInfo));
-	oVMOpcodeCollector.Insert(CreateInstruction(JE, iPos + 5,   iDebugInfo));
+	oVMOpcodeCollector.Insert(CreateInstruction(JE, iPos + 3,   iDebugInfo));
 	oVMOpcodeCollector.Insert(CreateInstruction(POP                                      , 0,        iDebugInfo));
-	oVMOpcodeCollector.Insert(CreateInstruction(PUSH | ARG_SRC_BR, 0,    iDebugInfo));
-	return oVMOpcodeCollector.Insert(CreateInstruction(REPLACE | ARG_SRC_IND_STR | ARG_DST_STACK, iId,    iDebugInfo));
+return oVMOpcodeCollector.Insert(CreateInstruction(iPushInstruction, iPushArgument, iDebugInfo));
 }
 
 //
@@ -0,0 +1,644 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2Escape.cpp
+ *
+ * $CTPP$
+ */
+#include "CDT.hpp"
+#include "CTPP2Escape.hpp"
+
+#include "CTPP2OutputCollector.hpp"
+#include "CTPP2Util.hpp"
+
+#include <string.h>
+
+#ifdef SIMD_ESCAPE_SUPPORT
+#include <immintrin.h>
+#endif
+
+/** Runs of data longer than this are passed to destination without copying to buffer */
+#define C_ESCAPE_MIN_DIRECT_RUN     64
+
+/** Characters after escaped one checked without search kernel */
+#define C_ESCAPE_INLINE_SCAN        16
+
+namespace CTPP // C++ Template Engine
+{
+
+/** Character classes of lookup table */
+#define C_ESCAPE_MARKUP             0x01
+#define C_ESCAPE_WML                0x02
+#define C_ESCAPE_URL                0x04
+#define C_ESCAPE_JSON               0x08
+
+/**
+  Lookup table for scalar search, one bit per character class; constant, so it is ready before any static constructor runs
+    MARKUP - " ' < > &
+    WML    - as MARKUP, $ and control characters
+    URL    - all except [A-Za-z0-9/._-]
+    JSON   - " \ / ' < > and control characters
+*/
+static const UCHAR_8 aEscapeTable[256] =
+{
+	0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E,
+	0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E,
+	0x04, 0x04, 0x0F, 0x04, 0x06, 0x04, 0x07, 0x0F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00, 0x08,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x04, 0x0F, 0x04, 0x0F, 0x04,
+	0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x0C, 0x04, 0x04, 0x00,
+	0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x04, 0x04, 0x04, 0x04,
+	0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+	0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+	0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+	0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+	0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+	0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+	0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+	0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04
+};
+
+/** Search kernel, one per character class */
+typedef UINT_32 (*ScanKernel)(CCHAR_P szData, const UINT_32 iDataLength);
+
+// FWD
+template <UINT_32 iKernel> static UINT_32 ScanFirst(CCHAR_P        szData,
+                                                    const UINT_32  iDataLength);
+
+/** Search kernels; kernel is selected by first search, so escaping works from static constructors of other modules too */
+static ScanKernel      aScanKernels[4] = { ScanFirst<0>, ScanFirst<1>, ScanFirst<2>, ScanFirst<3> };
+/** Selected kernel, ESCAPE_KERNEL_AUTO until kernel is selected */
+static eEscapeKernel   eUsedKernel = ESCAPE_KERNEL_AUTO;
+
+//
+// Get character class of escaping rules
+//
+static UINT_32 EscapeClass(const eEscapeType  eType)
+{
+	switch (eType)
+	{
+		case ESCAPE_HTML:
+		case ESCAPE_XML:
+			return 0;
+		case ESCAPE_WML:
+			return 1;
+		case ESCAPE_URL:
+		case ESCAPE_URI:
+			return 2;
+		default:
+			;;
+	}
+return 3;
+}
+
+//
+// Scalar search
+//
+template <UINT_32 iClass> static UINT_32 ScanScalar(CCHAR_P        szData,
+                                                    const UINT_32  iDataLength)
+{
+	UINT_32 iPos = 0;
+	while (iPos < iDataLength && (aEscapeTable[UCHAR_8(szData[iPos])] & iClass) == 0) { ++iPos; }
+
+return iPos;
+}
+
+#ifdef SIMD_ESCAPE_SUPPORT
+//
+// SSE2 search, 16 bytes per step
+//
+template <UINT_32 iClass> __attribute__((target("sse2"))) static UINT_32 ScanSSE2(CCHAR_P        szData,
+                                                                                  const UINT_32  iDataLength)
+{
+	UINT_32 iPos = 0;
+	for (; iPos + 16 <= iDataLength; iPos += 16)
+	{
+		const __m128i vData = _mm_loadu_si128((const __m128i *)(szData + iPos));
+		__m128i vFound;
+		if (iClass == C_ESCAPE_URL)
+		{
+			// [-./0-9], [A-Za-z] and '_' are not escaped
+			const __m128i vLower = _mm_or_si128(vData, _mm_set1_epi8(0x20));
+			__m128i vClean = _mm_cmpeq_epi8(_mm_min_epu8(_mm_max_epu8(vData, _mm_set1_epi8('-')), _mm_set1_epi8('9')), vData);
+			vClean = _mm_or_si128(vClean, _mm_cmpeq_epi8(_mm_min_epu8(_mm_max_epu8(vLower, _mm_set1_epi8('a')), _mm_set1_epi8('z')), vLower));
+			vClean = _mm_or_si128(vClean, _mm_cmpeq_epi8(vData, _mm_set1_epi8('_')));
+			vFound = _mm_xor_si128(vClean, _mm_set1_epi8(-1));
+		}
+		else
+		{
+			vFound = _mm_or_si128(_mm_cmpeq_epi8(vData, _mm_set1_epi8('"')), _mm_cmpeq_epi8(vData, _mm_set1_epi8('\'')));
+			vFound = _mm_or_si128(vFound, _mm_cmpeq_epi8(vData, _mm_set1_epi8('<')));
+			vFound = _mm_or_si128(vFound, _mm_cmpeq_epi8(vData, _mm_set1_epi8('>')));
+			if (iClass == C_ESCAPE_JSON)
+			{
+				vFound = _mm_or_si128(vFound, _mm_cmpeq_epi8(vData, _mm_set1_epi8('\\')));
+				vFound = _mm_or_si128(vFound, _mm_cmpeq_epi8(vData, _mm_set1_epi8('/')));
+			}
+			else
+			{
+				vFound = _mm_or_si128(vFound, _mm_cmpeq_epi8(vData, _mm_set1_epi8('&')));
+			}
+
+			if (iClass == C_ESCAPE_WML)
+			{
+				vFound = _mm_or_si128(vFound, _mm_cmpeq_epi8(vData, _mm_set1_epi8('$')));
+			}
+
+			// Control characters, unsigned comparison
+			if (iClass != C_ESCAPE_MARKUP)
+			{
+				vFound = _mm_or_si128(vFound, _mm_cmpeq_epi8(_mm_max_epu8(vData, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F)));
+			}
+		}
+
+		const UINT_32 iMask = _mm_movemask_epi8(vFound);
+		if (iMask != 0) { return iPos + __builtin_ctz(iMask); }
+	}
+
+return iPos + ScanScalar<iClass>(szData + iPos, iDataLength - iPos);
+}
+
+//
+// AVX2 search, 32 bytes per step
+//
+template <UINT_32 iClass> __attribute__((target("avx2"))) static UINT_32 ScanAVX2(CCHAR_P        szData,
+                                                                                  const UINT_32  iDataLength)
+{
+	UINT_32 iPos = 0;
+	for (; iPos + 32 <= iDataLength; iPos += 32)
+	{
+		const __m256i vData = _mm256_loadu_si256((const __m256i *)(szData + iPos));
+		__m256i vFound;
+		if (iClass == C_ESCAPE_URL)
+		{
+			// [-./0-9], [A-Za-z] and '_' are not escaped
+			const __m256i vLower = _mm256_or_si256(vData, _mm256_set1_epi8(0x20));
+			__m256i vClean = _mm256_cmpeq_epi8(_mm256_min_epu8(_mm256_max_epu8(vData, _mm256_set1_epi8('-')), _mm256_set1_epi8('9')), vData);
+			vClean = _mm256_or_si256(vClean, _mm256_cmpeq_epi8(_mm256_min_epu8(_mm256_max_epu8(vLower, _mm256_set1_epi8('a')), _mm256_set1_epi8('z')), vLower));
+			vClean = _mm256_or_si256(vClean, _mm256_cmpeq_epi8(vData, _mm256_set1_epi8('_')));
+			vFound = _mm256_xor_si256(vClean, _mm256_set1_epi8(-1));
+		}
+		else
+		{
+			vFound = _mm256_or_si256(_mm256_cmpeq_epi8(vData, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(vData, _mm256_set1_epi8('\'')));
+			vFound = _mm256_or_si256(vFound, _mm256_cmpeq_epi8(vData, _mm256_set1_epi8('<')));
+			vFound = _mm256_or_si256(vFound, _mm256_cmpeq_epi8(vData, _mm256_set1_epi8('>')));
+			if (iClass == C_ESCAPE_JSON)
+			{
+				vFound = _mm256_or_si256(vFound, _mm256_cmpeq_epi8(vData, _mm256_set1_epi8('\\')));
+				vFound = _mm256_or_si256(vFound, _mm256_cmpeq_epi8(vData, _mm256_set1_epi8('/')));
+			}
+			else
+			{
+				vFound = _mm256_or_si256(vFound, _mm256_cmpeq_epi8(vData, _mm256_set1_epi8('&')));
+			}
+
+			if (iClass == C_ESCAPE_WML)
+			{
+				vFound = _mm256_or_si256(vFound, _mm256_cmpeq_epi8(vData, _mm256_set1_epi8('$')));
+			}
+
+			// Control characters, unsigned comparison
+			if (iClass != C_ESCAPE_MARKUP)
+			{
+				vFound = _mm256_or_si256(vFound, _mm256_cmpeq_epi8(_mm256_max_epu8(vData, _mm256_set1_epi8(0x1F)), _mm256_set1_epi8(0x1F)));
+			}
+		}
+
+		const UINT_32 iMask = _mm256_movemask_epi8(vFound);
+		if (iMask != 0) { return iPos + __builtin_ctz(iMask); }
+	}
+
+	// Tail is shorter than 32 bytes
+return iPos + ScanSSE2<iClass>(szData + iPos, iDataLength - iPos);
+}
+#endif // SIMD_ESCAPE_SUPPORT
+
+//
+// Select fastest kernel and search with it
+//
+template <UINT_32 iKernel> static UINT_32 ScanFirst(CCHAR_P        szData,
+                                                    const UINT_32  iDataLength)
+{
+	if (eUsedKernel == ESCAPE_KERNEL_AUTO) { SetEscapeKernel(ESCAPE_KERNEL_AUTO); }
+
+return aScanKernels[iKernel](szData, iDataLength);
+}
+
+//
+// Select search kernel
+//
+eEscapeKernel SetEscapeKernel(const eEscapeKernel  eKernel)
+{
+	eUsedKernel = ESCAPE_KERNEL_SCALAR;
+#ifdef SIMD_ESCAPE_SUPPORT
+	__builtin_cpu_init();
+	if (eKernel != ESCAPE_KERNEL_SCALAR && __builtin_cpu_supports("sse2"))
+	{
+		eUsedKernel = ESCAPE_KERNEL_SSE2;
+		if (eKernel != ESCAPE_KERNEL_SSE2 && __builtin_cpu_supports("avx2")) { eUsedKernel = ESCAPE_KERNEL_AVX2; }
+	}
+
+	if (eUsedKernel == ESCAPE_KERNEL_AVX2)
+	{
+		aScanKernels[0] = ScanAVX2<C_ESCAPE_MARKUP>;
+		aScanKernels[1] = ScanAVX2<C_ESCAPE_WML>;
+		aScanKernels[2] = ScanAVX2<C_ESCAPE_URL>;
+		aScanKernels[3] = ScanAVX2<C_ESCAPE_JSON>;
+		return eUsedKernel;
+	}
+
+	if (eUsedKernel == ESCAPE_KERNEL_SSE2)
+	{
+		aScanKernels[0] = ScanSSE2<C_ESCAPE_MARKUP>;
+		aScanKernels[1] = ScanSSE2<C_ESCAPE_WML>;
+		aScanKernels[2] = ScanSSE2<C_ESCAPE_URL>;
+		aScanKernels[3] = ScanSSE2<C_ESCAPE_JSON>;
+		return eUsedKernel;
+	}
+#endif // SIMD_ESCAPE_SUPPORT
+
+	aScanKernels[0] = ScanScalar<C_ESCAPE_MARKUP>;
+	aScanKernels[1] = ScanScalar<C_ESCAPE_WML>;
+	aScanKernels[2] = ScanScalar<C_ESCAPE_URL>;
+	aScanKernels[3] = ScanScalar<C_ESCAPE_JSON>;
+
+return eUsedKernel;
+}
+
+//
+// Get used search kernel
+//
+eEscapeKernel GetEscapeKernel()
+{
+	if (eUsedKernel == ESCAPE_KERNEL_AUTO) { SetEscapeKernel(ESCAPE_KERNEL_AUTO); }
+
+return eUsedKernel;
+}
+
+//
+// Find first character to escape
+//
+UINT_32 EscapeScan(const eEscapeType  eType,
+                   CCHAR_P            szData,
+                   const UINT_32      iDataLength)
+{
+	return aScanKernels[EscapeClass(eType)](szData, iDataLength);
+}
+
+//
+// Escape one character found by search kernel, return length of escape sequence
+//
+static inline UINT_32 EscapeChar(const eEscapeType  eType,
+                                 const UCHAR_8      uCH,
+                                 CHAR_P             szBuffer)
+{
+	static const CHAR_8 * szHex = "0123456789ABCDEF";
+	static const CHAR_8 * szJSONHex = "0123456789abcdef";
+
+	CCHAR_P  szEscaped = NULL;
+	switch (eType)
+	{
+		case ESCAPE_HTML:
+		case ESCAPE_XML:
+		case ESCAPE_WML:
+			switch (uCH)
+			{
+				case '"':  szEscaped = "&quot;"; break;
+				case '\'': szEscaped = (eType == ESCAPE_HTML) ? "&#39;" : "&apos;"; break;
+				case '<':  szEscaped = "&lt;";   break;
+				case '>':  szEscaped = "&gt;";   break;
+				case '&':  szEscaped = "&amp;";  break;
+				case '$':  szEscaped = "$$";     break;
+				// Control characters are not allowed in WML
+				default:   return 0;
+			}
+			break;
+
+		case ESCAPE_URL:
+			if (uCH == ' ') { szBuffer[0] = '+'; return 1; }
+			// Fall through
+		case ESCAPE_URI:
+			szBuffer[0] = '%';
+			szBuffer[1] = szHex[(uCH >> 4) & 0x0F];
+			szBuffer[2] = szHex[uCH & 0x0F];
+			return 3;
+
+		default:
+			{
+				const bool bECMAConventions = (eType == ESCAPE_JSON_ECMA || eType == ESCAPE_JSON_ECMA_HTML);
+				const bool bHTMLSafe        = (eType == ESCAPE_JSON_HTML || eType == ESCAPE_JSON_ECMA_HTML);
+				switch (uCH)
+				{
+					case '"':  szEscaped = "\\\""; break;
+					case '\\': szEscaped = "\\\\"; break;
+					case '/':  szEscaped = "\\/";  break;
+					case '\b': szEscaped = "\\b";  break;
+					case '\f': szEscaped = "\\f";  break;
+					case '\n': szEscaped = "\\n";  break;
+					case '\r': szEscaped = "\\r";  break;
+					case '\t': szEscaped = "\\t";  break;
+					case '\'': if (bECMAConventions) { szEscaped = "\\'"; } break;
+					case '\v': if (bECMAConventions) { szEscaped = "\\v"; } break;
+					case '\0': if (bECMAConventions) { szEscaped = "\\0"; } break;
+					default:   ;;
+				}
+
+				if (szEscaped != NULL) { break; }
+
+				if (uCH < ' ' || (bHTMLSafe && (uCH == '<' || uCH == '>')))
+				{
+					szBuffer[0] = '\\';
+					szBuffer[1] = 'u';
+					szBuffer[2] = '0';
+					szBuffer[3] = '0';
+					szBuffer[4] = szJSONHex[uCH >> 4];
+					szBuffer[5] = szJSONHex[uCH & 0x0F];
+					return 6;
+				}
+
+				// Character of search superset, no escaping needed with this rules
+				szBuffer[0] = uCH;
+				return 1;
+			}
+	}
+
+	UINT_32 iLength = 0;
+	while (szEscaped[iLength] != '\0') { szBuffer[iLength] = szEscaped[iLength]; ++iLength; }
+
+return iLength;
+}
+
+//
+// Escape data, T is destination with methods Write(CCHAR_P, UINT_32), Reserve() and Commit(UINT_32)
+//
+template <eEscapeType eType, typename T> static void EscapeData(CCHAR_P            szData,
+                                                                const UINT_32      iDataLength,
+                                                                T                & oDestination)
+{
+	const UINT_32    iClass = EscapeClass(eType);
+	const UCHAR_8    iFlag  = 1 << iClass;
+	const ScanKernel pScan  = aScanKernels[iClass];
+
+	UINT_32 iPos = 0;
+	for (;;)
+	{
+		// Run of characters that need no escaping; short runs are checked inline, long ones by search kernel
+		UINT_32 iRunEnd = iPos;
+		const UINT_32 iInlineEnd = (iDataLength - iPos > C_ESCAPE_INLINE_SCAN) ? iPos + C_ESCAPE_INLINE_SCAN : iDataLength;
+		while (iRunEnd < iInlineEnd && (aEscapeTable[UCHAR_8(szData[iRunEnd])] & iFlag) == 0) { ++iRunEnd; }
+		if (iRunEnd == iInlineEnd && iRunEnd != iDataLength) { iRunEnd += pScan(szData + iRunEnd, iDataLength - iRunEnd); }
+
+		if (iRunEnd != iPos) { oDestination.Write(szData + iPos, iRunEnd - iPos); }
+
+		iPos = iRunEnd;
+		if (iPos == iDataLength) { break; }
+
+		oDestination.Commit(EscapeChar(eType, szData[iPos], oDestination.Reserve()));
+
+		++iPos;
+		if (iPos == iDataLength) { break; }
+	}
+}
+
+//
+// Escape data with rules known at compile time
+//
+template <typename T> static void EscapeDispatch(const eEscapeType  eType,
+                                                 CCHAR_P            szData,
+                                                 const UINT_32      iDataLength,
+                                                 T                & oDestination)
+{
+	switch (eType)
+	{
+		case ESCAPE_HTML:           EscapeData<ESCAPE_HTML>(szData, iDataLength, oDestination);           break;
+		case ESCAPE_XML:            EscapeData<ESCAPE_XML>(szData, iDataLength, oDestination);            break;
+		case ESCAPE_WML:            EscapeData<ESCAPE_WML>(szData, iDataLength, oDestination);            break;
+		case ESCAPE_URL:            EscapeData<ESCAPE_URL>(szData, iDataLength, oDestination);            break;
+		case ESCAPE_URI:            EscapeData<ESCAPE_URI>(szData, iDataLength, oDestination);            break;
+		case ESCAPE_JSON:           EscapeData<ESCAPE_JSON>(szData, iDataLength, oDestination);           break;
+		case ESCAPE_JSON_ECMA:      EscapeData<ESCAPE_JSON_ECMA>(szData, iDataLength, oDestination);      break;
+		case ESCAPE_JSON_HTML:      EscapeData<ESCAPE_JSON_HTML>(szData, iDataLength, oDestination);      break;
+		case ESCAPE_JSON_ECMA_HTML: EscapeData<ESCAPE_JSON_ECMA_HTML>(szData, iDataLength, oDestination); break;
+	}
+}
+
+//
+// Destination: buffer of sufficient size
+//
+struct EscapeBufferWriter
+{
+	CHAR_P  buffer;
+
+	void Write(CCHAR_P szData, const UINT_32 iDataLength)
+	{
+		memcpy(buffer, szData, iDataLength);
+		buffer += iDataLength;
+	}
+
+	CHAR_P Reserve() { return buffer; }
+
+	void Commit(const UINT_32 iDataLength) { buffer += iDataLength; }
+};
+
+//
+// Destination: string
+//
+struct EscapeStringWriter
+{
+	STLW::string  & result;
+
+	void Write(CCHAR_P szData, const UINT_32 iDataLength) { result.append(szData, iDataLength); }
+};
+
+//
+// Destination: output collector
+//
+struct EscapeCollectorWriter
+{
+	OutputCollector  & collector;
+
+	void Write(CCHAR_P szData, const UINT_32 iDataLength) { collector.Collect(szData, iDataLength); }
+};
+
+//
+// Short runs and escape sequences are collected to buffer, long runs are written to T as is
+//
+template <typename T> struct EscapeBufferedWriter
+{
+	T        & destination;
+	UINT_32    buffer_length;
+	CHAR_8     buffer[CTPP_ESCAPE_BUFFER_LEN];
+
+	EscapeBufferedWriter(T  & oIDestination): destination(oIDestination), buffer_length(0) { ;; }
+
+	void Write(CCHAR_P szData, const UINT_32 iDataLength)
+	{
+		if (buffer_length + iDataLength > CTPP_ESCAPE_BUFFER_LEN || iDataLength >= C_ESCAPE_MIN_DIRECT_RUN)
+		{
+			Flush();
+			if (iDataLength >= C_ESCAPE_MIN_DIRECT_RUN) { destination.Write(szData, iDataLength); return; }
+		}
+
+		// Most of runs between escaped characters are a few bytes long
+		if (iDataLength <= 16)
+		{
+			for (UINT_32 iPos = 0; iPos < iDataLength; ++iPos) { buffer[buffer_length + iPos] = szData[iPos]; }
+		}
+		else
+		{
+			memcpy(buffer + buffer_length, szData, iDataLength);
+		}
+		buffer_length += iDataLength;
+	}
+
+	CHAR_P Reserve()
+	{
+		if (buffer_length + C_ESCAPE_MAX_EXPANSION > CTPP_ESCAPE_BUFFER_LEN) { Flush(); }
+
+	return buffer + buffer_length;
+	}
+
+	void Commit(const UINT_32 iDataLength) { buffer_length += iDataLength; }
+
+	void Flush()
+	{
+		if (buffer_length != 0) { destination.Write(buffer, buffer_length); }
+		buffer_length = 0;
+	}
+};
+
+//
+// Escape data to T through buffer
+//
+template <typename T> static void EscapeBuffered(const eEscapeType  eType,
+                                                 CCHAR_P            szData,
+                                                 const UINT_32      iDataLength,
+                                                 T                & oDestination)
+{
+	// Nothing to escape
+	const UINT_32 iRunLength = EscapeScan(eType, szData, iDataLength);
+	if (iRunLength == iDataLength)
+	{
+		if (iDataLength != 0) { oDestination.Write(szData, iDataLength); }
+		return;
+	}
+
+	EscapeBufferedWriter<T> oWriter(oDestination);
+	oWriter.Write(szData, iRunLength);
+	EscapeDispatch(eType, szData + iRunLength, iDataLength - iRunLength, oWriter);
+	oWriter.Flush();
+}
+
+//
+// Escape data to buffer
+//
+UINT_32 Escape(const eEscapeType  eType,
+               CCHAR_P            szData,
+               const UINT_32      iDataLength,
+               CHAR_P             szBuffer)
+{
+	EscapeBufferWriter oWriter = { szBuffer };
+	EscapeDispatch(eType, szData, iDataLength, oWriter);
+
+return oWriter.buffer - szBuffer;
+}
+
+//
+// Escape data and append it to string
+//
+void Escape(const eEscapeType  eType,
+            CCHAR_P            szData,
+            const UINT_32      iDataLength,
+            STLW::string     & sResult)
+{
+	EscapeStringWriter oWriter = { sResult };
+	EscapeBuffered(eType, szData, iDataLength, oWriter);
+}
+
+//
+// Escape data and append it to dump buffer
+//
+void Escape(const eEscapeType  eType,
+            CCHAR_P            szData,
+            const UINT_32      iDataLength,
+            DumpBuffer       & oBuffer)
+{
+	EscapeBuffered(eType, szData, iDataLength, oBuffer);
+}
+
+//
+// Escape data and write it to output collector
+//
+void Escape(const eEscapeType  eType,
+            CCHAR_P            szData,
+            const UINT_32      iDataLength,
+            OutputCollector  & oCollector)
+{
+	EscapeCollectorWriter oWriter = { oCollector };
+	EscapeBuffered(eType, szData, iDataLength, oWriter);
+}
+
+//
+// Escape string representation of CDT value
+//
+template <typename T> static void EscapeCDT(const eEscapeType    eType,
+                                            const CDT          & oData,
+                                            T                  & oDestination)
+{
+	UINT_32  iLength = 0;
+	CCHAR_P  szData  = oData.GetStringData(iLength);
+	// Strings are escaped in place, everything else is converted first
+	if (szData != NULL) { Escape(eType, szData, iLength, oDestination); return; }
+
+	const STLW::string sData = oData.GetString();
+	Escape(eType, sData.data(), sData.size(), oDestination);
+}
+
+//
+// Escape string representation of CDT value and append it to string
+//
+void Escape(const eEscapeType  eType,
+            const CDT        & oData,
+            STLW::string     & sResult)
+{
+	EscapeCDT(eType, oData, sResult);
+}
+
+//
+// Escape string representation of CDT value and write it to output collector
+//
+void Escape(const eEscapeType  eType,
+            const CDT        & oData,
+            OutputCollector  & oCollector)
+{
+	EscapeCDT(eType, oData, oCollector);
+}
+
+} // namespace CTPP
+// End.
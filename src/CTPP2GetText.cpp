@@ -35,19 +35,17 @@
 #include "STLFunctional.hpp"
 #include "functions/FnGetText.hpp"
 
+#include <ctype.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-#include <errno.h>
-#include <stdio.h>
-#include <ctype.h>
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <libgen.h>
-#include <assert.h>
 
 #define LE_MAGIC 0x950412DE
 #define BE_MAGIC 0xDE120495
 
+// Size of .mo file header
+#define C_MO_HEADER_SIZE 28
+
 //#define _GETTEXT_PLURAL_DEBUG 1
 //#define _GETTEXT_USE_REPORTER 1
 
@@ -132,68 +130,6 @@ int Reporter::iLevel = 0;
 
 #endif // Reporter class
 
-
-/**
-  @class ScopeGuard
-  @brief Deallocate memory of pointer when go out from scope
-  @tparam type of pointer
-*/
-template<typename T>
-class ScopeGuard
-{
-	/** Type of function, that deallocate memory */
-	typedef void (*DeleteFuncType)(T *);
-
-public:
-	/**
-	  @brief Constructor
-	  @param p - pointer
-	  @param func - function for deleting pointer
-	*/
-    ScopeGuard(T *p, DeleteFuncType func = DefaultDeleteFunc) :
-        pData(p), deleteFunc(func) { ;; }
-
-	/**
-	  @brief Destructor
-	*/
-    ~ScopeGuard() throw() { if (pData) { deleteFunc(pData); } }
-
-	/**
-	  @brief Get pointer
-	  @return pointer
-    */
-    T * Get() const { return pData; }
-
-	/**
-	  @brief Release pointer
-	  @return pointer
-	*/
-    T * Release()
-	{
-        T * pTemp = pData;
-        pData = NULL;
-        return pTemp;
-    }
-
-private:
-	// Does not exist
-    ScopeGuard(const ScopeGuard &);
-    ScopeGuard & operator=(const ScopeGuard &);
-
-	/** Default function for deleting pointer */
-    static void DefaultDeleteFunc(T * p) { delete p; }
-
-	/** Pointer                               */
-	T * pData;
-	/** Function for deleting pointer         */
-	DeleteFuncType deleteFunc;
-};
-
-//
-// Deletes array
-//
-static void DeleteArrFunc(UCHAR_P pData) { delete[] pData; }
-
 //
 // Split string into vector of substrings by separator
 //
@@ -227,185 +163,417 @@ static void Trim(STLW::string & s)
 }
 
 //
-// A constructor
+// Swap bytes of 32-bit integer
 //
-CTPP2GetText::CTPP2GetText() { sDefaultDomain.assign("default"); }
+static UINT_32 Swap32(const UINT_32 iValue)
+{
+	return ((iValue >> 24) & 0x000000FF) |
+	       ((iValue >>  8) & 0x0000FF00) |
+	       ((iValue <<  8) & 0x00FF0000) |
+	       ((iValue << 24) & 0xFF000000);
+}
 
 //
-// A destructor
+// Hash function of GNU gettext (hashpjw), stops at zero byte as original one
 //
-CTPP2GetText::~CTPP2GetText() throw() { ;; }
+static UINT_32 HashString(CCHAR_P szString, const UINT_32 iLength)
+{
+	UINT_32 iHash = 0;
+	for (UINT_32 iI = 0; iI < iLength && szString[iI] != '\0'; ++iI)
+	{
+		iHash = (iHash << 4) + UCHAR_8(szString[iI]);
+
+		const UINT_32 iG = iHash & 0xF0000000;
+		if (iG != 0)
+		{
+			iHash ^= iG >> 24;
+			iHash ^= iG;
+		}
+	}
+
+return iHash;
+}
 
 //
-// Add translation
+// Get smallest prime number greater or equal to given one
 //
-void CTPP2GetText::AddTranslation(const STLW::string & sFileName, const STLW::string & sDomain, const STLW::string & sLang)
+static UINT_32 NextPrime(UINT_32 iNumber)
 {
-	UINT_32 iLength = 0;
-
-    ScopeGuard<UCHAR_8> pData(ReadFile(sFileName.c_str(), iLength), DeleteArrFunc);
+	for (;; ++iNumber)
+	{
+		bool bPrime = true;
+		for (UINT_32 iDivisor = 2; iDivisor * iDivisor <= iNumber; ++iDivisor)
+		{
+			if (iNumber % iDivisor == 0) { bPrime = false; break; }
+		}
 
-	sWorkableDomain = sDomain;
-	sWorkableLang = sLang;
+		if (bPrime) { return iNumber; }
+	}
+}
 
-	CTPP2Catalog & oCatalog = mCatalog[sWorkableLang][sWorkableDomain];
+//
+// A constructor
+//
+CTPP2GetTextCatalog::CTPP2GetTextCatalog(const STLW::string & sFileName,
+                                         const STLW::string & sIDomain): sDomain(sIDomain),
+                                                                         pData(NULL),
+                                                                         iDataLength(0),
+                                                                         bReversed(false),
+                                                                         pHashTable(NULL),
+                                                                         iHashSize(0),
+                                                                         bHashReversed(false),
+                                                                         iPluralStackSize(0),
+                                                                         iPluralInstructionsSize(0)
+{
+	ReadFile(sFileName);
+	ParseData(sFileName);
+}
 
-    UINT_32 iMagic = (reinterpret_cast<UINT_32 *>(pData.Get()))[0];
+//
+// Find message
+//
+INT_32 CTPP2GetTextCatalog::FindMessage(CCHAR_P szMessage, const UINT_32 iMessageLength) const
+{
+	// Open addressing with double hashing, as GNU gettext does
+	const UINT_32 iHash = HashString(szMessage, iMessageLength);
+	const UINT_32 iIncr = 1 + iHash % (iHashSize - 2);
+	UINT_32 iIdx = iHash % iHashSize;
 
-    switch (iMagic)
+	// Number of probes is limited in case of corrupted hash table
+	for (UINT_32 iProbe = 0; iProbe < iHashSize; ++iProbe)
 	{
-	case LE_MAGIC:
-		oCatalog.b_reversed = false;
-		break;
-	case BE_MAGIC:
-		oCatalog.b_reversed = true;
-		break;
-	default:
+		UINT_32 iEntry = pHashTable[iIdx];
+		if (bHashReversed) { iEntry = Swap32(iEntry); }
+
+		if (iEntry == 0) { return -1; }
+		--iEntry;
+
+		// Original of plural message is "singular\0plural"
+		if (iEntry < vOriginals.size())
 		{
-			STLW::string sMsg = sFileName + ": invalid MO file";
-			throw CTPPGetTextError(sMsg.c_str());
+			const CDTStringView & oOriginal = vOriginals[iEntry];
+			if (oOriginal.length >= iMessageLength                                              &&
+			    (oOriginal.length == iMessageLength || oOriginal.data[iMessageLength] == '\0') &&
+			    memcmp(oOriginal.data, szMessage, iMessageLength) == 0)
+			{
+				return INT_32(iEntry);
+			}
 		}
-		break;
+
+		if (iIdx >= iHashSize - iIncr) { iIdx -= iHashSize - iIncr; }
+		else                           { iIdx += iIncr;             }
 	}
 
-    UINT_32 iMsgCount = ReadMOData(pData.Get(), 8);
-    UINT_32 iMasteridx = ReadMOData(pData.Get(), 12);
-    UINT_32 iTransidx = ReadMOData(pData.Get(), 16);
+return -1;
+}
+
+//
+// Get translation of message
+//
+const CDTStringView * CTPP2GetTextCatalog::GetTranslation(const INT_32 iMessage, const UINT_32 iForm) const
+{
+	const UINT_32 iTranslation = vFirstTranslation[iMessage] + iForm;
+	if (iTranslation >= vFirstTranslation[iMessage + 1]) { return NULL; }
+
+return &vTranslations[iTranslation];
+}
 
-    for (UINT_32 iI = 0; iI < iMsgCount; ++iI)
+//
+// Get translation of message with correct plural form
+//
+const CDTStringView & CTPP2GetTextCatalog::GetPluralTranslation(const INT_32 iMessage, const UINT_32 iCount) const
+{
+	const CDTStringView * pTranslation = GetTranslation(iMessage, GetPluralForm(iCount));
+	if (pTranslation == NULL)
 	{
-        ExtractMessage(pData.Get(), iLength, iMasteridx, iTransidx);
-		iMasteridx += 2 * sizeof(UINT_32);
-		iTransidx += 2 * sizeof(UINT_32);
-    }
+		STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': failed to found plural form: " + vOriginals[iMessage].data;
+		throw CTPPGetTextError(sMsg.c_str());
+	}
 
-	sWorkableDomain.erase();
-	sWorkableLang.erase();
+return *pTranslation;
+}
+
+//
+// Calculate plural form of message
+//
+UINT_32 CTPP2GetTextCatalog::GetPluralForm(const UINT_32 iCount) const
+{
+	// No rule in .mo file, use default one of GNU gettext: n != 1
+	if (iPluralInstructionsSize == 0) { return iCount == 1 ? 0 : 1; }
 
-#if _GETTEXT_PLURAL_DEBUG
-	CatalogMap::const_iterator itmC = mCatalog.begin();
-	for (; itmC != mCatalog.end(); ++itmC)
+	UINT_32 aStack[C_GETTEXT_MAX_PLURAL_RULE];
+	UINT_32 iTop = iPluralStackSize;
+	for (UINT_32 iI = 0; iI < iPluralStackSize; ++iI)
 	{
-		fprintf(stdout, "============================================\n");
-		fprintf(stdout, "Language %s\n", itmC -> first.c_str());
-		fprintf(stdout, "============================================\n");
-		STLW::map<STLW::string, CTPP2Catalog>::const_iterator itm = itmC -> second;
-		for (; itm != itmC -> end(); ++itm)
+		aStack[iI] = aPluralVariable[iI] ? iCount : aPluralStack[iI];
+	}
+
+	UINT_32 iIP = 0;
+	while (iIP < iPluralInstructionsSize)
+	{
+		const UINT_32 eInstruction = aPluralInstructions[iIP];
+
+		// Operators pop 2 values, jumps pop condition, stack and instruction offsets
+		if (eInstruction != INS_NONE && iTop < (eInstruction < INS_JN ? 2 : 3)) { return 0; }
+
+#define CALCULATE_EXPR(N)                              \
+	do {                                               \
+		const UINT_32 iLeft  = aStack[iTop - 1];       \
+		const UINT_32 iRight = aStack[iTop - 2];       \
+		--iTop;                                        \
+		aStack[iTop - 1] = (N);                        \
+	} while(0)
+
+		switch (eInstruction)
 		{
-			fprintf(stdout, "CTPP2Catalog %s\n", itm -> first.c_str());
-			fprintf(stdout, "--------------------------------------------\n");
-			fprintf(stdout, "Charset: %s\n", itm -> second.s_charset.c_str());
-			fprintf(stdout, "Info:\n");
-			{
-				STLW::map<STLW::string, STLW::string>::const_iterator mit = itm -> second.m_info.begin();
-				for (; mit != itm -> second.m_info.end(); ++mit) {
-					fprintf(stdout, "\t%s: %s\n", mit -> first.c_str(), mit -> second.c_str());
-				}
-			}
-			fprintf(stdout, "Reversed: %d\n", itm -> second.b_reversed);
-			fprintf(stdout, "Messages:\n");
+		case INS_EQ:
+			CALCULATE_EXPR(iLeft == iRight);
+			break;
+		case INS_LE:
+			CALCULATE_EXPR(iLeft <= iRight);
+			break;
+		case INS_GE:
+			CALCULATE_EXPR(iLeft >= iRight);
+			break;
+		case INS_LT:
+			CALCULATE_EXPR(iLeft < iRight);
+			break;
+		case INS_GT:
+			CALCULATE_EXPR(iLeft > iRight);
+			break;
+		case INS_NE:
+			CALCULATE_EXPR(iLeft != iRight);
+			break;
+		case INS_MOD:
+			CALCULATE_EXPR(iRight == 0 ? 0 : iLeft % iRight);
+			break;
+#undef CALCULATE_EXPR
+		case INS_JLAND:
+		case INS_JLOR:
+		case INS_JN:
+		case INS_JMP:
 			{
-				STLW::map<STLW::string, STLW::vector<STLW::string> >::const_iterator itmM = itm -> second.m_messages.begin();
-				++itmM;
-				for (; itmM != itm -> second.m_messages.end(); ++itmM) {
-					fprintf(stdout, "\t'%s':\n", itmM -> first.c_str());
-					STLW::vector<STLW::string>::const_iterator vit = itmM -> second.begin();
-					for (; itv != itmM -> second.end(); ++itv) {
-						fprintf(stdout, "\t\t'%s' ", itv -> c_str());
-					}
-					fprintf(stdout, "\n");
+				const UINT_32 iValue       = aStack[iTop - 1];
+				const UINT_32 iStackOffset = aStack[iTop - 2];
+				const UINT_32 iInstrOffset = aStack[iTop - 3];
+				iTop -= 3;
+
+				// Skip operands and instructions of unused branch
+				if ((eInstruction == INS_JLAND && !iValue) ||
+				    (eInstruction == INS_JLOR  &&  iValue) ||
+				    (eInstruction == INS_JN    && !iValue) ||
+				     eInstruction == INS_JMP)
+				{
+					if (iStackOffset > iTop) { return 0; }
+
+					iTop -= iStackOffset;
+					iIP  += iInstrOffset;
+
+					// Result of logical operation or last value of ternary operator
+					if (eInstruction != INS_JN) { aStack[iTop++] = iValue; }
+					// Skip "else" jump
+					else                        { ++iIP;                   }
 				}
 			}
-			fprintf(stdout, "--------------------------------------------\n");
+			break;
+		default:
+			break;
 		}
-		fprintf(stdout, "============================================\n");
+		++iIP;
 	}
-#endif
+
+	if (iTop == 0) { return 0; }
+
+return aStack[iTop - 1];
 }
 
 //
-// Find translated message
+// Get charset of messages
 //
-STLW::string CTPP2GetText::FindMessage(const STLW::string & sLang, const STLW::string & sMessage, const STLW::string & sDomain_)
-{
-	STLW::string sDomain = sDomain_;
-	if (sDomain.empty()) { sDomain = sDefaultDomain; }
+const STLW::string & CTPP2GetTextCatalog::GetCharset() const { return sCharset; }
+
+//
+// A destructor
+//
+CTPP2GetTextCatalog::~CTPP2GetTextCatalog() throw() { ;; }
 
-	if (mCatalog.find(sLang) == mCatalog.end() || mCatalog[sLang].find(sDomain) == mCatalog[sLang].end()) { return sMessage; }
+// Parsing of .mo file ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-	typedef STLW::map<STLW::string, STLW::vector<STLW::string> > MessageMap;
-	MessageMap & oMessages = mCatalog[sLang][sDomain].m_messages;
-	MessageMap::const_iterator itM = oMessages.find(sMessage);
+//
+// Map or read .mo file
+//
+void CTPP2GetTextCatalog::ReadFile(const STLW::string & sFileName)
+{
+	try
+	{
+		oFile.Open(sFileName.c_str());
+	}
+	catch(CTPPUnixException & e)
+	{
+		STLW::string sMsg = sFileName + ": " + strerror(e.ErrNo());
+		throw CTPPGetTextError(sMsg.c_str());
+	}
+	catch(CTPPLogicError & e)
+	{
+		STLW::string sMsg = sFileName + ": " + e.what();
+		throw CTPPGetTextError(sMsg.c_str());
+	}
 
-	if (itM == oMessages.end()) { return sMessage; }
+	if (oFile.GetSize() < C_MO_HEADER_SIZE)
+	{
+		STLW::string sMsg = sFileName + ": invalid MO file";
+		throw CTPPGetTextError(sMsg.c_str());
+	}
 
-    return itM -> second[0];
+	pData       = reinterpret_cast<UCCHAR_P>(oFile.GetData());
+	iDataLength = oFile.GetSize();
 }
 
 //
-// Find translated message with correct plural form
+// Parse .mo data, build index
 //
-STLW::string CTPP2GetText::FindPluralMessage(const STLW::string & sLang, const STLW::string & sMessage,
-                                            const STLW::string & sPlMessage, UINT_32 iCount, const STLW::string & sDomain_)
+void CTPP2GetTextCatalog::ParseData(const STLW::string & sFileName)
 {
-	STLW::string sDomain = sDomain_;
-	if (sDomain.empty()) { sDomain = sDefaultDomain; }
+	switch (*reinterpret_cast<const UINT_32 *>(pData))
+	{
+	case LE_MAGIC:
+		bReversed = false;
+		break;
+	case BE_MAGIC:
+		bReversed = true;
+		break;
+	default:
+		{
+			STLW::string sMsg = sFileName + ": invalid MO file";
+			throw CTPPGetTextError(sMsg.c_str());
+		}
+		break;
+	}
 
-	if (mCatalog.find(sLang) == mCatalog.end() ||
-	    mCatalog[sLang].find(sDomain) == mCatalog[sLang].end() ||
-	    mCatalog[sLang][sDomain].m_messages.find(sMessage) == mCatalog[sLang][sDomain].m_messages.end())
+	const UINT_32 iMsgCount   = ReadMOData(8);
+	const UINT_32 iMasteridx  = ReadMOData(12);
+	const UINT_32 iTransidx   = ReadMOData(16);
+	const UINT_32 iMOHashSize = ReadMOData(20);
+	const UINT_32 iMOHashIdx  = ReadMOData(24);
+
+	if (UINT_64(iMasteridx) + UINT_64(iMsgCount) * 2 * sizeof(UINT_32) > iDataLength ||
+	    UINT_64(iTransidx)  + UINT_64(iMsgCount) * 2 * sizeof(UINT_32) > iDataLength)
 	{
-		if (iCount > 1) { return sPlMessage; }
-		else            { return sMessage;   }
+		STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': corrupted MO file";
+		throw CTPPGetTextError(sMsg.c_str());
 	}
 
-    UINT_32 iN = CalculatePluralForm(iCount, sLang, sDomain);
+	vOriginals.reserve(iMsgCount);
+	vFirstTranslation.reserve(iMsgCount + 1);
+	for (UINT_32 iI = 0; iI < iMsgCount; ++iI)
+	{
+		ExtractMessage(iMasteridx + iI * 2 * sizeof(UINT_32), iTransidx + iI * 2 * sizeof(UINT_32));
+	}
+	vFirstTranslation.push_back(UINT_32(vTranslations.size()));
 
-	typedef STLW::map<STLW::string, STLW::vector<STLW::string> > MessageMap;
-	MessageMap & oMessages = mCatalog[sLang][sDomain].m_messages;
-	MessageMap::const_iterator itM = oMessages.find(sMessage);
+	// Use hash table of .mo file, if any
+	if (iMOHashSize > 2 && iMOHashIdx % sizeof(UINT_32) == 0 &&
+	    UINT_64(iMOHashIdx) + UINT_64(iMOHashSize) * sizeof(UINT_32) <= iDataLength)
+	{
+		pHashTable    = reinterpret_cast<const UINT_32 *>(pData + iMOHashIdx);
+		iHashSize     = iMOHashSize;
+		bHashReversed = bReversed;
+	}
+	else
+	{
+		BuildHashTable();
+	}
 
-	if (iN >= itM -> second.size())
+	// Metadata is translation of empty message
+	const INT_32 iHeader = FindMessage("", 0);
+	if (iHeader != -1)
 	{
-		STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': failed to found plural form: " + sMessage;
-		throw CTPPGetTextError(sMsg.c_str());
+		const CDTStringView & oHeader = vTranslations[vFirstTranslation[iHeader]];
+		ParseMetadata(STLW::string(oHeader.data, oHeader.length));
 	}
-    return itM -> second[iN];
 }
 
 //
-// Set default i18n domain
+// Read .mo data by 4 bytes
 //
-void CTPP2GetText::SetDefaultDomain(const STLW::string & sDomain) { sDefaultDomain = sDomain; }
+UINT_32 CTPP2GetTextCatalog::ReadMOData(const UINT_32 iOffset) const
+{
+	const UINT_32 iValue = *reinterpret_cast<const UINT_32 *>(pData + iOffset);
+
+	if (bReversed) { return Swap32(iValue); }
+
+return iValue;
+}
 
 //
-// Initialize system calls FnGetText
+// Extract message from .mo data
 //
-void CTPP2GetText::InitSTDLibFunction(SyscallFactory & oSyscallFactory)
+void CTPP2GetTextCatalog::ExtractMessage(const UINT_32 iMasteridx, const UINT_32 iTransidx)
 {
-	FnGetText * pTMP = dynamic_cast<FnGetText *>(oSyscallFactory.GetHandlerByName("gettext"));
-	pTMP -> SetGetText(this);
-	pTMP = dynamic_cast<FnGetText *>(oSyscallFactory.GetHandlerByName("_"));
-	pTMP -> SetGetText(this);
+	const UINT_32 iMsgLen      = ReadMOData(iMasteridx);
+	const UINT_32 iMsgOffset   = ReadMOData(iMasteridx + sizeof(UINT_32));
+	const UINT_32 iTransLen    = ReadMOData(iTransidx);
+	const UINT_32 iTransOffset = ReadMOData(iTransidx + sizeof(UINT_32));
+
+	// Strings are zero-terminated
+	if (UINT_64(iMsgLen)   + iMsgOffset   >= iDataLength || pData[iMsgOffset   + iMsgLen]   != '\0' ||
+	    UINT_64(iTransLen) + iTransOffset >= iDataLength || pData[iTransOffset + iTransLen] != '\0')
+	{
+		STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': corrupted MO file";
+		throw CTPPGetTextError(sMsg.c_str());
+	}
+
+	const CDTStringView oOriginal = { reinterpret_cast<CCHAR_P>(pData + iMsgOffset), iMsgLen };
+	vOriginals.push_back(oOriginal);
+	vFirstTranslation.push_back(UINT_32(vTranslations.size()));
+
+	// Plural forms are separated by zero byte
+	CCHAR_P szForm = reinterpret_cast<CCHAR_P>(pData + iTransOffset);
+	CCHAR_P szEnd  = szForm + iTransLen;
+	for (;;)
+	{
+		CCHAR_P szFormEnd = static_cast<CCHAR_P>(memchr(szForm, '\0', szEnd - szForm));
+		if (szFormEnd == NULL) { szFormEnd = szEnd; }
+
+		const CDTStringView oTranslation = { szForm, UINT_32(szFormEnd - szForm) };
+		vTranslations.push_back(oTranslation);
+
+		if (szFormEnd == szEnd) { break; }
+		szForm = szFormEnd + 1;
+	}
 }
 
 //
-// Set language for system calls FnGetText/FnGetText_
+// Build own hash table for .mo file without it
 //
-void CTPP2GetText::SetLanguage(SyscallFactory & oSyscallFactory, const STLW::string & sLang)
+void CTPP2GetTextCatalog::BuildHashTable()
 {
-	FnGetText * pTMP = dynamic_cast<FnGetText *>(oSyscallFactory.GetHandlerByName("gettext"));
-	pTMP -> SetLanguage(sLang);
-	pTMP = dynamic_cast<FnGetText *>(oSyscallFactory.GetHandlerByName("_"));
-	pTMP -> SetLanguage(sLang);
-}
+	// Same size as msgfmt chooses: prime number, table is filled at most by 3/4
+	iHashSize = NextPrime(UINT_32(vOriginals.size()) * 4 / 3 + 3);
+	vHashTable.assign(iHashSize, 0);
 
-// Parsing of .mo file ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	for (UINT_32 iI = 0; iI < vOriginals.size(); ++iI)
+	{
+		const UINT_32 iHash = HashString(vOriginals[iI].data, vOriginals[iI].length);
+		const UINT_32 iIncr = 1 + iHash % (iHashSize - 2);
+		UINT_32 iIdx = iHash % iHashSize;
+
+		while (vHashTable[iIdx] != 0)
+		{
+			if (iIdx >= iHashSize - iIncr) { iIdx -= iHashSize - iIncr; }
+			else                           { iIdx += iIncr;             }
+		}
+		vHashTable[iIdx] = iI + 1;
+	}
+
+	pHashTable    = &vHashTable[0];
+	bHashReversed = false;
+}
 
 //
 // Parse line of metadata from .mo file
 //
-void CTPP2GetText::ParseMetadataLine(const STLW::string & sLine, STLW::string & sLastKey)
+void CTPP2GetTextCatalog::ParseMetadataLine(const STLW::string & sLine, STLW::string & sLastKey)
 {
 	STLW::string::size_type iLineDelimPos = sLine.find(":");
 	STLW::string sKey;
@@ -417,12 +585,12 @@ void CTPP2GetText::ParseMetadataLine(const STLW::string & sLine, STLW::string &
 		STLW::transform(sKey.begin(), sKey.end(), sKey.begin(), ::tolower);
 		sValue = sLine.substr(iLineDelimPos + 1);
 		Trim(sValue);
-		mCatalog[sWorkableLang][sWorkableDomain].m_info[sKey] = sValue;
+		mInfo[sKey] = sValue;
 		sLastKey = sKey;
 	}
 	else if (!sLastKey.empty())
 	{
-		mCatalog[sWorkableLang][sWorkableDomain].m_info[sLastKey] += "\n" + sLine;
+		mInfo[sLastKey] += "\n" + sLine;
 	}
 
 	if (sKey == "content-type")
@@ -430,7 +598,7 @@ void CTPP2GetText::ParseMetadataLine(const STLW::string & sLine, STLW::string &
 		STLW::string::size_type iCharsetPos = sValue.find("charset=");
 		if (iCharsetPos != STLW::string::npos)
 		{
-			mCatalog[sWorkableLang][sWorkableDomain].s_charset = sValue.substr(iCharsetPos + 8);
+			sCharset = sValue.substr(iCharsetPos + 8);
 		}
 	}
 	else if (sKey == "plural-forms")
@@ -445,7 +613,7 @@ void CTPP2GetText::ParseMetadataLine(const STLW::string & sLine, STLW::string &
 //
 // Parse metadata from .mo file
 //
-void CTPP2GetText::ParseMetadata(const STLW::string & sMeta)
+void CTPP2GetTextCatalog::ParseMetadata(const STLW::string & sMeta)
 {
 	STLW::string sLastKey;
 
@@ -459,111 +627,17 @@ void CTPP2GetText::ParseMetadata(const STLW::string & sMeta)
 	}
 }
 
-//
-// Read .mo data by 4 bytes
-//
-UINT_32 CTPP2GetText::ReadMOData(UCCHAR_P pData, INT_32 iOffset)
-{
-	const UINT_32 *p = reinterpret_cast<const UINT_32 *>(pData + iOffset);
-
-	if (mCatalog[sWorkableLang][sWorkableDomain].b_reversed)
-	{
-		UINT_32 i0 = (*p >>  0) & 0xFF;
-		UINT_32 i1 = (*p >>  8) & 0xFF;
-		UINT_32 i2 = (*p >> 16) & 0xFF;
-		UINT_32 i3 = (*p >> 24) & 0xFF;
-
-		return (i0 << 24) | (i1 << 16) | (i2 << 8) | i3;
-	}
-
-	return *p;
-}
-
-//
-// Read .mo file
-//
-UCHAR_P CTPP2GetText::ReadFile(CCHAR_P szFileName, UINT_32 &iLength)
-{
-    FILE * pFile = ::fopen(szFileName, "rb");
-    if (!pFile)
-	{
-		STLW::string sMsg = STLW::string(szFileName) + ": " + strerror(errno);
-		throw CTPPGetTextError(sMsg.c_str());
-	}
-
-    struct stat st;
-    if (::fstat(fileno(pFile), &st) == -1)
-	{
-		STLW::string sMsg = STLW::string(szFileName) + ": fstat failed";
-        throw CTPPGetTextError(sMsg.c_str());
-    }
-
-    ScopeGuard<UCHAR_8> pData(new UCHAR_8[st.st_size], DeleteArrFunc);
-
-    ::fseek(pFile, 0, SEEK_SET);
-
-    if (::fread(reinterpret_cast<void *>(pData.Get()), st.st_size, 1, pFile) < 1)
-	{
-		STLW::string sMsg = STLW::string(szFileName) + ": fread failed";
-        throw CTPPGetTextError(sMsg.c_str());
-    }
-
-	iLength = st.st_size;
-    return pData.Release();
-}
-
-//
-// Extract message from .mo data
-//
-void CTPP2GetText::ExtractMessage(UCCHAR_P pData, UINT_32 iLength, INT_32 iMasteridx, INT_32 iTransidx)
-{
-    UINT_32 iMsgLen = ReadMOData(pData, iMasteridx);
-    UINT_32 iMsgOffset = ReadMOData(pData, iMasteridx + sizeof(UINT_32));
-    UINT_32 iTransLen = ReadMOData(pData, iTransidx);
-    UINT_32 iTransOffset = ReadMOData(pData, iTransidx + sizeof(UINT_32));
-    if (iMsgLen + iMsgOffset >= iLength || iTransLen + iTransOffset >= iLength)
-	{
-		STLW::string sMsg = STLW::string("i18n domain '") + sWorkableDomain + "': corrupted MO file";
-        throw CTPPGetTextError(sMsg.c_str());
-    }
-
-    STLW::string sMessage(reinterpret_cast<CCHAR_P>(pData + iMsgOffset), iMsgLen);
-    STLW::string sTMessage(reinterpret_cast<CCHAR_P>(pData + iTransOffset), iTransLen);
-
-    if (iMsgLen == 0) { ParseMetadata(sTMessage); }
-
-	CTPP2Catalog & oCatalog = mCatalog[sWorkableLang][sWorkableDomain];
-    STLW::string::size_type iPos = sMessage.find("\x00");
-    if (iPos != STLW::string::npos)
-	{
-        STLW::vector<STLW::string> vMsgIds;
-        Split(sMessage, '\x00', vMsgIds);
-
-        STLW::vector<STLW::string> vTMsgIds;
-        Split(sTMessage, '\x00', vTMsgIds);
-
-		oCatalog.m_messages[vMsgIds[0]] = vTMsgIds;
-    }
-	else
-	{
-        STLW::vector<STLW::string> vTMsgIds;
-        vTMsgIds.push_back(sTMessage);
-		oCatalog.m_messages[sMessage] = vTMsgIds;
-    }
-}
-
 // Expressions for generating plural form rule ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 //
 // Term           = number | "n" | "(" TernaryExpr ")" | TernaryExpr
 //
-STLW::string::size_type CTPP2GetText::IsTerm(const STLW::string & sData, STLW::string::size_type iPos)
+STLW::string::size_type CTPP2GetTextCatalog::IsTerm(const STLW::string & sData, STLW::string::size_type iPos)
 {
 	REPORTER("IsTerm", sData, iPos);
 
 	if (iPos == STLW::string::npos) { return iPos; }
 
-	CTPP2Catalog & oCatalog = mCatalog[sWorkableLang][sWorkableDomain];
 	if (::isdigit(sData[iPos]))
 	{
 		STLW::string::size_type iDigitPos = iPos;
@@ -573,14 +647,14 @@ STLW::string::size_type CTPP2GetText::IsTerm(const STLW::string & sData, STLW::s
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "PUSH: %d\n", iDigit);
 #endif
-		oCatalog.v_pl_stack.push_back(CTPP2Data(iDigit));
+		PushPluralData(iDigit);
 	}
 	else if (sData[iPos] == 'n')
 	{
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "PUSH: n\n");
 #endif
-		oCatalog.v_pl_stack.push_back(CTPP2Data());
+		PushPluralData(0, true);
 		++iPos;
 	}
 	else if (sData[iPos] == '(')
@@ -588,7 +662,7 @@ fprintf(stdout, "PUSH: n\n");
 		++iPos;
 		if (iPos >= sData.size())
 		{
-			STLW::string sMsg = STLW::string("i18n domain '") + sWorkableDomain + "': plural rule parser error (1 IsTerm)";
+			STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': plural rule parser error (1 IsTerm)";
 			throw CTPPGetTextError(sMsg.c_str());
 		}
 
@@ -596,7 +670,7 @@ fprintf(stdout, "PUSH: n\n");
 
 		if (sData[iPos] != ')')
 		{
-			STLW::string sMsg = STLW::string("i18n domain '") + sWorkableDomain + "': plural rule parser error (2 IsTerm)";
+			STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': plural rule parser error (2 IsTerm)";
 			throw CTPPGetTextError(sMsg.c_str());
 		}
 		++iPos;
@@ -607,7 +681,7 @@ fprintf(stdout, "PUSH: n\n");
 
 		if (iNextPos == iPos)
 		{
-			STLW::string sMsg = STLW::string("i18n domain '") + sWorkableDomain + "': plural rule parser error (3 IsTerm)";
+			STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': plural rule parser error (3 IsTerm)";
 			throw CTPPGetTextError(sMsg.c_str());
 		}
 		iPos = iNextPos;
@@ -619,7 +693,7 @@ fprintf(stdout, "PUSH: n\n");
 //
 // ModExpr        = Term { "%" Term }
 //
-STLW::string::size_type CTPP2GetText::IsModExpr(const STLW::string & sData, STLW::string::size_type iPos)
+STLW::string::size_type CTPP2GetTextCatalog::IsModExpr(const STLW::string & sData, STLW::string::size_type iPos)
 {
 	REPORTER("IsModExr", sData, iPos);
 
@@ -631,14 +705,13 @@ STLW::string::size_type CTPP2GetText::IsModExpr(const STLW::string & sData, STLW
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "\t --> OPERATOR '%%'\n");
 #endif
-		CTPP2Catalog & oCatalog = mCatalog[sWorkableLang][sWorkableDomain];
 
-		oCatalog.v_pl_instructions.push_back(INS_MOD);
+		PushPluralInstruction(INS_MOD);
 
 		iPos = IsTerm(sData, iPos + 1);
 		if (iPos == STLW::string::npos)
 		{
-			STLW::string sMsg = STLW::string("i18n domain '") + sWorkableDomain + "': plural rule parser error (2 IsModExpr)";
+			STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': plural rule parser error (2 IsModExpr)";
 			throw CTPPGetTextError(sMsg.c_str());
 		}
 	}
@@ -649,14 +722,13 @@ fprintf(stdout, "\t --> OPERATOR '%%'\n");
 //
 // LtOrGtExpr     = ModExpr { LtOrGtRelation ModExpr }
 //
-STLW::string::size_type CTPP2GetText::IsLtOrGtExpr(const STLW::string & sData, STLW::string::size_type iPos)
+STLW::string::size_type CTPP2GetTextCatalog::IsLtOrGtExpr(const STLW::string & sData, STLW::string::size_type iPos)
 {
 	REPORTER("IsLtOrGtExpr", sData, iPos);
 
 	iPos = IsModExpr(sData, iPos);
 	if (iPos == STLW::string::npos) { return iPos; }
 
-	CTPP2Catalog & oCatalog = mCatalog[sWorkableLang][sWorkableDomain];
 
 	bool bHasRelation = true;
 	if (sData.find(">=", iPos) == iPos)
@@ -664,7 +736,7 @@ STLW::string::size_type CTPP2GetText::IsLtOrGtExpr(const STLW::string & sData, S
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "\t --> OPERATOR '>='\n");
 #endif
-		oCatalog.v_pl_instructions.push_back(INS_GE);
+		PushPluralInstruction(INS_GE);
 		iPos += 2;
 	}
 	else if (sData.find("<=", iPos) == iPos)
@@ -672,7 +744,7 @@ fprintf(stdout, "\t --> OPERATOR '>='\n");
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "\t --> OPERATOR '<='\n");
 #endif
-		oCatalog.v_pl_instructions.push_back(INS_LE);
+		PushPluralInstruction(INS_LE);
 		iPos += 2;
 	}
 	else if (sData[iPos] == '<')
@@ -680,7 +752,7 @@ fprintf(stdout, "\t --> OPERATOR '<='\n");
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "\t --> OPERATOR '<'\n");
 #endif
-		oCatalog.v_pl_instructions.push_back(INS_LT);
+		PushPluralInstruction(INS_LT);
 		++iPos;
 	}
 	else if (sData[iPos] == '>')
@@ -688,7 +760,7 @@ fprintf(stdout, "\t --> OPERATOR '<'\n");
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "\t --> OPERATOR '>'\n");
 #endif
-		oCatalog.v_pl_instructions.push_back(INS_GT);
+		PushPluralInstruction(INS_GT);
 		++iPos;
 	}
 	else
@@ -700,7 +772,7 @@ fprintf(stdout, "\t --> OPERATOR '>'\n");
 	{
 		if (iPos >= sData.size())
 		{
-			STLW::string sMsg = STLW::string("i18n domain '") + sWorkableDomain + "': plural rule parser error (1 IsLtOrGtExpr)";
+			STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': plural rule parser error (1 IsLtOrGtExpr)";
 			throw CTPPGetTextError(sMsg.c_str());
 		}
 		iPos = IsModExpr(sData, iPos);
@@ -712,14 +784,13 @@ fprintf(stdout, "\t --> OPERATOR '>'\n");
 //
 // EqExpr         = LtOrGtExpr { EqRelation LtOrGtExpr }
 //
-STLW::string::size_type CTPP2GetText::IsEqExpr(const STLW::string & sData, STLW::string::size_type iPos)
+STLW::string::size_type CTPP2GetTextCatalog::IsEqExpr(const STLW::string & sData, STLW::string::size_type iPos)
 {
 	REPORTER("IsEqExpr", sData, iPos);
 
 	iPos = IsLtOrGtExpr(sData, iPos);
 	if (iPos == STLW::string::npos) { return iPos; }
 
-	CTPP2Catalog & oCatalog = mCatalog[sWorkableLang][sWorkableDomain];
 
 	bool bHasRelation = true;
 	if (sData.find("==", iPos) == iPos)
@@ -727,7 +798,7 @@ STLW::string::size_type CTPP2GetText::IsEqExpr(const STLW::string & sData, STLW:
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "\t --> OPERATOR '=='\n");
 #endif
-		oCatalog.v_pl_instructions.push_back(INS_EQ);
+		PushPluralInstruction(INS_EQ);
 		iPos += 2;
 	}
 	else if (sData.find("!=", iPos) == iPos)
@@ -735,7 +806,7 @@ fprintf(stdout, "\t --> OPERATOR '=='\n");
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "\t --> OPERATOR '!='\n");
 #endif
-		oCatalog.v_pl_instructions.push_back(INS_NE);
+		PushPluralInstruction(INS_NE);
 		iPos += 2;
 	}
 	else
@@ -747,7 +818,7 @@ fprintf(stdout, "\t --> OPERATOR '!='\n");
 	{
 		if (iPos >= sData.size())
 		{
-			STLW::string sMsg = STLW::string("i18n domain '") + sWorkableDomain + "': plural rule parser error (1 IsEqExpr)";
+			STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': plural rule parser error (1 IsEqExpr)";
 			throw CTPPGetTextError(sMsg.c_str());
 		}
 		iPos = IsLtOrGtExpr(sData, iPos);
@@ -759,7 +830,7 @@ fprintf(stdout, "\t --> OPERATOR '!='\n");
 //
 // AndExpr        = EqExpr { "&&" AndExpr }
 //
-STLW::string::size_type CTPP2GetText::IsAndExpr(const STLW::string & sData, STLW::string::size_type iPos)
+STLW::string::size_type CTPP2GetTextCatalog::IsAndExpr(const STLW::string & sData, STLW::string::size_type iPos)
 {
 	REPORTER("IsAndExpr", sData, iPos);
 
@@ -772,38 +843,35 @@ STLW::string::size_type CTPP2GetText::IsAndExpr(const STLW::string & sData, STLW
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "\t --> JUMP IF '&&'\n");
 #endif
-		CTPP2Catalog & oCatalog = mCatalog[sWorkableLang][sWorkableDomain];
-		oCatalog.v_pl_instructions.push_back(INS_JLAND);
+		PushPluralInstruction(INS_JLAND);
 
-		oCatalog.v_pl_stack.push_back(0);
-		oCatalog.v_pl_stack.push_back(0);
-		UINT_32 iSIdx = oCatalog.v_pl_stack.size() - 2;
-		UINT_32 iIIdx = oCatalog.v_pl_stack.size() - 1;
+		const UINT_32 iSIdx = PushPluralData(0);
+		const UINT_32 iIIdx = PushPluralData(0);
 
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "PUSH: 0 (STACK OFFSET), IDX = %u\n", iSIdx);
 fprintf(stdout, "PUSH: 0 (INSTRUCTION OFFSET), IDX = %u\n", iIIdx);
 #endif
 
-		UINT_32 iPrevStackSize = oCatalog.v_pl_stack.size();
-		UINT_32 iPrevInstrSize = oCatalog.v_pl_instructions.size();
+		UINT_32 iPrevStackSize = iPluralStackSize;
+		UINT_32 iPrevInstrSize = iPluralInstructionsSize;
 		if (iPos >= sData.size())
 		{
-			STLW::string sMsg = STLW::string("i18n domain '") + sWorkableDomain + "': plural rule parser error (1 IsAndExpr)";
+			STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': plural rule parser error (1 IsAndExpr)";
 			throw CTPPGetTextError(sMsg.c_str());
 		}
 		iPos = IsAndExpr(sData, iPos + 2);
 
-		UINT_32 iStackSize = oCatalog.v_pl_stack.size();
-		UINT_32 iInstrSize = oCatalog.v_pl_instructions.size();
+		UINT_32 iStackSize = iPluralStackSize;
+		UINT_32 iInstrSize = iPluralInstructionsSize;
 
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "REPLACE: %u (STACK OFFSET), IDX = %u\n", iStackSize - iPrevStackSize, iSIdx);
 fprintf(stdout, "REPLACE: %u (INSTRUCTION OFFSET), IDX = %u\n", iInstrSize - iPrevInstrSize, iIIdx);
 #endif
 
-		oCatalog.v_pl_stack[iSIdx] = iStackSize - iPrevStackSize;
-		oCatalog.v_pl_stack[iIIdx] = iInstrSize - iPrevInstrSize;
+		aPluralStack[iSIdx] = iStackSize - iPrevStackSize;
+		aPluralStack[iIIdx] = iInstrSize - iPrevInstrSize;
 	}
 
 
@@ -813,7 +881,7 @@ fprintf(stdout, "REPLACE: %u (INSTRUCTION OFFSET), IDX = %u\n", iInstrSize - iPr
 //
 // OrExpr         = AndExpr { "||" OrExpr }
 //
-STLW::string::size_type CTPP2GetText::IsOrExpr(const STLW::string & sData, STLW::string::size_type iPos)
+STLW::string::size_type CTPP2GetTextCatalog::IsOrExpr(const STLW::string & sData, STLW::string::size_type iPos)
 {
 	REPORTER("IsOrExpr", sData, iPos);
 
@@ -826,38 +894,35 @@ STLW::string::size_type CTPP2GetText::IsOrExpr(const STLW::string & sData, STLW:
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "\t --> JUMP IF '||'\n");
 #endif
-		CTPP2Catalog & oCatalog = mCatalog[sWorkableLang][sWorkableDomain];
-		oCatalog.v_pl_instructions.push_back(INS_JLOR);
+		PushPluralInstruction(INS_JLOR);
 
-		oCatalog.v_pl_stack.push_back(0);
-		oCatalog.v_pl_stack.push_back(0);
-		UINT_32 iSIdx = oCatalog.v_pl_stack.size() - 2;
-		UINT_32 iIIdx = oCatalog.v_pl_stack.size() - 1;
+		const UINT_32 iSIdx = PushPluralData(0);
+		const UINT_32 iIIdx = PushPluralData(0);
 
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "PUSH: 0 (STACK OFFSET), IDX = %u\n", iSIdx);
 fprintf(stdout, "PUSH: 0 (INSTRUCTION OFFSET), IDX = %u\n", iIIdx);
 #endif
 
-		UINT_32 iPrevStackSize = oCatalog.v_pl_stack.size();
-		UINT_32 iPrevInstrSize = oCatalog.v_pl_instructions.size();
+		UINT_32 iPrevStackSize = iPluralStackSize;
+		UINT_32 iPrevInstrSize = iPluralInstructionsSize;
 		if (iPos >= sData.size())
 		{
-			STLW::string sMsg = STLW::string("i18n domain '") + sWorkableDomain + "': plural rule parser error (1 IsOrExpr)";
+			STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': plural rule parser error (1 IsOrExpr)";
 			throw CTPPGetTextError(sMsg.c_str());
 		}
 		iPos = IsOrExpr(sData, iPos + 2);
 
-		UINT_32 iStackSize = oCatalog.v_pl_stack.size();
-		UINT_32 iInstrSize = oCatalog.v_pl_instructions.size();
+		UINT_32 iStackSize = iPluralStackSize;
+		UINT_32 iInstrSize = iPluralInstructionsSize;
 
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "REPLACE: %u (STACK OFFSET), IDX = %u\n", iStackSize - iPrevStackSize, iSIdx);
 fprintf(stdout, "REPLACE: %u (INSTRUCTION OFFSET), IDX = %u\n", iInstrSize - iPrevInstrSize, iIIdx);
 #endif
 
-		oCatalog.v_pl_stack[iSIdx] = iStackSize - iPrevStackSize;
-		oCatalog.v_pl_stack[iIIdx] = iInstrSize - iPrevInstrSize;
+		aPluralStack[iSIdx] = iStackSize - iPrevStackSize;
+		aPluralStack[iIIdx] = iInstrSize - iPrevInstrSize;
 	}
 
 	return iPos;
@@ -866,7 +931,7 @@ fprintf(stdout, "REPLACE: %u (INSTRUCTION OFFSET), IDX = %u\n", iInstrSize - iPr
 //
 // TernaryExpr    = OrExpr { "?" TernaryExpr ":" TernaryExpr }
 //
-STLW::string::size_type CTPP2GetText::IsTernaryExpr(const STLW::string & sData, STLW::string::size_type iPos)
+STLW::string::size_type CTPP2GetTextCatalog::IsTernaryExpr(const STLW::string & sData, STLW::string::size_type iPos)
 {
 	REPORTER("IsTernaryExpr", sData, iPos);
 
@@ -879,37 +944,34 @@ STLW::string::size_type CTPP2GetText::IsTernaryExpr(const STLW::string & sData,
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "\t --> JUMP IF '?:'\n");
 #endif
-		CTPP2Catalog & oCatalog = mCatalog[sWorkableLang][sWorkableDomain];
-		oCatalog.v_pl_instructions.push_back(INS_JN);
+		PushPluralInstruction(INS_JN);
 
-		oCatalog.v_pl_stack.push_back(0);
-		oCatalog.v_pl_stack.push_back(0);
-		UINT_32 iJNSIdx = oCatalog.v_pl_stack.size() - 2;
-		UINT_32 iJNIIdx = oCatalog.v_pl_stack.size() - 1;
+		const UINT_32 iJNSIdx = PushPluralData(0);
+		const UINT_32 iJNIIdx = PushPluralData(0);
 
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "PUSH: 0 (STACK OFFSET), IDX = %u\n", iJNSIdx);
 fprintf(stdout, "PUSH: 0 (INSTRUCTION OFFSET), IDX = %u\n", iJNIIdx);
 #endif
 
-		UINT_32 iPrevStackSize = oCatalog.v_pl_stack.size();
-		UINT_32 iPrevInstrSize = oCatalog.v_pl_instructions.size();
+		UINT_32 iPrevStackSize = iPluralStackSize;
+		UINT_32 iPrevInstrSize = iPluralInstructionsSize;
 		if (iPos >= sData.size())
 		{
-			STLW::string sMsg = STLW::string("i18n domain '") + sWorkableDomain + "': plural rule parser error (1 IsTernaryExpr)";
+			STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': plural rule parser error (1 IsTernaryExpr)";
 			throw CTPPGetTextError(sMsg.c_str());
 		}
 
 		iPos = IsTernaryExpr(sData, iPos + 1);
 
-		UINT_32 iStackSize = oCatalog.v_pl_stack.size();
-		UINT_32 iInstrSize = oCatalog.v_pl_instructions.size();
+		UINT_32 iStackSize = iPluralStackSize;
+		UINT_32 iInstrSize = iPluralInstructionsSize;
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "REPLACE: %u (STACK OFFSET), IDX = %u\n", iStackSize - iPrevStackSize + 2, iJNSIdx);
 fprintf(stdout, "REPLACE: %u (INSTRUCTION OFFSET), IDX = %u\n", iInstrSize - iPrevInstrSize, iJNIIdx);
 #endif
-		oCatalog.v_pl_stack[iJNSIdx] = iStackSize - iPrevStackSize + 2;
-		oCatalog.v_pl_stack[iJNIIdx] = iInstrSize - iPrevInstrSize;
+		aPluralStack[iJNSIdx] = iStackSize - iPrevStackSize + 2;
+		aPluralStack[iJNIIdx] = iInstrSize - iPrevInstrSize;
 
 		if (sData[iPos] == ':')
 		{
@@ -919,37 +981,35 @@ fprintf(stdout, "\t --> JUMP\n");
 			++iPos;
 			if (iPos >= sData.size())
 			{
-				STLW::string sMsg = STLW::string("i18n domain '") + sWorkableDomain + "': plural rule parser error (2 IsTernaryExpr)";
+				STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': plural rule parser error (2 IsTernaryExpr)";
 				throw CTPPGetTextError(sMsg.c_str());
 			}
 
-			oCatalog.v_pl_instructions.push_back(INS_JMP);
+			PushPluralInstruction(INS_JMP);
 
-			oCatalog.v_pl_stack.push_back(0);
-			oCatalog.v_pl_stack.push_back(0);
-			UINT_32 iJMPSIdx = oCatalog.v_pl_stack.size() - 2;
-			UINT_32 iJMPIIdx = oCatalog.v_pl_stack.size() - 1;
+			const UINT_32 iJMPSIdx = PushPluralData(0);
+			const UINT_32 iJMPIIdx = PushPluralData(0);
 
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "PUSH: 0 (STACK OFFSET), IDX = %u\n", iJMPSIdx);
 fprintf(stdout, "PUSH: 0 (INSTRUCTION OFFSET), IDX = %u\n", iJMPIIdx);
 #endif
 
-			iPrevStackSize = oCatalog.v_pl_stack.size();
-			iPrevInstrSize = oCatalog.v_pl_instructions.size();
+			iPrevStackSize = iPluralStackSize;
+			iPrevInstrSize = iPluralInstructionsSize;
 			iPos = IsTernaryExpr(sData, iPos);
-			iStackSize = oCatalog.v_pl_stack.size();
-			iInstrSize = oCatalog.v_pl_instructions.size();
+			iStackSize = iPluralStackSize;
+			iInstrSize = iPluralInstructionsSize;
 #ifdef _GETTEXT_PLURAL_DEBUG
 fprintf(stdout, "REPLACE: %u (STACK OFFSET), IDX = %u\n", iStackSize - iPrevStackSize, iJMPSIdx);
 fprintf(stdout, "REPLACE: %u (INSTRUCTION OFFSET), IDX = %u\n", iInstrSize - iPrevInstrSize, iJMPIIdx);
 #endif
-			oCatalog.v_pl_stack[iJMPSIdx] = iStackSize - iPrevStackSize;
-			oCatalog.v_pl_stack[iJMPIIdx] = iInstrSize - iPrevInstrSize;
+			aPluralStack[iJMPSIdx] = iStackSize - iPrevStackSize;
+			aPluralStack[iJMPIIdx] = iInstrSize - iPrevInstrSize;
 		}
 		else
 		{
-			STLW::string sMsg = STLW::string("i18n domain '") + sWorkableDomain + "': plural rule parser error (3 IsTernaryExpr)";
+			STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': plural rule parser error (3 IsTernaryExpr)";
 			throw CTPPGetTextError(sMsg.c_str());
 		}
 	}
@@ -960,294 +1020,61 @@ fprintf(stdout, "REPLACE: %u (INSTRUCTION OFFSET), IDX = %u\n", iInstrSize - iPr
 // Other stuff ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 //
-// Calculate plural form of message
+// Add data item to plural form rule
 //
-UINT_32 CTPP2GetText::CalculatePluralForm(UINT_32 iCount, const STLW::string & sLang, const STLW::string & sDomain)
+UINT_32 CTPP2GetTextCatalog::PushPluralData(const UINT_32 iValue, const bool bVariable)
 {
-	STLW::vector<UINT_32> vStack;
-	CTPP2Catalog & oCatalog = mCatalog[sLang][sDomain];
-	vStack.reserve(oCatalog.v_pl_stack.size());
-
-	STLW::vector<CTPP2Data>::reverse_iterator itvSrc = oCatalog.v_pl_stack.rbegin();
-	for (; itvSrc != oCatalog.v_pl_stack.rend(); ++itvSrc)
+	if (iPluralStackSize == C_GETTEXT_MAX_PLURAL_RULE)
 	{
-		if (itvSrc -> b_variable) { vStack.push_back(iCount);            }
-		else                      { vStack.push_back(itvSrc -> i_value); }
-	}
-
-#ifdef _GETTEXT_PLURAL_DEBUG
-	fprintf(stdout, "==>");
-	for (STLW::vector<eCTPP2Instruction>::iterator it = oCatalog.v_pl_instructions.begin();
-		it != oCatalog.v_pl_instructions.end(); ++it)
-	{
-			fprintf(stdout, " %s", StringifyInstruction(*it));
+		STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': plural rule is too long";
+		throw CTPPGetTextError(sMsg.c_str());
 	}
-	fprintf(stdout, " <==\n");
-#endif
-
-	STLW::vector<eCTPP2Instruction>::iterator itvPluralInstrs = oCatalog.v_pl_instructions.begin();
-	while (itvPluralInstrs != oCatalog.v_pl_instructions.end())
-	{
-#ifdef _GETTEXT_PLURAL_DEBUG
-		fprintf(stdout, "\t --> INSTRUCTION: %s\n", StringifyInstruction(*itvPluralInstrs));
-		fprintf(stdout, "\t --> STACK DUMP: ");
-		for (INT_32 iN = vStack.size() - 1; iN >= 0; --iN) { fprintf(stdout, "%u, ", vStack[iN]); }
-		fprintf(stdout, "\n");
-#endif
-
-#ifdef _GETTEXT_PLURAL_DEBUG
-#define CALCULATE_EXPR(N)                                      \
-	do {                                                       \
-		UINT_32 iLeft = vStack.back();                         \
-		fprintf(stdout, "POP: %u (iLeft)\n", iLeft);           \
-		vStack.pop_back();                                     \
-		UINT_32 iRight = vStack.back();                        \
-		fprintf(stdout, "POP: %u (iRight)\n", iRight);         \
-		vStack.pop_back();			                           \
-		vStack.push_back(N);                                   \
-		fprintf(stdout, "PUSH: %u (RESULT OF '%s')\n", N, #N); \
-	} while(0)
-#else
-#define CALCULATE_EXPR(N)                                      \
-	do {                                                       \
-		UINT_32 iLeft = vStack.back();                         \
-		vStack.pop_back();                                     \
-		UINT_32 iRight = vStack.back();                        \
-		vStack.pop_back();			                           \
-		vStack.push_back(N);                                   \
-	} while(0)
-#endif
-
-		switch (*itvPluralInstrs)
-		{
-		case INS_EQ:
-			CALCULATE_EXPR(iLeft == iRight);
-			break;
-		case INS_LE:
-			CALCULATE_EXPR(iLeft <= iRight);
-			break;
-		case INS_GE:
-			CALCULATE_EXPR(iLeft >= iRight);
-			break;
-		case INS_LT:
-			CALCULATE_EXPR(iLeft < iRight);
-			break;
-		case INS_GT:
-			CALCULATE_EXPR(iLeft > iRight);
-			break;
-		case INS_NE:
-			CALCULATE_EXPR(iLeft != iRight);
-			break;
-		case INS_MOD:
-			CALCULATE_EXPR(iLeft % iRight);
-			break;
-#undef CALCULATE_EXPR
-		case INS_JLAND:
-			{
-				UINT_32 iCond = vStack.back();
-				vStack.pop_back();
-#ifdef _GETTEXT_PLURAL_DEBUG
-				fprintf(stdout, "POP: %u (JLAND CONDITION)\n", iCond);
-#endif
 
-				UINT_32 iStackOffset = vStack.back();
-#ifdef _GETTEXT_PLURAL_DEBUG
-				fprintf(stdout, "POP: %u (STACK OFFSET)\n", iStackOffset);
-#endif
-				vStack.pop_back();
-				UINT_32 iInstrOffset = vStack.back();
-#ifdef _GETTEXT_PLURAL_DEBUG
-				fprintf(stdout, "POP: %u (INSTRUCTION OFFSET)\n", iInstrOffset);
-#endif
-				vStack.pop_back();
+	aPluralStack[iPluralStackSize]    = iValue;
+	aPluralVariable[iPluralStackSize] = bVariable;
 
-				if (!iCond)
-				{
-#ifdef _GETTEXT_PLURAL_DEBUG
-					STLW::vector<UINT_32>::const_reverse_iterator itvStack = vStack.rbegin();
-					for (INT_32 iN = vStack.size() - iStackOffset; itvStack != vStack.rend() && iN < vStack.size() ; ++iN)
-					{
-						fprintf(stdout, "POP: %d (JLAND UNUSED)\n", *itvStack);
-					}
-#endif
-					vStack.resize(vStack.size() - iStackOffset);
-					for (UINT_32 iI = 0; iI < iInstrOffset; ++iI)
-					{
-#ifdef _GETTEXT_PLURAL_DEBUG
-						assert(itvPluralInstrs != oCatalog.v_pl_instructions.end());
-#endif
-						++itvPluralInstrs;
-#ifdef _GETTEXT_PLURAL_DEBUG
-						fprintf(stdout, "\t --> INSTRUCTION (SKIP): %s\n",
-						        StringifyInstruction(*itvPluralInstrs));
-#endif
-					}
-#ifdef _GETTEXT_PLURAL_DEBUG
-					fprintf(stdout, "PUSH: %u (JLAND CONDITION)\n", iCond);
-#endif
-					vStack.push_back(iCond);
-				}
-			}
-			break;
-		case INS_JLOR:
-			{
-				UINT_32 iCond = vStack.back();
-#ifdef _GETTEXT_PLURAL_DEBUG
-				fprintf(stdout, "POP: %u (JLOR CONDITION)\n", iCond);
-#endif
-				vStack.pop_back();
-
-				UINT_32 iStackOffset = vStack.back();
-#ifdef _GETTEXT_PLURAL_DEBUG
-				fprintf(stdout, "POP: %u (STACK OFFSET)\n", iStackOffset);
-#endif
-				vStack.pop_back();
-				UINT_32 iInstrOffset = vStack.back();
-#ifdef _GETTEXT_PLURAL_DEBUG
-				fprintf(stdout, "POP: %u (INSTRUCTION OFFSET)\n", iInstrOffset);
-#endif
-				vStack.pop_back();
-
-				if (iCond)
-				{
-#ifdef _GETTEXT_PLURAL_DEBUG
-					STLW::vector<UINT_32>::const_reverse_iterator itvStack = vStack.rbegin();
-					for (INT_32 iN = vStack.size() - iStackOffset; itvStack != vStack.rend() && iN < vStack.size() ; ++iN)
-					{
-						fprintf(stdout, "POP: %d (JLOR UNUSED)\n", *itvStack);
-					}
-#endif
-					vStack.resize(vStack.size() - iStackOffset);
-					for (UINT_32 iI = 0; iI < iInstrOffset; ++iI)
-					{
-#ifdef _GETTEXT_PLURAL_DEBUG
-						assert(itvPluralInstrs != oCatalog.v_pl_instructions.end());
-#endif
-						++itvPluralInstrs;
-#ifdef _GETTEXT_PLURAL_DEBUG
-						fprintf(stdout, "\t --> INSTRUCTION (SKIP): %s\n", StringifyInstruction(*itvPluralInstrs));
-#endif
-					}
-#ifdef _GETTEXT_PLURAL_DEBUG
-					fprintf(stdout, "PUSH: %u (JLAND CONDITION)\n", iCond);
-#endif
-					vStack.push_back(iCond);
-				}
-			}
-			break;
-		case INS_JN:
-			{
-				UINT_32 iCond = vStack.back();
-#ifdef _GETTEXT_PLURAL_DEBUG
-				fprintf(stdout, "POP: %u (JN CONDITION)\n", iCond);
-#endif
-				vStack.pop_back();
-
-				UINT_32 iStackOffset = vStack.back();
-#ifdef _GETTEXT_PLURAL_DEBUG
-				fprintf(stdout, "POP: %u (STACK OFFSET)\n", iStackOffset);
-#endif
-				vStack.pop_back();
-				UINT_32 iInstrOffset = vStack.back();
-#ifdef _GETTEXT_PLURAL_DEBUG
-				fprintf(stdout, "POP: %u (INSTRUCTION OFFSET)\n", iInstrOffset);
-#endif
-				vStack.pop_back();
-
-				if (!iCond)
-				{
-#ifdef _GETTEXT_PLURAL_DEBUG
-					STLW::vector<UINT_32>::const_reverse_iterator itvStack = vStack.rbegin();
-					for (INT_32 iN = vStack.size() - iStackOffset; itvStack != vStack.rend() && iN < vStack.size() ; ++iN)
-					{
-						fprintf(stdout, "POP: %d (JN UNUSED)\n", *itvStack);
-					}
-#endif
-					vStack.resize(vStack.size() - iStackOffset);
-					for (UINT_32 iI = 0; iI < iInstrOffset + 1; ++iI)
-					{
-#ifdef _GETTEXT_PLURAL_DEBUG
-						assert(itvPluralInstrs != oCatalog.v_pl_instructions.end());
-#endif
-						++itvPluralInstrs;
-#ifdef _GETTEXT_PLURAL_DEBUG
-						fprintf(stdout, "\t --> INSTRUCTION (SKIP): %s\n", StringifyInstruction(*itvPluralInstrs));
-#endif
-					}
-				}
-			}
-			break;
-		case INS_JMP:
-			{
-				INT_32 iLastValue = vStack.back();
-				vStack.pop_back();
-#ifdef _GETTEXT_PLURAL_DEBUG
-				fprintf(stdout, "POP: %u (LAST VALUE)\n", iLastValue);
-#endif
-
-				UINT_32 iStackOffset = vStack.back();
-#ifdef _GETTEXT_PLURAL_DEBUG
-				fprintf(stdout, "POP: %u (STACK OFFSET)\n", iStackOffset);
-#endif
-				vStack.pop_back();
-				UINT_32 iInstrOffset = vStack.back();
-#ifdef _GETTEXT_PLURAL_DEBUG
-				fprintf(stdout, "POP: %u (INSTRUCTION OFFSET)\n", iInstrOffset);
-#endif
-				vStack.pop_back();
+return iPluralStackSize++;
+}
 
-#ifdef _GETTEXT_PLURAL_DEBUG
-				STLW::vector<UINT_32>::const_reverse_iterator itvStack = vStack.rbegin();
-				for (INT_32 iN = vStack.size() - iStackOffset; itvStack != vStack.rend() && iN < vStack.size() ; ++iN)
-				{
-					fprintf(stdout, "POP: %d (JMP UNUSED)\n", *itvStack);
-				}
-#endif
-				vStack.resize(vStack.size() - iStackOffset);
-				for (UINT_32 iI = 0; iI < iInstrOffset; ++iI)
-				{
-#ifdef _GETTEXT_PLURAL_DEBUG
-					assert(itvPluralInstrs != oCatalog.v_pl_instructions.end());
-#endif
-					++itvPluralInstrs;
-#ifdef _GETTEXT_PLURAL_DEBUG
-					fprintf(stdout, "\t --> INSTRUCTION (SKIP): %s\n", StringifyInstruction(*itvPluralInstrs));
-#endif
-				}
-#ifdef _GETTEXT_PLURAL_DEBUG
-				fprintf(stdout, "PUSH: %u (LAST VALUE)\n", iLastValue);
-#endif
-				vStack.push_back(iLastValue);
-			}
-			break;
-		default:
-			break;
-		}
-		++itvPluralInstrs;
+//
+// Add instruction to plural form rule
+//
+void CTPP2GetTextCatalog::PushPluralInstruction(const eCTPP2Instruction eType)
+{
+	if (iPluralInstructionsSize == C_GETTEXT_MAX_PLURAL_RULE)
+	{
+		STLW::string sMsg = STLW::string("i18n domain '") + sDomain + "': plural rule is too long";
+		throw CTPPGetTextError(sMsg.c_str());
 	}
 
-#ifdef _GETTEXT_PLURAL_DEBUG
-	fprintf(stdout, "Stack size: %u\n", vStack.size());
-	for (UINT_32 idx = 0; idx < vStack.size(); ++idx) { fprintf(stdout, "--> %u\n", vStack[idx]); }
-#endif
-	return vStack.back();
+	aPluralInstructions[iPluralInstructionsSize++] = eType;
 }
 
 //
 // Generate plural form rule
 //
-void CTPP2GetText::GeneratePluralRule(const STLW::string & sPluralRule)
+void CTPP2GetTextCatalog::GeneratePluralRule(const STLW::string & sPluralRule)
 {
 	STLW::string s = sPluralRule;
 	s.erase(STLW::remove_if(s.begin(), s.end(), ::isspace), s.end());
 	IsTernaryExpr(s, 0);
-	mCatalog[sWorkableLang][sWorkableDomain].v_pl_instructions.push_back(INS_NONE);
+	PushPluralInstruction(INS_NONE);
+
+	// Data are taken from the end of stack, reverse them once instead of every calculation
+	STLW::reverse(aPluralStack,    aPluralStack    + iPluralStackSize);
+	STLW::reverse(aPluralVariable, aPluralVariable + iPluralStackSize);
+
+#ifdef _GETTEXT_PLURAL_DEBUG
+	fprintf(stdout, "==>");
+	for (UINT_32 iI = 0; iI < iPluralInstructionsSize; ++iI) { fprintf(stdout, " %s", StringifyInstruction(aPluralInstructions[iI])); }
+	fprintf(stdout, " <==\n");
+#endif
 }
 
 //
 // Stringify instruction for determining plural form
 //
-CCHAR_P CTPP2GetText::StringifyInstruction(eCTPP2Instruction eType)
+CCHAR_P CTPP2GetTextCatalog::StringifyInstruction(const UINT_32 eType)
 {
 	switch (eType)
 	{
@@ -1280,5 +1107,153 @@ CCHAR_P CTPP2GetText::StringifyInstruction(eCTPP2Instruction eType)
 	}
 }
 
+//
+// A constructor
+//
+CTPP2GetText::CTPP2GetText(): sDefaultDomain("default"), iRevision(0) { ;; }
+
+//
+// A destructor
+//
+CTPP2GetText::~CTPP2GetText() throw()
+{
+	CatalogMap::iterator itmLang = mCatalog.begin();
+	for (; itmLang != mCatalog.end(); ++itmLang)
+	{
+		DomainMap::iterator itmDomain = itmLang -> second.begin();
+		for (; itmDomain != itmLang -> second.end(); ++itmDomain)
+		{
+			CatalogList::iterator itvCatalog = itmDomain -> second.begin();
+			for (; itvCatalog != itmDomain -> second.end(); ++itvCatalog) { delete *itvCatalog; }
+		}
+	}
+}
+
+//
+// Add translation
+//
+void CTPP2GetText::AddTranslation(const STLW::string & sFileName, const STLW::string & sDomain, const STLW::string & sLang)
+{
+	CTPP2GetTextCatalog * pCatalog = new CTPP2GetTextCatalog(sFileName, sDomain);
+
+	// Messages of most recently added file take precedence
+	CatalogList & vCatalogs = mCatalog[sLang][sDomain];
+	vCatalogs.insert(vCatalogs.begin(), pCatalog);
+	++iRevision;
+}
+
+//
+// Find translated message
+//
+STLW::string CTPP2GetText::FindMessage(const STLW::string & sLang, const STLW::string & sMessage, const STLW::string & sDomain) const
+{
+	INT_32 iMessage = -1;
+	const CTPP2GetTextCatalog * pCatalog = FindCatalog(GetCatalogs(GetDomains(sLang), sDomain), sMessage.data(), UINT_32(sMessage.size()), iMessage);
+	if (pCatalog == NULL) { return sMessage; }
+
+	const CDTStringView * pTranslation = pCatalog -> GetTranslation(iMessage, 0);
+
+return STLW::string(pTranslation -> data, pTranslation -> length);
+}
+
+//
+// Find translated message with correct plural form
+//
+STLW::string CTPP2GetText::FindPluralMessage(const STLW::string & sLang, const STLW::string & sMessage,
+                                            const STLW::string & sPlMessage, UINT_32 iCount, const STLW::string & sDomain) const
+{
+	INT_32 iMessage = -1;
+	const CTPP2GetTextCatalog * pCatalog = FindCatalog(GetCatalogs(GetDomains(sLang), sDomain), sMessage.data(), UINT_32(sMessage.size()), iMessage);
+	if (pCatalog == NULL)
+	{
+		if (iCount > 1) { return sPlMessage; }
+		else            { return sMessage;   }
+	}
+
+	const CDTStringView & oTranslation = pCatalog -> GetPluralTranslation(iMessage, iCount);
+
+return STLW::string(oTranslation.data, oTranslation.length);
+}
+
+//
+// Get catalogs of language
+//
+const CTPP2GetText::DomainMap * CTPP2GetText::GetDomains(const STLW::string & sLang) const
+{
+	CatalogMap::const_iterator itmLang = mCatalog.find(sLang);
+	if (itmLang == mCatalog.end()) { return NULL; }
+
+return &(itmLang -> second);
+}
+
+//
+// Get catalogs of i18n domain
+//
+const CTPP2GetText::CatalogList * CTPP2GetText::GetCatalogs(const DomainMap * pDomains, const STLW::string & sDomain) const
+{
+	if (pDomains == NULL) { return NULL; }
+
+	DomainMap::const_iterator itmDomain = pDomains -> find(sDomain.empty() ? sDefaultDomain : sDomain);
+	if (itmDomain == pDomains -> end()) { return NULL; }
+
+return &(itmDomain -> second);
+}
+
+//
+// Find message in list of catalogs
+//
+const CTPP2GetTextCatalog * CTPP2GetText::FindCatalog(const CatalogList  * pCatalogs,
+                                                      CCHAR_P              szMessage,
+                                                      const UINT_32        iMessageLength,
+                                                      INT_32             & iMessage)
+{
+	if (pCatalogs == NULL) { return NULL; }
+
+	CatalogList::const_iterator itvCatalog = pCatalogs -> begin();
+	for (; itvCatalog != pCatalogs -> end(); ++itvCatalog)
+	{
+		iMessage = (*itvCatalog) -> FindMessage(szMessage, iMessageLength);
+		if (iMessage != -1) { return *itvCatalog; }
+	}
+
+return NULL;
+}
+
+//
+// Set default i18n domain
+//
+void CTPP2GetText::SetDefaultDomain(const STLW::string & sDomain)
+{
+	sDefaultDomain = sDomain;
+	++iRevision;
+}
+
+//
+// Get revision of catalogs
+//
+UINT_32 CTPP2GetText::GetRevision() const { return iRevision; }
+
+//
+// Initialize system calls FnGetText
+//
+void CTPP2GetText::InitSTDLibFunction(SyscallFactory & oSyscallFactory)
+{
+	FnGetText * pTMP = dynamic_cast<FnGetText *>(oSyscallFactory.GetHandlerByName("gettext"));
+	pTMP -> SetGetText(this);
+	pTMP = dynamic_cast<FnGetText *>(oSyscallFactory.GetHandlerByName("_"));
+	pTMP -> SetGetText(this);
+}
+
+//
+// Set language for system calls FnGetText/FnGetText_
+//
+void CTPP2GetText::SetLanguage(SyscallFactory & oSyscallFactory, const STLW::string & sLang)
+{
+	FnGetText * pTMP = dynamic_cast<FnGetText *>(oSyscallFactory.GetHandlerByName("gettext"));
+	pTMP -> SetLanguage(sLang);
+	pTMP = dynamic_cast<FnGetText *>(oSyscallFactory.GetHandlerByName("_"));
+	pTMP -> SetLanguage(sLang);
+}
+
 }  // namespace CTPP
 // End.
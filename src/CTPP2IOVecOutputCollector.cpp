@@ -0,0 +1,228 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2IOVecOutputCollector.cpp
+ *
+ * $CTPP$
+ */
+#include "CTPP2IOVecOutputCollector.hpp"
+
+#ifdef HAVE_SYS_UIO_H
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef IOV_MAX
+    #define IOV_MAX 1024
+#endif
+
+namespace CTPP // C++ Template Engine
+{
+
+//
+// Constructor
+//
+IOVecOutputCollector::IOVecOutputCollector(const UINT_32  iIChunkSize): pPos(NULL),
+                                                                        iFree(0),
+                                                                        iChunkSize(iIChunkSize),
+                                                                        iSize(0)
+{
+	;;
+}
+
+//
+// Collect data
+//
+INT_32 IOVecOutputCollector::Collect(const void     * vData,
+                                     const UINT_32    iDataLength)
+{
+	if (iDataLength == 0) { return 0; }
+
+	if (iDataLength > iFree)
+	{
+		// Large data is placed into separate block, free space of current chunk is still used
+		if (iDataLength > iChunkSize / 2)
+		{
+			vLargeBlocks.reserve(vLargeBlocks.size() + 1);
+			CHAR_P pBlock = new CHAR_8[iDataLength];
+			vLargeBlocks.push_back(pBlock);
+
+			memcpy(pBlock, vData, iDataLength);
+			AddFragment(pBlock, iDataLength);
+			return 0;
+		}
+
+		vChunks.reserve(vChunks.size() + 1);
+		pPos  = new CHAR_8[iChunkSize];
+		iFree = iChunkSize;
+		vChunks.push_back(pPos);
+	}
+
+	memcpy(pPos, vData, iDataLength);
+	AddFragment(pPos, iDataLength);
+
+	pPos  += iDataLength;
+	iFree -= iDataLength;
+
+return 0;
+}
+
+//
+// Collect static text
+//
+INT_32 IOVecOutputCollector::CollectStatic(const void     * vData,
+                                           const UINT_32    iDataLength)
+{
+	// Copy of short text is cheaper than one more fragment
+	if (iDataLength < C_IOVEC_MIN_STATIC_LENGTH) { return Collect(vData, iDataLength); }
+
+	AddFragment(vData, iDataLength);
+
+return 0;
+}
+
+//
+// Add fragment, adjacent fragments are merged
+//
+void IOVecOutputCollector::AddFragment(const void     * vData,
+                                       const UINT_32    iDataLength)
+{
+	iSize += iDataLength;
+
+	if (!vIOVec.empty())
+	{
+		struct iovec & oLast = vIOVec.back();
+		if ((CCHAR_P)oLast.iov_base + oLast.iov_len == (CCHAR_P)vData)
+		{
+			oLast.iov_len += iDataLength;
+			return;
+		}
+	}
+
+	struct iovec oIOVec;
+	oIOVec.iov_base = const_cast<void *>(vData);
+	oIOVec.iov_len  = iDataLength;
+	vIOVec.push_back(oIOVec);
+}
+
+//
+// Get list of collected fragments
+//
+const struct iovec * IOVecOutputCollector::GetIOVec(UINT_32 & iIOVecCount) const
+{
+	iIOVecCount = UINT_32(vIOVec.size());
+	if (iIOVecCount == 0) { return NULL; }
+
+return &vIOVec[0];
+}
+
+//
+// Get total size of collected data
+//
+UINT_64 IOVecOutputCollector::GetSize() const { return iSize; }
+
+//
+// Write collected data to file descriptor
+//
+INT_32 IOVecOutputCollector::Flush(const INT_32  iFD)
+{
+	UINT_32 iPos = 0;
+	while (iPos < vIOVec.size())
+	{
+		const UINT_32 iCount = UINT_32(vIOVec.size() - iPos) < UINT_32(IOV_MAX) ? UINT_32(vIOVec.size() - iPos) : UINT_32(IOV_MAX);
+
+		ssize_t iWritten = writev(iFD, &vIOVec[iPos], iCount);
+		if (iWritten == -1)
+		{
+			if (errno == EINTR) { continue; }
+
+			// Written fragments are removed, so Flush may be called again
+			const INT_32 iErrNo = errno;
+			for (UINT_32 iI = 0; iI < iPos; ++iI) { iSize -= vIOVec[iI].iov_len; }
+			vIOVec.erase(vIOVec.begin(), vIOVec.begin() + iPos);
+			errno = iErrNo;
+			return -1;
+		}
+
+		// Skip written data, last fragment may be written partially
+		while (iWritten > 0)
+		{
+			struct iovec & oIOVec = vIOVec[iPos];
+			if (size_t(iWritten) >= oIOVec.iov_len)
+			{
+				iWritten -= oIOVec.iov_len;
+				++iPos;
+			}
+			else
+			{
+				oIOVec.iov_base = (CHAR_P)oIOVec.iov_base + iWritten;
+				oIOVec.iov_len -= iWritten;
+				iSize          -= iWritten;
+				iWritten = 0;
+			}
+		}
+	}
+
+	Clear();
+
+return 0;
+}
+
+//
+// Clear collected data
+//
+void IOVecOutputCollector::Clear()
+{
+	vIOVec.clear();
+	iSize = 0;
+
+	for (UINT_32 iPos = 0; iPos < vLargeBlocks.size(); ++iPos) { delete [] vLargeBlocks[iPos]; }
+	vLargeBlocks.clear();
+
+	if (vChunks.empty()) { return; }
+
+	for (UINT_32 iPos = 1; iPos < vChunks.size(); ++iPos) { delete [] vChunks[iPos]; }
+	vChunks.resize(1);
+
+	pPos  = vChunks[0];
+	iFree = iChunkSize;
+}
+
+//
+// A destructor
+//
+IOVecOutputCollector::~IOVecOutputCollector() throw()
+{
+	for (UINT_32 iPos = 0; iPos < vLargeBlocks.size(); ++iPos) { delete [] vLargeBlocks[iPos]; }
+	for (UINT_32 iPos = 0; iPos < vChunks.size(); ++iPos)      { delete [] vChunks[iPos];      }
+}
+
+} // namespace CTPP
+#endif // HAVE_SYS_UIO_H
+// End.
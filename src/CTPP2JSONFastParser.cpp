@@ -0,0 +1,789 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2JSONFastParser.cpp
+ *
+ * $CTPP$
+ */
+
+#include "CTPP2JSONFastParser.hpp"
+#include "CTPP2JSONMappedFile.hpp"
+
+#include "CTPP2Escape.hpp"
+#include "CTPP2Util.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef HAVE_STRINGS_H
+#include <strings.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#ifdef SIMD_ESCAPE_SUPPORT
+#include <immintrin.h>
+#endif
+
+/** Number of characters processed at once by stage 1 */
+#define C_JSON_BLOCK_SIZE           64
+
+namespace CTPP // C++ Template Engine
+{
+
+/** Character classes of lookup table */
+#define C_JSON_QUOTE                0x01
+#define C_JSON_BACKSLASH            0x02
+#define C_JSON_STRUCTURAL           0x04
+#define C_JSON_SPACE                0x08
+#define C_JSON_UNSUPPORTED          0x10
+
+/**
+  @struct JSONBlock CTPP2JSONFastParser.cpp
+  @brief Characters of block, one bit per character
+*/
+struct JSONBlock
+{
+	/** '"'                            */
+	UINT_64    quote;
+	/** '\\'                           */
+	UINT_64    backslash;
+	/** { } [ ] : ,                    */
+	UINT_64    structural;
+	/** Space, tab, CR, LF             */
+	UINT_64    space;
+	/** '\'' and '/', start of comment */
+	UINT_64    unsupported;
+};
+
+/**
+  @struct JSONIndexState CTPP2JSONFastParser.cpp
+  @brief State of stage 1 carried from block to block
+*/
+struct JSONIndexState
+{
+	/** 1 if first character of block is escaped        */
+	UINT_64    escaped;
+	/** All bits set if block starts inside of string   */
+	UINT_64    in_string;
+	/** 1 if previous block ends with scalar value      */
+	UINT_64    scalar;
+	/** Unsupported characters found outside of strings */
+	UINT_64    unsupported;
+};
+
+/** Lookup table for scalar kernel */
+static UCHAR_8 aJSONClass[256];
+
+/** Stage 1 kernel, indexes all complete blocks and returns number of positions */
+typedef UINT_32 (*IndexKernel)(CCHAR_P                  szData,
+                               const UINT_32            iDataLength,
+                               JSONIndexState         & oState,
+                               STLW::vector<UINT_32>  & vIndex);
+
+//
+// Build lookup table
+//
+static UINT_32 InitJSONClasses()
+{
+	for (UINT_32 iChar = 0; iChar < 256; ++iChar)
+	{
+		UCHAR_8 iFlags = 0;
+		if (iChar == '"')                                                    { iFlags = C_JSON_QUOTE;       }
+		else if (iChar == '\\')                                              { iFlags = C_JSON_BACKSLASH;   }
+		else if (iChar == '{' || iChar == '}' || iChar == '[' ||
+		         iChar == ']' || iChar == ':' || iChar == ',')               { iFlags = C_JSON_STRUCTURAL;  }
+		else if (iChar == ' ' || iChar == '\t' || iChar == '\r' || iChar == '\n') { iFlags = C_JSON_SPACE;  }
+		else if (iChar == '\'' || iChar == '/')                              { iFlags = C_JSON_UNSUPPORTED; }
+
+		aJSONClass[iChar] = iFlags;
+	}
+
+return 0;
+}
+
+static const UINT_32 iJSONClassesInit = InitJSONClasses();
+
+//
+// Number of trailing zero bits, iValue is not 0
+//
+static inline UINT_32 TrailingZeros(const UINT_64 iValue)
+{
+#ifdef __GNUC__
+	return __builtin_ctzll(iValue);
+#else
+	UINT_32 iBits = 0;
+	while (((iValue >> iBits) & 1) == 0) { ++iBits; }
+	return iBits;
+#endif
+}
+
+//
+// Bit i of result is XOR of bits 0 .. i of value
+//
+static inline UINT_64 PrefixXOR(UINT_64 iValue)
+{
+	iValue ^= iValue << 1;
+	iValue ^= iValue << 2;
+	iValue ^= iValue << 4;
+	iValue ^= iValue << 8;
+	iValue ^= iValue << 16;
+	iValue ^= iValue << 32;
+
+return iValue;
+}
+
+//
+// Find quotes, structural characters and first characters of scalar values in block
+//
+static inline UINT_32 IndexBlock(const JSONBlock   & oBlock,
+                                 JSONIndexState    & oState,
+                                 const UINT_32       iBlockPos,
+                                 UINT_32           * aIndex)
+{
+	// Characters escaped by backslash; backslashes are rare, so they are resolved one by one
+	UINT_64 iEscaped   = oState.escaped;
+	UINT_64 iBackslash = oBlock.backslash & ~iEscaped;
+	oState.escaped = 0;
+	while (iBackslash != 0)
+	{
+		const UINT_64 iBit = iBackslash & (~iBackslash + 1);
+		// Escaped character is first one of next block
+		if (iBit == (UINT_64(1) << 63)) { oState.escaped = 1; break; }
+
+		iEscaped   |= iBit << 1;
+		iBackslash &= ~(iBit | (iBit << 1));
+	}
+
+	// Strings, from opening quote up to closing one, not including it
+	const UINT_64 iQuote    = oBlock.quote & ~iEscaped;
+	const UINT_64 iInString = PrefixXOR(iQuote) ^ oState.in_string;
+	oState.in_string = UINT_64(0) - (iInString >> 63);
+
+	oState.unsupported |= oBlock.unsupported & ~iInString;
+
+	// Numbers, null, true, false and garbage
+	const UINT_64 iScalar = ~(oBlock.quote | oBlock.structural | oBlock.space | iInString);
+	const UINT_64 iScalarStart = iScalar & ~((iScalar << 1) | oState.scalar);
+	oState.scalar = iScalar >> 63;
+
+	UINT_64 iBits  = (oBlock.structural & ~iInString) | iQuote | iScalarStart;
+	UINT_32 iSlots = 0;
+	while (iBits != 0)
+	{
+		aIndex[iSlots++] = iBlockPos + TrailingZeros(iBits);
+		iBits &= iBits - 1;
+	}
+
+return iSlots;
+}
+
+//
+// Scalar classification of block
+//
+static inline void ClassifyScalar(CCHAR_P      szBlock,
+                                  JSONBlock  & oBlock)
+{
+	oBlock.quote = oBlock.backslash = oBlock.structural = oBlock.space = oBlock.unsupported = 0;
+	for (UINT_32 iPos = 0; iPos < C_JSON_BLOCK_SIZE; ++iPos)
+	{
+		const UCHAR_8 iFlags = aJSONClass[UCHAR_8(szBlock[iPos])];
+		if (iFlags == 0) { continue; }
+
+		const UINT_64 iBit = UINT_64(1) << iPos;
+		if      (iFlags == C_JSON_QUOTE)      { oBlock.quote       |= iBit; }
+		else if (iFlags == C_JSON_BACKSLASH)  { oBlock.backslash   |= iBit; }
+		else if (iFlags == C_JSON_STRUCTURAL) { oBlock.structural  |= iBit; }
+		else if (iFlags == C_JSON_SPACE)      { oBlock.space       |= iBit; }
+		else                                  { oBlock.unsupported |= iBit; }
+	}
+}
+
+//
+// Make room for positions of one block
+//
+static inline UINT_32 * ReserveSlots(STLW::vector<UINT_32>  & vIndex,
+                                     const UINT_32            iSlots)
+{
+	if (iSlots + C_JSON_BLOCK_SIZE > vIndex.size()) { vIndex.resize(vIndex.size() * 2 + C_JSON_BLOCK_SIZE); }
+
+return &vIndex[iSlots];
+}
+
+//
+// Scalar stage 1
+//
+static UINT_32 IndexScalar(CCHAR_P                  szData,
+                           const UINT_32            iDataLength,
+                           JSONIndexState         & oState,
+                           STLW::vector<UINT_32>  & vIndex)
+{
+	UINT_32 iSlots = 0;
+	for (UINT_32 iPos = 0; iPos + C_JSON_BLOCK_SIZE <= iDataLength && oState.unsupported == 0; iPos += C_JSON_BLOCK_SIZE)
+	{
+		JSONBlock oBlock;
+		ClassifyScalar(szData + iPos, oBlock);
+		iSlots += IndexBlock(oBlock, oState, iPos, ReserveSlots(vIndex, iSlots));
+	}
+
+return iSlots;
+}
+
+#ifdef SIMD_ESCAPE_SUPPORT
+//
+// SSE2 classification of block, 16 bytes per step
+//
+__attribute__((target("sse2"))) static inline void ClassifySSE2(CCHAR_P      szBlock,
+                                                                JSONBlock  & oBlock)
+{
+	oBlock.quote = oBlock.backslash = oBlock.structural = oBlock.space = oBlock.unsupported = 0;
+	for (UINT_32 iPos = 0; iPos < C_JSON_BLOCK_SIZE; iPos += 16)
+	{
+		const __m128i vData  = _mm_loadu_si128((const __m128i *)(szBlock + iPos));
+		// '[' and ']' differ from '{' and '}' by one bit
+		const __m128i vLower = _mm_or_si128(vData, _mm_set1_epi8(0x20));
+
+		__m128i vStructural = _mm_or_si128(_mm_cmpeq_epi8(vLower, _mm_set1_epi8('{')), _mm_cmpeq_epi8(vLower, _mm_set1_epi8('}')));
+		vStructural = _mm_or_si128(vStructural, _mm_cmpeq_epi8(vData, _mm_set1_epi8(':')));
+		vStructural = _mm_or_si128(vStructural, _mm_cmpeq_epi8(vData, _mm_set1_epi8(',')));
+
+		__m128i vSpace = _mm_or_si128(_mm_cmpeq_epi8(vData, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(vData, _mm_set1_epi8('\t')));
+		vSpace = _mm_or_si128(vSpace, _mm_cmpeq_epi8(vData, _mm_set1_epi8('\r')));
+		vSpace = _mm_or_si128(vSpace, _mm_cmpeq_epi8(vData, _mm_set1_epi8('\n')));
+
+		const __m128i vUnsupported = _mm_or_si128(_mm_cmpeq_epi8(vData, _mm_set1_epi8('\'')), _mm_cmpeq_epi8(vData, _mm_set1_epi8('/')));
+
+		oBlock.quote       |= UINT_64(UINT_32(_mm_movemask_epi8(_mm_cmpeq_epi8(vData, _mm_set1_epi8('"')))))  << iPos;
+		oBlock.backslash   |= UINT_64(UINT_32(_mm_movemask_epi8(_mm_cmpeq_epi8(vData, _mm_set1_epi8('\\'))))) << iPos;
+		oBlock.structural  |= UINT_64(UINT_32(_mm_movemask_epi8(vStructural)))  << iPos;
+		oBlock.space       |= UINT_64(UINT_32(_mm_movemask_epi8(vSpace)))       << iPos;
+		oBlock.unsupported |= UINT_64(UINT_32(_mm_movemask_epi8(vUnsupported))) << iPos;
+	}
+}
+
+//
+// SSE2 stage 1
+//
+__attribute__((target("sse2"))) static UINT_32 IndexSSE2(CCHAR_P                  szData,
+                                                         const UINT_32            iDataLength,
+                                                         JSONIndexState         & oState,
+                                                         STLW::vector<UINT_32>  & vIndex)
+{
+	UINT_32 iSlots = 0;
+	for (UINT_32 iPos = 0; iPos + C_JSON_BLOCK_SIZE <= iDataLength && oState.unsupported == 0; iPos += C_JSON_BLOCK_SIZE)
+	{
+		JSONBlock oBlock;
+		ClassifySSE2(szData + iPos, oBlock);
+		iSlots += IndexBlock(oBlock, oState, iPos, ReserveSlots(vIndex, iSlots));
+	}
+
+return iSlots;
+}
+
+//
+// AVX2 classification of block, 32 bytes per step
+//
+__attribute__((target("avx2"))) static inline void ClassifyAVX2(CCHAR_P      szBlock,
+                                                                JSONBlock  & oBlock)
+{
+	oBlock.quote = oBlock.backslash = oBlock.structural = oBlock.space = oBlock.unsupported = 0;
+	for (UINT_32 iPos = 0; iPos < C_JSON_BLOCK_SIZE; iPos += 32)
+	{
+		const __m256i vData  = _mm256_loadu_si256((const __m256i *)(szBlock + iPos));
+		// '[' and ']' differ from '{' and '}' by one bit
+		const __m256i vLower = _mm256_or_si256(vData, _mm256_set1_epi8(0x20));
+
+		__m256i vStructural = _mm256_or_si256(_mm256_cmpeq_epi8(vLower, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(vLower, _mm256_set1_epi8('}')));
+		vStructural = _mm256_or_si256(vStructural, _mm256_cmpeq_epi8(vData, _mm256_set1_epi8(':')));
+		vStructural = _mm256_or_si256(vStructural, _mm256_cmpeq_epi8(vData, _mm256_set1_epi8(',')));
+
+		__m256i vSpace = _mm256_or_si256(_mm256_cmpeq_epi8(vData, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(vData, _mm256_set1_epi8('\t')));
+		vSpace = _mm256_or_si256(vSpace, _mm256_cmpeq_epi8(vData, _mm256_set1_epi8('\r')));
+		vSpace = _mm256_or_si256(vSpace, _mm256_cmpeq_epi8(vData, _mm256_set1_epi8('\n')));
+
+		const __m256i vUnsupported = _mm256_or_si256(_mm256_cmpeq_epi8(vData, _mm256_set1_epi8('\'')), _mm256_cmpeq_epi8(vData, _mm256_set1_epi8('/')));
+
+		oBlock.quote       |= UINT_64(UINT_32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(vData, _mm256_set1_epi8('"')))))  << iPos;
+		oBlock.backslash   |= UINT_64(UINT_32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(vData, _mm256_set1_epi8('\\'))))) << iPos;
+		oBlock.structural  |= UINT_64(UINT_32(_mm256_movemask_epi8(vStructural)))  << iPos;
+		oBlock.space       |= UINT_64(UINT_32(_mm256_movemask_epi8(vSpace)))       << iPos;
+		oBlock.unsupported |= UINT_64(UINT_32(_mm256_movemask_epi8(vUnsupported))) << iPos;
+	}
+}
+
+//
+// AVX2 stage 1
+//
+__attribute__((target("avx2"))) static UINT_32 IndexAVX2(CCHAR_P                  szData,
+                                                         const UINT_32            iDataLength,
+                                                         JSONIndexState         & oState,
+                                                         STLW::vector<UINT_32>  & vIndex)
+{
+	UINT_32 iSlots = 0;
+	for (UINT_32 iPos = 0; iPos + C_JSON_BLOCK_SIZE <= iDataLength && oState.unsupported == 0; iPos += C_JSON_BLOCK_SIZE)
+	{
+		JSONBlock oBlock;
+		ClassifyAVX2(szData + iPos, oBlock);
+		iSlots += IndexBlock(oBlock, oState, iPos, ReserveSlots(vIndex, iSlots));
+	}
+
+return iSlots;
+}
+#endif // SIMD_ESCAPE_SUPPORT
+
+//
+// JSON white space
+//
+static inline bool IsSpace(const CHAR_8 chData)
+{
+	return chData == ' ' || chData == '\t' || chData == '\r' || chData == '\n';
+}
+
+//
+// JSON number [-]0-9[. [0-9] ] [E][+- 0-9], same syntax as CTPP2JSONParser::IsNum
+//
+static CCHAR_P ScanNumber(CCHAR_P   szData,
+                          CCHAR_P   szEnd,
+                          bool    & bFloat)
+{
+	bFloat = false;
+	// First character: digit or sign
+	if (!((*szData >= '0' && *szData <= '9') || *szData == '-' || *szData == '+')) { return NULL; }
+	++szData;
+
+	// Digits
+	while (szData != szEnd && *szData >= '0' && *szData <= '9') { ++szData; }
+
+	// Optional '.'. If not found, this is an integer value
+	if (szData == szEnd || *szData != '.') { return szData; }
+	++szData;
+	bFloat = true;
+
+	// Digits after point
+	while (szData != szEnd && *szData >= '0' && *szData <= '9') { ++szData; }
+
+	// Scientific?
+	if (szData == szEnd || (*szData != 'E' && *szData != 'e')) { return szData; }
+	++szData;
+
+	// Exponent sign
+	if (szData != szEnd && (*szData == '-' || *szData == '+')) { ++szData; }
+
+	// Exponent value
+	CCHAR_P szDigits = szData;
+	while (szData != szEnd && *szData >= '0' && *szData <= '9') { ++szData; }
+	if (szData == szDigits) { return NULL; }
+
+return szData;
+}
+
+//
+// Constructor
+//
+CTPP2JSONFastParser::CTPP2JSONFastParser(CDT                  & oICDT,
+                                         CDTArena             * pIArena,
+                                         CTPP2JSONMappedFile  * pIMappedFile): oCDT(oICDT),
+                                                                               pArena(pIArena),
+                                                                               pMappedFile(pIMappedFile),
+                                                                               szData(NULL),
+                                                                               iDataLength(0),
+                                                                               iSlots(0),
+                                                                               iSlot(0),
+                                                                               iContainer(0)
+{
+	;;
+}
+
+//
+// Build structural index
+//
+INT_32 CTPP2JSONFastParser::BuildIndex()
+{
+	JSONIndexState oState = { 0, 0, 0, 0 };
+
+	if (vIndex.size() < iDataLength / 8 + C_JSON_BLOCK_SIZE) { vIndex.resize(iDataLength / 8 + C_JSON_BLOCK_SIZE); }
+
+	// Same instruction set as for escaping
+	IndexKernel fnKernel = IndexScalar;
+#ifdef SIMD_ESCAPE_SUPPORT
+	switch (GetEscapeKernel())
+	{
+		case ESCAPE_KERNEL_AVX2:
+			fnKernel = IndexAVX2;
+			break;
+		case ESCAPE_KERNEL_SSE2:
+			fnKernel = IndexSSE2;
+			break;
+		default:
+			;;
+	}
+#endif // SIMD_ESCAPE_SUPPORT
+	iSlots = fnKernel(szData, iDataLength, oState, vIndex);
+
+	// Tail of data, padded with spaces
+	const UINT_32 iTail = iDataLength % C_JSON_BLOCK_SIZE;
+	if (iTail != 0 && oState.unsupported == 0)
+	{
+		CHAR_8 aBlock[C_JSON_BLOCK_SIZE];
+		memset(aBlock, ' ', C_JSON_BLOCK_SIZE);
+		memcpy(aBlock, szData + iDataLength - iTail, iTail);
+
+		JSONBlock oBlock;
+		ClassifyScalar(aBlock, oBlock);
+		iSlots += IndexBlock(oBlock, oState, iDataLength - iTail, ReserveSlots(vIndex, iSlots));
+	}
+
+	// Comments, single-quoted or unterminated strings
+	if (oState.unsupported != 0 || oState.in_string != 0 || oState.escaped != 0) { return -1; }
+
+	// End of data, limit of last scalar value
+	ReserveSlots(vIndex, iSlots);
+	vIndex[iSlots] = iDataLength;
+
+return 0;
+}
+
+//
+// Count elements of ARRAY-s and HASH-es
+//
+INT_32 CTPP2JSONFastParser::CountElements()
+{
+	vElements.clear();
+
+	STLW::vector<UINT_32> vOpened;
+	for (UINT_32 iPos = 0; iPos < iSlots; ++iPos)
+	{
+		switch (szData[vIndex[iPos]])
+		{
+			case '{':
+			case '[':
+				{
+					vOpened.push_back(UINT_32(vElements.size()));
+					// Empty container?
+					const CHAR_8 chNext = (iPos + 1 < iSlots) ? szData[vIndex[iPos + 1]] : ']';
+					vElements.push_back((chNext == '}' || chNext == ']') ? 0 : 1);
+				}
+				break;
+
+			case ',':
+				if (!vOpened.empty()) { ++vElements[vOpened.back()]; }
+				break;
+
+			case '}':
+			case ']':
+				if (vOpened.empty()) { return -1; }
+				vOpened.pop_back();
+				break;
+
+			default:
+				;;
+		}
+	}
+
+return vOpened.empty() ? 0 : -1;
+}
+
+//
+// JSON string
+//
+INT_32 CTPP2JSONFastParser::ParseString(STLW::string & sValue)
+{
+	// Closing quote always follows opening one in index
+	if (iSlot + 1 >= iSlots) { return -1; }
+
+	CCHAR_P szPos    = szData + vIndex[iSlot] + 1;
+	CCHAR_P szEnd    = szData + vIndex[iSlot + 1];
+	iSlot += 2;
+
+	CCHAR_P szEscape = (CCHAR_P)memchr(szPos, '\\', szEnd - szPos);
+	if (szEscape == NULL)
+	{
+		sValue.assign(szPos, szEnd - szPos);
+		return 0;
+	}
+
+	sValue.assign(szPos, szEscape - szPos);
+	while (szEscape != NULL)
+	{
+		// Escaped character always precedes closing quote
+		szPos = szEscape + 1;
+		switch (*szPos)
+		{
+			// man ascii
+			case 'a': sValue += '\a'; ++szPos; break;
+			case 'b': sValue += '\b'; ++szPos; break;
+			case 't': sValue += '\t'; ++szPos; break;
+			case 'n': sValue += '\n'; ++szPos; break;
+			case 'v': sValue += '\v'; ++szPos; break;
+			case 'f': sValue += '\f'; ++szPos; break;
+			case 'r': sValue += '\r'; ++szPos; break;
+			// Unicode + 4 digits
+			case 'u':
+				{
+					++szPos;
+					UINT_32 iTMP = 0;
+					for (INT_32 iI = 3; iI >= 0; --iI)
+					{
+						if (szPos == szEnd) { return -1; }
+
+						const UCHAR_8 iCh = *szPos;
+						if      (iCh >= '0' && iCh <= '9') { iTMP += ((iCh - '0') << (iI * 4));      }
+						// Character parser accepts lowercase hex digits only
+						else if (iCh >= 'a' && iCh <= 'f') { iTMP += ((iCh - 'a' + 10) << (iI * 4)); }
+						else                               { return -1; }
+
+						++szPos;
+					}
+					UCHAR_8 aBuffer[6];
+					INT_32 iCharLength = UnicodeToUTF8(iTMP, aBuffer);
+
+					sValue.append((CHAR_P)aBuffer, iCharLength);
+				}
+				break;
+			default:
+				sValue += *szPos;
+				++szPos;
+		}
+
+		// Copy span up to next escape sequence
+		szEscape = (CCHAR_P)memchr(szPos, '\\', szEnd - szPos);
+		sValue.append(szPos, (szEscape == NULL ? szEnd : szEscape) - szPos);
+	}
+
+return 0;
+}
+
+//
+// JSON number, null, true, false
+//
+INT_32 CTPP2JSONFastParser::ParseScalar(CDT & oValue)
+{
+	if (iSlot >= iSlots) { return -1; }
+
+	CCHAR_P szPos = szData + vIndex[iSlot];
+	// Scalar value cannot span over next position in index
+	CCHAR_P szEnd = szData + vIndex[iSlot + 1];
+	++iSlot;
+
+	if ((*szPos >= 'a' && *szPos <= 'z') || (*szPos >= 'A' && *szPos <= 'Z'))
+	{
+		CCHAR_P szWord = szPos;
+		while (szPos != szEnd && ((*szPos >= 'a' && *szPos <= 'z') || (*szPos >= 'A' && *szPos <= 'Z'))) { ++szPos; }
+
+		// Character parser does not accept word at end of data
+		if (szPos == szData + iDataLength) { return -1; }
+
+		const UINT_32 iLength = szPos - szWord;
+		if      (iLength == 4 && strncasecmp("null",  szWord, 4) == 0) { oValue = CDT(CDT::UNDEF); }
+		else if (iLength == 5 && strncasecmp("false", szWord, 5) == 0) { oValue = 0; }
+		else if (iLength == 4 && strncasecmp("true",  szWord, 4) == 0) { oValue = 1; }
+		// Unexpected data found
+		else { return -1; }
+	}
+	else
+	{
+		bool bFloat = false;
+		CCHAR_P szNumber = szPos;
+		szPos = ScanNumber(szPos, szEnd, bFloat);
+		if (szPos == NULL) { return -1; }
+
+		ConvertJSONNumber(szNumber, szPos, bFloat, oValue);
+	}
+
+	// Value must be followed by white space or structural character
+	if (szPos != szEnd && !IsSpace(*szPos)) { return -1; }
+
+return 0;
+}
+
+//
+// JSON Key
+//
+INT_32 CTPP2JSONFastParser::ParseKey(STLW::string & sKey)
+{
+	if (iSlot >= iSlots) { return -1; }
+
+	CCHAR_P szPos = szData + vIndex[iSlot];
+	if (*szPos == '"') { return ParseString(sKey); }
+
+	// Number, raw text is used as key
+	CCHAR_P szEnd = szData + vIndex[iSlot + 1];
+	++iSlot;
+
+	bool bFloat = false;
+	CCHAR_P szNumberEnd = ScanNumber(szPos, szEnd, bFloat);
+	if (szNumberEnd == NULL || (szNumberEnd != szEnd && !IsSpace(*szNumberEnd))) { return -1; }
+
+	sKey.assign(szPos, szNumberEnd - szPos);
+
+return 0;
+}
+
+//
+// JSON Object
+//
+INT_32 CTPP2JSONFastParser::ParseObject(CDT & oValue)
+{
+	oValue = CDT(CDT::HASH_VAL, pArena);
+	oValue.Reserve(vElements[iContainer++]);
+	++iSlot;
+
+	// Empty hash
+	if (iSlot < iSlots && szData[vIndex[iSlot]] == '}') { ++iSlot; return 0; }
+
+	STLW::string sKey;
+	for (;;)
+	{
+		if (ParseKey(sKey) == -1) { return -1; }
+
+		// Delimiter
+		if (iSlot >= iSlots || szData[vIndex[iSlot]] != ':') { return -1; }
+		++iSlot;
+
+		// Value is built in place
+		if (ParseValue(oValue[sKey]) == -1) { return -1; }
+
+		if (iSlot >= iSlots) { return -1; }
+		const CHAR_8 chNext = szData[vIndex[iSlot++]];
+
+		// End of object
+		if (chNext == '}') { break; }
+		// Next key : value pair?
+		if (chNext != ',') { return -1; }
+	}
+
+return 0;
+}
+
+//
+// JSON Array
+//
+INT_32 CTPP2JSONFastParser::ParseArray(CDT & oValue)
+{
+	oValue = CDT(CDT::ARRAY_VAL, pArena);
+	oValue.Reserve(vElements[iContainer++]);
+	++iSlot;
+
+	// Empty array
+	if (iSlot < iSlots && szData[vIndex[iSlot]] == ']') { ++iSlot; return 0; }
+
+	for (UINT_32 iArrayIndex = 0; ; ++iArrayIndex)
+	{
+		// Value is built in place
+		if (ParseValue(oValue[iArrayIndex]) == -1) { return -1; }
+
+		if (iSlot >= iSlots) { return -1; }
+		const CHAR_8 chNext = szData[vIndex[iSlot++]];
+
+		// End of array?
+		if (chNext == ']') { break; }
+		// Next element?
+		if (chNext != ',') { return -1; }
+	}
+
+return 0;
+}
+
+//
+// JSON Value
+//
+INT_32 CTPP2JSONFastParser::ParseValue(CDT & oValue)
+{
+	if (iSlot >= iSlots) { return -1; }
+
+	switch (szData[vIndex[iSlot]])
+	{
+		case '{':
+			return ParseObject(oValue);
+
+		case '[':
+			return ParseArray(oValue);
+
+		case '"':
+			// String without escape sequences refers to mapped file
+			if (pMappedFile != NULL && iSlot + 1 < iSlots)
+			{
+				CCHAR_P       szString = szData + vIndex[iSlot] + 1;
+				const UINT_32 iLength  = vIndex[iSlot + 1] - vIndex[iSlot] - 1;
+				if (memchr(szString, '\\', iLength) == NULL)
+				{
+					iSlot += 2;
+					oValue = pMappedFile -> MakeString(szString, iLength, pArena);
+					return 0;
+				}
+			}
+
+			if (ParseString(sTMPBuf) == -1) { return -1; }
+			oValue = CDT(sTMPBuf, pArena);
+			return 0;
+
+		default:
+			;;
+	}
+
+return ParseScalar(oValue);
+}
+
+//
+// Parse JSON data
+//
+INT_32 CTPP2JSONFastParser::Parse(CCHAR_P  szIData,
+                                  CCHAR_P  szIEnd)
+{
+	// Positions in index are 32-bit
+	if (szIEnd <= szIData || UINT_64(szIEnd - szIData) >= 0xFFFFFFFFULL) { return -1; }
+
+	szData      = szIData;
+	iDataLength = UINT_32(szIEnd - szIData);
+	iSlot       = 0;
+	iContainer  = 0;
+
+	if (BuildIndex() == -1 || CountElements() == -1) { return -1; }
+
+	// Empty document
+	if (iSlots == 0) { return -1; }
+
+	if (ParseValue(oCDT) == -1) { return -1; }
+
+	// Data after value
+	if (iSlot != iSlots) { return -1; }
+
+return 0;
+}
+
+//
+// A destructor
+//
+CTPP2JSONFastParser::~CTPP2JSONFastParser() throw()
+{
+	;;
+}
+
+} // namespace CTPP
+// End.
@@ -43,7 +43,11 @@ namespace CTPP // C++ Template Engine
 //
 // Constructor
 //
-CTPP2JSONFileParser::CTPP2JSONFileParser(CDT & oICDT): CTPP2JSONParser(oICDT) { ;; }
+CTPP2JSONFileParser::CTPP2JSONFileParser(CDT                                 & oICDT,
+                                         CDTArena                            * pIArena,
+                                         const CTPP2JSONParser::eParserMode    eIMode,
+                                         CTPP2JSONMappedFile                 * pIMappedFile): CTPP2JSONParser(oICDT, pIArena, eIMode, pIMappedFile),
+                                                                                             pMappedFile(pIMappedFile) { ;; }
 
 
 //
@@ -51,6 +55,14 @@ CTPP2JSONFileParser::CTPP2JSONFileParser(CDT & oICDT): CTPP2JSONParser(oICDT) {
 //
 INT_32 CTPP2JSONFileParser::Parse(CCHAR_P szFileName)
 {
+	// File data are kept in memory with parsed document
+	if (pMappedFile != NULL)
+	{
+		pMappedFile -> Open(szFileName);
+		CTPP2JSONParser::Parse(pMappedFile -> GetData(), pMappedFile -> GetData() + pMappedFile -> GetSize());
+		return 0;
+	}
+
 	// Get file size
 	struct stat oStat;
 	if (stat(szFileName, &oStat) == -1) { throw CTPPUnixException("stat", errno); }
@@ -0,0 +1,167 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2JSONMappedFile.cpp
+ *
+ * $CTPP$
+ */
+#include "CTPP2JSONMappedFile.hpp"
+
+#include "CTPP2Exception.hpp"
+#include "CTPP2MappedFile.hpp"
+
+#include "STLVector.hpp"
+
+namespace CTPP // C++ Template Engine
+{
+
+/**
+  @struct CTPP2JSONMappedFile::Storage CTPP2JSONMappedFile.cpp
+  @brief File data and blocks of string views; CDT refers to view itself and holds reference to storage
+*/
+struct CTPP2JSONMappedFile::Storage:
+  public CDTStringOwner
+{
+	/** File data               */
+	MappedFile                            file;
+	/** Blocks of string views  */
+	STLW::vector<CDTOwnedStringView *>    views;
+
+	/**
+	  @brief A destructor
+	*/
+	~Storage() throw();
+};
+
+//
+// A destructor
+//
+CTPP2JSONMappedFile::Storage::~Storage() throw()
+{
+	STLW::vector<CDTOwnedStringView *>::iterator itvViews = views.begin();
+	for (; itvViews != views.end(); ++itvViews) { delete [] *itvViews; }
+}
+
+//
+// Constructor
+//
+CTPP2JSONMappedFile::CTPP2JSONMappedFile(): pStorage(NULL),
+                                            iUsedViews(C_JSON_VIEWS_BLOCK_SIZE)
+{
+	;;
+}
+
+//
+// Map file to memory
+//
+void CTPP2JSONMappedFile::Open(CCHAR_P szFileName)
+{
+	if (pStorage != NULL) { throw CTPPLogicError("File is already mapped"); }
+
+	Storage * pTMP = new Storage;
+	try
+	{
+		pTMP -> file.Open(szFileName);
+		if (pTMP -> file.GetSize() == 0) { throw CTPPLogicError("Cannot get size of file"); }
+	}
+	catch(...)
+	{
+		pTMP -> Release();
+		throw;
+	}
+
+	pStorage = pTMP;
+}
+
+//
+// Get file data
+//
+CCHAR_P CTPP2JSONMappedFile::GetData() const { return (pStorage == NULL) ? NULL : pStorage -> file.GetData(); }
+
+//
+// Get file size
+//
+UINT_32 CTPP2JSONMappedFile::GetSize() const { return (pStorage == NULL) ? 0 : pStorage -> file.GetSize(); }
+
+//
+// Create string value
+//
+CDT CTPP2JSONMappedFile::MakeString(CCHAR_P          szString,
+                                    const UINT_32    iLength,
+                                    CDTArena       * pArena)
+{
+	CCHAR_P szData      = GetData();
+	const UINT_32 iSize = GetSize();
+
+	// String outside file data is copied
+	if (szString < szData || szString + iLength > szData + iSize) { return CDT(STLW::string(szString, iLength), pArena); }
+
+	// Short string is copied into CDT, view is not referred to
+	if (iLength <= C_CDT_INLINE_LENGTH)
+	{
+		const CDTStringView oView = { szString, iLength };
+		return CDT(oView);
+	}
+
+	if (iUsedViews == C_JSON_VIEWS_BLOCK_SIZE)
+	{
+		pStorage -> views.push_back(new CDTOwnedStringView[C_JSON_VIEWS_BLOCK_SIZE]);
+		iUsedViews = 0;
+	}
+
+	CDTOwnedStringView & oStoredView = pStorage -> views.back()[iUsedViews++];
+	oStoredView.view.data   = szString;
+	oStoredView.view.length = iLength;
+	oStoredView.owner       = pStorage;
+
+	// Tree of arena refers to file, so it is destroyed by walk
+	if (pArena != NULL) { pArena -> MarkForeign(); }
+
+return CDT(oStoredView);
+}
+
+//
+// Release file
+//
+void CTPP2JSONMappedFile::Release() throw()
+{
+	if (pStorage != NULL) { pStorage -> Release(); }
+
+	pStorage   = NULL;
+	iUsedViews = C_JSON_VIEWS_BLOCK_SIZE;
+}
+
+//
+// A destructor
+//
+CTPP2JSONMappedFile::~CTPP2JSONMappedFile() throw()
+{
+	Release();
+}
+
+} // namespace CTPP
+// End.
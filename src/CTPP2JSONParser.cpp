@@ -32,6 +32,8 @@
 
 #include "CTPP2JSONParser.hpp"
 
+#include "CTPP2JSONFastParser.hpp"
+#include "CTPP2JSONMappedFile.hpp"
 #include "CTPP2ParserException.hpp"
 #include "CTPP2Util.hpp"
 
@@ -51,7 +53,13 @@ namespace CTPP // C++ Template Engine
 //
 // Constructor
 //
-CTPP2JSONParser::CTPP2JSONParser(CDT & oICDT): oCDT(oICDT)
+CTPP2JSONParser::CTPP2JSONParser(CDT                   & oICDT,
+                                 CDTArena              * pIArena,
+                                 const eParserMode       eIMode,
+                                 CTPP2JSONMappedFile   * pIMappedFile): oCDT(oICDT),
+                                                                        pArena(pIArena),
+                                                                        eMode(eIMode),
+                                                                        pMappedFile(pIMappedFile)
 {
 	;;
 }
@@ -362,7 +370,7 @@ CCharIterator CTPP2JSONParser::IsObject(CCharIterator szData, CCharIterator szEn
 	if (*szData() != '{') { return NULL; }
 	++szData;
 
-	oCurrentCDT   = CDT(CDT::HASH_VAL);
+	oCurrentCDT   = CDT(CDT::HASH_VAL, pArena);
 
 	// Parse array
 	CCharIterator  sTMP     = szData;
@@ -473,7 +481,7 @@ CCharIterator CTPP2JSONParser::IsArray(CCharIterator szData, CCharIterator szEnd
 	if (*szData() != '[') { return NULL; }
 	++szData;
 
-	oCurrentCDT   = CDT(CDT::ARRAY_VAL);
+	oCurrentCDT   = CDT(CDT::ARRAY_VAL, pArena);
 
 	// Parse array
 	CCharIterator  sTMP     = szData;
@@ -568,7 +576,15 @@ CCharIterator CTPP2JSONParser::IsValue(CCharIterator szData, CCharIterator szEnd
 				sTMP = IsString(szData, szEnd);
 				if (sTMP != NULL)
 				{
-					oCurrentCDT = sTMPBuf;
+					// Escape sequences are longer than characters they stand for, so string
+					// without them is as long as its source without quotes and refers to mapped file
+					if (pMappedFile != NULL && sTMPBuf.size() + 2 == UINT_32(sTMP() - szData()))
+					{
+						oCurrentCDT = pMappedFile -> MakeString(szData() + 1, UINT_32(sTMPBuf.size()), pArena);
+						return sTMP;
+					}
+
+					oCurrentCDT = CDT(sTMPBuf, pArena);
 					return sTMP;
 				}
 				else
@@ -598,6 +614,16 @@ return NULL;
 //
 INT_32 CTPP2JSONParser::Parse(CCharIterator szData, CCharIterator szEnd)
 {
+	// Containers in arena get values of the same arena only; views of mapped file mark arena as foreign
+	CDTArena::Builder oBuilder(pArena);
+
+	// Line and position are calculated only if fast parser fails
+	if (eMode == FAST_MODE)
+	{
+		CTPP2JSONFastParser oFastParser(oCDT, pArena, pMappedFile);
+		if (oFastParser.Parse(szData(), szEnd()) == 0) { return 0; }
+	}
+
 	// Skip white space
 	szData = IsWhiteSpace(szData, szEnd, 0);
 	// Unexpected EOD?
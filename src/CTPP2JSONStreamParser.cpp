@@ -0,0 +1,547 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2JSONStreamParser.cpp
+ *
+ * $CTPP$
+ */
+#include "CTPP2JSONStreamParser.hpp"
+
+#include "CTPP2ParserException.hpp"
+#include "CTPP2Util.hpp"
+
+#ifdef HAVE_STRINGS_H
+#include <strings.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+namespace CTPP // C++ Template Engine
+{
+
+//
+// Count lines and position in line
+//
+static void CountLines(CCHAR_P    szData,
+                       CCHAR_P    szEnd,
+                       UINT_32  & iLine,
+                       UINT_32  & iLinePos)
+{
+	while (szData != szEnd)
+	{
+		CCHAR_P szNewLine = (CCHAR_P)memchr(szData, '\n', szEnd - szData);
+		if (szNewLine == NULL)
+		{
+			iLinePos += szEnd - szData;
+			return;
+		}
+
+		++iLine;
+		iLinePos = 1;
+		szData = szNewLine + 1;
+	}
+}
+
+//
+// Constructor
+//
+CTPP2JSONStreamParser::CTPP2JSONStreamParser(CDT       & oICDT,
+                                             CDTArena  * pIArena): oCDT(oICDT),
+                                                                   pArena(pIArena),
+                                                                   pValue(NULL),
+                                                                   eState(VALUE),
+                                                                   eToken(NO_TOKEN),
+                                                                   eNumber(INTEGER),
+                                                                   bFloat(false),
+                                                                   chEOS('"'),
+                                                                   iUnicodeDigits(0),
+                                                                   iUnicode(0),
+                                                                   szChunk(NULL),
+                                                                   iLine(1),
+                                                                   iLinePos(1)
+{
+	;;
+}
+
+//
+// Throw error with line and position
+//
+void CTPP2JSONStreamParser::ThrowError(CCHAR_P  szReason,
+                                       CCHAR_P  szData)
+{
+	UINT_32 iErrorLine    = iLine;
+	UINT_32 iErrorLinePos = iLinePos;
+	if (szData != NULL) { CountLines(szChunk, szData, iErrorLine, iErrorLinePos); }
+
+	throw CTPPParserSyntaxError(szReason, iErrorLine, iErrorLinePos);
+}
+
+//
+// Error message depends on what is expected
+//
+void CTPP2JSONStreamParser::SyntaxError(CCHAR_P  szData)
+{
+	const bool bInHash = !vContainers.empty() && vContainers.back() -> GetType() == CDT::HASH_VAL;
+
+	// Unexpected character
+	if (szData != NULL)
+	{
+		switch (eState)
+		{
+			case VALUE:
+				if (vContainers.empty()) { ThrowError("not an JSON object", szData); }
+				ThrowError(bInHash ? "expected value after ':'" : "expected value after ','", szData);
+				break;
+			case VALUE_OR_END_ARRAY: ThrowError("expected value or ']'", szData);            break;
+			case KEY_OR_END_HASH:    ThrowError("expected key or '}'", szData);              break;
+			case KEY:                ThrowError("expected key after ','", szData);           break;
+			case COLON:              ThrowError("expected ':' after key", szData);           break;
+			case NEXT:               ThrowError(bInHash ? "',' expected" : "',' or ']' expected", szData); break;
+			default:                 ThrowError("syntax error", szData);
+		}
+	}
+
+	// Unexpected end of data
+	switch (eState)
+	{
+		case VALUE:
+			if (vContainers.empty()) { ThrowError("empty JSON object", NULL); }
+			ThrowError(bInHash ? "expected value after ':', but end of JSON object found" : "expected value after ',', but end of JSON object found", NULL);
+			break;
+		case VALUE_OR_END_ARRAY: ThrowError("expected value or ']' after '[', but end of JSON object found", NULL); break;
+		case KEY_OR_END_HASH:    ThrowError("expected key after '{', but end of JSON object found", NULL);          break;
+		case KEY:                ThrowError("expected key after ',', but end of JSON object found", NULL);          break;
+		case COLON:              ThrowError("expected ':', but end of JSON object found", NULL);                    break;
+		case NEXT:
+			ThrowError(bInHash ? "expected ',' or '}', but end of JSON object found" : "expected ',' or ']', but end of JSON object found", NULL);
+			break;
+		default:                 ThrowError("syntax error", NULL);
+	}
+}
+
+//
+// Start of value
+//
+void CTPP2JSONStreamParser::BeginValue(CCHAR_P  szData)
+{
+	if (eState != VALUE && eState != VALUE_OR_END_ARRAY) { SyntaxError(szData); }
+
+	// Top level value
+	if (vContainers.empty()) { pValue = &oCDT; }
+	// Next element of ARRAY; element of HASH is created after ':'
+	else if (vContainers.back() -> GetType() == CDT::ARRAY_VAL)
+	{
+		CDT & oArray = *vContainers.back();
+		pValue = &oArray[oArray.Size()];
+	}
+}
+
+//
+// End of value
+//
+void CTPP2JSONStreamParser::EndValue()
+{
+	eState = vContainers.empty() ? DONE : NEXT;
+}
+
+//
+// End of string, number or word
+//
+void CTPP2JSONStreamParser::EndToken(CCHAR_P  szData)
+{
+	const eTokenState eEndedToken = eToken;
+	eToken = NO_TOKEN;
+
+	// String or number key
+	if (eState == KEY || eState == KEY_OR_END_HASH)
+	{
+		sKey.swap(sToken);
+		eState = COLON;
+		return;
+	}
+
+	if      (eEndedToken == STRING) { *pValue = CDT(sToken, pArena); }
+	else if (eEndedToken == NUMBER) { ConvertJSONNumber(sToken.data(), sToken.data() + sToken.size(), bFloat, *pValue); }
+	else
+	{
+		if      (strcasecmp("null",  sToken.c_str()) == 0) { *pValue = CDT(CDT::UNDEF); }
+		else if (strcasecmp("false", sToken.c_str()) == 0) { *pValue = 0; }
+		else if (strcasecmp("true",  sToken.c_str()) == 0) { *pValue = 1; }
+		// Unexpected data found
+		else { SyntaxError(szData); }
+	}
+
+	EndValue();
+}
+
+//
+// White space and structural characters
+//
+CCHAR_P CTPP2JSONStreamParser::ParseStructure(CCHAR_P  szData,
+                                              CCHAR_P  szEnd)
+{
+	// Skip white space
+	while (szData != szEnd && (*szData == ' ' || *szData == '\t' || *szData == '\r' || *szData == '\n')) { ++szData; }
+	if (szData == szEnd) { return szData; }
+
+	const CHAR_8 chData = *szData;
+	switch (chData)
+	{
+		// Comment
+		case '/':
+			eToken = COMMENT_START;
+			break;
+
+		case '{':
+			BeginValue(szData);
+			*pValue = CDT(CDT::HASH_VAL, pArena);
+			vContainers.push_back(pValue);
+			eState = KEY_OR_END_HASH;
+			break;
+
+		case '[':
+			BeginValue(szData);
+			*pValue = CDT(CDT::ARRAY_VAL, pArena);
+			vContainers.push_back(pValue);
+			eState = VALUE_OR_END_ARRAY;
+			break;
+
+		case '}':
+			if (eState != KEY_OR_END_HASH && !(eState == NEXT && vContainers.back() -> GetType() == CDT::HASH_VAL)) { SyntaxError(szData); }
+			vContainers.pop_back();
+			EndValue();
+			break;
+
+		case ']':
+			if (eState != VALUE_OR_END_ARRAY && !(eState == NEXT && vContainers.back() -> GetType() == CDT::ARRAY_VAL)) { SyntaxError(szData); }
+			vContainers.pop_back();
+			EndValue();
+			break;
+
+		case ',':
+			if (eState != NEXT) { SyntaxError(szData); }
+			eState = vContainers.back() -> GetType() == CDT::HASH_VAL ? KEY : VALUE;
+			break;
+
+		case ':':
+			if (eState != COLON) { SyntaxError(szData); }
+			pValue = &(*vContainers.back())[sKey];
+			eState = VALUE;
+			break;
+
+		// String value or key
+		case '"':
+		case '\'':
+			if (eState != KEY && eState != KEY_OR_END_HASH) { BeginValue(szData); }
+			sToken.erase();
+			chEOS  = chData;
+			eToken = STRING;
+			break;
+
+		default:
+			// Number value or key
+			if ((chData >= '0' && chData <= '9') || chData == '-' || chData == '+')
+			{
+				if (eState != KEY && eState != KEY_OR_END_HASH) { BeginValue(szData); }
+				sToken.assign(1, chData);
+				bFloat  = false;
+				eNumber = INTEGER;
+				eToken  = NUMBER;
+			}
+			// null, true, false
+			else if ((chData >= 'a' && chData <= 'z') || (chData >= 'A' && chData <= 'Z'))
+			{
+				BeginValue(szData);
+				sToken.assign(1, chData);
+				eToken = WORD;
+			}
+			else
+			{
+				SyntaxError(szData);
+			}
+	}
+
+return szData + 1;
+}
+
+//
+// Comments
+//
+CCHAR_P CTPP2JSONStreamParser::ParseComment(CCHAR_P  szData,
+                                            CCHAR_P  szEnd)
+{
+	switch (eToken)
+	{
+		// Character after '/'
+		case COMMENT_START:
+			if      (*szData == '*') { eToken = BLOCK_COMMENT; }
+			else if (*szData == '/') { eToken = LINE_COMMENT;  }
+			// Not a comment
+			else { SyntaxError(szData); }
+			return szData + 1;
+
+		// New line is parsed as white space
+		case LINE_COMMENT:
+			{
+				CCHAR_P szNewLine = (CCHAR_P)memchr(szData, '\n', szEnd - szData);
+				if (szNewLine == NULL) { return szEnd; }
+
+				eToken = NO_TOKEN;
+				return szNewLine;
+			}
+
+		case BLOCK_COMMENT:
+			{
+				CCHAR_P szStar = (CCHAR_P)memchr(szData, '*', szEnd - szData);
+				if (szStar == NULL) { return szEnd; }
+
+				eToken = BLOCK_COMMENT_STAR;
+				return szStar + 1;
+			}
+
+		// Character after '*' is skipped even if it is '*', as in CTPP2JSONParser::IsWhiteSpace
+		default:
+			eToken = (*szData == '/') ? NO_TOKEN : BLOCK_COMMENT;
+	}
+
+return szData + 1;
+}
+
+//
+// String
+//
+CCHAR_P CTPP2JSONStreamParser::ParseString(CCHAR_P  szData,
+                                           CCHAR_P  szEnd)
+{
+	while (szData != szEnd)
+	{
+		if (eToken == STRING)
+		{
+			// Copy span up to escape sequence or end of string
+			CCHAR_P szSpan = szData;
+			while (szData != szEnd && *szData != chEOS && *szData != '\\') { ++szData; }
+			sToken.append(szSpan, szData - szSpan);
+
+			if (szData == szEnd) { break; }
+
+			if (*szData == chEOS)
+			{
+				EndToken(szData);
+				return szData + 1;
+			}
+
+			eToken = STRING_ESCAPE;
+		}
+		else if (eToken == STRING_ESCAPE)
+		{
+			eToken = STRING;
+			switch (*szData)
+			{
+				// man ascii
+				case 'a': sToken += '\a'; break;
+				case 'b': sToken += '\b'; break;
+				case 't': sToken += '\t'; break;
+				case 'n': sToken += '\n'; break;
+				case 'v': sToken += '\v'; break;
+				case 'f': sToken += '\f'; break;
+				case 'r': sToken += '\r'; break;
+				// Unicode + 4 digits
+				case 'u':
+					iUnicode       = 0;
+					iUnicodeDigits = 0;
+					eToken         = STRING_UNICODE;
+					break;
+				default:
+					sToken += *szData;
+			}
+		}
+		else
+		{
+			const UCHAR_8 iCh = *szData;
+			if      (iCh >= '0' && iCh <= '9') { iUnicode = (iUnicode << 4) + (iCh - '0');      }
+			// Character parser accepts lowercase hex digits only
+			else if (iCh >= 'a' && iCh <= 'f') { iUnicode = (iUnicode << 4) + (iCh - 'a' + 10); }
+			else                               { ThrowError("invalid unicode escape sequence", szData); }
+
+			if (++iUnicodeDigits == 4)
+			{
+				UCHAR_8 aBuffer[6];
+				INT_32 iCharLength = UnicodeToUTF8(iUnicode, aBuffer);
+
+				sToken.append((CHAR_P)aBuffer, iCharLength);
+				eToken = STRING;
+			}
+		}
+
+		++szData;
+	}
+
+return szData;
+}
+
+//
+// Number
+//
+CCHAR_P CTPP2JSONStreamParser::ParseNumber(CCHAR_P  szData,
+                                           CCHAR_P  szEnd)
+{
+	CCHAR_P szNumber = szData;
+	for (; szData != szEnd; ++szData)
+	{
+		const CHAR_8 chData = *szData;
+		const bool   bDigit = chData >= '0' && chData <= '9';
+
+		// Digits and '.' continue number; any other character ends it
+		if      (eNumber == INTEGER  && (bDigit || chData == '.')) { if (!bDigit) { eNumber = FRACTION; bFloat = true; } }
+		else if (eNumber == FRACTION && (bDigit || chData == 'E' || chData == 'e')) { if (!bDigit) { eNumber = EXPONENT_START; } }
+		else if (eNumber == EXPONENT_START && (chData == '-' || chData == '+')) { eNumber = EXPONENT_SIGN; }
+		else if (eNumber == EXPONENT_START || eNumber == EXPONENT_SIGN)
+		{
+			if (!bDigit) { ThrowError("exponent has no digits", szData); }
+			eNumber = EXPONENT;
+		}
+		else if (!(eNumber == EXPONENT && bDigit)) { break; }
+	}
+
+	sToken.append(szNumber, szData - szNumber);
+	if (szData != szEnd) { EndToken(szData); }
+
+return szData;
+}
+
+//
+// Word
+//
+CCHAR_P CTPP2JSONStreamParser::ParseWord(CCHAR_P  szData,
+                                         CCHAR_P  szEnd)
+{
+	CCHAR_P szWord = szData;
+	while (szData != szEnd && ((*szData >= 'a' && *szData <= 'z') || (*szData >= 'A' && *szData <= 'Z'))) { ++szData; }
+
+	sToken.append(szWord, szData - szWord);
+	if (szData != szEnd) { EndToken(szData); }
+
+return szData;
+}
+
+//
+// Parse chunk of data
+//
+INT_32 CTPP2JSONStreamParser::Feed(CCHAR_P        szData,
+                                   const UINT_32  iDataLength)
+{
+	// Containers in arena get values of the same arena only
+	CDTArena::Builder oBuilder(pArena);
+
+	szChunk = szData;
+
+	CCHAR_P szEnd = szData + iDataLength;
+	while (szData != szEnd)
+	{
+		switch (eToken)
+		{
+			case NO_TOKEN:
+				szData = ParseStructure(szData, szEnd);
+				break;
+
+			case STRING:
+			case STRING_ESCAPE:
+			case STRING_UNICODE:
+				szData = ParseString(szData, szEnd);
+				break;
+
+			case NUMBER:
+				szData = ParseNumber(szData, szEnd);
+				break;
+
+			case WORD:
+				szData = ParseWord(szData, szEnd);
+				break;
+
+			default:
+				szData = ParseComment(szData, szEnd);
+		}
+	}
+
+	// Line and position of next chunk
+	CountLines(szChunk, szEnd, iLine, iLinePos);
+	szChunk = NULL;
+
+return 0;
+}
+
+//
+// End of data
+//
+INT_32 CTPP2JSONStreamParser::Finish()
+{
+	CDTArena::Builder oBuilder(pArena);
+
+	switch (eToken)
+	{
+		case NUMBER:
+			if (eNumber == EXPONENT_START || eNumber == EXPONENT_SIGN) { ThrowError("exponent has no digits", NULL); }
+			EndToken(NULL);
+			break;
+
+		// Character parser does not accept word at end of data
+		case WORD:
+		case COMMENT_START:
+			SyntaxError(NULL);
+			break;
+
+		case STRING:
+		case STRING_ESCAPE:
+			ThrowError("expected terminating character but end of JSON object found", NULL);
+			break;
+
+		case STRING_UNICODE:
+			ThrowError("invalid unicode escape sequence", NULL);
+			break;
+
+		// Unterminated comment is the same as white space
+		default:
+			;;
+	}
+
+	if (eState != DONE) { SyntaxError(NULL); }
+
+return 0;
+}
+
+//
+// A destructor
+//
+CTPP2JSONStreamParser::~CTPP2JSONStreamParser() throw()
+{
+	;;
+}
+
+} // namespace CTPP
+// End.
@@ -0,0 +1,171 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2MappedFile.cpp
+ *
+ * $CTPP$
+ */
+#include "CTPP2MappedFile.hpp"
+
+#include "CTPP2Exception.hpp"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace CTPP // C++ Template Engine
+{
+
+//
+// Constructor
+//
+MappedFile::MappedFile(): szData(NULL),
+                          iSize(0),
+                          bMapped(false)
+{
+	;;
+}
+
+//
+// Map file to memory
+//
+void MappedFile::Open(CCHAR_P szFileName)
+{
+	if (szData != NULL) { throw CTPPLogicError("File is already mapped"); }
+
+	// Open file
+	const INT_32 iFD = open(szFileName, O_RDONLY);
+	if (iFD == -1) { throw CTPPUnixException("open", errno); }
+
+	// Get file size
+	struct stat oStat;
+	if (fstat(iFD, &oStat) == -1)
+	{
+		const INT_32 iErrNo = errno;
+		close(iFD);
+		throw CTPPUnixException("fstat", iErrNo);
+	}
+
+	// Positions in file data are 32-bit
+	if (UINT_64(oStat.st_size) >= 0xFFFFFFFFull)
+	{
+		close(iFD);
+		throw CTPPLogicError("File is too large");
+	}
+
+	// Nothing to map
+	if (oStat.st_size == 0)
+	{
+		close(iFD);
+		return;
+	}
+
+	iSize = UINT_32(oStat.st_size);
+
+#ifdef HAVE_SYS_MMAN_H
+	// Map file read-only, all processes share one copy of data via page cache
+	void * vMapping = mmap(NULL, iSize, PROT_READ, MAP_SHARED, iFD, 0);
+	if (vMapping != MAP_FAILED)
+	{
+		szData  = static_cast<CHAR_P>(vMapping);
+		bMapped = true;
+	}
+	else
+#endif
+	{
+		// Allocate memory
+		szData = (CHAR_P)malloc(iSize);
+
+		// Read from file
+		UINT_32 iRead = 0;
+		while (iRead < iSize)
+		{
+			const ssize_t iBytes = read(iFD, szData + iRead, iSize - iRead);
+			if (iBytes == -1 && errno == EINTR) { continue; }
+
+			if (iBytes <= 0)
+			{
+				// File was truncated while reading
+				const INT_32 iErrNo = (iBytes == 0) ? EIO : errno;
+				close(iFD);
+				Close();
+				throw CTPPUnixException("read", iErrNo);
+			}
+			iRead += UINT_32(iBytes);
+		}
+	}
+
+	// All Done
+	close(iFD);
+}
+
+//
+// Get file data
+//
+CCHAR_P MappedFile::GetData() const { return szData; }
+
+//
+// Get file size
+//
+UINT_32 MappedFile::GetSize() const { return iSize; }
+
+//
+// Unmap or free file data
+//
+void MappedFile::Close() throw()
+{
+#ifdef HAVE_SYS_MMAN_H
+	if (bMapped) { munmap(szData, iSize); }
+	else
+#endif
+	{
+		free(szData);
+	}
+
+	szData  = NULL;
+	iSize   = 0;
+	bMapped = false;
+}
+
+//
+// A destructor
+//
+MappedFile::~MappedFile() throw()
+{
+	Close();
+}
+
+} // namespace CTPP
+// End.
@@ -259,7 +259,8 @@ CTPP2Parser::CTPP2Parser(CTPP2SourceLoader   * pISourceLoader,
                                                                   iRecursionLevel(iIRecursionLevel),
                                                                   bInsideComplexVariable(false),
                                                                   bVerboseMode(false),
-                                                                  bInBlock(false)
+                                                                  bInBlock(false),
+                                                                  bIncludeUnits(false)
 {
 	iSourceNameId = pCTPP2Compiler -> StoreSourceName(sSourceName.c_str(), sSourceName.size());
 }
@@ -317,6 +318,11 @@ void CTPP2Parser::SetBlockArgSizeMap(const CTPP2Parser::BlockArgSizeMapType & mI
 //
 CTPP2Parser::BlockArgSizeMapType CTPP2Parser::GetBlockArgSizeMap() const { return mBlockArgSizes; }
 
+//
+// Compile include files into callable units
+//
+void CTPP2Parser::SetIncludeUnits(const bool bIIncludeUnits) { bIncludeUnits = bIIncludeUnits; }
+
 // Simple tokens: open and close tags, operators, variables, strings and numbers //////////////////////////////////////////////////////////////////////////////////
 
 //
@@ -1742,6 +1748,9 @@ CCharIterator CTPP2Parser::VarOperator(CCharIterator szData, CCharIterator szEnd
 	if (sTMP == NULL) { throw CTPPParserSyntaxError("expected at least one space symbol", szData.GetLine(), szData.GetLinePos()); }
 	szData = sTMP;
 
+	// Start of expression code, simple variable output may be fused into one instruction
+	const UINT_32 iExprIP = pCTPP2Compiler -> GetCodeSize();
+
 	sTMP = IsExpr(szData, szEnd, eResultOperator);
 	STLW::string sExprDebug(szData(), sTMP() - szData());
 
@@ -1762,7 +1771,7 @@ CCharIterator CTPP2Parser::VarOperator(CCharIterator szData, CCharIterator szEnd
 	if (bRemoveTrailingNewLine || bVerboseMode) { RemoveTrailingNewLines(szData, szEnd); }
 
 	// Output variable
-	pCTPP2Compiler -> OutputVariable(VM_DEBUG(szData));
+	pCTPP2Compiler -> OutputVariable(iExprIP, VM_DEBUG(szData));
 
 return szData;
 }
@@ -2127,12 +2136,34 @@ CCharIterator CTPP2Parser::IncludeOperator(CCharIterator szData, CCharIterator s
 		pTMPSourceLoader = pSourceLoader -> Clone();
 		// Load template
 		pTMPSourceLoader -> LoadTemplate(sIncludeFilename.c_str());
-		// Create parser
-		CTPP2Parser oTMPParser(pTMPSourceLoader, pCTPP2Compiler, sIncludeFilename, bInForeach, iRecursionLevel + 1);
-		oTMPParser.SetBlockArgSizeMap(mBlockArgSizes);
-		// No HLT at end of code
-		oTMPParser.Compile(0);
-		mBlockArgSizes = oTMPParser.GetBlockArgSizeMap();
+
+		// Iterators of enclosing loop are addressed by stack depth, so include inside loop is always inlined
+		const bool bIncludeUnit = bIncludeUnits && !bInForeach;
+		STLW::string sUnitName;
+		if (bIncludeUnit)
+		{
+			CCHAR_P szUnitName = pTMPSourceLoader -> GetTemplateName();
+			sUnitName.assign(szUnitName != NULL ? szUnitName : sIncludeFilename.c_str());
+		}
+
+		const INT_32 iEntryIP = bIncludeUnit ? pCTPP2Compiler -> GetIncludeUnit(sUnitName) : -1;
+		// Unit already compiled
+		if (iEntryIP != -1) { pCTPP2Compiler -> CallIncludeUnit(iEntryIP, VM_DEBUG(szData)); }
+		else
+		{
+			UINT_32 iJumpIP = 0;
+			if (bIncludeUnit) { iJumpIP = pCTPP2Compiler -> StartIncludeUnit(VM_DEBUG(szData)); }
+
+			// Create parser
+			CTPP2Parser oTMPParser(pTMPSourceLoader, pCTPP2Compiler, sIncludeFilename, bInForeach, iRecursionLevel + 1);
+			oTMPParser.SetBlockArgSizeMap(mBlockArgSizes);
+			oTMPParser.SetIncludeUnits(bIncludeUnits);
+			// No HLT at end of code
+			oTMPParser.Compile(0);
+			mBlockArgSizes = oTMPParser.GetBlockArgSizeMap();
+
+			if (bIncludeUnit) { pCTPP2Compiler -> EndIncludeUnit(sUnitName, iJumpIP, VM_DEBUG(szData)); }
+		}
 	}
 	catch(CTPPLogicError & e)
 	{
@@ -32,14 +32,17 @@
 #include "CTPP2SimpleCompiler.hpp"
 
 #include "CTPP2Compiler.hpp"
+#include "CTPP2Exception.hpp"
 #include "CTPP2FileSourceLoader.hpp"
 #include "CTPP2Parser.hpp"
 
 #include "CTPP2SyscallFactory.hpp"
+#include "CTPP2Util.hpp"
 #include "CTPP2VM.hpp"
 #include "CTPP2VMDumper.hpp"
 #include "CTPP2VMLoader.hpp"
 #include "CTPP2VMOpcodeCollector.hpp"
+#include "CTPP2VMOptimizer.hpp"
 
 
 namespace CTPP // C++ Template Engine
@@ -109,6 +112,10 @@ SimpleCompiler::SimpleCompiler(const std::string & sSourceFile)
 	// Compile template
 	oCTPP2Parser.Compile();
 
+	// Merge outputs of static text
+	VMOptimizer oOptimizer(oVMOpcodeCollector, oStaticData, oStaticText, oHashTable);
+	oOptimizer.MergeStaticOutput();
+
 	// Get program core
 	UINT_32 iCodeSize = 0;
 	const VMInstruction * oVMInstruction = oVMOpcodeCollector.GetCode(iCodeSize);
@@ -121,19 +128,14 @@ SimpleCompiler::SimpleCompiler(const std::string & sSourceFile)
 //
 UINT_32 SimpleCompiler::Save(const std::string & sCompiledFile) const
 {
-	INT_32 iRC = -1;
-
-	// Open file only if compilation is done
-	FILE * FW = fopen(sCompiledFile.c_str(), "wb");
-	if (FW == NULL) { return iRC; }
-
-	// Write to the disc
-	if (fwrite(pSimpleCompiler -> vm_executable, pSimpleCompiler -> vm_executable_size, 1, FW) == 1) { iRC =0 ; }
-
-	// All done
-	fclose(FW);
-
-return iRC;
+	// Old file may be mapped by running programs, so it is replaced, not rewritten
+	try
+	{
+		ReplaceFile(sCompiledFile, pSimpleCompiler -> vm_executable, pSimpleCompiler -> vm_executable_size);
+	}
+	catch(CTPPUnixException &) { return -1; }
+
+return 0;
 }
 
 
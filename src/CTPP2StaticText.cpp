@@ -111,6 +111,14 @@ StaticText::StaticText(CCHAR_P                sIData,
 
 	memcpy(sData, sIData, iMaxDataSize);
 	memcpy(aDataOffsets, aIDataOffsets, iMaxDataOffsetsSize * sizeof(TextDataIndex));
+
+	// Build index of stored data
+	vReferences.assign(iUsedDataOffsetsSize, 1);
+	for (UINT_32 iDataId = 0; iDataId < iUsedDataOffsetsSize; ++iDataId)
+	{
+		const TextDataIndex & oDataIndex = aDataOffsets[iDataId];
+		mDataIndex.insert(STLW::pair<STLW::string, UINT_32>(STLW::string(sData + oDataIndex.offset, oDataIndex.length), iDataId));
+	}
 }
 
 //
@@ -118,6 +126,15 @@ StaticText::StaticText(CCHAR_P                sIData,
 //
 UINT_32 StaticText::StoreData(CCHAR_P sStoreData, const UINT_32  iDataLength)
 {
+	// Data already stored?
+	const STLW::string sKey(sStoreData, iDataLength);
+	STLW::map<STLW::string, UINT_32>::const_iterator itmDataIndex = mDataIndex.find(sKey);
+	if (itmDataIndex != mDataIndex.end())
+	{
+		++vReferences[itmDataIndex -> second];
+		return itmDataIndex -> second;
+	}
+
 	// New data offset
 	UINT_32 iDataOffset = iUsedDataSize + iDataLength;
 
@@ -156,9 +173,54 @@ UINT_32 StaticText::StoreData(CCHAR_P sStoreData, const UINT_32  iDataLength)
 
 	iUsedDataSize = iDataOffset + 1;
 
+	mDataIndex[sKey] = iUsedDataOffsetsSize;
+	vReferences.push_back(1);
+
 return iUsedDataOffsetsSize++;
 }
 
+//
+// Release data
+//
+void StaticText::ReleaseData(const UINT_32  iDataId)
+{
+	if (iDataId >= iUsedDataOffsetsSize || vReferences[iDataId] == 0) { return; }
+
+	if (--vReferences[iDataId] != 0) { return; }
+
+	// Data is not used any more; record itself is kept to preserve IDs of other records
+	const TextDataIndex & oDataIndex = aDataOffsets[iDataId];
+	mDataIndex.erase(STLW::string(sData + oDataIndex.offset, oDataIndex.length));
+}
+
+//
+// Remove unreferenced text from segment
+//
+UINT_32 StaticText::Compact()
+{
+	UINT_32 iDataOffset = 0;
+	for (UINT_32 iDataId = 0; iDataId < iUsedDataOffsetsSize; ++iDataId)
+	{
+		TextDataIndex & oDataIndex = aDataOffsets[iDataId];
+		if (vReferences[iDataId] == 0)
+		{
+			oDataIndex.offset = 0;
+			oDataIndex.length = 0;
+			continue;
+		}
+
+		// Move data with trailing zero
+		memmove(sData + iDataOffset, sData + oDataIndex.offset, oDataIndex.length + 1);
+		oDataIndex.offset = iDataOffset;
+		iDataOffset += oDataIndex.length + 1;
+	}
+
+	const UINT_32 iFreed = iUsedDataSize - iDataOffset;
+	iUsedDataSize = iDataOffset;
+
+return iFreed;
+}
+
 //
 // GetData by ID
 //
@@ -177,6 +239,11 @@ return &sData[aDataOffsets[iDataId].offset];
 //
 UINT_32 StaticText::GetRecordsNum() const { return iUsedDataOffsetsSize; }
 
+//
+// Get size of text segment
+//
+UINT_32 StaticText::GetDataSize() const { return iUsedDataSize; }
+
 //
 // A destructor
 //
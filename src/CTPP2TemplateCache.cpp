@@ -0,0 +1,603 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2TemplateCache.cpp
+ *
+ * $CTPP$
+ */
+#include "CTPP2TemplateCache.hpp"
+
+#include "CTPP2Exception.hpp"
+#include "CTPP2Logger.hpp"
+#include "CTPP2SimpleCompiler.hpp"
+#include "CTPP2VMFileLoader.hpp"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace CTPP // C++ Template Engine
+{
+
+//
+// Extension of compiled templates
+//
+static const STLW::string sCompiledExtension(".ct2");
+
+//
+// Lock mutex until end of scope
+//
+class MutexLock
+{
+public:
+	/**
+	  @brief Constructor
+	  @param pIMutex - mutex to lock
+	*/
+	MutexLock(pthread_mutex_t * pIMutex): pMutex(pIMutex) { pthread_mutex_lock(pMutex); }
+
+	/**
+	  @brief A destructor
+	*/
+	~MutexLock() throw() { pthread_mutex_unlock(pMutex); }
+private:
+	/** Locked mutex */
+	pthread_mutex_t  * pMutex;
+};
+
+//
+// Check whether file was changed
+//
+static bool FileChanged(const struct stat  & oOld,
+                        const struct stat  & oNew)
+{
+	return oOld.st_dev   != oNew.st_dev   ||
+	       oOld.st_ino   != oNew.st_ino   ||
+	       oOld.st_size  != oNew.st_size  ||
+	       oOld.st_mtime != oNew.st_mtime;
+}
+
+/**
+  @struct TemplateCache::Template CTPP2TemplateCache.cpp
+  @brief Loaded template, immutable for readers
+*/
+struct TemplateCache::Template
+{
+	/** File name                                    */
+	STLW::string          name;
+	/** State of file; changed only under writers lock */
+	struct stat           file_stat;
+	/** Loader of compiled template                  */
+	VMFileLoader        * loader;
+	/** Compiler of template source                  */
+	SimpleCompiler      * compiler;
+	/** Ready-to-run program                         */
+	const VMMemoryCore  * core;
+
+	/**
+	  @brief Constructor, load or compile template
+	  @param sName - file name
+	  @param oStat - state of file before loading
+	*/
+	Template(const STLW::string  & sName,
+	         const struct stat   & oStat);
+
+	/**
+	  @brief A destructor
+	*/
+	~Template() throw();
+};
+
+//
+// Constructor
+//
+TemplateCache::Template::Template(const STLW::string  & sName,
+                                  const struct stat   & oStat): name(sName),
+                                                                file_stat(oStat),
+                                                                loader(NULL),
+                                                                compiler(NULL),
+                                                                core(NULL)
+{
+	if (sName.size() > sCompiledExtension.size() &&
+	    sName.compare(sName.size() - sCompiledExtension.size(), sCompiledExtension.size(), sCompiledExtension) == 0)
+	{
+		loader = new VMFileLoader(sName.c_str());
+		core   = loader -> GetCore();
+	}
+	else
+	{
+		compiler = new SimpleCompiler(sName);
+		core     = compiler -> GetCore();
+	}
+}
+
+//
+// A destructor
+//
+TemplateCache::Template::~Template() throw()
+{
+	delete loader;
+	delete compiler;
+}
+
+/**
+  @struct TemplateCache::Table CTPP2TemplateCache.cpp
+  @brief Immutable table of templates; templates are not owned by table
+*/
+struct TemplateCache::Table
+{
+	/** Templates by file name */
+	STLW::map<STLW::string, Template *>  templates;
+};
+
+/**
+  @struct TemplateCache::ReaderSlot CTPP2TemplateCache.cpp
+  @brief Numbers of readers in even and odd epochs, one cache line per slot
+*/
+struct TemplateCache::ReaderSlot
+{
+	/** Number of readers by epoch parity */
+	UINT_32            readers[2];
+	/** Padding up to cache line          */
+	CHAR_8             padding[C_TEMPLATE_CACHE_LINE_SIZE - 2 * sizeof(UINT_32)];
+};
+
+// ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Class TemplateCache::Handle
+//
+
+//
+// Constructor
+//
+TemplateCache::Handle::Handle(): pSlot(NULL), iParity(0), pTemplate(NULL) { ;; }
+
+//
+// Copy constructor
+//
+TemplateCache::Handle::Handle(const Handle & oRhs): pSlot(oRhs.pSlot),
+                                                    iParity(oRhs.iParity),
+                                                    pTemplate(oRhs.pTemplate)
+{
+	// Epoch of original is not finished, so it is safe to join it
+	if (pSlot != NULL) { __atomic_fetch_add(&(pSlot -> readers[iParity]), 1, __ATOMIC_SEQ_CST); }
+}
+
+//
+// Copy operator
+//
+TemplateCache::Handle & TemplateCache::Handle::operator=(const Handle & oRhs)
+{
+	if (oRhs.pSlot != NULL) { __atomic_fetch_add(&(oRhs.pSlot -> readers[oRhs.iParity]), 1, __ATOMIC_SEQ_CST); }
+	Release();
+
+	pSlot     = oRhs.pSlot;
+	iParity   = oRhs.iParity;
+	pTemplate = oRhs.pTemplate;
+
+return *this;
+}
+
+//
+// Get ready-to-run program
+//
+const VMMemoryCore * TemplateCache::Handle::GetCore() const
+{
+	if (pTemplate == NULL) { return NULL; }
+
+return pTemplate -> core;
+}
+
+//
+// Release reference
+//
+void TemplateCache::Handle::Release() throw()
+{
+	if (pSlot != NULL) { __atomic_fetch_sub(&(pSlot -> readers[iParity]), 1, __ATOMIC_SEQ_CST); }
+
+	pSlot     = NULL;
+	pTemplate = NULL;
+}
+
+//
+// A destructor
+//
+TemplateCache::Handle::~Handle() throw() { Release(); }
+
+// ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Class TemplateCache
+//
+
+//
+// Constructor
+//
+TemplateCache::TemplateCache(): pTable(new Table),
+                                iEpoch(0),
+                                aSlots(NULL),
+                                iNextSlot(0),
+                                bCheckerRunning(false),
+                                bStopChecker(false),
+                                iCheckInterval(0),
+                                pCheckerLogger(NULL)
+{
+	void * vSlots = NULL;
+	INT_32 iRC = posix_memalign(&vSlots, C_TEMPLATE_CACHE_LINE_SIZE, sizeof(ReaderSlot) * C_TEMPLATE_CACHE_READER_SLOTS);
+	if (iRC != 0)
+	{
+		delete pTable;
+		throw CTPPUnixException("posix_memalign", iRC);
+	}
+
+	memset(vSlots, 0, sizeof(ReaderSlot) * C_TEMPLATE_CACHE_READER_SLOTS);
+	aSlots = static_cast<ReaderSlot *>(vSlots);
+
+	iRC = pthread_key_create(&oSlotKey, NULL);
+	if (iRC != 0)
+	{
+		free(aSlots);
+		delete pTable;
+		throw CTPPUnixException("pthread_key_create", iRC);
+	}
+
+	pthread_mutex_init(&oWriteMutex, NULL);
+	pthread_mutex_init(&oCheckerMutex, NULL);
+	pthread_cond_init(&oCheckerCond, NULL);
+}
+
+//
+// Get reader slot of current thread
+//
+TemplateCache::ReaderSlot * TemplateCache::GetSlot()
+{
+	ReaderSlot * pSlot = static_cast<ReaderSlot *>(pthread_getspecific(oSlotKey));
+	if (pSlot != NULL) { return pSlot; }
+
+	// Threads are spread over slots round-robin, so readers do not share cache lines
+	pSlot = &aSlots[__atomic_fetch_add(&iNextSlot, 1, __ATOMIC_RELAXED) % C_TEMPLATE_CACHE_READER_SLOTS];
+	pthread_setspecific(oSlotKey, pSlot);
+
+return pSlot;
+}
+
+//
+// Find template, lock-free
+//
+bool TemplateCache::Find(const STLW::string  & sName,
+                         Handle              & oHandle)
+{
+	ReaderSlot * pSlot = GetSlot();
+
+	// Enter current epoch; retry if epoch was changed before registration
+	UINT_32 iParity = 0;
+	for (;;)
+	{
+		const UINT_32 iCurrentEpoch = __atomic_load_n(&iEpoch, __ATOMIC_SEQ_CST);
+		iParity = iCurrentEpoch & 1;
+
+		__atomic_fetch_add(&(pSlot -> readers[iParity]), 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&iEpoch, __ATOMIC_SEQ_CST) == iCurrentEpoch) { break; }
+		__atomic_fetch_sub(&(pSlot -> readers[iParity]), 1, __ATOMIC_SEQ_CST);
+	}
+
+	const Table * pCurrentTable = __atomic_load_n(&pTable, __ATOMIC_ACQUIRE);
+	STLW::map<STLW::string, Template *>::const_iterator itmTemplate = pCurrentTable -> templates.find(sName);
+	if (itmTemplate == pCurrentTable -> templates.end())
+	{
+		__atomic_fetch_sub(&(pSlot -> readers[iParity]), 1, __ATOMIC_SEQ_CST);
+		return false;
+	}
+
+	oHandle.Release();
+	oHandle.pSlot     = pSlot;
+	oHandle.iParity   = iParity;
+	oHandle.pTemplate = itmTemplate -> second;
+
+return true;
+}
+
+//
+// Get template, load it if need
+//
+TemplateCache::Handle TemplateCache::Get(const STLW::string & sName)
+{
+	Handle oHandle;
+	if (Find(sName, oHandle)) { return oHandle; }
+
+	struct stat oStat;
+	if (stat(sName.c_str(), &oStat) == -1) { throw CTPPUnixException("stat", errno); }
+
+	{
+		MutexLock oLock(&oWriteMutex);
+
+		// Template may be loaded by other thread
+		if (Find(sName, oHandle)) { return oHandle; }
+
+		Template * pTemplate = new Template(sName, oStat);
+		Table    * pNewTable = NULL;
+		try
+		{
+			pNewTable = new Table(*pTable);
+			pNewTable -> templates[sName] = pTemplate;
+
+			Publish(pNewTable, STLW::vector<Template *>());
+		}
+		catch(...)
+		{
+			delete pNewTable;
+			delete pTemplate;
+			throw;
+		}
+		Reclaim();
+	}
+
+	Find(sName, oHandle);
+
+return oHandle;
+}
+
+//
+// Reload changed templates
+//
+UINT_32 TemplateCache::CheckUpdates(Logger * pLogger)
+{
+	MutexLock oLock(&oWriteMutex);
+
+	UINT_32                   iReloaded = 0;
+	Table                   * pNewTable = NULL;
+	STLW::vector<Template *>  vReplaced;
+
+	try
+	{
+		STLW::map<STLW::string, Template *>::const_iterator itmTemplate = pTable -> templates.begin();
+		while (itmTemplate != pTable -> templates.end())
+		{
+			Template * pTemplate = itmTemplate -> second;
+			++itmTemplate;
+
+			struct stat oStat;
+			if (stat(pTemplate -> name.c_str(), &oStat) == -1 || !FileChanged(pTemplate -> file_stat, oStat)) { continue; }
+
+			// Old version is used until file is changed again
+			Template * pNewTemplate = LoadTemplate(pTemplate, oStat, pLogger);
+			if (pNewTemplate == NULL) { continue; }
+
+			try
+			{
+				if (pNewTable == NULL) { pNewTable = new Table(*pTable); }
+				vReplaced.push_back(pTemplate);
+			}
+			catch(...)
+			{
+				delete pNewTemplate;
+				throw;
+			}
+
+			// Key exists, nothing is allocated
+			pNewTable -> templates[pTemplate -> name] = pNewTemplate;
+			++iReloaded;
+		}
+
+		if (pNewTable != NULL) { Publish(pNewTable, vReplaced); }
+	}
+	catch(...)
+	{
+		// Templates of unpublished table, which are not in current table, are loaded by this call
+		if (pNewTable != NULL)
+		{
+			STLW::map<STLW::string, Template *>::const_iterator itmTemplate = pNewTable -> templates.begin();
+			for (; itmTemplate != pNewTable -> templates.end(); ++itmTemplate)
+			{
+				if (pTable -> templates.find(itmTemplate -> first) -> second != itmTemplate -> second) { delete itmTemplate -> second; }
+			}
+			delete pNewTable;
+		}
+		throw;
+	}
+
+	Reclaim();
+
+return iReloaded;
+}
+
+//
+// Load new version of template, NULL if it cannot be loaded
+//
+TemplateCache::Template * TemplateCache::LoadTemplate(Template           * pTemplate,
+                                                      const struct stat  & oStat,
+                                                      Logger             * pLogger)
+{
+	STLW::string sError;
+	try
+	{
+		return new Template(pTemplate -> name, oStat);
+	}
+	catch(CTPPException & e)    { sError = e.what(); }
+	catch(STLW::exception & e)  { sError = e.what(); }
+	catch(...)                  { sError = "Unknown error"; }
+
+	pTemplate -> file_stat = oStat;
+	if (pLogger != NULL) { pLogger -> Err("Cannot reload template `%s`: %s", pTemplate -> name.c_str(), sError.c_str()); }
+
+return NULL;
+}
+
+//
+// Publish new table
+//
+void TemplateCache::Publish(Table                           * pNewTable,
+                            const STLW::vector<Template *>  & vReplaced)
+{
+	Table * pOldTable = pTable;
+
+	// Nothing can throw after new table is visible
+	vPendingTables.reserve(vPendingTables.size() + 1);
+	vPendingTemplates.reserve(vPendingTemplates.size() + vReplaced.size());
+
+	// Content of table must be visible before pointer to it
+	__atomic_store_n(&pTable, pNewTable, __ATOMIC_SEQ_CST);
+
+	vPendingTables.push_back(pOldTable);
+	vPendingTemplates.insert(vPendingTemplates.end(), vReplaced.begin(), vReplaced.end());
+}
+
+//
+// Release retired objects if readers of old epoch are gone, advance epoch
+//
+void TemplateCache::Reclaim()
+{
+	const UINT_32 iCurrentEpoch = iEpoch;
+	const UINT_32 iOldParity    = (iCurrentEpoch + 1) & 1;
+
+	// Readers, which entered before last change of epoch, are still working
+	for (UINT_32 iPos = 0; iPos < C_TEMPLATE_CACHE_READER_SLOTS; ++iPos)
+	{
+		if (__atomic_load_n(&(aSlots[iPos].readers[iOldParity]), __ATOMIC_SEQ_CST) != 0) { return; }
+	}
+
+	// Nobody can see objects retired before last change of epoch
+	for (UINT_32 iPos = 0; iPos < vWaitingTables.size(); ++iPos)    { delete vWaitingTables[iPos];    }
+	for (UINT_32 iPos = 0; iPos < vWaitingTemplates.size(); ++iPos) { delete vWaitingTemplates[iPos]; }
+	vWaitingTables.clear();
+	vWaitingTemplates.clear();
+
+	if (vPendingTables.empty() && vPendingTemplates.empty()) { return; }
+
+	// Objects retired in current epoch wait for its readers
+	vWaitingTables.swap(vPendingTables);
+	vWaitingTemplates.swap(vPendingTemplates);
+
+	__atomic_store_n(&iEpoch, iCurrentEpoch + 1, __ATOMIC_SEQ_CST);
+}
+
+//
+// Start background thread
+//
+void TemplateCache::StartChecker(const UINT_32    iInterval,
+                                 Logger         * pLogger)
+{
+	MutexLock oLock(&oCheckerMutex);
+
+	if (bCheckerRunning) { throw CTPPLogicError("Checker thread is already running"); }
+
+	iCheckInterval = iInterval;
+	pCheckerLogger = pLogger;
+	bStopChecker   = false;
+
+	const INT_32 iRC = pthread_create(&oChecker, NULL, CheckerThread, this);
+	if (iRC != 0) { throw CTPPUnixException("pthread_create", iRC); }
+
+	bCheckerRunning = true;
+}
+
+//
+// Stop background thread
+//
+void TemplateCache::StopChecker()
+{
+	{
+		MutexLock oLock(&oCheckerMutex);
+		if (!bCheckerRunning) { return; }
+
+		bStopChecker = true;
+		pthread_cond_signal(&oCheckerCond);
+	}
+
+	pthread_join(oChecker, NULL);
+
+	MutexLock oLock(&oCheckerMutex);
+	bCheckerRunning = false;
+}
+
+//
+// Checker thread function
+//
+void * TemplateCache::CheckerThread(void * pContext)
+{
+	TemplateCache * pCache = static_cast<TemplateCache *>(pContext);
+
+	MutexLock oLock(&(pCache -> oCheckerMutex));
+	while (!pCache -> bStopChecker)
+	{
+		struct timeval oNow;
+		gettimeofday(&oNow, NULL);
+
+		const UINT_64 iDeadline = (UINT_64(oNow.tv_sec) * 1000000 + oNow.tv_usec) + UINT_64(pCache -> iCheckInterval) * 1000;
+		struct timespec oDeadline;
+		oDeadline.tv_sec  = iDeadline / 1000000;
+		oDeadline.tv_nsec = (iDeadline % 1000000) * 1000;
+
+		pthread_cond_timedwait(&(pCache -> oCheckerCond), &(pCache -> oCheckerMutex), &oDeadline);
+		if (pCache -> bStopChecker) { break; }
+
+		// Renders are not blocked by check, only loading of new templates
+		pthread_mutex_unlock(&(pCache -> oCheckerMutex));
+		try
+		{
+			pCache -> CheckUpdates(pCache -> pCheckerLogger);
+		}
+		catch(...) { ;; }
+		pthread_mutex_lock(&(pCache -> oCheckerMutex));
+	}
+
+return NULL;
+}
+
+//
+// A destructor
+//
+TemplateCache::~TemplateCache() throw()
+{
+	StopChecker();
+
+	STLW::map<STLW::string, Template *>::const_iterator itmTemplate = pTable -> templates.begin();
+	while (itmTemplate != pTable -> templates.end())
+	{
+		delete itmTemplate -> second;
+		++itmTemplate;
+	}
+	delete pTable;
+
+	for (UINT_32 iPos = 0; iPos < vPendingTables.size(); ++iPos)    { delete vPendingTables[iPos];    }
+	for (UINT_32 iPos = 0; iPos < vPendingTemplates.size(); ++iPos) { delete vPendingTemplates[iPos]; }
+	for (UINT_32 iPos = 0; iPos < vWaitingTables.size(); ++iPos)    { delete vWaitingTables[iPos];    }
+	for (UINT_32 iPos = 0; iPos < vWaitingTemplates.size(); ++iPos) { delete vWaitingTemplates[iPos]; }
+
+	pthread_cond_destroy(&oCheckerCond);
+	pthread_mutex_destroy(&oCheckerMutex);
+	pthread_mutex_destroy(&oWriteMutex);
+	pthread_key_delete(oSlotKey);
+
+	free(aSlots);
+}
+
+} // namespace CTPP
+// End.
@@ -30,11 +30,25 @@
  * $CTPP$
  */
 #include "CTPP2Util.hpp"
+#include "CTPP2Escape.hpp"
 #include "CTPP2Exception.hpp"
 
 #include "CDT.hpp"
 
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+/** Numbers shorter than this are copied to stack buffer for conversion */
+#define C_JSON_MAX_NUMBER_LENGTH    64
 
 namespace CTPP // C++ Template Engine
 {
@@ -79,9 +93,14 @@ static const UINT_32 aCRC32[] =
 //
 // Calculate crc32 checksum
 //
-UINT_32 crc32(UCCHAR_P sBuffer, const UINT_32 & iSize)
+UINT_32 crc32(UCCHAR_P sBuffer, const UINT_32 & iSize) { return crc32(sBuffer, iSize, 0); }
+
+//
+// Continue calculation of crc32 checksum
+//
+UINT_32 crc32(UCCHAR_P sBuffer, const UINT_32 & iSize, const UINT_32 & iPrevCRC)
 {
-	UINT_32 iCRC = 0;
+	UINT_32 iCRC = iPrevCRC;
 
 	for (UINT_32 iI = 0; iI < iSize; ++iI)
 	{
@@ -126,49 +145,8 @@ return u.ul;
 //
 STLW::string URLEscape(const STLW::string  & sData)
 {
-	static const CHAR_8 * szEscape = "0123456789ABCDEF";
-
-	CHAR_8 sBuffer[CTPP_ESCAPE_BUFFER_LEN + 1];
-
-	STLW::string sRetVal = "";
-
-	UINT_32 iBufferPointer = 0;
-
-	// Get string to escape
-	STLW::string::const_iterator itsData = sData.begin();
-	while (itsData != sData.end())
-	{
-		UCHAR_8 chTMP = (UCHAR_8)(*itsData);
-
-		if ((chTMP >= 'a' && chTMP <= 'z') ||
-		    (chTMP >= 'A' && chTMP <= 'Z') ||
-		    (chTMP >= '0' && chTMP <= '9') ||
-		     chTMP == '/' || chTMP == '.' || chTMP == '-' || chTMP == '_')
-		{
-			sBuffer[iBufferPointer++] = *itsData;
-		}
-		else if (chTMP == ' ') { sBuffer[iBufferPointer++] = '+'; }
-		else
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 3))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-			sBuffer[iBufferPointer++] = '%';
-			sBuffer[iBufferPointer++] = szEscape[((chTMP >> 4) & 0x0F)];
-			sBuffer[iBufferPointer++] = szEscape[(chTMP & 0x0F)];
-		}
-
-		if (iBufferPointer == CTPP_ESCAPE_BUFFER_LEN)
-		{
-			sRetVal.append(sBuffer, iBufferPointer);
-			iBufferPointer = 0;
-		}
-		++itsData;
-	}
-
-	if (iBufferPointer != 0) { sRetVal.append(sBuffer, iBufferPointer); }
+	STLW::string sRetVal;
+	Escape(ESCAPE_URL, sData.data(), sData.size(), sRetVal);
 
 return sRetVal;
 }
@@ -178,48 +156,8 @@ return sRetVal;
 //
 STLW::string URIEscape(const STLW::string  & sData)
 {
-	static const CHAR_8 * szEscape = "0123456789ABCDEF";
-
-	CHAR_8 sBuffer[CTPP_ESCAPE_BUFFER_LEN + 1];
-
-	STLW::string sRetVal = "";
-
-	UINT_32 iBufferPointer = 0;
-
-	// Get string to escape
-	STLW::string::const_iterator itsData = sData.begin();
-	while (itsData != sData.end())
-	{
-		UCHAR_8 chTMP = (UCHAR_8)(*itsData);
-
-		if ((chTMP >= 'a' && chTMP <= 'z') ||
-		    (chTMP >= 'A' && chTMP <= 'Z') ||
-		    (chTMP >= '0' && chTMP <= '9') ||
-		     chTMP == '/' || chTMP == '.' || chTMP == '-' || chTMP == '_')
-		{
-			sBuffer[iBufferPointer++] = *itsData;
-		}
-		else
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 3))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-			sBuffer[iBufferPointer++] = '%';
-			sBuffer[iBufferPointer++] = szEscape[((chTMP >> 4) & 0x0F)];
-			sBuffer[iBufferPointer++] = szEscape[(chTMP & 0x0F)];
-		}
-
-		if (iBufferPointer == CTPP_ESCAPE_BUFFER_LEN)
-		{
-			sRetVal.append(sBuffer, iBufferPointer);
-			iBufferPointer = 0;
-		}
-		++itsData;
-	}
-
-	if (iBufferPointer != 0) { sRetVal.append(sBuffer, iBufferPointer); }
+	STLW::string sRetVal;
+	Escape(ESCAPE_URI, sData.data(), sData.size(), sRetVal);
 
 return sRetVal;
 }
@@ -229,101 +167,8 @@ return sRetVal;
 //
 STLW::string HTMLEscape(const STLW::string  & sData)
 {
-	CHAR_8 sBuffer[CTPP_ESCAPE_BUFFER_LEN + 1];
-
-	STLW::string sRetVal = "";
-
-	UINT_32 iBufferPointer = 0;
-
-	// Get string to escape
-	STLW::string::const_iterator itsData = sData.begin();
-	while (itsData != sData.end())
-	{
-		UCHAR_8 chTMP = (UCHAR_8)(*itsData);
-
-		if (chTMP == '"')
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 6))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '&';
-			sBuffer[iBufferPointer++] = 'q';
-			sBuffer[iBufferPointer++] = 'u';
-			sBuffer[iBufferPointer++] = 'o';
-			sBuffer[iBufferPointer++] = 't';
-			sBuffer[iBufferPointer++] = ';';
-		}
-		else if (chTMP == '\'')
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 5))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '&';
-			sBuffer[iBufferPointer++] = '#';
-			sBuffer[iBufferPointer++] = '3';
-			sBuffer[iBufferPointer++] = '9';
-			sBuffer[iBufferPointer++] = ';';
-		}
-		else if (chTMP == '<')
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 4))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '&';
-			sBuffer[iBufferPointer++] = 'l';
-			sBuffer[iBufferPointer++] = 't';
-			sBuffer[iBufferPointer++] = ';';
-		}
-		else if (chTMP == '>')
-		{
-			if (iBufferPointer >= CTPP_ESCAPE_BUFFER_LEN - 4)
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '&';
-			sBuffer[iBufferPointer++] = 'g';
-			sBuffer[iBufferPointer++] = 't';
-			sBuffer[iBufferPointer++] = ';';
-		}
-		else if (chTMP == '&')
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 5))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '&';
-			sBuffer[iBufferPointer++] = 'a';
-			sBuffer[iBufferPointer++] = 'm';
-			sBuffer[iBufferPointer++] = 'p';
-			sBuffer[iBufferPointer++] = ';';
-		}
-		else
-		{
-			sBuffer[iBufferPointer++] = *itsData;
-		}
-
-		if (iBufferPointer == CTPP_ESCAPE_BUFFER_LEN)
-		{
-			sRetVal.append(sBuffer, iBufferPointer);
-			iBufferPointer = 0;
-		}
-		++itsData;
-	}
-
-	if (iBufferPointer != 0) { sRetVal.append(sBuffer, iBufferPointer); }
+	STLW::string sRetVal;
+	Escape(ESCAPE_HTML, sData.data(), sData.size(), sRetVal);
 
 return sRetVal;
 }
@@ -333,102 +178,8 @@ return sRetVal;
 //
 STLW::string XMLEscape(const STLW::string  & sData)
 {
-	CHAR_8 sBuffer[CTPP_ESCAPE_BUFFER_LEN + 1];
-
-	STLW::string sRetVal = "";
-
-	UINT_32 iBufferPointer = 0;
-
-	// Get string to escape
-	STLW::string::const_iterator itsData = sData.begin();
-	while (itsData != sData.end())
-	{
-		UCHAR_8 chTMP = (UCHAR_8)(*itsData);
-
-		if (chTMP == '"')
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 6))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '&';
-			sBuffer[iBufferPointer++] = 'q';
-			sBuffer[iBufferPointer++] = 'u';
-			sBuffer[iBufferPointer++] = 'o';
-			sBuffer[iBufferPointer++] = 't';
-			sBuffer[iBufferPointer++] = ';';
-		}
-		else if (chTMP == '\'')
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 6))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '&';
-			sBuffer[iBufferPointer++] = 'a';
-			sBuffer[iBufferPointer++] = 'p';
-			sBuffer[iBufferPointer++] = 'o';
-			sBuffer[iBufferPointer++] = 's';
-			sBuffer[iBufferPointer++] = ';';
-		}
-		else if (chTMP == '<')
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 4))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '&';
-			sBuffer[iBufferPointer++] = 'l';
-			sBuffer[iBufferPointer++] = 't';
-			sBuffer[iBufferPointer++] = ';';
-		}
-		else if (chTMP == '>')
-		{
-			if (iBufferPointer >= CTPP_ESCAPE_BUFFER_LEN - 4)
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '&';
-			sBuffer[iBufferPointer++] = 'g';
-			sBuffer[iBufferPointer++] = 't';
-			sBuffer[iBufferPointer++] = ';';
-		}
-		else if (chTMP == '&')
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 5))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '&';
-			sBuffer[iBufferPointer++] = 'a';
-			sBuffer[iBufferPointer++] = 'm';
-			sBuffer[iBufferPointer++] = 'p';
-			sBuffer[iBufferPointer++] = ';';
-		}
-		else
-		{
-			sBuffer[iBufferPointer++] = *itsData;
-		}
-
-		if (iBufferPointer == CTPP_ESCAPE_BUFFER_LEN)
-		{
-			sRetVal.append(sBuffer, iBufferPointer);
-			iBufferPointer = 0;
-		}
-		++itsData;
-	}
-
-	if (iBufferPointer != 0) { sRetVal.append(sBuffer, iBufferPointer); }
+	STLW::string sRetVal;
+	Escape(ESCAPE_XML, sData.data(), sData.size(), sRetVal);
 
 return sRetVal;
 }
@@ -438,122 +189,8 @@ return sRetVal;
 //
 STLW::string WMLEscape(const STLW::string  & sData)
 {
-	CHAR_8 sBuffer[CTPP_ESCAPE_BUFFER_LEN + 1];
-
-	STLW::string sRetVal = "";
-
-	UINT_32 iBufferPointer = 0;
-
-	// Get string to escape
-	STLW::string::const_iterator itsData = sData.begin();
-	while (itsData != sData.end())
-	{
-		UCHAR_8 chTMP = (UCHAR_8)(*itsData);
-
-		if (chTMP < ' ')
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 6))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-			snprintf(sBuffer + iBufferPointer, 6, "\\u%04d", chTMP);
-		}
-		else if (chTMP == '"')
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 6))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '&';
-			sBuffer[iBufferPointer++] = 'q';
-			sBuffer[iBufferPointer++] = 'u';
-			sBuffer[iBufferPointer++] = 'o';
-			sBuffer[iBufferPointer++] = 't';
-			sBuffer[iBufferPointer++] = ';';
-		}
-		else if (chTMP == '\'')
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 6))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '&';
-			sBuffer[iBufferPointer++] = 'a';
-			sBuffer[iBufferPointer++] = 'p';
-			sBuffer[iBufferPointer++] = 'o';
-			sBuffer[iBufferPointer++] = 's';
-			sBuffer[iBufferPointer++] = ';';
-		}
-		else if (chTMP == '<')
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 4))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '&';
-			sBuffer[iBufferPointer++] = 'l';
-			sBuffer[iBufferPointer++] = 't';
-			sBuffer[iBufferPointer++] = ';';
-		}
-		else if (chTMP == '>')
-		{
-			if (iBufferPointer >= CTPP_ESCAPE_BUFFER_LEN - 4)
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '&';
-			sBuffer[iBufferPointer++] = 'g';
-			sBuffer[iBufferPointer++] = 't';
-			sBuffer[iBufferPointer++] = ';';
-		}
-		else if (chTMP == '&')
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 5))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '&';
-			sBuffer[iBufferPointer++] = 'a';
-			sBuffer[iBufferPointer++] = 'm';
-			sBuffer[iBufferPointer++] = 'p';
-			sBuffer[iBufferPointer++] = ';';
-		}
-		else if (chTMP == '$')
-		{
-			if (iBufferPointer >= (CTPP_ESCAPE_BUFFER_LEN - 4))
-			{
-				sRetVal.append(sBuffer, iBufferPointer);
-				iBufferPointer = 0;
-			}
-
-			sBuffer[iBufferPointer++] = '$';
-			sBuffer[iBufferPointer++] = '$';
-		}
-		else
-		{
-			sBuffer[iBufferPointer++] = *itsData;
-		}
-
-		if (iBufferPointer == CTPP_ESCAPE_BUFFER_LEN)
-		{
-			sRetVal.append(sBuffer, iBufferPointer);
-			iBufferPointer = 0;
-		}
-		++itsData;
-	}
-
-	if (iBufferPointer != 0) { sRetVal.append(sBuffer, iBufferPointer); }
+	STLW::string sRetVal;
+	Escape(ESCAPE_WML, sData.data(), sData.size(), sRetVal);
 
 return sRetVal;
 }
@@ -575,85 +212,10 @@ STLW::string EscapeJSONString(const STLW::string & sSource, const bool & bECMACo
 //
 DumpBuffer & DumpJSONString(DumpBuffer & sResult, const STLW::string & sSource, const bool & bECMAConventions, const bool & bHTMLSafe)
 {
-    INT_32 iPos = 0;
-    INT_32 iSize = sSource.size();
-    INT_32 iOffset = 0;
-
-    while (iSize--)
-    {
-        const UCHAR_8 uCH = sSource[iPos];
-        const CHAR_8 * sEscaped = NULL;
-        bool bFound = false;
-
-        switch (uCH)
-        {
-            case '"':
-                sEscaped = "\\\"";
-                bFound = true;
-                break;
-            case '\\':
-                sEscaped = "\\\\";
-                bFound = true;
-                break;
-            case '/':
-                sEscaped = "\\/";
-                bFound = true;
-                break;
-            case '\b':
-                sEscaped = "\\b";
-                bFound = true;
-                break;
-            case '\f':
-                sEscaped = "\\f";
-                bFound = true;
-                break;
-            case '\n':
-                sEscaped = "\\n";
-                bFound = true;
-                break;
-            case '\r':
-                sEscaped = "\\r";
-                bFound = true;
-                break;
-            case '\t':
-                sEscaped = "\\t";
-                bFound = true;
-                break;
-            case '\'':
-                sEscaped = "\\'";
-                if (bECMAConventions) { bFound = true; }
-                break;
-            case '\v':
-                sEscaped = "\\v";
-                if (bECMAConventions) { bFound = true; }
-                break;
-            case '\0':
-                sEscaped = "\\0";
-                if (bECMAConventions) { bFound = true; }
-                break;
-            default:
-                break;
-        }
-
-        if (bFound)
-        {
-            if (iPos - iOffset > 0) { sResult.Write(sSource.c_str() + iOffset, iPos - iOffset); }
-            sResult.Write(sEscaped, strlen(sEscaped));
-            iOffset = iPos + 1;
-        }
-        else if (uCH < ' ' || (bHTMLSafe && (uCH == '<' || uCH == '>')))
-        {
-            if (iPos - iOffset > 0) { sResult.Write(sSource.c_str() + iOffset, iPos - iOffset); }
-            CHAR_8 szBuffer[7] = { '\0' };
-            const CHAR_8 *szHexChars = "0123456789abcdef";
-			snprintf(szBuffer, 7, "\\u00%c%c", szHexChars[uCH >> 4], szHexChars[uCH & 0xF]);
-			sResult.Write(szBuffer, 6);
-            iOffset = iPos + 1;
-        }
-        ++iPos;
-    }
-
-    if (iPos - iOffset > 0) { sResult.Write(sSource.c_str() + iOffset, iPos - iOffset); }
+	static const eEscapeType aTypes[2][2] = { { ESCAPE_JSON,      ESCAPE_JSON_HTML      },
+	                                          { ESCAPE_JSON_ECMA, ESCAPE_JSON_ECMA_HTML } };
+
+	Escape(aTypes[bECMAConventions][bHTMLSafe], sSource.data(), sSource.size(), sResult);
 
 return sResult;
 }
@@ -1048,5 +610,111 @@ INT_32 UnicodeToUTF8(UINT_32 iUCS, UCHAR_P sUTF8)
 return iCharLength;
 }
 
+//
+// Convert number, result is the same as of sscanf() used by CTPP2JSONParser::IsNum
+//
+void ConvertJSONNumber(CCHAR_P       szData,
+                       CCHAR_P       szEnd,
+                       const bool    bFloat,
+                       CDT         & oValue)
+{
+	CCHAR_P szDigits = szData;
+	if (*szDigits == '-' || *szDigits == '+') { ++szDigits; }
+
+	// Decimal integer that fits into 64 bits; leading zero means octal number for "%lli"
+	const UINT_32 iDigits = szEnd - szDigits;
+	if (!bFloat && iDigits != 0 && iDigits <= 18 && (*szDigits != '0' || iDigits == 1))
+	{
+		INT_64 iValue = 0;
+		while (szDigits != szEnd) { iValue = iValue * 10 + (*szDigits++ - '0'); }
+
+		oValue = (*szData == '-') ? -iValue : iValue;
+		return;
+	}
+
+	// Number must be zero-terminated
+	CHAR_8        aBuffer[C_JSON_MAX_NUMBER_LENGTH];
+	STLW::string  sBuffer;
+	CCHAR_P       szNumber = aBuffer;
+
+	const UINT_32 iLength = szEnd - szData;
+	if (iLength < C_JSON_MAX_NUMBER_LENGTH)
+	{
+		memcpy(aBuffer, szData, iLength);
+		aBuffer[iLength] = '\0';
+	}
+	else
+	{
+		sBuffer.assign(szData, iLength);
+		szNumber = sBuffer.c_str();
+	}
+
+	if (bFloat)
+	{
+		oValue = W_FLOAT(strtod(szNumber, NULL));
+		return;
+	}
+
+	long long iLL = 0;
+	sscanf(szNumber, "%lli", &iLL);
+
+	oValue = INT_64(iLL);
+}
+
+//
+// Replace file atomically
+//
+void ReplaceFile(const STLW::string  & sFileName,
+                 const void          * vData,
+                 const UINT_32         iDataSize)
+{
+	// Unique name, so concurrent writers of the same file do not share temporary file
+	STLW::string sTempName(sFileName + ".XXXXXX");
+	const INT_32 iFD = mkstemp(&sTempName[0]);
+	if (iFD == -1) { throw CTPPUnixException("mkstemp", errno); }
+
+	// mkstemp creates file readable by owner only
+	struct stat oStat;
+	const mode_t iMode = (stat(sFileName.c_str(), &oStat) == 0) ? (oStat.st_mode & 07777) : 0644;
+
+	CCHAR_P szCall = "fchmod";
+	INT_32  iErrNo = 0;
+	if (fchmod(iFD, iMode) == -1) { iErrNo = errno; }
+
+	CCHAR_P szData = static_cast<CCHAR_P>(vData);
+	UINT_32 iLeft  = iDataSize;
+	while (iErrNo == 0 && iLeft != 0)
+	{
+		const ssize_t iWritten = write(iFD, szData, iLeft);
+		if (iWritten == -1)
+		{
+			if (errno == EINTR) { continue; }
+			szCall = "write";
+			iErrNo = errno;
+			break;
+		}
+		szData += iWritten;
+		iLeft  -= UINT_32(iWritten);
+	}
+
+	if (close(iFD) == -1 && iErrNo == 0)
+	{
+		szCall = "close";
+		iErrNo = errno;
+	}
+
+	if (iErrNo == 0 && rename(sTempName.c_str(), sFileName.c_str()) == -1)
+	{
+		szCall = "rename";
+		iErrNo = errno;
+	}
+
+	if (iErrNo != 0)
+	{
+		unlink(sTempName.c_str());
+		throw CTPPUnixException(szCall, iErrNo);
+	}
+}
+
 } // namespace CTPP
 // End.
@@ -95,26 +95,282 @@
 #define GR oRegs[6]
 #define HR oRegs[7]
 
+// Computed goto is GCC extension, supported also by Clang and ICC
+#if defined(__GNUC__) && !defined(_NO_COMPUTED_GOTO)
+    #define _COMPUTED_GOTO 1
+#endif
+
+#ifdef _COMPUTED_GOTO
+    // Entry point of instruction handler
+    #define VM_HANDLER(x) x##_HANDLER:
+    // Exit of instruction handler; threaded dispatch jumps straight to handler of next instruction
+    #define VM_NEXT                                         \
+        if (bThreaded)                                      \
+        {                                                   \
+            ++iExecutedSteps;                               \
+            if (iIP >= iCodeLength) { goto END_OF_CODE; }   \
+            iOpCode   = aCode[iIP].instruction; \
+            iOpCodeLo = SYSCALL_OPCODE_LO(iOpCode);         \
+            goto *aHandlers[aDecodedCode[iIP]];             \
+        }                                                   \
+        break
+#else
+    #define VM_HANDLER(x)
+    #define VM_NEXT break
+#endif
+
 namespace CTPP // C++ Template Engine
 {
 
+/**
+  @enum eHandler CTPP2VM.cpp
+  @brief Handlers of pre-decoded instructions
+*/
+enum eHandler { ILLEGAL_H = 0,
+                SYSCALL_H,  CALLNAME_H, CALLIND_H,  CALL_H,     RET_H,      JMP_H,      LOOP_H,     RCALL_H,    RJMP_H,
+                PUSH_H,     POP_H,      PUSH13_H,   POP13_H,    PUSH47_H,   POP47_H,    PUSHA_H,    POPA_H,
+                ARITHMETIC_H,
+                MOV_H,      MOVIINT_H,  MOVISTR_H,  IMOVINT_H,  IMOVSTR_H,  MOVSIZE_H,  MOVIREGI_H, MOVIREGS_H,
+                CMP_H,      SCMP_H,
+                JXX_H,      RJXX_H,
+                CLEAR_H,    OUTPUT_H,   REPLACE_H,  EXIST_H,    REPLINT_H,  REPLSTR_H,  REPLIND_H,  XCHG_H,
+                DEFINED_H,  SAVEBP_H,   RESTBP_H,   OUTVAR_H,   OUTVAR_ESC_H, OUTSYS_H,
+                HLT_H,      BRK_H,      NOP_H };
+
+//
+// Get handler of pre-decoded instruction
+//
+UCHAR_8 VM::DecodeInstruction(const UINT_32  iOpCode)
+{
+	// Groups of instructions with common handler
+	switch (SYSCALL_OPCODE_HI(iOpCode))
+	{
+		case SYSCALL_OPCODE_HI(ADD):  return ARITHMETIC_H;
+		case SYSCALL_OPCODE_HI(JXX):  return JXX_H;
+		case SYSCALL_OPCODE_HI(RJXX): return RJXX_H;
+		default:
+			;;
+	}
+
+	switch (SYSCALL_OPCODE(iOpCode))
+	{
+		case SYSCALL_OPCODE(SYSCALL):  return SYSCALL_H;
+		case SYSCALL_OPCODE(CALLNAME): return CALLNAME_H;
+		case SYSCALL_OPCODE(CALLIND):  return CALLIND_H;
+		case SYSCALL_OPCODE(CALL):     return CALL_H;
+		case SYSCALL_OPCODE(RET):      return RET_H;
+		case SYSCALL_OPCODE(JMP):      return JMP_H;
+		case SYSCALL_OPCODE(LOOP):     return LOOP_H;
+		case SYSCALL_OPCODE(RCALL):    return RCALL_H;
+		case SYSCALL_OPCODE(RJMP):     return RJMP_H;
+
+		case SYSCALL_OPCODE(PUSH):     return PUSH_H;
+		case SYSCALL_OPCODE(POP):      return POP_H;
+		case SYSCALL_OPCODE(PUSH13):   return PUSH13_H;
+		case SYSCALL_OPCODE(POP13):    return POP13_H;
+		case SYSCALL_OPCODE(PUSH47):   return PUSH47_H;
+		case SYSCALL_OPCODE(POP47):    return POP47_H;
+		case SYSCALL_OPCODE(PUSHA):    return PUSHA_H;
+		case SYSCALL_OPCODE(POPA):     return POPA_H;
+
+		case SYSCALL_OPCODE(MOV):      return MOV_H;
+		case SYSCALL_OPCODE(MOVIINT):  return MOVIINT_H;
+		case SYSCALL_OPCODE(MOVISTR):  return MOVISTR_H;
+		case SYSCALL_OPCODE(IMOVINT):  return IMOVINT_H;
+		case SYSCALL_OPCODE(IMOVSTR):  return IMOVSTR_H;
+		case SYSCALL_OPCODE(MOVSIZE):  return MOVSIZE_H;
+		case SYSCALL_OPCODE(MOVIREGI): return MOVIREGI_H;
+		case SYSCALL_OPCODE(MOVIREGS): return MOVIREGS_H;
+
+		case SYSCALL_OPCODE(CMP):      return CMP_H;
+		case SYSCALL_OPCODE(SCMP):     return SCMP_H;
+
+		case SYSCALL_OPCODE(CLEAR):    return CLEAR_H;
+		case SYSCALL_OPCODE(OUTPUT):   return OUTPUT_H;
+		case SYSCALL_OPCODE(REPLACE):  return REPLACE_H;
+		case SYSCALL_OPCODE(EXIST):    return EXIST_H;
+		case SYSCALL_OPCODE(REPLINT):  return REPLINT_H;
+		case SYSCALL_OPCODE(REPLSTR):  return REPLSTR_H;
+		case SYSCALL_OPCODE(REPLIND):  return REPLIND_H;
+		case SYSCALL_OPCODE(XCHG):     return XCHG_H;
+		case SYSCALL_OPCODE(DEFINED):  return DEFINED_H;
+		case SYSCALL_OPCODE(SAVEBP):   return SAVEBP_H;
+		case SYSCALL_OPCODE(RESTBP):   return RESTBP_H;
+		case SYSCALL_OPCODE(OUTVAR):     return OUTVAR_H;
+		case SYSCALL_OPCODE(OUTVAR_ESC): return OUTVAR_ESC_H;
+		case SYSCALL_OPCODE(OUTSYS):     return OUTSYS_H;
+
+		case SYSCALL_OPCODE(HLT):      return HLT_H;
+		case SYSCALL_OPCODE(BRK):      return BRK_H;
+		case SYSCALL_OPCODE(NOP):      return NOP_H;
+		default:
+			;;
+	}
+
+return ILLEGAL_H;
+}
+
+// Keys of foreach iterator record
+static const STLW::string sIterFirst("__first__");
+static const STLW::string sIterLast("__last__");
+static const STLW::string sIterInner("__inner__");
+static const STLW::string sIterOdd("__odd__");
+static const STLW::string sIterEven("__even__");
+static const STLW::string sIterValue("__value__");
+static const STLW::string sIterKey("__key__");
+static const STLW::string sIterIndex("__index__");
+
+// Number of keys in foreach iterator record
+#define C_ITER_RECORD_SIZE 8
+
+//
+// Fill foreach iterator record
+//
+static void FillIteratorRecord(CDT            & oRecord,
+                               const INT_32     iIdx,
+                               const UINT_32    iSize,
+                               const CDT      & oValue,
+                               const CDT      & oKey)
+{
+	static const CDT oUndef;
+	static const CDT oOne(1);
+
+	oRecord[sIterFirst] = (iIdx == 0) ? oOne : oUndef;
+	oRecord[sIterLast]  = (iIdx != 0 && UINT_32(iIdx + 1) == iSize) ? oOne : oUndef;
+	oRecord[sIterInner] = (iIdx != 0 && UINT_32(iIdx + 1) != iSize) ? oOne : oUndef;
+	oRecord[sIterOdd]   = ((iIdx + 1) % 2 == 1) ? oOne : oUndef;
+	oRecord[sIterEven]  = ((iIdx + 1) % 2 == 0) ? oOne : oUndef;
+	oRecord[sIterValue] = oValue;
+
+	// HASH: key of element, ARRAY: index of element
+	if (oKey.GetType() == CDT::INT_VAL)
+	{
+		oRecord[sIterKey]   = oUndef;
+		oRecord[sIterIndex] = oKey;
+	}
+	else
+	{
+		oRecord[sIterKey]   = oKey;
+		oRecord[sIterIndex] = oUndef;
+	}
+}
+
+//
+// Set foreach iterator record
+//
+static void SetIteratorRecord(CDT            & oRecord,
+                              const INT_32     iIdx,
+                              const UINT_32    iSize,
+                              const CDT      & oValue,
+                              const CDT      & oKey)
+{
+	// Record of previous iteration has the same set of keys, so it is updated in place
+	//  without any allocation; copy-on-write protects copies saved in stack
+	if (oRecord.GetType() == CDT::HASH_VAL && oRecord.Size() == C_ITER_RECORD_SIZE)
+	{
+		FillIteratorRecord(oRecord, iIdx, iSize, oValue, oKey);
+		if (oRecord.Size() == C_ITER_RECORD_SIZE) { return; }
+	}
+
+	// Register holds something else, create new record
+	oRecord = CDT(CDT::HASH_VAL);
+	FillIteratorRecord(oRecord, iIdx, iSize, oValue, oKey);
+}
+
+//
+// Replace value with element of ARRAY
+//
+static void ReplaceByIndex(CDT           & oValue,
+                           const INT_64    iIdx)
+{
+	// Constant access does not unshare container
+	if (oValue.GetType() == CDT::ARRAY_VAL && iIdx >= 0 && iIdx < INT_64(oValue.Size()))
+	{
+		const CDT oTMP = static_cast<const CDT &>(oValue).GetCDT(UINT_32(iIdx));
+		oValue = oTMP;
+		return;
+	}
+
+	oValue = oValue[iIdx];
+}
+
+//
+// Replace value with element of HASH
+//
+static void ReplaceByKey(CDT                 & oValue,
+                         const STLW::string  & sKey)
+{
+	// Constant access does not unshare container
+	if (oValue.GetType() == CDT::HASH_VAL)
+	{
+		const CDT oTMP = static_cast<const CDT &>(oValue).GetCDT(sKey);
+		oValue = oTMP;
+		return;
+	}
+
+	oValue = oValue[sKey];
+}
+
+//
+// Get interned HASH key by ID of static text record
+//
+static const CDTKey & GetKey(const VMMemoryCore  * pMemoryCore,
+                             const UINT_32         iTextId)
+{
+	static const CDTKey oEmptyKey;
+
+	if (iTextId >= pMemoryCore -> keys.size()) { return oEmptyKey; }
+
+return pMemoryCore -> keys[iTextId];
+}
+
+//
+// Get string literal by ID of static text record
+//
+static CDT GetString(const VMMemoryCore  * pMemoryCore,
+                     const UINT_32         iTextId)
+{
+	static const CDTStringView oEmptyView = { "", 0 };
+
+	if (iTextId >= pMemoryCore -> strings.size()) { return CDT(oEmptyView); }
+
+return CDT(pMemoryCore -> strings[iTextId]);
+}
+
+//
+// Find variable in local scope, then in global scope
+//
+static const CDT & LookupVariable(const CDT     & oLocalScope,
+                                  const CDT     & oGlobalScope,
+                                  const CDTKey  & oKey)
+{
+	const CDT & oValue = oLocalScope.GetCDT(oKey);
+	if (oValue.GetType() != CDT::UNDEF) { return oValue; }
+
+return oGlobalScope.GetCDT(oKey);
+}
+
 //
 // Constructor
 //
-VM::VM(SyscallFactory  * pISyscallFactory,
-       const UINT_32     iIMaxArgStackSize,
-       const UINT_32     iIMaxCodeStackSize,
-       const UINT_32     iIMaxSteps,
-       const UINT_32     iIDebugLevel): pSyscallFactory(pISyscallFactory),
-                                        iMaxArgStackSize(iIMaxArgStackSize),
-                                        iMaxCodeStackSize(iIMaxCodeStackSize),
-                                        iMaxSteps(iIMaxSteps),
-                                        iDebugLevel(iIDebugLevel),
-                                        iMaxCalls(0),
-                                        iMaxUsedCalls(0),
-                                        aCallTranslationMap(NULL),
-                                        oVMArgStack(iMaxArgStackSize),
-                                        oVMCodeStack(iMaxCodeStackSize)
+VM::VM(SyscallFactory       * pISyscallFactory,
+       const UINT_32          iIMaxArgStackSize,
+       const UINT_32          iIMaxCodeStackSize,
+       const UINT_32          iIMaxSteps,
+       const UINT_32          iIDebugLevel,
+       const eDispatchType    eIDispatchType): pSyscallFactory(pISyscallFactory),
+                                               iMaxArgStackSize(iIMaxArgStackSize),
+                                               iMaxCodeStackSize(iIMaxCodeStackSize),
+                                               iMaxSteps(iIMaxSteps),
+                                               iDebugLevel(iIDebugLevel),
+                                               eDispatch(eIDispatchType),
+                                               iMaxCalls(0),
+                                               iMaxUsedCalls(0),
+                                               aCallTranslationMap(NULL),
+                                               oVMArgStack(iMaxArgStackSize),
+                                               oVMCodeStack(iMaxCodeStackSize),
+                                               iFlags(0),
+                                               iExecutedSteps(0)
 {
 	;;
 }
@@ -171,6 +427,12 @@ INT_32 VM::Init(const VMMemoryCore  * pMemoryCore,
 return 0;
 }
 
+#ifdef _COMPUTED_GOTO
+// Labels as values are intended here, do not warn about them with -pedantic
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
 //
 // Run program
 //
@@ -181,22 +443,52 @@ INT_32 VM::Run(const VMMemoryCore  * pMemoryCore,
                Logger              * pLogger)
 {
 	DR = oCDT;
+	vLoopCursors.clear();
 	// Get code segment
 	const VMInstruction * aCode = pMemoryCore -> instructions;
 	const UINT_32 iCodeLength   = pMemoryCore -> code_size;
-	UINT_32 iExecutedSteps      = 0;
+	iExecutedSteps              = 0;
+
+#ifdef _COMPUTED_GOTO
+	// Handlers of pre-decoded instructions, in order of eHandler values
+	static const void * aHandlers[] = { &&ILLEGAL_HANDLER,
+	                                    &&SYSCALL_HANDLER,  &&CALLNAME_HANDLER, &&CALLIND_HANDLER,  &&CALL_HANDLER,
+	                                    &&RET_HANDLER,      &&JMP_HANDLER,      &&LOOP_HANDLER,     &&RCALL_HANDLER,
+	                                    &&RJMP_HANDLER,
+	                                    &&PUSH_HANDLER,     &&POP_HANDLER,      &&PUSH13_HANDLER,   &&POP13_HANDLER,
+	                                    &&PUSH47_HANDLER,   &&POP47_HANDLER,    &&PUSHA_HANDLER,    &&POPA_HANDLER,
+	                                    &&ARITHMETIC_HANDLER,
+	                                    &&MOV_HANDLER,      &&MOVIINT_HANDLER,  &&MOVISTR_HANDLER,  &&IMOVINT_HANDLER,
+	                                    &&IMOVSTR_HANDLER,  &&MOVSIZE_HANDLER,  &&MOVIREGI_HANDLER, &&MOVIREGS_HANDLER,
+	                                    &&CMP_HANDLER,      &&SCMP_HANDLER,
+	                                    &&JXX_HANDLER,      &&RJXX_HANDLER,
+	                                    &&CLEAR_HANDLER,    &&OUTPUT_HANDLER,   &&REPLACE_HANDLER,  &&EXIST_HANDLER,
+	                                    &&REPLINT_HANDLER,  &&REPLSTR_HANDLER,  &&REPLIND_HANDLER,  &&XCHG_HANDLER,
+	                                    &&DEFINED_HANDLER,  &&SAVEBP_HANDLER,   &&RESTBP_HANDLER,   &&OUTVAR_HANDLER,
+	                                    &&OUTVAR_ESC_HANDLER, &&OUTSYS_HANDLER,
+	                                    &&HLT_HANDLER,      &&BRK_HANDLER,      &&NOP_HANDLER };
+
+	// Instructions are pre-decoded once per program, see VMMemoryCore
+	const UCHAR_8 * aDecodedCode = pMemoryCore -> handlers.empty() ? NULL : &(pMemoryCore -> handlers[0]);
+	const bool bThreaded         = (eDispatch == THREADED_DISPATCH);
+#endif
 
 	try
 	{
 		while (iIP < iCodeLength)
 		{
-			const UINT_32 iOpCode = aCode[iIP].instruction;
+			// Opcode is reloaded by threaded dispatch at exit of every handler
+			UINT_32 iOpCode         = aCode[iIP].instruction;
 			const UINT_32 iOpCodeHi = SYSCALL_OPCODE_HI(iOpCode);
-			const UINT_32 iOpCodeLo = SYSCALL_OPCODE_LO(iOpCode);
+			UINT_32 iOpCodeLo       = SYSCALL_OPCODE_LO(iOpCode);
 #ifdef _DEBUG
 HL_CODE(BLUE);
 fprintf(stderr, "CODE 0x%08X ARG 0x%08X RES 0x%016llX | ", iOpCode, aCode[iIP].argument, (long long)(aCode[iIP].reserved));
 HL_RST;
+#endif
+#ifdef _COMPUTED_GOTO
+			// Jump directly to handler of pre-decoded instruction
+			if (bThreaded) { goto *aHandlers[aDecodedCode[iIP]]; }
 #endif
 
 			switch(iOpCodeHi)
@@ -208,6 +500,7 @@ HL_RST;
 						{
 							// SYSCALL
 							case SYSCALL_OPCODE_LO(SYSCALL):
+							VM_HANDLER(SYSCALL)
 								{
 									const UINT_32 iCallNum    = (aCode[iIP].argument & 0xFFFF0000) >> 16;
 									const UINT_32 iCallArgNum = (aCode[iIP].argument & 0x0000FFFF);
@@ -246,10 +539,11 @@ HL_RST;
 
 									++iIP;
 								}
-								break;
+								VM_NEXT;
 
 							// CALLNAME
 							case SYSCALL_OPCODE_LO(CALLNAME):
+							VM_HANDLER(CALLNAME)
 								{
 									// Get call name
 									UINT_32 iDataSize = 0;
@@ -278,10 +572,11 @@ HL_RST;
 									oVMCodeStack.PushAddress(iIP + 1);
 									iIP = iNewIP;
 								}
-								break;
+								VM_NEXT;
 
 							// CALLIND
 							case SYSCALL_OPCODE_LO(CALLIND):
+							VM_HANDLER(CALLIND)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -361,10 +656,11 @@ HL_RST;
 									oVMCodeStack.PushAddress(iIP + 1);
 									iIP = iNewIP;
 								}
-								break;
+								VM_NEXT;
 
 							// CALL
 							case SYSCALL_OPCODE_LO(CALL):
+							VM_HANDLER(CALL)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -390,10 +686,11 @@ fprintf(stderr, "0x%08X CALL      0x%08X\n", iIP, aCode[iIP].argument);
 									oVMCodeStack.PushAddress(iIP + 1);
 									iIP = iNewIP;
 								}
-								break;
+								VM_NEXT;
 
 							// RET
 							case SYSCALL_OPCODE_LO(RET):
+							VM_HANDLER(RET)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -413,10 +710,11 @@ HL_RST;
 									// Return
 									iIP = oVMCodeStack.PopAddress();
 								}
-								break;
+								VM_NEXT;
 
 							// JMP
 							case SYSCALL_OPCODE_LO(JMP):
+							VM_HANDLER(JMP)
 								{
 #ifdef _DEBUG
 HL_CODE(GREEN);
@@ -442,10 +740,11 @@ HL_RST;
 
 									iIP = iNewIP;
 								}
-								break;
+								VM_NEXT;
 
 							// LOOP, cycle
 							case SYSCALL_OPCODE_LO(LOOP):
+							VM_HANDLER(LOOP)
 								{
 									// Check execution limit
 									if (iExecutedSteps >= iMaxSteps)
@@ -495,10 +794,11 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								VM_NEXT;
 
 							// RCALL
 							case SYSCALL_OPCODE_LO(RCALL):
+							VM_HANDLER(RCALL)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -524,10 +824,11 @@ fprintf(stderr, "0x%08X RCALL     0x%08X\n", iIP, aCode[iIP].argument);
 									oVMCodeStack.PushAddress(iIP + 1);
 									iIP = iNewIP;
 								}
-								break;
+								VM_NEXT;
 
 							// RJMP
 							case SYSCALL_OPCODE_LO(RJMP):
+							VM_HANDLER(RJMP)
 								{
 #ifdef _DEBUG
 HL_CODE(GREEN);
@@ -553,7 +854,7 @@ HL_RST;
 
 									iIP = iNewIP;
 								}
-								break;
+								VM_NEXT;
 
 							// Illegal Opcode?
 							default:
@@ -573,6 +874,7 @@ HL_RST;
 						{
 							// PUSH
 							case SYSCALL_OPCODE_LO(PUSH):
+							VM_HANDLER(PUSH)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -593,11 +895,10 @@ HL_RST;
 									// From static text segment to stack
 									else if (iSrcReg == ARG_SRC_STR)
 									{
-										UINT_32 iDataSize = 0;
-										CCHAR_P szTMP = pMemoryCore -> static_text.GetData(aCode[iIP].argument, iDataSize);
-										oVMArgStack.PushElement(STLW::string(szTMP, iDataSize));
+										// String is not copied, it refers to static text segment
+										oVMArgStack.PushElement(GetString(pMemoryCore, aCode[iIP].argument));
 #ifdef _DEBUG
-fprintf(stderr, "STRING POS: %d (VAL: `%s`)\n", aCode[iIP].argument, szTMP);
+fprintf(stderr, "STRING POS: %d (VAL: `%s`)\n", aCode[iIP].argument, oVMArgStack.GetTopElement(0).GetString().c_str());
 HL_RST;
 #endif
 									}
@@ -643,8 +944,7 @@ HL_RST;
 									// From indirect HASH
 									else if (iSrcReg == ARG_SRC_IND_STR)
 									{
-										UINT_32 iDataSize = 0;
-										CCHAR_P szTMP     = pMemoryCore -> static_text.GetData(aCode[iIP].argument, iDataSize);
+										const CDTKey & oKey = GetKey(pMemoryCore, aCode[iIP].argument);
 
 										const UINT_32 iDstReg = SYSCALL_REG_DST(iOpCode);
 										// Indirect operations works ONLY with registers AR - HR and LR
@@ -652,11 +952,11 @@ HL_RST;
 										{
 											bool bCDTExist = false;
 #ifdef _DEBUG
-fprintf(stderr, "%cR[\"%s\"] ", CHAR_8((iDstReg >> 8) + 'A'), szTMP);
-fprintf(stderr, "(`%s`)\n", oRegs[iDstReg >> 8].GetExistedCDT(STLW::string(szTMP, iDataSize), bCDTExist).GetString().c_str());
+fprintf(stderr, "%cR[\"%s\"] ", CHAR_8((iDstReg >> 8) + 'A'), oKey.key.c_str());
+fprintf(stderr, "(`%s`)\n", oRegs[iDstReg >> 8].GetExistedCDT(oKey, bCDTExist).GetString().c_str());
 HL_RST;
 #endif
-											oVMArgStack.PushElement(oRegs[iDstReg >> 8].GetExistedCDT(STLW::string(szTMP, iDataSize), bCDTExist));
+											oVMArgStack.PushElement(oRegs[iDstReg >> 8].GetExistedCDT(oKey, bCDTExist));
 
 											// Found
 											if (bCDTExist) { iFlags = FL_EQ; }
@@ -688,10 +988,12 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// POP
 							case SYSCALL_OPCODE_LO(POP):
+							VM_HANDLER(POP)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -718,10 +1020,12 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// PUSH13
 							case SYSCALL_OPCODE_LO(PUSH13):
+							VM_HANDLER(PUSH13)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -732,10 +1036,12 @@ fprintf(stderr, "0x%08X PUSH13    \n", iIP);
 										oVMArgStack.PushElement(oRegs[iSrcReg]);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// POP13
 							case SYSCALL_OPCODE_LO(POP13):
+							VM_HANDLER(POP13)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -747,10 +1053,12 @@ fprintf(stderr, "0x%08X POP13     \n", iIP);
 										oVMArgStack.ClearStack(1);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// PUSH47
 							case SYSCALL_OPCODE_LO(PUSH47):
+							VM_HANDLER(PUSH47)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -762,10 +1070,12 @@ fprintf(stderr, "0x%08X PUSH47    \n", iIP);
 										oVMArgStack.PushElement(oRegs[iSrcReg]);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// POP47
 							case SYSCALL_OPCODE_LO(POP47):
+							VM_HANDLER(POP47)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -778,10 +1088,12 @@ fprintf(stderr, "0x%08X POP47     \n", iIP);
 										oVMArgStack.ClearStack(1);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// PUSHA
 							case SYSCALL_OPCODE_LO(PUSHA):
+							VM_HANDLER(PUSHA)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -793,10 +1105,12 @@ fprintf(stderr, "0x%08X PUSHA     \n", iIP);
 										oVMArgStack.PushElement(oRegs[iSrcReg]);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// POPA
 							case SYSCALL_OPCODE_LO(POPA):
+							VM_HANDLER(POPA)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -809,7 +1123,8 @@ fprintf(stderr, "0x%08X POPA      \n", iIP);
 										oVMArgStack.ClearStack(1);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// Illegal Opcode?
 							default:
@@ -820,11 +1135,11 @@ fprintf(stderr, "0x%08X POPA      \n", iIP);
 							}
 						}
 					}
-					++iIP;
 					break;
 
 				// Arithmetic ops. ///// 0x-3-X----
 				case 0x03:
+				VM_HANDLER(ARITHMETIC)
 					{
 						const UINT_32 iSrcReg = SYSCALL_REG_SRC(iOpCode);
 						const UINT_32 iDstReg = SYSCALL_REG_DST(iOpCode);
@@ -1069,7 +1384,7 @@ HL_RST;
 						}
 					}
 					++iIP;
-					break;
+					VM_NEXT;
 
 				// Register ops. /////// 0x-4------
 				case 0x04:
@@ -1078,6 +1393,7 @@ HL_RST;
 						{
 							// MOV
 							case SYSCALL_OPCODE_LO(MOV):
+							VM_HANDLER(MOV)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -1131,13 +1447,11 @@ HL_RST;
 										// String-to-register
 										else if (iSrcReg == ARG_SRC_STR)
 										{
-											UINT_32 iDataSize = 0;
-											CCHAR_P szTMP = pMemoryCore -> static_text.GetData(aCode[iIP].argument, iDataSize);
+											oRegs[iDstReg >> 8] = GetString(pMemoryCore, aCode[iIP].argument);
 #ifdef _DEBUG
-fprintf(stderr, "STRING POS: %d (VAL: `%s`)\n", aCode[iIP].argument, szTMP);
+fprintf(stderr, "STRING POS: %d (VAL: `%s`)\n", aCode[iIP].argument, oRegs[iDstReg >> 8].GetString().c_str());
 HL_RST;
 #endif
-											oRegs[iDstReg >> 8] = STLW::string(szTMP, iDataSize);
 										}
 										// Illegal Opcode?
 										else
@@ -1155,10 +1469,12 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// MOVIINT, Move indirect ARRAY to register
 							case SYSCALL_OPCODE_LO(MOVIINT):
+							VM_HANDLER(MOVIINT)
 								{
 									const UINT_32 iSrcReg = SYSCALL_REG_SRC(iOpCode);
 									const UINT_32 iDstReg = SYSCALL_REG_DST(iOpCode);
@@ -1192,10 +1508,12 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// MOVISTR, Move indirect HASH to register
 							case SYSCALL_OPCODE_LO(MOVISTR):
+							VM_HANDLER(MOVISTR)
 								{
 									const UINT_32 iSrcReg = SYSCALL_REG_SRC(iOpCode);
 									const UINT_32 iDstReg = SYSCALL_REG_DST(iOpCode);
@@ -1205,11 +1523,10 @@ HL_RST;
 										// Register-to-register
 										if (iSrcReg <= ARG_SRC_LASTREG)
 										{
-											UINT_32 iDataSize = 0;
-											CCHAR_P szTMP     = pMemoryCore -> static_text.GetData(aCode[iIP].argument, iDataSize);
+											const CDTKey & oKey = GetKey(pMemoryCore, aCode[iIP].argument);
 
 											bool bCDTExist = false;
-											oRegs[iDstReg >> 8] = oRegs[iSrcReg].GetExistedCDT(STLW::string(szTMP, iDataSize), bCDTExist);
+											oRegs[iDstReg >> 8] = oRegs[iSrcReg].GetExistedCDT(oKey, bCDTExist);
 
 											// Found
 											if (bCDTExist) { iFlags = FL_EQ; }
@@ -1218,7 +1535,7 @@ HL_RST;
 
 #ifdef _DEBUG
 HL_CODE(RED);
-fprintf(stderr, "0x%08X MOVISTR   %cR, %cR[%s] (`%s`)\n", iIP, CHAR_8((iDstReg >> 8)  + 'A'), CHAR_8(iSrcReg + 'A'), szTMP, oRegs[iDstReg >> 8].GetString().c_str());
+fprintf(stderr, "0x%08X MOVISTR   %cR, %cR[%s] (`%s`)\n", iIP, CHAR_8((iDstReg >> 8)  + 'A'), CHAR_8(iSrcReg + 'A'), oKey.key.c_str(), oRegs[iDstReg >> 8].GetString().c_str());
 HL_RST;
 #endif
 										}
@@ -1238,10 +1555,12 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// IMOVINT, Move register to indirect ARRAY
 							case SYSCALL_OPCODE_LO(IMOVINT):
+							VM_HANDLER(IMOVINT)
 								{
 									const UINT_32 iSrcReg = SYSCALL_REG_SRC(iOpCode);
 									const UINT_32 iDstReg = SYSCALL_REG_DST(iOpCode);
@@ -1274,10 +1593,12 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// IMOVSTR
 							case SYSCALL_OPCODE_LO(IMOVSTR):
+							VM_HANDLER(IMOVSTR)
 								{
 									const UINT_32 iSrcReg = SYSCALL_REG_SRC(iOpCode);
 									const UINT_32 iDstReg = SYSCALL_REG_DST(iOpCode);
@@ -1287,12 +1608,11 @@ HL_RST;
 										// Register-to-register
 										if (iSrcReg <= ARG_SRC_LASTREG)
 										{
-											UINT_32 iDataSize = 0;
-											CCHAR_P szTMP     = pMemoryCore -> static_text.GetData(aCode[iIP].argument, iDataSize);
-											oRegs[iDstReg >> 8][STLW::string(szTMP, iDataSize)] = oRegs[iSrcReg];
+											const CDTKey & oKey = GetKey(pMemoryCore, aCode[iIP].argument);
+											oRegs[iDstReg >> 8][oKey.key] = oRegs[iSrcReg];
 #ifdef _DEBUG
 HL_CODE(RED);
-fprintf(stderr, "0x%08X IMOVSTR   %cR[%s], %cR (`%s`)\n", iIP, CHAR_8((iDstReg >> 8) + 'A'), szTMP, CHAR_8(iSrcReg + 'A'), oRegs[iDstReg >> 8][STLW::string(szTMP, iDataSize)].GetString().c_str());
+fprintf(stderr, "0x%08X IMOVSTR   %cR[%s], %cR (`%s`)\n", iIP, CHAR_8((iDstReg >> 8) + 'A'), oKey.key.c_str(), CHAR_8(iSrcReg + 'A'), oRegs[iDstReg >> 8][oKey.key].GetString().c_str());
 HL_RST;
 #endif
 										}
@@ -1312,10 +1632,12 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// MOVSIZE, Get object size
 							case SYSCALL_OPCODE_LO(MOVSIZE):
+							VM_HANDLER(MOVSIZE)
 								{
 									const UINT_32 iSrcReg = SYSCALL_REG_SRC(iOpCode);
 									const UINT_32 iDstReg = SYSCALL_REG_DST(iOpCode);
@@ -1392,10 +1714,12 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// MOVIREGI
 							case SYSCALL_OPCODE_LO(MOVIREGI):
+							VM_HANDLER(MOVIREGI)
 								{
 									const UINT_32 iSrcReg = SYSCALL_REG_SRC(iOpCode);
 									const UINT_32 iDstReg = SYSCALL_REG_DST(iOpCode);
@@ -1421,44 +1745,25 @@ HL_CODE(GREEN);
 fprintf(stderr, "0x%08X MOVIREG   %cR, %cR[%cR] ", iIP, CHAR_8((iDstReg >> 8) + 'A'), CHAR_8(iSrcReg + 'A'), CHAR_8(iArgNum + 'A'));
 #endif
                                             const INT_32 iIdx = oRegs[iArgNum].GetInt();
-                                            CDT oItVal(CDT::HASH_VAL);
-                                            if (iIdx == 0)
-                                            {
-                                                oItVal["__first__"] = 1;
-                                            }
-                                            else if (UINT_32(iIdx + 1) == oRegs[iSrcReg].Size())
-                                            {
-                                                oItVal["__last__"] = 1;
-                                            }
-                                            else
-                                            {
-                                                oItVal["__inner__"] = 1;
-                                            }
-
-                                            if ((iIdx + 1) % 2 == 1) { oItVal["__odd__"] = 1; }
-                                            else                     { oItVal["__even__"] = 1; }
+                                            const CDT & oContainer = oRegs[iSrcReg];
+                                            CDT & oItVal = oRegs[iDstReg >> 8];
 
-                                            if (oRegs[iSrcReg].GetType() == CDT::HASH_VAL)
+                                            if (oContainer.GetType() == CDT::HASH_VAL)
                                             {
-                                                CDT::Iterator it = oRegs[iSrcReg].Begin();
-                                                for (INT_32 iI = 0; iI < iIdx; ++iI) { ++it; }
+                                                CDT::ConstIterator it = GetLoopCursor(iIP, oContainer, iIdx);
 #ifdef _DEBUG
 fprintf(stderr, "(`%s`): %s\n", it->first.c_str(), it->second.GetString().c_str());
 HL_RST;
 #endif
-                                                oItVal["__value__"] = it->second;
-                                                oItVal["__key__"] = it->first;
-                                                oRegs[iDstReg >> 8] = oItVal;
+                                                SetIteratorRecord(oItVal, iIdx, oContainer.Size(), it->second, it->first);
                                             }
                                             else
                                             {
 #ifdef _DEBUG
-fprintf(stderr, "(%d): %s\n", iIdx, oRegs[iSrcReg][iIdx].GetString().c_str());
+fprintf(stderr, "(%d): %s\n", iIdx, oContainer[iIdx].GetString().c_str());
 HL_RST;
 #endif
-                                                oItVal["__value__"] = oRegs[iSrcReg][iIdx];
-                                                oItVal["__index__"] = iIdx;
-                                                oRegs[iDstReg >> 8] = oItVal;
+                                                SetIteratorRecord(oItVal, iIdx, oContainer.Size(), oContainer[iIdx], CDT(iIdx));
                                             }
 										}
 										// Illegal Opcode?
@@ -1477,9 +1782,11 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 							// MOVIREGS
 							case SYSCALL_OPCODE_LO(MOVIREGS):
+							VM_HANDLER(MOVIREGS)
 								{
 									const UINT_32 iSrcReg = SYSCALL_REG_SRC(iOpCode);
 									const UINT_32 iDstReg = SYSCALL_REG_DST(iOpCode);
@@ -1522,7 +1829,8 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 							// Illegal Opcode?
 							default:
 							{
@@ -1532,7 +1840,6 @@ HL_RST;
 							}
 						}
 					}
-					++iIP;
 					break;
 
 				// Comparison ops. ///// 0x-5-X----
@@ -1542,6 +1849,7 @@ HL_RST;
 						{
 							// CMP
 							case SYSCALL_OPCODE_LO(CMP):
+							VM_HANDLER(CMP)
 								{
 									// Register
 									const UINT_32 iSrcReg = SYSCALL_REG_SRC(iOpCode);
@@ -1594,10 +1902,12 @@ HL_RST;
 									if ((iTMP % 2) == 0) { iFlags |= FL_PF;  }
 									else                 { iFlags |= FL_NPF; }
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// SCMP
 							case SYSCALL_OPCODE_LO(SCMP):
+							VM_HANDLER(SCMP)
 								{
 									// Register
 									const UINT_32 iSrcReg = SYSCALL_REG_SRC(iOpCode);
@@ -1645,7 +1955,8 @@ HL_RST;
 									else if (sSrc > sDst) { iFlags = FL_GT | FL_NE; }
 									else                  { iFlags = FL_EQ; }
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// Illegal Opcode?
 							default:
@@ -1656,11 +1967,11 @@ HL_RST;
 							}
 						}
 					}
-					++iIP;
 					break;
 
 				// Conditional ops.1 /// 0x-6-X----
 				case 0x06:
+				VM_HANDLER(JXX)
 					{
 						const UINT_32 iOpCodeFlag = iOpCode & 0x00FF0000;
 #ifdef _DEBUG
@@ -1705,10 +2016,11 @@ HL_RST;
 							iIP = iNewIP;
 						}
 					}
-					break;
+					VM_NEXT;
 
 				// Conditional ops.2 /// 0x-7-X----
 				case 0x07:
+				VM_HANDLER(RJXX)
 					{
 						const UINT_32 iOpCodeFlag = iOpCode & 0x00FF0000;
 #ifdef _DEBUG
@@ -1753,7 +2065,7 @@ HL_RST;
 							iIP = iNewIP;
 						}
 					}
-					break;
+					VM_NEXT;
 				// Other ops. ////////// 0x-8-X----
 				case 0x08:
 					{
@@ -1761,6 +2073,7 @@ HL_RST;
 						{
 							// CLEAR
 							case SYSCALL_OPCODE_LO(CLEAR):
+							VM_HANDLER(CLEAR)
 								{
 									// Register
 									const UINT_32 iSrcReg = SYSCALL_REG_SRC(iOpCode);
@@ -1795,10 +2108,12 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// OUTPUT
 							case SYSCALL_OPCODE_LO(OUTPUT):
+							VM_HANDLER(OUTPUT)
 								{
 									// Register
 									const UINT_32 iSrcReg = SYSCALL_REG_SRC(iOpCode);
@@ -1813,8 +2128,7 @@ fprintf(stderr, "0x%08X OUTPUT    ", iIP);
 fprintf(stderr, "STACK[%d](`%s`)\n", aCode[iIP].argument, oVMArgStack.GetTopElement(aCode[iIP].argument).GetString().c_str());
 HL_RST;
 #endif
-										const STLW::string sTMP = oVMArgStack.GetTopElement(0).GetString();
-										pOutputCollector -> Collect(sTMP.c_str(), sTMP.size());
+										oVMArgStack.GetTopElement(0).WriteTo(*pOutputCollector);
 										oVMArgStack.ClearStack(1);
 									}
 									// From static text segment
@@ -1826,7 +2140,7 @@ HL_RST;
 fprintf(stderr, "STRING POS: %d (VAL: `%s`)\n", aCode[iIP].argument, szTMP);
 HL_RST;
 #endif
-										pOutputCollector -> Collect(szTMP, iDataSize);
+										pOutputCollector -> CollectStatic(szTMP, iDataSize);
 									}
 									// From static data segment (integer value)
 									else if (iSrcReg == ARG_SRC_INT)
@@ -1836,8 +2150,7 @@ fprintf(stderr, "INT POS: %d (VAL: %d)\n", aCode[iIP].argument, INT_32(pMemoryCo
 HL_RST;
 #endif
 										const CDT oTMP(pMemoryCore -> static_data.GetInt(aCode[iIP].argument));
-										const STLW::string sTMP = oTMP.GetString();
-										pOutputCollector -> Collect(sTMP.c_str(), sTMP.size());
+										oTMP.WriteTo(*pOutputCollector);
 									}
 									// From static data segment (float value)
 									else if (iSrcReg == ARG_SRC_FLOAT)
@@ -1847,8 +2160,7 @@ fprintf(stderr, "FLOAT POS: %d (VAL: %f)\n", aCode[iIP].argument, pMemoryCore ->
 HL_RST;
 #endif
 										const CDT oTMP(pMemoryCore -> static_data.GetFloat(aCode[iIP].argument));
-										STLW::string sTMP = oTMP.GetString();
-										pOutputCollector -> Collect(sTMP.c_str(), sTMP.size());
+										oTMP.WriteTo(*pOutputCollector);
 									}
 									// From register
 									else if (iSrcReg <= ARG_SRC_LASTREG)
@@ -1857,8 +2169,7 @@ HL_RST;
 fprintf(stderr, "%cR\n", CHAR_8(iSrcReg + 'A'));
 HL_RST;
 #endif
-										const STLW::string sTMP = oRegs[iSrcReg].GetString();
-										pOutputCollector -> Collect(sTMP.c_str(), sTMP.size());
+										oRegs[iSrcReg].WriteTo(*pOutputCollector);
 									}
 									// Indirect operations works ONLY with registers
 									else if (iSrcReg == ARG_SRC_IND_VAL)
@@ -1870,8 +2181,7 @@ HL_RST;
 #endif
 										if (iDstReg <= ARG_DST_LASTREG)
 										{
-											const STLW::string sTMP = oRegs[iDstReg >> 8].GetCDT(aCode[iIP].argument).GetString();
-											pOutputCollector -> Collect(sTMP.c_str(), sTMP.size());
+											oRegs[iDstReg >> 8].GetCDT(aCode[iIP].argument).WriteTo(*pOutputCollector);
 										}
 										// Illegal Opcode?
 										else
@@ -1886,16 +2196,14 @@ HL_RST;
 									{
 										const UINT_32 iDstReg = SYSCALL_REG_DST(iOpCode);
 
-										UINT_32 iDataSize = 0;
-										CCHAR_P szTMP     = pMemoryCore -> static_text.GetData(aCode[iIP].argument, iDataSize);
+										const CDTKey & oKey = GetKey(pMemoryCore, aCode[iIP].argument);
 #ifdef _DEBUG
-fprintf(stderr, "%cR[\"%s\"] (`%s`)\n", CHAR_8((iDstReg >> 8) + 'A'), szTMP, oRegs[iDstReg >> 8].GetCDT(STLW::string(szTMP, iDataSize)).GetString().c_str());
+fprintf(stderr, "%cR[\"%s\"] (`%s`)\n", CHAR_8((iDstReg >> 8) + 'A'), oKey.key.c_str(), oRegs[iDstReg >> 8].GetCDT(oKey).GetString().c_str());
 HL_RST;
 #endif
 										if (iDstReg <= ARG_DST_LASTREG)
 										{
-											STLW::string sTMP = oRegs[iDstReg >> 8].GetCDT(STLW::string(szTMP, iDataSize)).GetString();
-											pOutputCollector -> Collect(sTMP.c_str(), sTMP.size());
+											oRegs[iDstReg >> 8].GetCDT(oKey).WriteTo(*pOutputCollector);
 										}
 										// Illegal Opcode?
 										else
@@ -1913,10 +2221,12 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// REPLACE
 							case SYSCALL_OPCODE_LO(REPLACE):
+							VM_HANDLER(REPLACE)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -1929,23 +2239,21 @@ fprintf(stderr, "0x%08X REPLACE   ", iIP);
 									{
 										if (iDstReg <= ARG_DST_LASTREG)
 										{
-											UINT_32 iDataSize = 0;
-											CCHAR_P szTMP     = pMemoryCore -> static_text.GetData(aCode[iIP].argument, iDataSize);
+											const CDTKey & oKey = GetKey(pMemoryCore, aCode[iIP].argument);
 #ifdef _DEBUG
-fprintf(stderr, "%cR[\"%s\"] (`%s`)\n", CHAR_8((iDstReg >> 8) + 'A'), szTMP, oRegs[iDstReg >> 8].GetCDT(STLW::string(szTMP, iDataSize)).GetString().c_str());
+fprintf(stderr, "%cR[\"%s\"] (`%s`)\n", CHAR_8((iDstReg >> 8) + 'A'), oKey.key.c_str(), oRegs[iDstReg >> 8].GetCDT(oKey).GetString().c_str());
 HL_RST;
 #endif
-											oVMArgStack.GetTopElement(0) = oRegs[iDstReg >> 8].GetCDT(STLW::string(szTMP, iDataSize));
+											oVMArgStack.GetTopElement(0) = oRegs[iDstReg >> 8].GetCDT(oKey);
 										}
 										else if (iDstReg == ARG_DST_STACK)
 										{
-											UINT_32 iDataSize = 0;
-											CCHAR_P szTMP     = pMemoryCore -> static_text.GetData(aCode[iIP].argument, iDataSize);
+											const CDTKey & oKey = GetKey(pMemoryCore, aCode[iIP].argument);
 
 											CDT & oTopStack  = oVMArgStack.GetTopElement(0);
-											CDT oTMP = oTopStack.GetCDT(STLW::string(szTMP, iDataSize));
+											CDT oTMP = oTopStack.GetCDT(oKey);
 #ifdef _DEBUG
-fprintf(stderr, "TOP STACK[\"%s\"] (`%s`)\n", szTMP, oTMP.GetString().c_str());
+fprintf(stderr, "TOP STACK[\"%s\"] (`%s`)\n", oKey.key.c_str(), oTMP.GetString().c_str());
 HL_RST;
 #endif
 											oTopStack = oTMP;
@@ -2004,10 +2312,12 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// EXIST, check existence of operand
 							case SYSCALL_OPCODE_LO(EXIST):
+							VM_HANDLER(EXIST)
 								{
 #ifdef _DEBUG
 HL_CODE(GREEN);
@@ -2044,9 +2354,11 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 							// REPLINT
 							case SYSCALL_OPCODE_LO(REPLINT):
+							VM_HANDLER(REPLINT)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -2059,7 +2371,7 @@ fprintf(stderr, "0x%08X REPLINT   ", iIP);
 fprintf(stderr, "STACK[%d](%d)\n", aCode[iIP].argument, INT_32(oVMArgStack.GetTopElement(aCode[iIP].argument).GetInt()));
 HL_RST;
 #endif
-										oVMArgStack.GetTopElement(0) = oVMArgStack.GetTopElement(0)[oVMArgStack.GetTopElement(aCode[iIP].argument).GetInt()];
+										ReplaceByIndex(oVMArgStack.GetTopElement(0), oVMArgStack.GetTopElement(aCode[iIP].argument).GetInt());
 									}
 									else if (iSrcReg <= ARG_SRC_LASTREG)
 									{
@@ -2067,7 +2379,7 @@ HL_RST;
 fprintf(stderr, "%cR (%d)\n", CHAR_8(iSrcReg + 'A'), INT_32(oRegs[iSrcReg].GetInt()));
 HL_RST;
 #endif
-										oVMArgStack.GetTopElement(0) = oVMArgStack.GetTopElement(0)[oRegs[iSrcReg].GetInt()];
+										ReplaceByIndex(oVMArgStack.GetTopElement(0), oRegs[iSrcReg].GetInt());
 									}
 									// Illegal Opcode?
 									else
@@ -2077,10 +2389,12 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 
 							// REPLSTR
 							case SYSCALL_OPCODE_LO(REPLSTR):
+							VM_HANDLER(REPLSTR)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -2093,7 +2407,7 @@ fprintf(stderr, "0x%08X REPLSTR   ", iIP);
 fprintf(stderr, "STACK[%d](`%s`)\n", aCode[iIP].argument, oVMArgStack.GetTopElement(aCode[iIP].argument).GetString().c_str());
 HL_RST;
 #endif
-										oVMArgStack.GetTopElement(0) = oVMArgStack.GetTopElement(0)[oVMArgStack.GetTopElement(aCode[iIP].argument).GetString()];
+										ReplaceByKey(oVMArgStack.GetTopElement(0), oVMArgStack.GetTopElement(aCode[iIP].argument).GetString());
 									}
 									else if (iSrcReg <= ARG_SRC_LASTREG)
 									{
@@ -2101,7 +2415,7 @@ HL_RST;
 fprintf(stderr, "%cR (`%s`)\n", CHAR_8(iSrcReg + 'A'), oRegs[iSrcReg].GetString().c_str());
 HL_RST;
 #endif
-										oVMArgStack.GetTopElement(0) = oVMArgStack.GetTopElement(0)[oRegs[iSrcReg].GetString()];
+										ReplaceByKey(oVMArgStack.GetTopElement(0), oRegs[iSrcReg].GetString());
 									}
 									// Illegal Opcode?
 									else
@@ -2111,9 +2425,11 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 							// REPLIND
 							case SYSCALL_OPCODE_LO(REPLIND):
+							VM_HANDLER(REPLIND)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -2131,7 +2447,7 @@ fprintf(stderr, "0x%08X REPLIND   ", iIP);
 fprintf(stderr, "STACK[%d](%d)\n", aCode[iIP].argument, INT_32(oVMArgStack.GetTopElement(aCode[iIP].argument).GetInt()));
 HL_RST;
 #endif
-											oVMArgStack.GetTopElement(0) = oVMArgStack.GetTopElement(0)[oVMArgStack.GetTopElement(aCode[iIP].argument).GetInt()];
+											ReplaceByIndex(oVMArgStack.GetTopElement(0), oVMArgStack.GetTopElement(aCode[iIP].argument).GetInt());
 											break;
 										case CDT::STRING_VAL:
 										case CDT::STRING_INT_VAL:
@@ -2140,7 +2456,7 @@ HL_RST;
 fprintf(stderr, "STACK[%d](`%s`)\n", aCode[iIP].argument, oVMArgStack.GetTopElement(aCode[iIP].argument).GetString().c_str());
 HL_RST;
 #endif
-											oVMArgStack.GetTopElement(0) = oVMArgStack.GetTopElement(0)[oVMArgStack.GetTopElement(aCode[iIP].argument).GetString()];
+											ReplaceByKey(oVMArgStack.GetTopElement(0), oVMArgStack.GetTopElement(aCode[iIP].argument).GetString());
 											break;
 										default:
 #ifdef _DEBUG
@@ -2162,7 +2478,7 @@ HL_RST;
 fprintf(stderr, "%cR (%d)\n", CHAR_8(iSrcReg + 'A'), INT_32(oRegs[iSrcReg].GetInt()));
 HL_RST;
 #endif
-											oVMArgStack.GetTopElement(0) = oVMArgStack.GetTopElement(0)[oRegs[iSrcReg].GetInt()];
+											ReplaceByIndex(oVMArgStack.GetTopElement(0), oRegs[iSrcReg].GetInt());
 											break;
 										case CDT::STRING_VAL:
 										case CDT::STRING_INT_VAL:
@@ -2171,7 +2487,7 @@ HL_RST;
 fprintf(stderr, "%cR (`%s`)\n", CHAR_8(iSrcReg + 'A'), oRegs[iSrcReg].GetString().c_str());
 HL_RST;
 #endif
-											oVMArgStack.GetTopElement(0) = oVMArgStack.GetTopElement(0)[oRegs[iSrcReg].GetString()];
+											ReplaceByKey(oVMArgStack.GetTopElement(0), oRegs[iSrcReg].GetString());
 											break;
 										default:
 #ifdef _DEBUG
@@ -2190,9 +2506,11 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 							// XCHG
 							case SYSCALL_OPCODE_LO(XCHG):
+							VM_HANDLER(XCHG)
 								{
 #ifdef _DEBUG
 HL_CODE(RED);
@@ -2234,9 +2552,11 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 							// DEFINED, check existence of operand
 							case SYSCALL_OPCODE_LO(DEFINED):
+							VM_HANDLER(DEFINED)
 								{
 #ifdef _DEBUG
 HL_CODE(GREEN);
@@ -2273,9 +2593,11 @@ HL_RST;
 										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
 									}
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 							// SAVEBP, save base pointer
 							case SYSCALL_OPCODE_LO(SAVEBP):
+							VM_HANDLER(SAVEBP)
 								{
 #ifdef _DEBUG
 HL_CODE(GREEN);
@@ -2289,9 +2611,11 @@ if (aCode[iIP].argument > 0) {
 #endif
 									oVMArgStack.SaveBasePointer(aCode[iIP].argument);
 								}
-								break;
+								++iIP;
+								VM_NEXT;
 							// RESTBP, restore base pointer
 							case SYSCALL_OPCODE_LO(RESTBP):
+							VM_HANDLER(RESTBP)
 								{
 #ifdef _DEBUG
 HL_CODE(GREEN);
@@ -2299,7 +2623,110 @@ fprintf(stderr, "0x%08X RESTBP\n", iIP);
 #endif
 									oVMArgStack.RestoreBasePointer();
 								}
-								break;
+								++iIP;
+								VM_NEXT;
+							// OUTVAR, output variable from local scope or, if it is undefined, from global scope
+							case SYSCALL_OPCODE_LO(OUTVAR):
+							VM_HANDLER(OUTVAR)
+								{
+									const UINT_32 iSrcReg = SYSCALL_REG_SRC(iOpCode);
+									const UINT_32 iDstReg = SYSCALL_REG_DST(iOpCode);
+									if (iSrcReg > ARG_SRC_LASTREG || iDstReg > ARG_DST_LASTREG)
+									{
+										UINT_32 iDataSize = 0;
+										CCHAR_P szTMP     = pMemoryCore -> static_text.GetData(VMDebugInfo(aCode[iIP].reserved).GetDescrId(), iDataSize);
+										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
+									}
+
+									const CDT & oValue = LookupVariable(oRegs[iSrcReg], oRegs[iDstReg >> 8], GetKey(pMemoryCore, aCode[iIP].argument));
+#ifdef _DEBUG
+HL_CODE(YELLOW);
+fprintf(stderr, "0x%08X OUTVAR    %cR/%cR[\"%s\"] (`%s`)\n", iIP, CHAR_8(iSrcReg + 'A'), CHAR_8((iDstReg >> 8) + 'A'), GetKey(pMemoryCore, aCode[iIP].argument).key.c_str(), oValue.GetString().c_str());
+HL_RST;
+#endif
+									oValue.WriteTo(*pOutputCollector);
+								}
+								++iIP;
+								VM_NEXT;
+							// OUTVAR_ESC, output variable passed through single-argument system call
+							case SYSCALL_OPCODE_LO(OUTVAR_ESC):
+							VM_HANDLER(OUTVAR_ESC)
+								{
+									const UINT_32 iSrcReg  = SYSCALL_REG_SRC(iOpCode);
+									const UINT_32 iDstReg  = SYSCALL_REG_DST(iOpCode);
+									const UINT_32 iCallNum = (aCode[iIP].argument & 0xFFFF0000) >> 16;
+									const UINT_32 iTextId  = (aCode[iIP].argument & 0x0000FFFF);
+									if (iSrcReg > ARG_SRC_LASTREG || iDstReg > ARG_DST_LASTREG)
+									{
+										UINT_32 iDataSize = 0;
+										CCHAR_P szTMP     = pMemoryCore -> static_text.GetData(VMDebugInfo(aCode[iIP].reserved).GetDescrId(), iDataSize);
+										throw IllegalOpcode(iIP, iOpCode, aCode[iIP].reserved, szTMP);
+									}
+
+									// Check call number
+									if (iCallNum >= iMaxUsedCalls)
+									{
+										UINT_32 iDataSize = 0;
+										CCHAR_P szTMP = pMemoryCore -> static_text.GetData(VMDebugInfo(aCode[iIP].reserved).GetDescrId(), iDataSize);
+										throw InvalidSyscall("*** CORRUPTED ***", iIP, aCode[iIP].reserved, szTMP);
+									}
+#ifdef _DEBUG
+{
+	UINT_32 iCallNameLength = 0;
+	CCHAR_P sCallName = pMemoryCore -> syscalls.GetData(iCallNum, iCallNameLength);
+	HL_CODE(YELLOW);
+	fprintf(stderr, "0x%08X OUTVAR_ESC %s(%cR/%cR[\"%s\"])\n", iIP, sCallName, CHAR_8(iSrcReg + 'A'), CHAR_8((iDstReg >> 8) + 'A'), GetKey(pMemoryCore, iTextId).key.c_str());
+	HL_RST;
+}
+#endif
+									// Argument of system call is passed in stack
+									oVMArgStack.PushElement(LookupVariable(oRegs[iSrcReg], oRegs[iDstReg >> 8], GetKey(pMemoryCore, iTextId)));
+
+									if (aCallTranslationMap[iCallNum] -> HandlerToOutput(oVMArgStack.GetStackFrame(), 1, *pOutputCollector, *pLogger) != 0)
+									{
+										UINT_32 iDataSize = 0;
+										CCHAR_P szTMP = pMemoryCore -> static_text.GetData(VMDebugInfo(aCode[iIP].reserved).GetDescrId(), iDataSize);
+										throw InvalidSyscall("*** Internal syscall error ***", iIP, aCode[iIP].reserved, szTMP);
+									}
+									oVMArgStack.ClearStack(1);
+								}
+								++iIP;
+								VM_NEXT;
+							// OUTSYS, system call with result written to output collector
+							case SYSCALL_OPCODE_LO(OUTSYS):
+							VM_HANDLER(OUTSYS)
+								{
+									const UINT_32 iCallNum    = (aCode[iIP].argument & 0xFFFF0000) >> 16;
+									const UINT_32 iCallArgNum = (aCode[iIP].argument & 0x0000FFFF);
+#ifdef _DEBUG
+{
+	UINT_32 iCallNameLength = 0;
+	CCHAR_P sCallName = pMemoryCore -> syscalls.GetData(iCallNum, iCallNameLength);
+	HL_CODE(YELLOW);
+	fprintf(stderr, "0x%08X OUTSYS    0x%08X %s(ARGS: %d)\n", iIP, iCallNum, sCallName, iCallArgNum);
+	HL_RST;
+}
+#endif
+									// Check call number
+									if (iCallNum >= iMaxUsedCalls)
+									{
+										UINT_32 iDataSize = 0;
+										CCHAR_P szTMP = pMemoryCore -> static_text.GetData(VMDebugInfo(aCode[iIP].reserved).GetDescrId(), iDataSize);
+										throw InvalidSyscall("*** CORRUPTED ***", iIP, aCode[iIP].reserved, szTMP);
+									}
+
+									if (aCallTranslationMap[iCallNum] -> HandlerToOutput(oVMArgStack.GetStackFrame(), iCallArgNum, *pOutputCollector, *pLogger) != 0)
+									{
+										UINT_32 iDataSize = 0;
+										CCHAR_P szTMP = pMemoryCore -> static_text.GetData(VMDebugInfo(aCode[iIP].reserved).GetDescrId(), iDataSize);
+										throw InvalidSyscall("*** Internal syscall error ***", iIP, aCode[iIP].reserved, szTMP);
+									}
+
+									// Clear stack, result is not stored
+									oVMArgStack.ClearStack(iCallArgNum);
+								}
+								++iIP;
+								VM_NEXT;
 							// Illegal Opcode?
 							default:
 							{
@@ -2309,7 +2736,6 @@ fprintf(stderr, "0x%08X RESTBP\n", iIP);
 							}
 						}
 					}
-					++iIP;
 					break;
 
 				// HLT
@@ -2319,6 +2745,7 @@ fprintf(stderr, "0x%08X RESTBP\n", iIP);
 						{
 							// HLT
 							case SYSCALL_OPCODE_LO(HLT):
+							VM_HANDLER(HLT)
 #ifdef _DEBUG
 HL_CODE(RED);
 fprintf(stderr, "0x%08X HLT\n", iIP);
@@ -2327,6 +2754,7 @@ HL_RST;
 								return 0;
 							// BRK
 							case SYSCALL_OPCODE_LO(BRK):
+							VM_HANDLER(BRK)
 #ifdef _DEBUG
 HL_CODE(RED);
 fprintf(stderr, "0x%08X BRK\n", iIP);
@@ -2334,16 +2762,17 @@ HL_RST;
 #endif
 								if (iDebugLevel > 0) { return 0; }
 								++iIP;
-								break;
+								VM_NEXT;
 							// NOP
 							case SYSCALL_OPCODE_LO(NOP):
+							VM_HANDLER(NOP)
 #ifdef _DEBUG
 HL_CODE(RED);
 fprintf(stderr, "0x%08X NOP\n", iIP);
 HL_RST;
 #endif
 								++iIP; // Do nothing
-								break;
+								VM_NEXT;
 							// Illegal Opcode?
 							default:
 							{
@@ -2357,6 +2786,7 @@ HL_RST;
 
 				// Illegal Opcode?
 				default:
+				VM_HANDLER(ILLEGAL)
 					{
 						UINT_32 iDataSize = 0;
 						CCHAR_P szTMP     = pMemoryCore -> static_text.GetData(VMDebugInfo(aCode[iIP].reserved).GetDescrId(), iDataSize);
@@ -2365,6 +2795,10 @@ HL_RST;
 			} // switch(SYSCALL_OPCODE_HI(iOpCode))
 			++iExecutedSteps;
 		} // while (iIP < iCodeLength)
+#ifdef _COMPUTED_GOTO
+END_OF_CODE:
+		;;
+#endif
 	}
 	catch (StackOverflow  & e)
 	{
@@ -2390,6 +2824,10 @@ HL_RST;
 return 0;
 }
 
+#ifdef _COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
+
 //
 // Reset virtual machine state
 //
@@ -2409,9 +2847,75 @@ INT_32 VM::Reset()
 	oVMArgStack.Reset();
 	oVMCodeStack.Reset();
 
+	// Free memory too, cursors hold iterated containers
+	STLW::vector<LoopCursor>().swap(vLoopCursors);
+
 return 0;
 }
 
+//
+// Constructor
+//
+VM::LoopCursor::LoopCursor(const UINT_32  iIIP,
+                           const CDT    & oIContainer): ip(iIIP),
+                                                        index(0),
+                                                        container(oIContainer),
+                                                        cursor(oIContainer.Begin())
+{
+	;;
+}
+
+//
+// Get iterator pointed to element of HASH in foreach loop
+//
+CDT::ConstIterator VM::GetLoopCursor(const UINT_32  iIP,
+                                     const CDT    & oHash,
+                                     const INT_32   iIdx)
+{
+	// Find cursor of this loop; nested loops are on top of vector
+	UINT_32 iPos = vLoopCursors.size();
+	for (; iPos > 0; --iPos)
+	{
+		const LoopCursor & oCursor = vLoopCursors[iPos - 1];
+		if (oCursor.ip == iIP && oCursor.container.SharesData(oHash)) { break; }
+	}
+
+	if (iPos == 0)
+	{
+		// Forget the oldest cursor; such loop was interrupted by TMPL_break
+		if (vLoopCursors.size() >= C_MAX_LOOP_CURSORS) { vLoopCursors.erase(vLoopCursors.begin()); }
+
+		vLoopCursors.push_back(LoopCursor(iIP, oHash));
+		iPos = vLoopCursors.size();
+	}
+
+	LoopCursor & oCursor = vLoopCursors[iPos - 1];
+	// Next element, O(1)
+	if (iIdx == oCursor.index + 1)
+	{
+		++oCursor.cursor;
+	}
+	// Loop restarted or moved backwards, rescan hash
+	else if (iIdx != oCursor.index)
+	{
+		oCursor.cursor = oCursor.container.Begin();
+		for (INT_32 iI = 0; iI < iIdx; ++iI) { ++oCursor.cursor; }
+	}
+	oCursor.index = iIdx;
+
+	CDT::ConstIterator itResult = oCursor.cursor;
+
+	// Last element, loop is done
+	if (UINT_32(iIdx + 1) >= oHash.Size()) { vLoopCursors.erase(vLoopCursors.begin() + (iPos - 1)); }
+
+return itResult;
+}
+
+//
+// Get number of instructions executed by last run of program
+//
+UINT_32 VM::GetExecutedSteps() const { return iExecutedSteps; }
+
 //
 //
 //
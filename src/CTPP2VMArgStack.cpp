@@ -87,6 +87,7 @@ INT_32 VMArgStack::PopElement()
 {
 	if (iStackPointer == vBasePointers.back()) { throw StackUnderflow(0); }
 
+	ReleaseElements(iStackPointer, iStackPointer + 1);
 	++iStackPointer;
 
 return iStackPointer;
@@ -113,6 +114,7 @@ INT_32 VMArgStack::ClearStack(const INT_32  iDepth)
 
 	if (iNewSP > vBasePointers.back()) { throw StackUnderflow(0); }
 
+	ReleaseElements(iStackPointer, iNewSP);
 	iStackPointer = iNewSP;
 
 return iNewSP;
@@ -123,11 +125,26 @@ return iNewSP;
 //
 void VMArgStack::Reset()
 {
+	ReleaseElements(iStackPointer, iMaxStackSize);
 	iStackPointer = iMaxStackSize;
 	vBasePointers.clear();
 	vBasePointers.push_back(iMaxStackSize);
 }
 
+//
+// Release values of elements in range [iBegin, iEnd)
+//
+void VMArgStack::ReleaseElements(const INT_32  iBegin,
+                                 const INT_32  iEnd)
+{
+	const CDT oUndef;
+	for (INT_32 iPos = iBegin; iPos < iEnd; ++iPos)
+	{
+		// Values of scalars are not referenced, nothing to release
+		if (aStack[iPos].GetType() >= CDT::STRING_VAL) { aStack[iPos] = oUndef; }
+	}
+}
+
 //
 // A destructor
 //
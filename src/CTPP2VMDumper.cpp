@@ -33,6 +33,7 @@
 
 #include "CTPP2Util.hpp"
 #include "CTPP2VMInstruction.hpp"
+#include "CTPP2VMOpcodes.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -53,25 +54,29 @@ return iOffset + 8 - iAlignedOffset;
 }
 
 //
-// Constructor
+// Get size of text segment; empty records left by StaticText::Compact() may be the last ones
 //
-VMDumper::VMDumper(const VMMemoryCore & oMemoryCore)
+static INT_32 GetTextDataSize(const TextDataIndex  * aDataOffsets,
+                              const UINT_32          iDataOffsetsSize)
 {
-	INT_32 iSyscallsDataSize   = 0;
-	if (oMemoryCore.syscalls.iUsedDataOffsetsSize == 0) { iSyscallsDataSize = 0; }
-	else
+	INT_32 iDataSize = 0;
+	for (UINT_32 iPos = 0; iPos < iDataOffsetsSize; ++iPos)
 	{
-		const TextDataIndex & oTMP = oMemoryCore.syscalls.aDataOffsets[oMemoryCore.syscalls.iUsedDataOffsetsSize - 1];
-		iSyscallsDataSize = oTMP.offset + oTMP.length + 1;
+		const TextDataIndex & oTMP = aDataOffsets[iPos];
+		const INT_32 iEnd = oTMP.offset + oTMP.length + 1;
+		if (iEnd > iDataSize) { iDataSize = iEnd; }
 	}
 
-	INT_32 iStaticTextDataSize = 0;
-	if (oMemoryCore.static_text.iUsedDataOffsetsSize == 0) { iStaticTextDataSize = 0; }
-	else
-	{
-		const TextDataIndex & oTMP = oMemoryCore.static_text.aDataOffsets[oMemoryCore.static_text.iUsedDataOffsetsSize - 1];
-		iStaticTextDataSize    = oTMP.offset + oTMP.length + 1;
-	}
+return iDataSize;
+}
+
+//
+// Constructor
+//
+VMDumper::VMDumper(const VMMemoryCore & oMemoryCore)
+{
+	const INT_32 iSyscallsDataSize   = GetTextDataSize(oMemoryCore.syscalls.aDataOffsets,    oMemoryCore.syscalls.iUsedDataOffsetsSize);
+	const INT_32 iStaticTextDataSize = GetTextDataSize(oMemoryCore.static_text.aDataOffsets, oMemoryCore.static_text.iUsedDataOffsetsSize);
 
 	const INT_32 iCodeSize               = sizeof(VMInstruction) * oMemoryCore.code_size;
 	const INT_32 iSyscallsIndexSize      = sizeof(TextDataIndex) * oMemoryCore.syscalls.iUsedDataOffsetsSize;
@@ -120,6 +125,8 @@ VMDumper::VMDumper(const VMMemoryCore & oMemoryCore)
 	for(UINT_32 iI = 0; iI < 8; ++iI) { oVMExecutable -> version[iI] = 0; }
 
 	oVMExecutable -> version[0] = 2;
+	// Version of instruction set
+	oVMExecutable -> version[1] = VM_OPCODE_VERSION;
 
 	oVMExecutable -> entry_point              = 0;
 	oVMExecutable -> code_offset              = AlignSegment(sizeof(VMExecutable));
@@ -216,21 +223,8 @@ VMDumper::VMDumper(const UINT_32          iInstructions,
                    const StaticText     & oStaticText,
                    const HashTable      & oHashTable)
 {
-	INT_32 iSyscallsDataSize   = 0;
-	if (oSyscalls.iUsedDataOffsetsSize == 0) { iSyscallsDataSize = 0; }
-	else
-	{
-		const TextDataIndex & oTMP = oSyscalls.aDataOffsets[oSyscalls.iUsedDataOffsetsSize - 1];
-		iSyscallsDataSize = oTMP.offset + oTMP.length + 1;
-	}
-
-	INT_32 iStaticTextDataSize = 0;
-	if (oStaticText.iUsedDataOffsetsSize == 0) { iStaticTextDataSize = 0; }
-	else
-	{
-		const TextDataIndex & oTMP = oStaticText.aDataOffsets[oStaticText.iUsedDataOffsetsSize - 1];
-		iStaticTextDataSize    = oTMP.offset + oTMP.length + 1;
-	}
+	const INT_32 iSyscallsDataSize   = oSyscalls.iUsedDataSize;
+	const INT_32 iStaticTextDataSize = oStaticText.iUsedDataSize;
 
 	const INT_32 iCodeSize               = sizeof(VMInstruction) * iInstructions;
 	const INT_32 iSyscallsIndexSize      = sizeof(TextDataIndex) * oSyscalls.iUsedDataOffsetsSize;
@@ -278,6 +272,8 @@ VMDumper::VMDumper(const UINT_32          iInstructions,
 	for(UINT_32 iI = 0; iI < 8; ++iI) { oVMExecutable -> version[iI] = 0; }
 
 	oVMExecutable -> version[0] = 2;
+	// Version of instruction set
+	oVMExecutable -> version[1] = VM_OPCODE_VERSION;
 
 	oVMExecutable -> entry_point              = 0;
 	oVMExecutable -> code_offset              = AlignSegment(sizeof(VMExecutable));
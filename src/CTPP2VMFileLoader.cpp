@@ -37,13 +37,12 @@
 #include "CTPP2VMExecutable.hpp"
 #include "CTPP2VMInstruction.hpp"
 #include "CTPP2VMMemoryCore.hpp"
+#include "CTPP2VMOpcodes.h"
 
-#include <sys/types.h>
-#include <sys/stat.h>
-
-#include <errno.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 namespace CTPP // C++ Template Engine
 {
@@ -153,85 +152,122 @@ static void ConvertExecutable(VMExecutable * oCore)
 //
 // Constructor
 //
-VMFileLoader::VMFileLoader(CCHAR_P szFileName)
+VMFileLoader::VMFileLoader(CCHAR_P szFileName): oCore(NULL),
+                                                iCoreSize(0),
+                                                bCopied(false),
+                                                pVMMemoryCore(NULL)
 {
-	// Get file size
-	struct stat oStat;
-	if (stat(szFileName, &oStat) == -1) { throw CTPPUnixException("stat", errno); }
-	if (oStat.st_size == 0) { throw CTPPLogicError("Cannot get size of file"); }
-
-	// Load file
-	FILE * F = fopen(szFileName, "rb");
-	if (F == NULL) { throw CTPPUnixException("fopen", errno); }
-
-	// Allocate memory
-	oCore = (VMExecutable *)malloc(oStat.st_size);
-	// Read from file
-	if (fread(oCore, oStat.st_size, 1, F) != 1)
+	oFile.Open(szFileName);
+
+	if (oFile.GetSize() == 0) { throw CTPPLogicError("Cannot get size of file"); }
+
+	if (oFile.GetSize() < sizeof(VMExecutable)) { throw CTPPLogicError("Not an CTPP bytecode file."); }
+
+	// Program core is read-only while it is not converted
+	oCore     = (VMExecutable *)(oFile.GetData());
+	iCoreSize = oFile.GetSize();
+
+	try
 	{
-		fclose(F);
-		throw CTPPUnixException("fread", errno);
+		CheckCore();
+		pVMMemoryCore = new VMMemoryCore(oCore);
 	}
+	catch(...)
+	{
+		ReleaseCore();
+		throw;
+	}
+}
 
-	// All Done
-	fclose(F);
+//
+// Check program core, convert byte order if need
+//
+void VMFileLoader::CheckCore()
+{
+	if (oCore -> magic[0] != 'C' ||
+	    oCore -> magic[1] != 'T' ||
+	    oCore -> magic[2] != 'P' ||
+	    oCore -> magic[3] != 'P')
+	{
+		throw CTPPLogicError("Not an CTPP bytecode file.");
+	}
+
+	// Check version
+	if (oCore -> version[0] < 1) { return; }
 
-	if (oCore -> magic[0] == 'C' &&
-	    oCore -> magic[1] == 'T' &&
-	    oCore -> magic[2] == 'P' &&
-	    oCore -> magic[3] == 'P')
+	// Programs compiled before versioning of instruction set have zero here and are still supported
+	if (UCHAR_8(oCore -> version[1]) > VM_OPCODE_VERSION)
+	{
+		throw CTPPLogicError("Program uses instructions not supported by this version of virtual machine");
+	}
+
+	// Platform-dependent data (byte order)
+	if (oCore -> platform == 0x4142434445464748ull)
 	{
-		// Check version
-		if (oCore -> version[0] >= 1)
-		{
-			// Platform-dependent data (byte order)
-			if (oCore -> platform == 0x4142434445464748ull)
-			{
 #ifdef _DEBUG
-				fprintf(stderr, "Big/Little Endian conversion: Nothing to do\n");
+		fprintf(stderr, "Big/Little Endian conversion: Nothing to do\n");
 #endif
 
-				// Nothing to do, only check crc
-				UINT_32 iCRC = oCore -> crc;
-				oCore -> crc = 0;
-
-				// Calculate CRC of file
-				if (iCRC != crc32((UCCHAR_P)oCore, oStat.st_size))
-				{
-					free(oCore);
-					throw CTPPLogicError("CRC checksum invalid");
-				}
-			}
-			// Platform-dependent data (byte order)
-			else if (oCore -> platform == 0x4847464544434241ull)
-			{
-				// Need to reconvert data
+		// Nothing to do, only check crc; CRC is calculated with zero crc field, core may be read-only
+		static const UCHAR_8 aZeroCRC[sizeof(UINT_32)] = { 0, 0, 0, 0 };
+		const UINT_32 iCRCOffset = offsetof(VMExecutable, crc);
+		const UINT_32 iDataOffset = iCRCOffset + sizeof(UINT_32);
+
+		UINT_32 iCRC = crc32((UCCHAR_P)oCore, iCRCOffset);
+		iCRC = crc32(aZeroCRC, sizeof(UINT_32), iCRC);
+		iCRC = crc32((UCCHAR_P)oCore + iDataOffset, iCoreSize - iDataOffset, iCRC);
+
+		// Calculate CRC of file
+		if (iCRC != oCore -> crc) { throw CTPPLogicError("CRC checksum invalid"); }
+	}
+	// Platform-dependent data (byte order)
+	else if (oCore -> platform == 0x4847464544434241ull)
+	{
+		// Need to reconvert data
 #ifdef _DEBUG
-				fprintf(stderr, "Big/Little Endian conversion: Need to reconvert core\n");
+		fprintf(stderr, "Big/Little Endian conversion: Need to reconvert core\n");
 #endif
-				ConvertExecutable(oCore);
-			}
-			else
-			{
-				free(oCore);
-				throw CTPPLogicError("Conversion of middle-end architecture does not supported.");
-			}
-
-			// Check IEEE 754 format
-			if (oCore -> ieee754double != 15839800103804824402926068484019465486336.0)
-			{
-				free(oCore);
-				throw CTPPLogicError("IEEE 754 format is broken, cannot convert file");
-			}
-		}
-
-		pVMMemoryCore = new VMMemoryCore(oCore);
+		// Only private copy of program can be converted
+		CopyCore();
+		ConvertExecutable(oCore);
 	}
 	else
 	{
-		free(oCore);
-		throw CTPPLogicError("Not an CTPP bytecode file.");
+		throw CTPPLogicError("Conversion of middle-end architecture does not supported.");
 	}
+
+	// Check IEEE 754 format
+	if (oCore -> ieee754double != 15839800103804824402926068484019465486336.0)
+	{
+		throw CTPPLogicError("IEEE 754 format is broken, cannot convert file");
+	}
+}
+
+//
+// Copy program core into private memory
+//
+void VMFileLoader::CopyCore()
+{
+	if (bCopied) { return; }
+
+	VMExecutable * oCopy = (VMExecutable *)malloc(iCoreSize);
+	memcpy(oCopy, oCore, iCoreSize);
+
+	ReleaseCore();
+	oCore   = oCopy;
+	bCopied = true;
+}
+
+//
+// Release program core
+//
+void VMFileLoader::ReleaseCore() throw()
+{
+	if (bCopied) { free(oCore); }
+	oFile.Close();
+
+	oCore   = NULL;
+	bCopied = false;
 }
 
 //
@@ -245,7 +281,7 @@ const VMMemoryCore * VMFileLoader::GetCore() const { return pVMMemoryCore; }
 VMFileLoader::~VMFileLoader() throw()
 {
 	delete pVMMemoryCore;
-	free(oCore);
+	ReleaseCore();
 }
 
 } // namespace CTPP
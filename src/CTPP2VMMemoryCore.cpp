@@ -31,8 +31,10 @@
  */
 #include "CTPP2VMMemoryCore.hpp"
 
+#include "CTPP2VM.hpp"
 #include "CTPP2VMExecutable.hpp"
 #include "CTPP2VMInstruction.hpp"
+#include "CTPP2VMOpcodes.h"
 
 namespace CTPP // C++ Template Engine
 {
@@ -59,7 +61,57 @@ VMMemoryCore::VMMemoryCore(const VMExecutable  * pVMExecutable): code_size(pVMEx
                                                                  calls_table(VMExecutable::GetCallsTable(pVMExecutable),
                                                                              VMExecutable::GetCallsTablePower(pVMExecutable))
 {
-	;;
+	// Intern all static text records used as HASH keys
+	keys.resize(static_text.GetRecordsNum());
+	for (UINT_32 iIP = 0; iIP < code_size; ++iIP)
+	{
+		const UINT_32 iOpCode = instructions[iIP].instruction;
+		// OUTVAR_ESC holds syscall number in high part of argument
+		const UINT_32 iTextId = (SYSCALL_OPCODE(iOpCode) == SYSCALL_OPCODE(OUTVAR_ESC)) ? (instructions[iIP].argument & 0x0000FFFF) : instructions[iIP].argument;
+
+		if (SYSCALL_OPCODE(iOpCode) == SYSCALL_OPCODE(MOVISTR)    ||
+		    SYSCALL_OPCODE(iOpCode) == SYSCALL_OPCODE(IMOVSTR)    ||
+		    SYSCALL_OPCODE(iOpCode) == SYSCALL_OPCODE(OUTVAR)     ||
+		    SYSCALL_OPCODE(iOpCode) == SYSCALL_OPCODE(OUTVAR_ESC) ||
+		    SYSCALL_REG_SRC(iOpCode) == ARG_SRC_IND_STR)
+		{
+			if (iTextId >= keys.size() || !keys[iTextId].key.empty()) { continue; }
+
+			UINT_32 iDataSize = 0;
+			CCHAR_P szData    = static_text.GetData(iTextId, iDataSize);
+			if (szData != NULL) { keys[iTextId] = CDTKey(szData, iDataSize); }
+		}
+	}
+
+	// Views of string literals; strings are pushed into stack without copying
+	static const CDTStringView oEmptyView = { "", 0 };
+	strings.resize(static_text.GetRecordsNum(), oEmptyView);
+	for (UINT_32 iIP = 0; iIP < code_size; ++iIP)
+	{
+		const UINT_32 iOpCode = instructions[iIP].instruction;
+		const UINT_32 iTextId = instructions[iIP].argument;
+
+		if ((SYSCALL_OPCODE(iOpCode) == SYSCALL_OPCODE(PUSH) ||
+		     SYSCALL_OPCODE(iOpCode) == SYSCALL_OPCODE(MOV)) && SYSCALL_REG_SRC(iOpCode) == ARG_SRC_STR)
+		{
+			if (iTextId >= strings.size()) { continue; }
+
+			UINT_32 iDataSize = 0;
+			CCHAR_P szData    = static_text.GetData(iTextId, iDataSize);
+			if (szData != NULL)
+			{
+				strings[iTextId].data   = szData;
+				strings[iTextId].length = iDataSize;
+			}
+		}
+	}
+
+	// Pre-decode instructions once per program; VM jumps straight to handlers
+	handlers.resize(code_size);
+	for (UINT_32 iIP = 0; iIP < code_size; ++iIP)
+	{
+		handlers[iIP] = VM::DecodeInstruction(instructions[iIP].instruction);
+	}
 }
 
 } // namespace CTPP
@@ -0,0 +1,540 @@
+/*-
+ * Copyright (c) 2004 - 2011 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CTPP2VMOptimizer.cpp
+ *
+ * $CTPP$
+ */
+#include "CTPP2VMOptimizer.hpp"
+
+#include "CDT.hpp"
+#include "CTPP2HashTable.hpp"
+#include "CTPP2StaticData.hpp"
+#include "CTPP2StaticText.hpp"
+#include "CTPP2VMOpcodeCollector.hpp"
+#include "CTPP2VMOpcodes.h"
+#include "STLString.hpp"
+
+namespace CTPP // C++ Template Engine
+{
+
+//
+// Check instruction with absolute jump target
+//
+static bool IsAbsoluteJump(const UINT_32  iOpCode)
+{
+	const UINT_32 iInstruction = iOpCode & 0xFFFF0000;
+	if (iInstruction == CALL || iInstruction == JMP || iInstruction == LOOP) { return true; }
+
+return (iOpCode & 0xFF000000) == JXX;
+}
+
+//
+// Check instruction with jump target relative to instruction position
+//
+static bool IsRelativeJump(const UINT_32  iOpCode)
+{
+	const UINT_32 iInstruction = iOpCode & 0xFFFF0000;
+	if (iInstruction == RCALL || iInstruction == RJMP || iInstruction == RLOOP_OBSOLETE) { return true; }
+
+return (iOpCode & 0xFF000000) == RJXX;
+}
+
+//
+// Get jump target of instruction
+//
+static UINT_32 GetJumpTarget(const VMInstruction  & oInstruction,
+                             const UINT_32          iIP)
+{
+	if (IsAbsoluteJump(oInstruction.instruction)) { return oInstruction.argument;       }
+	if (IsRelativeJump(oInstruction.instruction)) { return iIP + oInstruction.argument; }
+
+return (UINT_32)-1;
+}
+
+//
+// Set jump target of instruction
+//
+static void SetJumpTarget(VMInstruction  & oInstruction,
+                          const UINT_32    iIP,
+                          const UINT_32    iTarget)
+{
+	if      (IsAbsoluteJump(oInstruction.instruction)) { oInstruction.argument = iTarget;       }
+	else if (IsRelativeJump(oInstruction.instruction)) { oInstruction.argument = iTarget - iIP; }
+}
+
+//
+// Check unconditional jump
+//
+static bool IsUncondJump(const UINT_32  iOpCode)
+{
+	return iOpCode == JMP || iOpCode == RJMP;
+}
+
+//
+// Check instruction after which execution never continues to next one
+//
+static bool IsTerminator(const UINT_32  iOpCode)
+{
+	const UINT_32 iInstruction = iOpCode & 0xFFFF0000;
+
+return IsUncondJump(iOpCode) || iInstruction == RET || iInstruction == HLT;
+}
+
+//
+// Constructor
+//
+VMOptimizer::VMOptimizer(VMOpcodeCollector  & oIVMOpcodeCollector,
+                         StaticData         & oIStaticData,
+                         StaticText         & oIStaticText,
+                         HashTable          & oICallsTable): oVMOpcodeCollector(oIVMOpcodeCollector),
+                                                             oStaticData(oIStaticData),
+                                                             oStaticText(oIStaticText),
+                                                             oCallsTable(oICallsTable)
+{
+	;;
+}
+
+//
+// Apply all optimizations until code does not change
+//
+UINT_32 VMOptimizer::Optimize()
+{
+	UINT_32 iRemoved = 0;
+	for (;;)
+	{
+		UINT_32 iPassRemoved = FoldConstants();
+		iPassRemoved += RemovePushPop();
+		iPassRemoved += OptimizeJumps();
+		iPassRemoved += MergeStaticOutput();
+
+		if (iPassRemoved == 0) { break; }
+		iRemoved += iPassRemoved;
+	}
+
+return iRemoved;
+}
+
+//
+// Merge consecutive outputs of static text into one instruction
+//
+UINT_32 VMOptimizer::MergeStaticOutput()
+{
+	STLW::vector<VMInstruction> & oCodeSeg = oVMOpcodeCollector.oCodeSeg;
+	const UINT_32 iCodeSize = oCodeSeg.size();
+
+	// Output may be merged only if nobody jumps into the middle of sequence
+	STLW::vector<UINT_32> vTargets;
+	MarkJumpTargets(vTargets);
+
+	STLW::vector<bool> vRemoved(iCodeSize, false);
+	STLW::string       sMerged;
+	UINT_32 iPos = 0;
+	while (iPos < iCodeSize)
+	{
+		if (oCodeSeg[iPos].instruction != (OUTPUT | ARG_SRC_STR)) { ++iPos; continue; }
+
+		UINT_32 iEnd = iPos + 1;
+		while (iEnd < iCodeSize && oCodeSeg[iEnd].instruction == (OUTPUT | ARG_SRC_STR) && vTargets[iEnd] == 0) { ++iEnd; }
+
+		if (iEnd - iPos > 1)
+		{
+			sMerged.erase();
+			for (UINT_32 iMergePos = iPos; iMergePos < iEnd; ++iMergePos)
+			{
+				UINT_32 iDataSize = 0;
+				CCHAR_P szData = oStaticText.GetData(oCodeSeg[iMergePos].argument, iDataSize);
+				if (szData != NULL) { sMerged.append(szData, iDataSize); }
+			}
+
+			const UINT_32 iDataId = oStaticText.StoreData(sMerged.data(), sMerged.size());
+			for (UINT_32 iMergePos = iPos; iMergePos < iEnd; ++iMergePos)
+			{
+				oStaticText.ReleaseData(oCodeSeg[iMergePos].argument);
+				vRemoved[iMergePos] = true;
+			}
+
+			// First instruction of sequence outputs all text, debug info is kept
+			oCodeSeg[iPos].argument = iDataId;
+			vRemoved[iPos] = false;
+		}
+
+		iPos = iEnd;
+	}
+
+	const UINT_32 iRemoved = RemoveInstructions(vRemoved);
+	oStaticText.Compact();
+
+return iRemoved;
+}
+
+//
+// Calculate ADD, SUB, MUL and comparisons of static operands at compile time
+//
+//   PUSH     A                  PUSH     A + B
+//   PUSH     B            ->
+//   ADD      STACK, STACK
+//
+//   PUSH     A                  PUSH     0 or 1, depends on result of comparison
+//   PUSH     B            ->
+//   CMP      STACK, STACK
+//   RJXX     @L0
+//   PUSH     0
+//   RJMP     @L1
+// @L0:
+//   PUSH     1
+// @L1:
+//
+UINT_32 VMOptimizer::FoldConstants()
+{
+	STLW::vector<VMInstruction> & oCodeSeg = oVMOpcodeCollector.oCodeSeg;
+	const UINT_32 iCodeSize = oCodeSeg.size();
+
+	STLW::vector<UINT_32> vTargets;
+	MarkJumpTargets(vTargets);
+
+	STLW::vector<bool> vRemoved(iCodeSize, false);
+	UINT_32 iPos = 0;
+	while (iPos + 2 < iCodeSize)
+	{
+		CDT oFirst;
+		CDT oSecond;
+		if (vTargets[iPos + 1] != 0 || vTargets[iPos + 2] != 0 ||
+		    !GetStaticOperand(oCodeSeg[iPos], oFirst) || !GetStaticOperand(oCodeSeg[iPos + 1], oSecond)) { ++iPos; continue; }
+
+		const UINT_32 iOpCode = oCodeSeg[iPos + 2].instruction;
+		// Arithmetic operations, exactly as VM does it
+		if (iOpCode == (ADD | ARG_DST_STACK | ARG_SRC_STACK) ||
+		    iOpCode == (SUB | ARG_DST_STACK | ARG_SRC_STACK) ||
+		    iOpCode == (MUL | ARG_DST_STACK | ARG_SRC_STACK))
+		{
+			if      (iOpCode == (ADD | ARG_DST_STACK | ARG_SRC_STACK)) { oFirst += oSecond; }
+			else if (iOpCode == (SUB | ARG_DST_STACK | ARG_SRC_STACK)) { oFirst -= oSecond; }
+			else                                                       { oFirst *= oSecond; }
+
+			ReleaseStaticText(oCodeSeg[iPos]);
+			ReleaseStaticText(oCodeSeg[iPos + 1]);
+
+			if (oFirst.GetType() == CDT::INT_VAL) { oCodeSeg[iPos].instruction = PUSH | ARG_SRC_INT;   oCodeSeg[iPos].argument = oStaticData.StoreInt(oFirst.GetInt());     }
+			else                                  { oCodeSeg[iPos].instruction = PUSH | ARG_SRC_FLOAT; oCodeSeg[iPos].argument = oStaticData.StoreFloat(oFirst.GetFloat()); }
+
+			vRemoved[iPos + 1] = true;
+			vRemoved[iPos + 2] = true;
+			iPos += 3;
+			continue;
+		}
+
+		// Comparison with conversion of flags to 0 or 1; result is known only if jump goes inside sequence
+		if ((iOpCode == (CMP | ARG_DST_STACK | ARG_SRC_STACK) || iOpCode == (SCMP | ARG_DST_STACK | ARG_SRC_STACK)) &&
+		    iPos + 6 < iCodeSize                                               &&
+		    (oCodeSeg[iPos + 3].instruction & 0xFF000000) == RJXX && oCodeSeg[iPos + 3].argument == 3 &&
+		    oCodeSeg[iPos + 4].instruction == (PUSH | ARG_SRC_INT)                                    &&
+		    oCodeSeg[iPos + 5].instruction == RJMP                && oCodeSeg[iPos + 5].argument == 2 &&
+		    oCodeSeg[iPos + 6].instruction == (PUSH | ARG_SRC_INT)                                    &&
+		    vTargets[iPos + 3] == 0 && vTargets[iPos + 4] == 0 && vTargets[iPos + 5] == 0 && vTargets[iPos + 6] == 1)
+		{
+			UINT_32 iFlags = 0;
+			if (iOpCode == (CMP | ARG_DST_STACK | ARG_SRC_STACK))
+			{
+				const W_FLOAT dSrc = oFirst.GetFloat();
+				const W_FLOAT dTMP = dSrc - oSecond.GetFloat();
+				if      (dTMP < 0.0) { iFlags = FL_LT | FL_NE; }
+				else if (dTMP > 0.0) { iFlags = FL_GT | FL_NE; }
+				else                 { iFlags = FL_EQ; }
+
+				if ((UINT_64(dSrc) % 2) == 0) { iFlags |= FL_PF;  }
+				else                          { iFlags |= FL_NPF; }
+			}
+			else
+			{
+				const STLW::string sSrc = oFirst.GetString();
+				const STLW::string sDst = oSecond.GetString();
+				if      (sSrc < sDst) { iFlags = FL_LT | FL_NE; }
+				else if (sSrc > sDst) { iFlags = FL_GT | FL_NE; }
+				else                  { iFlags = FL_EQ; }
+			}
+
+			ReleaseStaticText(oCodeSeg[iPos]);
+			ReleaseStaticText(oCodeSeg[iPos + 1]);
+
+			const UINT_64 iDebugInfo = oCodeSeg[iPos].reserved;
+			oCodeSeg[iPos] = (oCodeSeg[iPos + 3].instruction & iFlags & 0x00FF0000) ? oCodeSeg[iPos + 6] : oCodeSeg[iPos + 4];
+			oCodeSeg[iPos].reserved = iDebugInfo;
+
+			for (UINT_32 iRemovePos = iPos + 1; iRemovePos <= iPos + 6; ++iRemovePos) { vRemoved[iRemovePos] = true; }
+			iPos += 7;
+			continue;
+		}
+
+		++iPos;
+	}
+
+	const UINT_32 iRemoved = RemoveInstructions(vRemoved);
+	oStaticText.Compact();
+
+return iRemoved;
+}
+
+//
+// Replace PUSH followed by POP with MOV
+//
+//   PUSH     X            ->    MOV      AR, X
+//   POP      AR
+//
+UINT_32 VMOptimizer::RemovePushPop()
+{
+	STLW::vector<VMInstruction> & oCodeSeg = oVMOpcodeCollector.oCodeSeg;
+	const UINT_32 iCodeSize = oCodeSeg.size();
+
+	STLW::vector<UINT_32> vTargets;
+	MarkJumpTargets(vTargets);
+
+	STLW::vector<bool> vRemoved(iCodeSize, false);
+	UINT_32 iPos = 0;
+	while (iPos + 1 < iCodeSize)
+	{
+		VMInstruction & oPush = oCodeSeg[iPos];
+		const VMInstruction & oPop = oCodeSeg[iPos + 1];
+
+		const UINT_32 iSrc = SYSCALL_REG_SRC(oPush.instruction);
+		const UINT_32 iDst = SYSCALL_REG_SRC(oPop.instruction);
+		if ((oPush.instruction & 0xFFFF0000) != PUSH || (oPop.instruction & 0xFFFF0000) != POP || vTargets[iPos + 1] != 0 ||
+		    iDst > ARG_SRC_LASTREG ||
+		    !(iSrc <= ARG_SRC_LASTREG || iSrc == ARG_SRC_STACK || iSrc == ARG_SRC_INT || iSrc == ARG_SRC_FLOAT || iSrc == ARG_SRC_STR)) { ++iPos; continue; }
+
+		// Register is pushed and popped back
+		if (iSrc == iDst)
+		{
+			vRemoved[iPos] = true;
+		}
+		else
+		{
+			oPush.instruction = MOV | (iDst << 8) | iSrc;
+		}
+
+		vRemoved[iPos + 1] = true;
+		iPos += 2;
+	}
+
+return RemoveInstructions(vRemoved);
+}
+
+//
+// Shorten chains of jumps, remove jumps to next instruction and unreachable code
+//
+UINT_32 VMOptimizer::OptimizeJumps()
+{
+	STLW::vector<VMInstruction> & oCodeSeg = oVMOpcodeCollector.oCodeSeg;
+	const UINT_32 iCodeSize = oCodeSeg.size();
+
+	// Jump to unconditional jump goes directly to the last one of chain
+	for (UINT_32 iPos = 0; iPos < iCodeSize; ++iPos)
+	{
+		VMInstruction & oInstruction = oCodeSeg[iPos];
+
+		UINT_32 iTarget = GetJumpTarget(oInstruction, iPos);
+		if (iTarget >= iCodeSize) { continue; }
+
+		// Loops of jumps are left as is
+		for (UINT_32 iChain = 0; iChain < iCodeSize && IsUncondJump(oCodeSeg[iTarget].instruction); ++iChain)
+		{
+			const UINT_32 iNextTarget = GetJumpTarget(oCodeSeg[iTarget], iTarget);
+			if (iNextTarget >= iCodeSize || iNextTarget == iTarget) { break; }
+			iTarget = iNextTarget;
+		}
+
+		SetJumpTarget(oInstruction, iPos, iTarget);
+	}
+
+	STLW::vector<UINT_32> vTargets;
+	MarkJumpTargets(vTargets);
+
+	STLW::vector<bool> vRemoved(iCodeSize, false);
+	for (UINT_32 iPos = 0; iPos < iCodeSize; ++iPos)
+	{
+		const VMInstruction & oInstruction = oCodeSeg[iPos];
+
+		// Jump to next instruction; conditional jumps do not change flags, so they may be removed too
+		const UINT_32 iInstruction = oInstruction.instruction & 0xFFFF0000;
+		if (iInstruction != CALL && iInstruction != RCALL && iInstruction != LOOP && iInstruction != RLOOP_OBSOLETE &&
+		    GetJumpTarget(oInstruction, iPos) == iPos + 1)
+		{
+			vRemoved[iPos] = true;
+			continue;
+		}
+
+		if (!IsTerminator(oInstruction.instruction)) { continue; }
+
+		// Code after jump, return or halt is reachable only by another jump
+		UINT_32 iDeadPos = iPos + 1;
+		while (iDeadPos < iCodeSize && vTargets[iDeadPos] == 0)
+		{
+			ReleaseStaticText(oCodeSeg[iDeadPos]);
+			vRemoved[iDeadPos] = true;
+			++iDeadPos;
+		}
+		iPos = iDeadPos - 1;
+	}
+
+	const UINT_32 iRemoved = RemoveInstructions(vRemoved);
+	oStaticText.Compact();
+
+return iRemoved;
+}
+
+//
+// Count jumps and calls to every instruction
+//
+void VMOptimizer::MarkJumpTargets(STLW::vector<UINT_32> & vTargets) const
+{
+	const STLW::vector<VMInstruction> & oCodeSeg = oVMOpcodeCollector.oCodeSeg;
+	const UINT_32 iCodeSize = oCodeSeg.size();
+
+	vTargets.assign(iCodeSize + 1, 0);
+	for (UINT_32 iPos = 0; iPos < iCodeSize; ++iPos)
+	{
+		const UINT_32 iTarget = GetJumpTarget(oCodeSeg[iPos], iPos);
+		if (iTarget <= iCodeSize) { ++vTargets[iTarget]; }
+	}
+
+	// Entry points of blocks
+	const UINT_32 iElements = 1 << oCallsTable.iPower;
+	for (UINT_32 iPos = 0; iPos < iElements; ++iPos)
+	{
+		const UINT_64 iTarget = oCallsTable.aElements[iPos].value;
+		if (iTarget <= iCodeSize) { ++vTargets[iTarget]; }
+	}
+}
+
+//
+// Get value pushed by instruction if it is static
+//
+bool VMOptimizer::GetStaticOperand(const VMInstruction  & oInstruction,
+                                   CDT                  & oValue) const
+{
+	switch (oInstruction.instruction)
+	{
+		case PUSH | ARG_SRC_INT:
+			oValue = oStaticData.GetInt(oInstruction.argument);
+			return true;
+
+		case PUSH | ARG_SRC_FLOAT:
+			oValue = oStaticData.GetFloat(oInstruction.argument);
+			return true;
+
+		case PUSH | ARG_SRC_STR:
+			{
+				UINT_32 iDataSize = 0;
+				CCHAR_P szData = oStaticText.GetData(oInstruction.argument, iDataSize);
+				if (szData == NULL) { return false; }
+
+				oValue = STLW::string(szData, iDataSize);
+			}
+			return true;
+
+		default:
+			;;
+	}
+
+return false;
+}
+
+//
+// Release static text used by instruction; only text stored once per instruction can be released
+//
+void VMOptimizer::ReleaseStaticText(const VMInstruction & oInstruction)
+{
+	if (oInstruction.instruction == (PUSH | ARG_SRC_STR) || oInstruction.instruction == (OUTPUT | ARG_SRC_STR))
+	{
+		oStaticText.ReleaseData(oInstruction.argument);
+	}
+}
+
+//
+// Remove instructions from code segment and correct jump targets
+//
+UINT_32 VMOptimizer::RemoveInstructions(const STLW::vector<bool> & vRemoved)
+{
+	STLW::vector<VMInstruction> & oCodeSeg = oVMOpcodeCollector.oCodeSeg;
+	const UINT_32 iCodeSize = oCodeSeg.size();
+
+	// Jump to removed instruction goes to the next one
+	STLW::vector<UINT_32> vNewIP(iCodeSize + 1);
+	UINT_32 iNewIP = 0;
+	for (UINT_32 iPos = 0; iPos < iCodeSize; ++iPos)
+	{
+		vNewIP[iPos] = iNewIP;
+		if (!vRemoved[iPos]) { ++iNewIP; }
+	}
+	vNewIP[iCodeSize] = iNewIP;
+
+	if (iNewIP == iCodeSize) { return 0; }
+
+	for (UINT_32 iPos = 0; iPos < iCodeSize; ++iPos)
+	{
+		if (vRemoved[iPos]) { continue; }
+
+		VMInstruction & oInstruction = oCodeSeg[iPos];
+		if (IsAbsoluteJump(oInstruction.instruction))
+		{
+			if (oInstruction.argument <= iCodeSize) { oInstruction.argument = vNewIP[oInstruction.argument]; }
+		}
+		else if (IsRelativeJump(oInstruction.instruction))
+		{
+			const UINT_32 iTarget = iPos + oInstruction.argument;
+			if (iTarget <= iCodeSize) { oInstruction.argument = vNewIP[iTarget] - vNewIP[iPos]; }
+		}
+	}
+
+	// Entry points of blocks
+	const UINT_32 iElements = 1 << oCallsTable.iPower;
+	for (UINT_32 iPos = 0; iPos < iElements; ++iPos)
+	{
+		HashElement & oElement = oCallsTable.aElements[iPos];
+		if (oElement.value <= iCodeSize) { oElement.value = vNewIP[oElement.value]; }
+	}
+
+	UINT_32 iNewPos = 0;
+	for (UINT_32 iPos = 0; iPos < iCodeSize; ++iPos)
+	{
+		if (!vRemoved[iPos]) { oCodeSeg[iNewPos++] = oCodeSeg[iPos]; }
+	}
+	oCodeSeg.resize(iNewPos);
+
+return iCodeSize - iNewPos;
+}
+
+//
+// A destructor
+//
+VMOptimizer::~VMOptimizer() throw()
+{
+	;;
+}
+
+} // namespace CTPP
+// End.
@@ -31,6 +31,8 @@
  */
 #include "CTPP2VMSyscall.hpp"
 
+#include "CDT.hpp"
+
 namespace CTPP // C++ Template Engine
 {
 
@@ -49,6 +51,22 @@ INT_32 SyscallHandler::PreExecuteSetup(OutputCollector          & oCollector,
 //
 INT_32 SyscallHandler::InitHandler(CDT & oCDT) { return 0; }
 
+//
+// Handler for call which result is sent to output immediately
+//
+INT_32 SyscallHandler::HandlerToOutput(CDT              * aArguments,
+                                       const UINT_32      iArgNum,
+                                       OutputCollector  & oCollector,
+                                       Logger           & oLogger)
+{
+	CDT oResult(CDT::UNDEF);
+	if (Handler(aArguments, iArgNum, oResult, oLogger) != 0) { return -1; }
+
+	oResult.WriteTo(oCollector);
+
+return 0;
+}
+
 //
 // Get API version
 //
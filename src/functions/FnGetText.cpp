@@ -35,7 +35,6 @@
 #include "FnGetText.hpp"
 
 #include <strings.h>
-#include "CTPP2GetText.hpp"
 
 namespace CTPP // C++ Template Engine
 {
@@ -43,11 +42,29 @@ namespace CTPP // C++ Template Engine
 //
 // Constructor
 //
-FnGetText::FnGetText(CCHAR_P szAlias) : pGetText(NULL), szFuncName(strdup(szAlias))
+FnGetText::FnGetText(CCHAR_P szAlias) : pGetText(NULL), iRevision(0), pDomains(NULL), pCatalogs(NULL), szFuncName(strdup(szAlias))
 {
 	;;
 }
 
+//
+// Find message in catalogs
+//
+static const CTPP2GetTextCatalog * FindMessage(const CTPP2GetText::CatalogList  * pCatalogs,
+                                               const CDT                        & oMessage,
+                                               INT_32                           & iMessage)
+{
+	if (pCatalogs == NULL) { return NULL; }
+
+	UINT_32 iLength = 0;
+	CCHAR_P szMessage = oMessage.GetStringData(iLength);
+	if (szMessage != NULL) { return CTPP2GetText::FindCatalog(pCatalogs, szMessage, iLength, iMessage); }
+
+	const STLW::string sMessage = oMessage.GetString();
+
+return CTPP2GetText::FindCatalog(pCatalogs, sMessage.data(), UINT_32(sMessage.size()), iMessage);
+}
+
 //
 // Handler
 //
@@ -62,36 +79,43 @@ INT_32 FnGetText::Handler(CDT            * aArguments,
 		return -1;
 	}
 
-	if (iArgNum == 1)
+	if (iArgNum == 0 || iArgNum > 4)
 	{
-		oCDTRetVal = pGetText -> FindMessage(sLanguage, aArguments[0].GetString());
-		return 0;
-	}
-	else if (iArgNum == 2)
-	{
-		oCDTRetVal = pGetText -> FindMessage(sLanguage, aArguments[1].GetString(), aArguments[0].GetString());
-		return 0;
-	}
-	else if (iArgNum == 3)
-	{
-		oCDTRetVal = pGetText -> FindPluralMessage(sLanguage, aArguments[2].GetString(),
-		                                     aArguments[1].GetString(), aArguments[0].GetUInt());
-		return 0;
+		STLW::string sTMP(szFuncName);
+
+		for (UINT_32 iI = 0; iI < sTMP.size(); ++iI) { sTMP[iI] = toupper(sTMP[iI]); }
+		STLW::string sMsg = "Usage: " + sTMP + "(msgid[, msgid_plural, n][, domain])";
+
+		oLogger.Emerg(sMsg.c_str());
+		return -1;
 	}
-	else if (iArgNum == 4)
+
+	// Translations were added or default domain was changed
+	if (iRevision != pGetText -> GetRevision()) { BindCatalogs(); }
+
+	// Arguments are in reverse order, domain is the last one
+	const CDT & oMessage = aArguments[iArgNum - 1];
+
+	const CTPP2GetText::CatalogList * pDomainCatalogs = pCatalogs;
+	if (iArgNum % 2 == 0) { pDomainCatalogs = pGetText -> GetCatalogs(pDomains, aArguments[0].GetString()); }
+
+	INT_32 iMessage = -1;
+	const CTPP2GetTextCatalog * pCatalog = FindMessage(pDomainCatalogs, oMessage, iMessage);
+
+	// Singular form
+	if (iArgNum <= 2)
 	{
-		oCDTRetVal = pGetText -> FindPluralMessage(sLanguage, aArguments[3].GetString(), aArguments[2].GetString(),
-		                                     aArguments[1].GetUInt(), aArguments[0].GetString());
+		if (pCatalog == NULL) { oCDTRetVal = oMessage;                                         }
+		else                  { oCDTRetVal = CDT(*(pCatalog -> GetTranslation(iMessage, 0))); }
 		return 0;
 	}
 
-	STLW::string sTMP(szFuncName);
+	// Plural form
+	const UINT_32 iCount = UINT_32(aArguments[iArgNum - 3].GetUInt());
+	if (pCatalog == NULL) { oCDTRetVal = iCount > 1 ? aArguments[iArgNum - 2] : oMessage;           }
+	else                  { oCDTRetVal = CDT(pCatalog -> GetPluralTranslation(iMessage, iCount)); }
 
-	for (UINT_32 iI = 0; iI < sTMP.size(); ++iI) { sTMP[iI] = toupper(sTMP[iI]); }
-	STLW::string sMsg = "Usage: " + sTMP + "(msgid[, msgid_plural, n][, domain])";
-
-	oLogger.Emerg(sMsg.c_str());
-return -1;
+return 0;
 }
 
 //
@@ -107,12 +131,30 @@ FnGetText::~FnGetText() throw() { free(szFuncName); }
 //
 // Set GetText object
 //
-void FnGetText::SetGetText(CTPP2GetText * pGetText_) { pGetText = pGetText_; }
+void FnGetText::SetGetText(CTPP2GetText * pGetText_)
+{
+	pGetText = pGetText_;
+	if (pGetText != NULL) { BindCatalogs(); }
+}
+
+//
+// Set language of translation, bind its catalogs
+//
+void FnGetText::SetLanguage(const STLW::string & sLang)
+{
+	sLanguage = sLang;
+	if (pGetText != NULL) { BindCatalogs(); }
+}
 
 //
-// Set language of translation
+// Bind catalogs of language and default i18n domain
 //
-void FnGetText::SetLanguage(const STLW::string & sLang) { sLanguage = sLang; }
+void FnGetText::BindCatalogs()
+{
+	pDomains  = pGetText -> GetDomains(sLanguage);
+	pCatalogs = pGetText -> GetCatalogs(pDomains);
+	iRevision = pGetText -> GetRevision();
+}
 
 } // namespace CTPP
 // End.
@@ -32,6 +32,7 @@
 
 #include "CDT.hpp"
 #include "CTPP2Logger.hpp"
+#include "CTPP2OutputCollector.hpp"
 #include "CTPP2Util.hpp"
 #include "FnJSON.hpp"
 
@@ -69,6 +70,28 @@ INT_32 FnJSON::Handler(CDT            * aArguments,
 return 0;
 }
 
+//
+// Handler, result is written to output collector
+//
+INT_32 FnJSON::HandlerToOutput(CDT              * aArguments,
+                               const UINT_32      iArgNum,
+                               OutputCollector  & oCollector,
+                               Logger           & oLogger)
+{
+	if (iArgNum != 1)
+	{
+		oLogger.Emerg("Usage: JSON(x)");
+		return -1;
+	}
+
+	DumpBuffer oBuffer;
+	DumpCDT2JSON(aArguments[0], oBuffer);
+
+	oCollector.Collect(oBuffer.Data(), oBuffer.Size());
+
+return 0;
+}
+
 //
 // Get function name
 //
@@ -31,7 +31,9 @@
  */
 
 #include "CDT.hpp"
+#include "CTPP2Escape.hpp"
 #include "CTPP2Logger.hpp"
+#include "CTPP2OutputCollector.hpp"
 #include "CTPP2Util.hpp"
 #include "FnJSONEscape.hpp"
 
@@ -80,7 +82,7 @@ INT_32 FnJSONEscape::Handler(CDT            * aArguments,
 				break;
 
 			case CDT::STRING_VAL:
-				sResult.append(EscapeJSONString(aArguments[iPos].GetString(), true, false));
+				Escape(ESCAPE_JSON_ECMA, aArguments[iPos], sResult);
 				break;
 
 			default:
@@ -92,6 +94,63 @@ INT_32 FnJSONEscape::Handler(CDT            * aArguments,
 return 0;
 }
 
+//
+// Handler, result is written to output collector
+//
+INT_32 FnJSONEscape::HandlerToOutput(CDT              * aArguments,
+                                     const UINT_32      iArgNum,
+                                     OutputCollector  & oCollector,
+                                     Logger           & oLogger)
+{
+	if (iArgNum < 1)
+	{
+		oLogger.Emerg("Usage: JSONESCAPE(a[, b, ...])");
+		return -1;
+	}
+
+	// Check types before writing anything
+	for(INT_32 iPos = iArgNum - 1; iPos >=0; --iPos)
+	{
+		switch (aArguments[iPos].GetType())
+		{
+			case CDT::UNDEF:
+			case CDT::INT_VAL:
+			case CDT::REAL_VAL:
+			case CDT::POINTER_VAL:
+			case CDT::STRING_INT_VAL:
+			case CDT::STRING_REAL_VAL:
+			case CDT::STRING_VAL:
+				break;
+
+			default:
+				oLogger.Emerg("Invalid type %s", aArguments[iPos].PrintableType());
+				return -1;
+		}
+	}
+
+	for(INT_32 iPos = iArgNum - 1; iPos >=0; --iPos)
+	{
+		switch (aArguments[iPos].GetType())
+		{
+			case CDT::UNDEF:
+				oCollector.Collect("null", 4);
+				break;
+
+			case CDT::STRING_VAL:
+				Escape(ESCAPE_JSON_ECMA, aArguments[iPos], oCollector);
+				break;
+
+			default:
+				{
+					const STLW::string sData = aArguments[iPos].GetString();
+					oCollector.Collect(sData.data(), sData.size());
+				}
+		}
+	}
+
+return 0;
+}
+
 //
 // Get function name
 //
@@ -31,7 +31,9 @@
  */
 
 #include "CDT.hpp"
+#include "CTPP2Escape.hpp"
 #include "CTPP2Logger.hpp"
+#include "CTPP2OutputCollector.hpp"
 #include "CTPP2Util.hpp"
 #include "FnURIEscape.hpp"
 
@@ -60,9 +62,28 @@ INT_32 FnURIEscape::Handler(CDT            * aArguments,
 	}
 
 	STLW::string sResult;
-	for(INT_32 iPos = iArgNum - 1; iPos >=0; --iPos) { sResult.append(aArguments[iPos].GetString()); }
+	for(INT_32 iPos = iArgNum - 1; iPos >=0; --iPos) { Escape(ESCAPE_URI, aArguments[iPos], sResult); }
 
-	oCDTRetVal = URIEscape(sResult);
+	oCDTRetVal = sResult;
+
+return 0;
+}
+
+//
+// Handler, result is written to output collector
+//
+INT_32 FnURIEscape::HandlerToOutput(CDT              * aArguments,
+                                     const UINT_32      iArgNum,
+                                     OutputCollector  & oCollector,
+                                     Logger           & oLogger)
+{
+	if (iArgNum < 1)
+	{
+		oLogger.Emerg("Usage: URIESCAPE(a[, b, ...])");
+		return -1;
+	}
+
+	for(INT_32 iPos = iArgNum - 1; iPos >=0; --iPos) { Escape(ESCAPE_URI, aArguments[iPos], oCollector); }
 
 return 0;
 }
@@ -31,7 +31,9 @@
  */
 
 #include "CDT.hpp"
+#include "CTPP2Escape.hpp"
 #include "CTPP2Logger.hpp"
+#include "CTPP2OutputCollector.hpp"
 #include "CTPP2Util.hpp"
 #include "FnXMLEscape.hpp"
 
@@ -62,9 +64,28 @@ INT_32 FnXMLEscape::Handler(CDT            * aArguments,
 
 
 	STLW::string sResult;
-	for(INT_32 iPos = iArgNum - 1; iPos >=0; --iPos) { sResult.append(aArguments[iPos].GetString()); }
+	for(INT_32 iPos = iArgNum - 1; iPos >=0; --iPos) { Escape(ESCAPE_XML, aArguments[iPos], sResult); }
 
-	oCDTRetVal = XMLEscape(sResult);
+	oCDTRetVal = sResult;
+
+return 0;
+}
+
+//
+// Handler, result is written to output collector
+//
+INT_32 FnXMLEscape::HandlerToOutput(CDT              * aArguments,
+                                     const UINT_32      iArgNum,
+                                     OutputCollector  & oCollector,
+                                     Logger           & oLogger)
+{
+	if (iArgNum < 1)
+	{
+		oLogger.Emerg("Usage: XMLESCAPE(a[, b, ...])");
+		return -1;
+	}
+
+	for(INT_32 iPos = iArgNum - 1; iPos >=0; --iPos) { Escape(ESCAPE_XML, aArguments[iPos], oCollector); }
 
 return 0;
 }
@@ -0,0 +1,169 @@
+/*-
+ * Copyright (c) 2006, 2007 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      CDTHashMapTest.cpp
+ *
+ * $CTPP$
+ */
+#include <CDTHashMap.hpp>
+
+#include "STLMap.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef HAVE_SYSEXITS_H
+#include <sysexits.h>
+#endif
+
+using namespace CTPP;
+
+typedef CDTHashMap<INT_32>                  HashMap;
+typedef STLW::map<STLW::string, INT_32>     TreeMap;
+
+//
+// Compare content and order of elements
+//
+static bool CompareMaps(const HashMap & mHash, const TreeMap & mTree)
+{
+	if (mHash.size() != mTree.size()) { return false; }
+
+	HashMap::const_iterator itmHash = mHash.begin();
+	TreeMap::const_iterator itmTree = mTree.begin();
+	while (itmTree != mTree.end())
+	{
+		if (itmHash == mHash.end() || itmHash -> first != itmTree -> first || itmHash -> second != itmTree -> second) { return false; }
+
+		++itmHash;
+		++itmTree;
+	}
+
+return itmHash == mHash.end();
+}
+
+int main(void)
+{
+	srand(1);
+
+	// Small and large maps, keys are inserted in random order; every second pair of rounds uses arena
+	for (UINT_32 iRound = 0; iRound < 100; ++iRound)
+	{
+		CDTArena oArena;
+		HashMap mHash(STLW::less<STLW::string>(), HashMap::allocator_type(iRound % 4 < 2 ? NULL : &oArena));
+		TreeMap mTree;
+
+		const INT_32 iKeys = (iRound % 2 == 0) ? 20 : 2000;
+		// Space for elements is reserved in advance in every third round
+		if (iRound % 3 == 0) { mHash.reserve(iKeys); }
+
+		for (INT_32 iI = 0; iI < iKeys * 3; ++iI)
+		{
+			// Reserve space in the middle of work, after erasures
+			if (iRound % 3 == 1 && iI == iKeys) { mHash.reserve(mHash.size() + iKeys); }
+
+			// Long keys do not fit into small-string buffer and are destroyed by arena
+			CHAR_8 szKey[32];
+			snprintf(szKey, 32, (iRound % 8 < 4) ? "key%d" : "long key of element #%d", rand() % iKeys);
+
+			const INT_32 iOp = rand() % 10;
+			// Insert or update
+			if (iOp < 6)
+			{
+				mHash[szKey] = iI;
+				mTree[szKey] = iI;
+			}
+			// Erase by key
+			else if (iOp < 8)
+			{
+				if (mHash.erase(szKey) != mTree.erase(szKey))
+				{
+					fprintf(stderr, "ERROR: erase(\"%s\") mismatch\n", szKey);
+					return EX_SOFTWARE;
+				}
+			}
+			// Find and erase by iterator
+			else
+			{
+				HashMap::iterator itmHash = mHash.find(szKey);
+				TreeMap::iterator itmTree = mTree.find(szKey);
+				if ((itmHash == mHash.end()) != (itmTree == mTree.end()) ||
+				    (itmHash != mHash.end() && itmHash -> second != itmTree -> second))
+				{
+					fprintf(stderr, "ERROR: find(\"%s\") mismatch\n", szKey);
+					return EX_SOFTWARE;
+				}
+
+				if (itmHash != mHash.end())
+				{
+					mHash.erase(itmHash);
+					mTree.erase(itmTree);
+				}
+			}
+		}
+
+		if (!CompareMaps(mHash, mTree))
+		{
+			fprintf(stderr, "ERROR: content mismatch, round %u\n", iRound);
+			return EX_SOFTWARE;
+		}
+
+		HashMap mCopy(mHash);
+		HashMap mAssigned;
+		mAssigned = mCopy;
+		if (!CompareMaps(mCopy, mTree) || !CompareMaps(mAssigned, mTree))
+		{
+			fprintf(stderr, "ERROR: copy mismatch, round %u\n", iRound);
+			return EX_SOFTWARE;
+		}
+	}
+
+	// References to elements survive insertion
+	HashMap mHash;
+	INT_32 & iFirst = mHash["first"];
+	for (INT_32 iI = 0; iI < 10000; ++iI)
+	{
+		CHAR_8 szKey[32];
+		snprintf(szKey, 32, "%d", iI);
+		mHash[szKey] = iI;
+	}
+	iFirst = -1;
+	if (*mHash.Get("first", HashMap::Hash("first")) != -1)
+	{
+		fprintf(stderr, "ERROR: reference to element is lost\n");
+		return EX_SOFTWARE;
+	}
+
+	fprintf(stdout, "OK\n");
+
+	// make valgrind happy
+	fclose(stdin);
+	fclose(stdout);
+	fclose(stderr);
+
+return EX_OK;
+}
+// End.
@@ -47,8 +47,125 @@
     #include <CTPP2Time.h>
 #endif
 
+#include <new>
+#include <stdlib.h>
+
 using namespace CTPP;
 
+/** Number of heap allocations */
+static UINT_64 iAllocations = 0;
+/** Number of allocated bytes  */
+static UINT_64 iAllocatedBytes = 0;
+
+//
+// Count heap allocations
+//
+void * operator new(size_t iSize)
+{
+	++iAllocations;
+	iAllocatedBytes += iSize;
+
+	void * vPtr = malloc(iSize == 0 ? 1 : iSize);
+	if (vPtr == NULL) { throw std::bad_alloc(); }
+
+return vPtr;
+}
+
+//
+// Release memory
+//
+void operator delete(void * vPtr) throw() { free(vPtr); }
+
+//
+// Release memory
+//
+void operator delete(void * vPtr, size_t) throw() { free(vPtr); }
+
+//
+// Fill array with string values of given length, print time and memory usage
+//
+static void StringPerfTest(const UINT_32 iLength)
+{
+	static const UINT_32 iValues = 1000000;
+
+	CHAR_8 szBuf[1024 + 1];
+
+	CDT oCDT_array(CDT::ARRAY_VAL);
+	oCDT_array[iValues - 1] = 0;
+
+	struct timeval sStartTime;
+	struct timeval sEndTime;
+
+	const UINT_64 iStartAllocations = iAllocations;
+	const UINT_64 iStartBytes       = iAllocatedBytes;
+	gettimeofday(&sStartTime, NULL);
+	for (UINT_32 iI = 0; iI < iValues; ++iI)
+	{
+		snprintf(szBuf, 1024, "%0*u", INT_32(iLength), iI % 100000);
+		oCDT_array[iI] = szBuf;
+	}
+
+	// Read values back
+	UINT_64 iTotalLength = 0;
+	for (UINT_32 iI = 0; iI < iValues; ++iI)
+	{
+		const CDT & oValue = oCDT_array.GetCDT(iI);
+		iTotalLength += oValue.Size() + oValue.GetInt();
+	}
+	gettimeofday(&sEndTime, NULL);
+
+	fprintf(stderr, "STRING values of length %u: Time: %f, allocations: %llu, bytes: %llu, checksum: %llu\n",
+	                iLength,
+	                ((sEndTime.tv_sec - sStartTime.tv_sec) + 1.0 * (sEndTime.tv_usec - sStartTime.tv_usec) / 1000000),
+	                (unsigned long long)(iAllocations - iStartAllocations),
+	                (unsigned long long)(iAllocatedBytes - iStartBytes),
+	                (unsigned long long)(iTotalLength));
+}
+
+//
+// Push string literal into array many times, like VM does with static text; print time and memory usage
+//
+static bool StringViewPerfTest(const bool bUseView)
+{
+	static const UINT_32 iValues = 1000000;
+	static const CHAR_8  szLiteral[] = "%Y-%m-%d %H:%M:%S, long format string";
+	static const CDTStringView oView = { szLiteral, sizeof(szLiteral) - 1 };
+
+	CDT oCDT_array(CDT::ARRAY_VAL);
+	oCDT_array[iValues - 1] = 0;
+
+	struct timeval sStartTime;
+	struct timeval sEndTime;
+
+	const UINT_64 iStartAllocations = iAllocations;
+	const UINT_64 iStartBytes       = iAllocatedBytes;
+	gettimeofday(&sStartTime, NULL);
+	for (UINT_32 iI = 0; iI < iValues; ++iI)
+	{
+		if (bUseView) { oCDT_array[iI] = CDT(oView); }
+		else          { oCDT_array[iI] = STLW::string(szLiteral, sizeof(szLiteral) - 1); }
+	}
+	gettimeofday(&sEndTime, NULL);
+
+	fprintf(stderr, "STRING %s of length %u: Time: %f, allocations: %llu, bytes: %llu\n",
+	                bUseView ? "views" : "copies",
+	                UINT_32(sizeof(szLiteral) - 1),
+	                ((sEndTime.tv_sec - sStartTime.tv_sec) + 1.0 * (sEndTime.tv_usec - sStartTime.tv_usec) / 1000000),
+	                (unsigned long long)(iAllocations - iStartAllocations),
+	                (unsigned long long)(iAllocatedBytes - iStartBytes));
+
+	// Modification of view makes private copy of string
+	CDT oValue = oCDT_array.GetCDT(0);
+	oValue.Append("!");
+	if (oCDT_array.GetCDT(1).GetString() != szLiteral || oValue.GetString() != STLW::string(szLiteral) + "!")
+	{
+		fprintf(stderr, "ERROR: string value was changed\n");
+		return false;
+	}
+
+return true;
+}
+
 int main(void)
 {
 	try
@@ -83,6 +200,13 @@ int main(void)
 		fprintf(stderr, "Time: %f\n", ((sEndTime.tv_sec - sStartTime.tv_sec) + 1.0 * (sEndTime.tv_usec - sStartTime.tv_usec) / 1000000));
 
 		fprintf(stderr, "ARRAY size: %d\n", oCDT_array.Size());
+
+		// Short strings are stored inline, long ones in shareable container
+		StringPerfTest(C_CDT_INLINE_LENGTH);
+		StringPerfTest(C_CDT_INLINE_LENGTH * 4);
+
+		// String literals refer to immutable data
+		if (!StringViewPerfTest(false) || !StringViewPerfTest(true)) { return EX_SOFTWARE; }
 	}
 	catch(CDTTypeCastException &e)
 	{
@@ -31,8 +31,10 @@
  */
 #include <CDT.hpp>
 #include <CDTSortRoutines.hpp>
+#include <CTPP2StringOutputCollector.hpp>
 
 #include <stdio.h>
+#include <string.h>
 
 #ifdef HAVE_SYSEXITS_H
 #include <sysexits.h>
@@ -763,6 +765,70 @@ $H{'q'} -> [1] -> {"test"} = "passed";
 		oDestination1.MergeCDT(oSource, CDT::DEEP_MERGE);
 		fprintf(stderr, "Merge: `%s`\n", oDestination1.RecursiveDump().c_str());
 	}
+	// Direct output must be the same as string representation
+	fprintf(stderr, "== WriteTo ==================================\n");
+	{
+		const W_FLOAT aFloats[] = { 0.0, -0.0, 0.1, -2.5, 1E-5, 0.0001, 100.0, 123456789012.0, 1234567890123.0,
+		                            3.14159265358979, 1E100, -1E-100, 999999999999.5, };
+		const INT_64  aInts[]   = { 0, 7, -10, 123456789, -9223372036854775807LL - 1, 9223372036854775807LL };
+
+		CDT oValues(CDT::ARRAY_VAL);
+		for (UINT_32 iI = 0; iI < sizeof(aFloats) / sizeof(W_FLOAT); ++iI) { oValues.PushBack(aFloats[iI]); }
+		for (UINT_32 iI = 0; iI < sizeof(aInts) / sizeof(INT_64); ++iI)    { oValues.PushBack(aInts[iI]);   }
+		oValues.PushBack("short");
+		oValues.PushBack("long string stored in shareable container");
+		oValues.PushBack(CDT());
+
+		for (UINT_32 iI = 0; iI < oValues.Size(); ++iI)
+		{
+			STLW::string sResult;
+			StringOutputCollector oCollector(sResult);
+			oValues[iI].WriteTo(oCollector);
+
+			fprintf(stderr, "WriteTo: `%s`\n", sResult.c_str());
+			if (sResult != oValues[iI].GetString())
+			{
+				fprintf(stderr, "ERROR: expected `%s`\n", oValues[iI].GetString().c_str());
+				return EX_SOFTWARE;
+			}
+		}
+	}
+	// Direct output of float must be the same as printf output
+	fprintf(stderr, "== WriteTo, random floats ===================\n");
+	{
+		UINT_64 iSeed = 0x2545F4914F6CDD1DULL;
+		for (UINT_32 iI = 0; iI < 100000; ++iI)
+		{
+			// xorshift64
+			iSeed ^= iSeed << 13;
+			iSeed ^= iSeed >> 7;
+			iSeed ^= iSeed << 17;
+
+			W_FLOAT dValue = 0;
+			switch (iI % 3)
+			{
+				// Any bit pattern
+				case 0: memcpy(&dValue, &iSeed, sizeof(dValue)); break;
+				// Integers with 13-16 digits
+				case 1: dValue = W_FLOAT(INT_64(iSeed % 10000000000000000ULL) - 5000000000000000LL); break;
+				// Decimal fractions
+				default: dValue = W_FLOAT(INT_64(iSeed % 100000000000000ULL)) / W_FLOAT(1ULL << (iSeed >> 58));
+			}
+
+			CHAR_8 szExpected[C_MAX_SPRINTF_LENGTH];
+			snprintf(szExpected, C_MAX_SPRINTF_LENGTH, "%.*G", CTPP_FLOAT_PRECISION, dValue);
+
+			STLW::string sResult;
+			StringOutputCollector oCollector(sResult);
+			CDT(dValue).WriteTo(oCollector);
+
+			if (sResult != szExpected)
+			{
+				fprintf(stderr, "ERROR: WriteTo: `%s`, expected `%s`\n", sResult.c_str(), szExpected);
+				return EX_SOFTWARE;
+			}
+		}
+	}
 	fprintf(stderr, "== END ======================================\n");
 
 	// make valgrind happy
@@ -29,29 +29,78 @@
  *
  * $CTPP$
  */
+#include <CTPP2BatchCompiler.hpp>
 #include <CTPP2Parser.hpp>
 #include <CTPP2FileSourceLoader.hpp>
+#include <CTPP2GetText.hpp>
 #include <CTPP2ParserException.hpp>
 #include <CTPP2HashTable.hpp>
+#include <CTPP2Util.hpp>
 #include <CTPP2VMDumper.hpp>
 #include <CTPP2VMOpcodes.h>
+#include <CTPP2VMOptimizer.hpp>
 
 #include <sys/stat.h>
 
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 using namespace CTPP;
 
-int main(int argc, char ** argv)
+//
+// Compile directory tree or templates listed in manifest
+//
+static int BatchCompile(CCHAR_P        szSource,
+                        CCHAR_P        szDestination,
+                        const bool     bOptimize,
+                        const bool     bIncludeUnits,
+                        const bool     bForce,
+                        const UINT_32  iThreads)
 {
-	if (argc != 3)
+	BatchCompiler oBatchCompiler(bOptimize, bIncludeUnits);
+	try
 	{
-		fprintf(stdout, "CTPP2 template compiler v" CTPP_VERSION " (" CTPP_IDENT "). Copyright (c) 2004-2011 CTPP Dev. Team.\n\n");
-		fprintf(stderr, "usage: %s source.ctpp2 destination.ct2\n", argv[0]);
-		return EX_USAGE;
+		struct stat oStat;
+		if (stat(szSource, &oStat) == -1) { throw CTPPUnixException("stat", errno); }
+
+		if (S_ISDIR(oStat.st_mode)) { oBatchCompiler.AddDirectory(szSource, szDestination); }
+		else                        { oBatchCompiler.AddManifest(szSource, szDestination);  }
+	}
+	catch(CTPPUnixException     & e)
+	{
+		fprintf(stderr, "ERROR: I/O in %s: %s\n", e.what(), strerror(e.ErrNo()));
+		return EX_NOINPUT;
 	}
 
+	oBatchCompiler.Compile(iThreads, bForce);
+
+	UINT_32 aStatuses[BatchCompiler::FAILED + 1] = { 0 };
+	const STLW::vector<BatchCompiler::Job> & vJobs = oBatchCompiler.GetJobs();
+	for (UINT_32 iPos = 0; iPos < vJobs.size(); ++iPos)
+	{
+		++aStatuses[vJobs[iPos].status];
+		if (vJobs[iPos].status == BatchCompiler::FAILED) { fprintf(stderr, "ERROR: %s: %s\n", vJobs[iPos].source.c_str(), vJobs[iPos].error.c_str()); }
+	}
+
+	fprintf(stdout, "Templates: %u, compiled: %u, up to date: %u, failed: %u\n", UINT_32(vJobs.size()), aStatuses[BatchCompiler::COMPILED],
+	                                                                            aStatuses[BatchCompiler::UP_TO_DATE], aStatuses[BatchCompiler::FAILED]);
+
+return aStatuses[BatchCompiler::FAILED] == 0 ? EX_OK : EX_SOFTWARE;
+}
+
+//
+// Compile one template, translate static gettext calls if translations are given
+//
+static int CompileTemplate(CCHAR_P               szSource,
+                           CCHAR_P               szDestination,
+                           const bool            bOptimize,
+                           const bool            bIncludeUnits,
+                           const CTPP2GetText  * pGetText,
+                           const STLW::string  & sLanguage)
+{
 	VMOpcodeCollector  oVMOpcodeCollector;
 	StaticText         oSyscalls;
 	StaticData         oStaticData;
@@ -63,10 +112,12 @@ int main(int argc, char ** argv)
 	{
 		// Load template
 		CTPP2FileSourceLoader oSourceLoader;
-		oSourceLoader.LoadTemplate(argv[1]);
+		oSourceLoader.LoadTemplate(szSource);
 
 		// Create template parser
-		CTPP2Parser oCTPP2Parser(&oSourceLoader, &oCompiler, argv[1]);
+		CTPP2Parser oCTPP2Parser(&oSourceLoader, &oCompiler, szSource);
+		oCTPP2Parser.SetIncludeUnits(bIncludeUnits);
+		oCompiler.SetTranslation(pGetText, sLanguage);
 
 		// Compile template
 		oCTPP2Parser.Compile();
@@ -76,6 +127,11 @@ int main(int argc, char ** argv)
 		fprintf(stderr, "ERROR: %s\n", e.what());
 		return EX_SOFTWARE;
 	}
+	catch(CTPPGetTextError      & e)
+	{
+		fprintf(stderr, "ERROR: %s\n", e.what());
+		return EX_SOFTWARE;
+	}
 	catch(CTPPUnixException     & e)
 	{
 		fprintf(stderr, "ERROR: I/O in %s: %s\n", e.what(), strerror(e.ErrNo()));
@@ -97,6 +153,21 @@ int main(int argc, char ** argv)
 		return EX_SOFTWARE;
 	}
 
+	// Size of program before optimization
+	UINT_32 iSourceCodeSize = 0;
+	UINT_32 iSourceSize     = 0;
+	{
+		const VMInstruction * oVMInstruction = oVMOpcodeCollector.GetCode(iSourceCodeSize);
+		VMDumper oDumper(iSourceCodeSize, oVMInstruction, oSyscalls, oStaticData, oStaticText, oHashTable);
+		oDumper.GetExecutable(iSourceSize);
+	}
+	const UINT_32 iSourceTextSize = oStaticText.GetDataSize();
+
+	// Merge outputs of static text or apply all optimizations
+	VMOptimizer oOptimizer(oVMOpcodeCollector, oStaticData, oStaticText, oHashTable);
+	if (bOptimize) { oOptimizer.Optimize();          }
+	else           { oOptimizer.MergeStaticOutput(); }
+
 	// Get program core
 	UINT_32 iCodeSize = 0;
 	const VMInstruction * oVMInstruction = oVMOpcodeCollector.GetCode(iCodeSize);
@@ -105,20 +176,140 @@ int main(int argc, char ** argv)
 	UINT_32 iSize = 0;
 	const VMExecutable * aProgramCore = oDumper.GetExecutable(iSize);
 
-	// Open file only if compilation is done
-	FILE * FW = fopen(argv[2], "wb");
-	if (FW == NULL) { fprintf(stderr, "ERROR: Cannot open destination file `%s` for writing\n", argv[2]); return EX_SOFTWARE; }
+	fprintf(stdout, "Instructions: %u -> %u, static text: %u -> %u bytes (%u records), program: %u -> %u bytes\n",
+	                iSourceCodeSize, iCodeSize, iSourceTextSize, oStaticText.GetDataSize(), oStaticText.GetRecordsNum(), iSourceSize, iSize);
+
+	// Write file only if compilation is done; old file may be mapped by running programs, so it is replaced, not rewritten
+	try
+	{
+		ReplaceFile(szDestination, aProgramCore, iSize);
+	}
+	catch(CTPPUnixException     & e)
+	{
+		fprintf(stderr, "ERROR: Cannot write destination file `%s`: %s: %s\n", szDestination, e.what(), strerror(e.ErrNo()));
+		return EX_SOFTWARE;
+	}
+
+return EX_OK;
+}
+
+//
+// Get name of localized program: name.ct2 -> name.lang.ct2
+//
+static STLW::string LocalizedName(const STLW::string  & sDestination,
+                                  const STLW::string  & sLanguage)
+{
+	const STLW::string::size_type iExtPos = sDestination.rfind(".ct2");
+	if (iExtPos == STLW::string::npos || iExtPos + 4 != sDestination.size()) { return sDestination + "." + sLanguage; }
+
+return sDestination.substr(0, iExtPos) + "." + sLanguage + ".ct2";
+}
+
+int main(int argc, char ** argv)
+{
+	// Optimize code
+	bool bOptimize     = false;
+	// Compile include files once
+	bool bIncludeUnits = false;
+	// Compile directory tree or manifest
+	bool bBatch        = false;
+	// Compile unchanged templates in batch mode
+	bool bForce        = false;
+	// Number of threads in batch mode
+	INT_32 iThreads    = 0;
+	// Translations, "lang:file.mo"
+	STLW::vector<STLW::string> vTranslations;
+	bool bBadTranslation = false;
+
+	CCHAR_P szProgramName = argv[0];
+	while (argc > 3 && argv[1][0] == '-')
+	{
+		if      (strcmp(argv[1], "-O")      == 0) { bOptimize     = true; }
+		else if (strcmp(argv[1], "-u")      == 0) { bIncludeUnits = true; }
+		else if (strcmp(argv[1], "-f")      == 0) { bForce        = true; }
+		else if (strcmp(argv[1], "--batch") == 0) { bBatch        = true; }
+		else if (strcmp(argv[1], "-j")      == 0)
+		{
+			iThreads = atoi(argv[2]);
+			--argc;
+			++argv;
+		}
+		else if (strcmp(argv[1], "-l")      == 0)
+		{
+			if (strchr(argv[2], ':') == NULL) { bBadTranslation = true; }
+
+			vTranslations.push_back(argv[2]);
+			--argc;
+			++argv;
+		}
+		else { break; }
 
-	// Write to the disc
-	fwrite(aProgramCore, iSize, 1, FW);
-	// All done
-	fclose(FW);
+		--argc;
+		++argv;
+	}
+
+	if (argc != 3 || iThreads < 0 || bBadTranslation || (bBatch && !vTranslations.empty()))
+	{
+		fprintf(stdout, "CTPP2 template compiler v" CTPP_VERSION " (" CTPP_IDENT "). Copyright (c) 2004-2011 CTPP Dev. Team.\n\n");
+		fprintf(stderr, "usage: %s [-O] [-u] [-l lang:file.mo ...] source.ctpp2 destination.ct2\n", szProgramName);
+		fprintf(stderr, "       %s --batch [-O] [-u] [-f] [-j threads] source_dir|manifest destination_dir\n", szProgramName);
+		return EX_USAGE;
+	}
+
+	if (bBatch)
+	{
+		if (iThreads == 0) { iThreads = sysconf(_SC_NPROCESSORS_ONLN); }
+		return BatchCompile(argv[1], argv[2], bOptimize, bIncludeUnits, bForce, iThreads > 0 ? iThreads : 1);
+	}
+
+	// No translations
+	int iResult = EX_OK;
+	if (vTranslations.empty()) { iResult = CompileTemplate(argv[1], argv[2], bOptimize, bIncludeUnits, NULL, ""); }
+
+	// One program per language; i18n domain is name of .mo file, first one is default domain
+	STLW::vector<STLW::string> vLanguages;
+	STLW::map<STLW::string, CTPP2GetText *> mGetText;
+	try
+	{
+		for (UINT_32 iPos = 0; iPos < vTranslations.size(); ++iPos)
+		{
+			const STLW::string::size_type iDelimPos = vTranslations[iPos].find(':');
+			const STLW::string sLanguage(vTranslations[iPos], 0, iDelimPos);
+			const STLW::string sFileName(vTranslations[iPos], iDelimPos + 1);
+
+			STLW::string sDomain(sFileName, sFileName.rfind('/') == STLW::string::npos ? 0 : sFileName.rfind('/') + 1);
+			if (sDomain.size() > 3 && sDomain.compare(sDomain.size() - 3, 3, ".mo") == 0) { sDomain.erase(sDomain.size() - 3); }
+
+			CTPP2GetText * & pGetText = mGetText[sLanguage];
+			if (pGetText == NULL)
+			{
+				pGetText = new CTPP2GetText();
+				pGetText -> SetDefaultDomain(sDomain);
+				vLanguages.push_back(sLanguage);
+			}
+			pGetText -> AddTranslation(sFileName, sDomain, sLanguage);
+		}
+	}
+	catch(CTPPGetTextError      & e)
+	{
+		fprintf(stderr, "ERROR: %s\n", e.what());
+		iResult = EX_NOINPUT;
+	}
+
+	for (UINT_32 iPos = 0; iPos < vLanguages.size() && iResult == EX_OK; ++iPos)
+	{
+		const STLW::string sDestination = LocalizedName(argv[2], vLanguages[iPos]);
+		iResult = CompileTemplate(argv[1], sDestination.c_str(), bOptimize, bIncludeUnits, mGetText[vLanguages[iPos]], vLanguages[iPos]);
+	}
+
+	STLW::map<STLW::string, CTPP2GetText *>::iterator itmGetText = mGetText.begin();
+	for (; itmGetText != mGetText.end(); ++itmGetText) { delete itmGetText -> second; }
 
 	// Make valgrind happy
 	fclose(stdin);
 	fclose(stdout);
 	fclose(stderr);
 
-return EX_OK;
+return iResult;
 }
 // End.
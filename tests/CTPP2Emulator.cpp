@@ -30,7 +30,10 @@
  * $CTPP$
  */
 
+#include <CTPP2JSONFileParser.hpp>
 #include <CTPP2JSONParser.hpp>
+#include <CTPP2JSONStreamParser.hpp>
+#include <CTPP2ParserException.hpp>
 #include <CTPP2FileOutputCollector.hpp>
 #include <CTPP2FileLogger.hpp>
 #include <CTPP2SyscallFactory.hpp>
@@ -65,7 +68,7 @@ int main(int argc, char ** argv)
 	if (argc != 2 && argc != 3 && argc != 4 && argc != 5)
 	{
 		fprintf(stdout, "CTPP2 virtual machine v" CTPP_VERSION " (" CTPP_IDENT "). Copyright (c) 2004-2011 CTPP Dev. Team.\n\n");
-		fprintf(stderr, "usage: %s file.name [data.json] [output.txt | 0] [translation.mo | 0] [limit of steps]\n", argv[0]);
+		fprintf(stderr, "usage: %s file.name [data.json | -] [output.txt | 0] [translation.mo | 0] [limit of steps]\n", argv[0]);
 		return EX_USAGE;
 	}
 
@@ -100,39 +103,42 @@ int main(int argc, char ** argv)
 		// Get program core
 		const VMMemoryCore * pVMMemoryCore = oLoader.GetCore();
 
+		// Strings of data refer to mapped data file
+		CTPP2JSONMappedFile oMappedFile;
 		CDT oHash(CDT::HASH_VAL);
 
 		// Load JSON data
 		if(argc >= 3)
 		{
 			struct stat oStat;
-			// Get file size
-			if (stat(argv[2], &oStat) == -1 || oStat.st_size == 0) { fprintf(stderr, "ERROR: Cannot get size of file `%s`\n", argv[2]); return EX_SOFTWARE; }
-
-			// Allocate memory
-			CHAR_8 * szJSONBuffer = (CHAR_8 *)malloc(oStat.st_size + 1);
-			// Read from file
-			FILE * F = fopen(argv[2], "rb");
-			if (F == NULL) { fprintf(stderr, "ERROR: Cannot open file `%s` for reading\n", argv[2]); return EX_SOFTWARE; }
-
-			if (fread(szJSONBuffer, oStat.st_size, 1, F) != 1)
+			// Standard input, pipe or device: size is unknown, data are parsed while read
+			const bool bStdIn = strcmp(argv[2], "-") == 0;
+			if (bStdIn || (stat(argv[2], &oStat) == 0 && !S_ISREG(oStat.st_mode)))
 			{
-				fprintf(stderr, "ERROR: Cannot read from file `%s`\n", argv[2]);
-				fclose(F);
-				free(szJSONBuffer);
-				return EX_SOFTWARE;
+				FILE * F = bStdIn ? stdin : fopen(argv[2], "rb");
+				if (F == NULL) { fprintf(stderr, "ERROR: Cannot open file `%s` for reading\n", argv[2]); return EX_SOFTWARE; }
+
+				CTPP2JSONStreamParser oJSONParser(oHash);
+				CHAR_8 szChunk[65536];
+				for (;;)
+				{
+					const size_t iReadBytes = fread(szChunk, 1, sizeof(szChunk), F);
+					if (iReadBytes == 0) { break; }
+					oJSONParser.Feed(szChunk, iReadBytes);
+				}
+
+				const bool bError = ferror(F) != 0;
+				if (!bStdIn) { fclose(F); }
+				if (bError) { fprintf(stderr, "ERROR: Cannot read from file `%s`\n", argv[2]); return EX_SOFTWARE; }
+
+				oJSONParser.Finish();
+			}
+			// Regular file is mapped to memory, strings refer to file data
+			else
+			{
+				CTPP2JSONFileParser oJSONParser(oHash, NULL, CTPP2JSONParser::FAST_MODE, &oMappedFile);
+				oJSONParser.Parse(argv[2]);
 			}
-
-			szJSONBuffer[oStat.st_size] = '\0';
-
-			CTPP2JSONParser oJSONParser(oHash);
-			CCHAR_P szEnd = szJSONBuffer + oStat.st_size;
-			oJSONParser.Parse(szJSONBuffer, szEnd);
-
-			// All Done
-			fclose(F);
-			// All done with loading
-			free(szJSONBuffer);
 		}
 		else
 		{
@@ -189,6 +195,7 @@ int main(int argc, char ** argv)
 	catch(VMException           & e) { fprintf(stderr, "ERROR: VM generic exception: %s at 0x%08X\n", e.what(), e.GetIP()); }
 
 	// CTPP
+	catch(CTPPParserSyntaxError & e) { fprintf(stderr, "ERROR: In JSON data: %s at line %d, pos. %d\n", e.what(), e.GetLine(), e.GetLinePos()); }
 	catch(CTPPLogicError        & e) { fprintf(stderr, "ERROR: %s\n", e.what());                                              }
 	catch(CTPPUnixException     & e) { fprintf(stderr, "ERROR: I/O in %s: %s\n", e.what(), strerror(e.ErrNo()));              }
 	catch(CTPPException         & e) { fprintf(stderr, "ERROR: CTPP Generic exception: %s\n", e.what());                      }
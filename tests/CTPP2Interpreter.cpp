@@ -47,6 +47,7 @@
 #include <CTPP2VM.hpp>
 #include <CTPP2VMFileLoader.hpp>
 #include <CTPP2VMOpcodeCollector.hpp>
+#include <CTPP2VMOptimizer.hpp>
 #include <CTPP2VMSTDLib.hpp>
 #include <CTPP2VMStackException.hpp>
 #include <CTPP2GetText.hpp>
@@ -108,6 +109,10 @@ int main(int argc, char ** argv)
 		// Compile template
 		oCTPP2Parser.Compile();
 
+		// Merge outputs of static text
+		VMOptimizer oOptimizer(oVMOpcodeCollector, oStaticData, oStaticText, oHashTable);
+		oOptimizer.MergeStaticOutput();
+
 		// Get program core
 		UINT_32 iCodeSize = 0;
 		const VMInstruction * oVMInstruction = oVMOpcodeCollector.GetCode(iCodeSize);
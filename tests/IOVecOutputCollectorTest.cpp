@@ -0,0 +1,139 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      IOVecOutputCollectorTest.cpp
+ *
+ * $CTPP$
+ */
+#include <CDT.hpp>
+#include <CTPP2FileLogger.hpp>
+#include <CTPP2IOVecOutputCollector.hpp>
+#include <CTPP2JSONFileParser.hpp>
+#include <CTPP2SimpleCompiler.hpp>
+#include <CTPP2StringOutputCollector.hpp>
+#include <CTPP2SyscallFactory.hpp>
+#include <CTPP2VM.hpp>
+#include <CTPP2VMSTDLib.hpp>
+
+#include <stdio.h>
+#include <unistd.h>
+
+#ifdef HAVE_SYSEXITS_H
+#include <sysexits.h>
+#endif
+
+using namespace CTPP;
+
+//
+// Render template into collector
+//
+static void Render(const VMMemoryCore  * pCore,
+                   CDT                 & oData,
+                   OutputCollector     & oCollector)
+{
+	SyscallFactory oSyscalls(1024);
+	STDLibInitializer::InitLibrary(oSyscalls);
+	{
+		VM         oVM(&oSyscalls);
+		FileLogger oLogger(stderr);
+		UINT_32    iIP = 0;
+
+		oVM.Init(pCore, &oCollector, &oLogger);
+		oVM.Run(pCore, &oCollector, iIP, oData, &oLogger);
+	}
+	STDLibInitializer::DestroyLibrary(oSyscalls);
+}
+
+int main(int argc, char ** argv)
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "usage: %s data.json template.tmpl\n", argv[0]);
+		return EX_USAGE;
+	}
+
+	CDT oData;
+	CTPP2JSONFileParser oJSONParser(oData);
+	oJSONParser.Parse(argv[1]);
+
+	SimpleCompiler oCompiler(argv[2]);
+
+	STLW::string sExpected;
+	StringOutputCollector oStringCollector(sExpected);
+	Render(oCompiler.GetCore(), oData, oStringCollector);
+
+	// Small chunks, so dynamic data is spread over several chunks and large blocks
+	IOVecOutputCollector oIOVecCollector(256);
+	for (UINT_32 iPass = 0; iPass < 2; ++iPass)
+	{
+		Render(oCompiler.GetCore(), oData, oIOVecCollector);
+
+		UINT_32 iIOVecCount = 0;
+		const struct iovec * aIOVec = oIOVecCollector.GetIOVec(iIOVecCount);
+
+		STLW::string sResult;
+		for (UINT_32 iPos = 0; iPos < iIOVecCount; ++iPos) { sResult.append((CCHAR_P)aIOVec[iPos].iov_base, aIOVec[iPos].iov_len); }
+
+		if (sResult != sExpected || oIOVecCollector.GetSize() != sExpected.size())
+		{
+			fprintf(stderr, "ERROR: iovec list differs from string output, pass %u\n", iPass);
+			return EX_SOFTWARE;
+		}
+
+		// Flush into file and read it back
+		FILE * F = tmpfile();
+		if (F == NULL || oIOVecCollector.Flush(fileno(F)) != 0)
+		{
+			fprintf(stderr, "ERROR: cannot flush output\n");
+			return EX_SOFTWARE;
+		}
+
+		if (oIOVecCollector.GetSize() != 0 || oIOVecCollector.GetIOVec(iIOVecCount) != NULL)
+		{
+			fprintf(stderr, "ERROR: collector is not cleared after flush\n");
+			return EX_SOFTWARE;
+		}
+
+		sResult.assign(sExpected.size(), ' ');
+		if (pread(fileno(F), &sResult[0], sResult.size(), 0) != ssize_t(sResult.size()) || sResult != sExpected)
+		{
+			fprintf(stderr, "ERROR: flushed output differs from string output, pass %u\n", iPass);
+			return EX_SOFTWARE;
+		}
+		fclose(F);
+	}
+
+	fprintf(stdout, "OK\n");
+
+	// make valgrind happy
+	fclose(stdin);
+	fclose(stdout);
+	fclose(stderr);
+
+return EX_OK;
+}
+// End.
@@ -33,6 +33,7 @@
 #include <CTPP2StaticText.hpp>
 
 #include <stdio.h>
+#include <string.h>
 
 #ifdef HAVE_SYSEXITS_H
 #include <sysexits.h>
@@ -67,6 +68,23 @@ int main(void)
 
 	fprintf(stderr, "\n");
 
+	// Identical text is stored once
+	if (oStaticText.StoreData("really", 6) != 1 || oStaticText.GetRecordsNum() != 4) { return EX_SOFTWARE; }
+	fprintf(stderr, "Duplicate text: OK\n");
+
+	// Text is removed when last reference is released, IDs of other records are kept
+	oStaticText.ReleaseData(1);
+	if (oStaticText.Compact() != 0) { return EX_SOFTWARE; }
+	oStaticText.ReleaseData(1);
+	if (oStaticText.Compact() != 7) { return EX_SOFTWARE; }
+
+	sData = oStaticText.GetData(2, iDataSize);
+	if (iDataSize != 8 || strncmp(sData, " passed?", 8) != 0) { return EX_SOFTWARE; }
+	sData = oStaticText.GetData(3, iDataSize);
+	if (iDataSize != 4 || strcmp(sData, "1234") != 0) { return EX_SOFTWARE; }
+	if (oStaticText.StoreData("really", 6) != 4) { return EX_SOFTWARE; }
+	fprintf(stderr, "Compacted text: OK\n");
+
 	// make valgrind happy
 	fclose(stdin);
 	fclose(stdout);
@@ -0,0 +1,260 @@
+/*-
+ * Copyright (c) 2004 - 2010 CTPP Team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 4. Neither the name of the CTPP Team nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *      VMMemoryRetentionTest.cpp
+ *
+ * $CTPP$
+ */
+#include <CDT.hpp>
+#include <CTPP2FileLogger.hpp>
+#include <CTPP2SimpleCompiler.hpp>
+#include <CTPP2StringOutputCollector.hpp>
+#include <CTPP2SyscallFactory.hpp>
+#include <CTPP2VM.hpp>
+#include <CTPP2VMArgStack.hpp>
+#include <CTPP2VMSTDLib.hpp>
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef HAVE_SYSEXITS_H
+#include <sysexits.h>
+#endif
+
+using namespace CTPP;
+
+// Live heap size, bytes
+static UINT_64 iLiveBytes = 0;
+
+// Size header, keeps alignment of user data
+#define C_HEADER_SIZE 16
+
+//
+// Allocate memory and account it
+//
+static void * TrackedAlloc(size_t iSize)
+{
+	CHAR_P pBlock = (CHAR_P)malloc(iSize + C_HEADER_SIZE);
+	if (pBlock == NULL) { return NULL; }
+
+	*(size_t *)pBlock = iSize;
+	iLiveBytes += iSize;
+
+return pBlock + C_HEADER_SIZE;
+}
+
+//
+// Free memory and account it
+//
+static void TrackedFree(void * vPtr)
+{
+	if (vPtr == NULL) { return; }
+
+	CHAR_P pBlock = (CHAR_P)vPtr - C_HEADER_SIZE;
+	iLiveBytes -= *(size_t *)pBlock;
+	free(pBlock);
+}
+
+void * operator new(size_t iSize)
+{
+	void * vPtr = TrackedAlloc(iSize);
+	if (vPtr == NULL) { throw std::bad_alloc(); }
+
+return vPtr;
+}
+
+void * operator new[](size_t iSize)
+{
+	void * vPtr = TrackedAlloc(iSize);
+	if (vPtr == NULL) { throw std::bad_alloc(); }
+
+return vPtr;
+}
+
+void * operator new(size_t iSize, const std::nothrow_t &) throw() { return TrackedAlloc(iSize); }
+
+void * operator new[](size_t iSize, const std::nothrow_t &) throw() { return TrackedAlloc(iSize); }
+
+void operator delete(void * vPtr) throw() { TrackedFree(vPtr); }
+
+void operator delete[](void * vPtr) throw() { TrackedFree(vPtr); }
+
+void operator delete(void * vPtr, const std::nothrow_t &) throw() { TrackedFree(vPtr); }
+
+void operator delete[](void * vPtr, const std::nothrow_t &) throw() { TrackedFree(vPtr); }
+
+void operator delete(void * vPtr, size_t) throw() { TrackedFree(vPtr); }
+
+void operator delete[](void * vPtr, size_t) throw() { TrackedFree(vPtr); }
+
+// Allowed growth of live heap between runs, bytes
+#define C_SLACK_BYTES (64 * 1024)
+
+//
+// Create template data
+//
+static void MakeData(CDT & oData, const UINT_32 iItems)
+{
+	oData = CDT(CDT::HASH_VAL);
+	oData["title"] = "Memory retention test";
+
+	CDT & oItems = oData["items"];
+	oItems = CDT(CDT::ARRAY_VAL);
+	for (UINT_32 iPos = 0; iPos < iItems; ++iPos)
+	{
+		CDT oItem(CDT::HASH_VAL);
+		oItem["name"] = iPos;
+		oItem["text"] = STLW::string(128, 'a' + iPos % 26) + " <&> ";
+		oItems.PushBack(oItem);
+	}
+}
+
+//
+// Render template, data is released before return
+//
+static INT_32 Render(VM & oVM, const VMMemoryCore * pCore, const UINT_32 iItems)
+{
+	STLW::string sResult;
+	{
+		CDT oData;
+		MakeData(oData, iItems);
+
+		StringOutputCollector oCollector(sResult);
+		FileLogger            oLogger(stderr);
+		UINT_32               iIP = 0;
+
+		oVM.Init(pCore, &oCollector, &oLogger);
+		oVM.Run(pCore, &oCollector, iIP, oData, &oLogger);
+	}
+	oVM.Reset();
+
+	// title + one line per item
+	UINT_32 iLines = 0;
+	for (UINT_32 iPos = 0; iPos < sResult.size(); ++iPos) { iLines += (sResult[iPos] == '\n'); }
+
+return (iLines == iItems + 1) ? 0 : -1;
+}
+
+//
+// Values popped from argument stack should be released at once
+//
+static INT_32 ArgStackTest()
+{
+	VMArgStack oStack(1024);
+	const UINT_64 iBaseline = iLiveBytes;
+	{
+		CDT oData;
+		MakeData(oData, 1000);
+
+		oStack.PushElement(oData);
+		oStack.PushElement(oData);
+		oStack.PushElement(oData);
+		oStack.PopElement();
+		oStack.ClearStack(2);
+	}
+
+	if (iLiveBytes != iBaseline)
+	{
+		fprintf(stderr, "ERROR: argument stack retains %llu bytes after pop\n", (unsigned long long)(iLiveBytes - iBaseline));
+		return -1;
+	}
+
+	{
+		CDT oData;
+		MakeData(oData, 1000);
+		oStack.PushElement(oData);
+	}
+	oStack.Reset();
+
+	if (iLiveBytes != iBaseline)
+	{
+		fprintf(stderr, "ERROR: argument stack retains %llu bytes after reset\n", (unsigned long long)(iLiveBytes - iBaseline));
+		return -1;
+	}
+
+return 0;
+}
+
+//
+// Pooled VM should not retain data of previous runs
+//
+static INT_32 PooledVMTest(const VMMemoryCore * pCore)
+{
+	SyscallFactory oSyscalls(1024);
+	STDLibInitializer::InitLibrary(oSyscalls);
+
+	INT_32 iRC = 0;
+	{
+		VM oVM(&oSyscalls, 4096, 4096, 10000000);
+
+		// Warm up
+		iRC = Render(oVM, pCore, 10);
+		const UINT_64 iBaseline = iLiveBytes;
+
+		for (UINT_32 iPass = 0; iRC == 0 && iPass < 3; ++iPass)
+		{
+			if (Render(oVM, pCore, 50000) != 0 || Render(oVM, pCore, 10) != 0)
+			{
+				fprintf(stderr, "ERROR: invalid output, pass %u\n", iPass);
+				iRC = -1;
+			}
+			else if (iLiveBytes > iBaseline + C_SLACK_BYTES)
+			{
+				fprintf(stderr, "ERROR: VM retains %llu bytes, pass %u\n", (unsigned long long)(iLiveBytes - iBaseline), iPass);
+				iRC = -1;
+			}
+		}
+	}
+	STDLibInitializer::DestroyLibrary(oSyscalls);
+
+return iRC;
+}
+
+int main(int argc, char ** argv)
+{
+	if (argc != 2)
+	{
+		fprintf(stderr, "usage: %s template.tmpl\n", argv[0]);
+		return EX_USAGE;
+	}
+
+	if (ArgStackTest() != 0) { return EX_SOFTWARE; }
+
+	SimpleCompiler oCompiler(argv[1]);
+	if (PooledVMTest(oCompiler.GetCore()) != 0) { return EX_SOFTWARE; }
+
+	fprintf(stdout, "OK\n");
+
+	// make valgrind happy
+	fclose(stdin);
+	fclose(stdout);
+	fclose(stderr);
+
+return EX_OK;
+}
+// End.